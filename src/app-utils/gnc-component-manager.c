@@ -253,33 +253,46 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
 }
 
 static void
-gnc_cm_event_handler (QofInstance *entity,
-                      QofEventId event_type,
-                      gpointer user_data,
-                      gpointer event_data)
+gnc_cm_event_handler (const QofEventBatchItem *items,
+                      guint n_items,
+                      gpointer user_data)
 {
-    const GncGUID *guid = qof_entity_get_guid(entity);
+    guint i;
+
+    for (i = 0; i < n_items; i++)
+    {
+        QofInstance *entity = items[i].entity;
+        QofEventId event_type = items[i].event_mask;
+        const GncGUID *guid;
+
+        if (!entity)
+            continue;
+
+        guid = qof_entity_get_guid(entity);
 #if CM_DEBUG
-    gchar guidstr[GUID_ENCODING_LENGTH+1];
-    guid_to_string_buff (guid, guidstr);
-    fprintf (stderr, "event_handler: event %d, entity %p, guid %s\n", event_type,
-             entity, guidstr);
+        {
+            gchar guidstr[GUID_ENCODING_LENGTH+1];
+            guid_to_string_buff (guid, guidstr);
+            fprintf (stderr, "event_handler: event %d, entity %p, guid %s\n",
+                     event_type, entity, guidstr);
+        }
 #endif
-    add_event (&changes, guid, event_type, TRUE);
+        add_event (&changes, guid, event_type, TRUE);
 
-    if (QOF_CHECK_TYPE(entity, GNC_ID_SPLIT))
-    {
-        /* split events are never generated by the engine, but might
-         * be generated by a backend (viz. the postgres backend.)
-         * Handle them like a transaction modify event. */
-        add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
-    }
-    else
-        add_event_type (&changes, entity->e_type, event_type, TRUE);
+        if (QOF_CHECK_TYPE(entity, GNC_ID_SPLIT))
+        {
+            /* split events are never generated by the engine, but might
+             * be generated by a backend (viz. the postgres backend.)
+             * Handle them like a transaction modify event. */
+            add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
+        }
+        else
+            add_event_type (&changes, entity->e_type, event_type, TRUE);
 
-    got_events = TRUE;
+        got_events = TRUE;
+    }
 
-    if (suspend_counter == 0)
+    if (got_events && suspend_counter == 0)
         gnc_gui_refresh_internal (FALSE);
 }
 
@@ -300,7 +313,7 @@ gnc_component_manager_init (void)
     changes_backup.event_masks = g_hash_table_new (g_str_hash, g_str_equal);
     changes_backup.entity_events = guid_hash_table_new ();
 
-    handler_id = qof_event_register_handler (gnc_cm_event_handler, NULL);
+    handler_id = qof_event_register_batch_handler (gnc_cm_event_handler, NULL);
 }
 
 void
@@ -573,6 +586,9 @@ gnc_unregister_gui_component_by_data (const char *component_class,
 void
 gnc_suspend_gui_refresh (void)
 {
+    /* Collect the events until the refresh resumes, so that an entity
+     * changed many times is only handed to us once. */
+    qof_event_begin_batch ();
     suspend_counter++;
 
     if (suspend_counter == 0)
@@ -590,6 +606,7 @@ gnc_resume_gui_refresh (void)
         return;
     }
 
+    qof_event_end_batch ();
     suspend_counter--;
 
     if (suspend_counter == 0)
@@ -671,7 +688,10 @@ gnc_gui_refresh_internal (gboolean force)
     if (!got_events && !force)
         return;
 
-    gnc_suspend_gui_refresh ();
+    /* Not gnc_suspend_gui_refresh: events the refresh handlers cause must
+     * reach changes before got_events is cleared below, as they always
+     * have, rather than at the end of a batch. */
+    suspend_counter++;
 
     {
         GHashTable *table;
@@ -739,7 +759,7 @@ gnc_gui_refresh_internal (gboolean force)
 
     g_list_free (list);
 
-    gnc_resume_gui_refresh ();
+    suspend_counter--;
 }
 
 void
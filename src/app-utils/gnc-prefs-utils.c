@@ -36,6 +36,12 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define GNC_PREF_RETAIN_TYPE_DAYS    "retain-type-days"
 #define GNC_PREF_RETAIN_TYPE_FOREVER "retain-type-forever"
 #define GNC_PREF_RETAIN_DAYS         "retain-days"
+#define GNC_PREF_FILE_LOAD_THREADS   "file-load-threads"
+#define GNC_PREF_FILE_SAVE_THREADS   "file-save-threads"
+#define GNC_PREF_FILE_SNAPSHOT       "file-snapshot"
+#define GNC_PREF_SQL_LOAD_AS_NEEDED  "sql-load-as-needed"
+#define GNC_PREF_SQL_CACHE_SIZE      "sql-cache-size"
+#define GNC_PREF_SQL_SLOT_BLOBS      "sql-slot-blobs"
 
 /***************************************************************
  * Initialization                                              *
@@ -78,6 +84,66 @@ file_compression_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
     }
 }
 
+static void
+file_load_threads_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint threads = gnc_prefs_get_int(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_LOAD_THREADS);
+        gnc_prefs_set_file_load_threads (threads);
+    }
+}
+
+static void
+file_save_threads_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint threads = gnc_prefs_get_int(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SAVE_THREADS);
+        gnc_prefs_set_file_save_threads (threads);
+    }
+}
+
+static void
+file_snapshot_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean snapshot = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SNAPSHOT);
+        gnc_prefs_set_file_snapshot (snapshot);
+    }
+}
+
+static void
+sql_load_as_needed_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean as_needed = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LOAD_AS_NEEDED);
+        gnc_prefs_set_sql_load_as_needed (as_needed);
+    }
+}
+
+static void
+sql_cache_size_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint size = gnc_prefs_get_int(GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_CACHE_SIZE);
+        gnc_prefs_set_sql_cache_size (size);
+    }
+}
+
+static void
+sql_slot_blobs_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean slot_blobs = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_SLOT_BLOBS);
+        gnc_prefs_set_sql_slot_blobs (slot_blobs);
+    }
+}
+
 
 void gnc_prefs_init (void)
 {
@@ -89,6 +155,12 @@ void gnc_prefs_init (void)
     file_retain_changed_cb (NULL, NULL, NULL);
     file_retain_type_changed_cb (NULL, NULL, NULL);
     file_compression_changed_cb (NULL, NULL, NULL);
+    file_load_threads_changed_cb (NULL, NULL, NULL);
+    file_save_threads_changed_cb (NULL, NULL, NULL);
+    file_snapshot_changed_cb (NULL, NULL, NULL);
+    sql_load_as_needed_changed_cb (NULL, NULL, NULL);
+    sql_cache_size_changed_cb (NULL, NULL, NULL);
+    sql_slot_blobs_changed_cb (NULL, NULL, NULL);
 
     /* Check for invalid retain_type (days)/retain_days (0) combo.
      * This can happen either because a user changed the preferences
@@ -122,5 +194,17 @@ void gnc_prefs_init (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_LOAD_THREADS,
+                           file_load_threads_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SAVE_THREADS,
+                           file_save_threads_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SNAPSHOT,
+                           file_snapshot_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LOAD_AS_NEEDED,
+                           sql_load_as_needed_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_CACHE_SIZE,
+                           sql_cache_size_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_SLOT_BLOBS,
+                           sql_slot_blobs_changed_cb, NULL);
 
 }
@@ -113,6 +113,7 @@ typedef struct
     // be used to prevent infinite loops.
     gboolean retry;         // Signals the calling function that it should retry (the error handler detected
     // transient error and managed to resolve it, but it can't run the original query)
+    GHashTable* templates;  // Statement template SQL, split at its parameters, by key
 
 } GncDbiSqlConnection;
 /* external access required for tests */
@@ -87,6 +87,7 @@ extern "C"
 #include <gnc-backend-prov.hpp>
 #include "gnc-backend-dbi.h"
 #include "gnc-backend-dbi-priv.h"
+#include "gnc-transaction-sql.h"
 
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
@@ -1581,6 +1582,7 @@ gnc_dbi_session_end (QofBackend* be_start)
         be->sql_be.conn = NULL;
     }
     gnc_sql_finalize_version_info (&be->sql_be);
+    gnc_sql_transaction_cache_free (&be->sql_be);
 
     LEAVE (" ");
 }
@@ -1818,6 +1820,10 @@ gnc_dbi_safe_sync_all (QofBackend* qbe, QofBook* book)
     g_return_if_fail (book != NULL);
 
     ENTER ("book=%p, primary=%p", book, be->primary_book);
+    /* The tables are about to be rewritten from the book, so it must hold
+     * all of the transactions */
+    if (be->sql_be.tx_cache != NULL && be->sql_be.book == book)
+        gnc_sql_load (&be->sql_be, book, LOAD_TYPE_LOAD_ALL);
     dbname = dbi_conn_get_option (be->conn, "dbname");
     table_list = conn->provider->get_table_list (conn->conn, dbname);
     if (!conn_table_operation ((GncSqlConnection*)conn, table_list,
@@ -1929,6 +1935,7 @@ init_sql_backend (GncDbiBackend* dbi_be)
     be->compile_query = gnc_sql_compile_query;
     be->run_query = gnc_sql_run_query;
     be->free_query = gnc_sql_free_query;
+    be->load_related = gnc_sql_load_related;
 
     be->export_fn = NULL;
 
@@ -2156,18 +2163,28 @@ gnc_module_finalize_backend_dbi (void)
 }
 
 /* --------------------------------------------------------- */
+/* The fields of a result, looked up once when it is created */
+typedef struct
+{
+    guint num_fields;
+    GHashTable* index;          /* Field name -> dbi field index */
+    gushort* types;
+    guint* attribs;
+    gboolean has_decimal;
+} GncDbiSqlColumns;
+
 typedef struct
 {
     GncSqlRow base;
 
     dbi_result result;
+    const GncDbiSqlColumns* columns;
     GList* gvalue_list;
 } GncDbiSqlRow;
 
 static void
-row_dispose (GncSqlRow* row)
+row_free_values (GncDbiSqlRow* dbi_row)
 {
-    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
     GList* node;
 
     if (dbi_row->gvalue_list != NULL)
@@ -2185,92 +2202,168 @@ row_dispose (GncSqlRow* row)
             g_free (value);
         }
         g_list_free (dbi_row->gvalue_list);
+        dbi_row->gvalue_list = NULL;
     }
+}
+
+static void
+row_dispose (GncSqlRow* row)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+
+    row_free_values (dbi_row);
+    gnc_sql_row_free_col_maps (row);
     g_free (dbi_row);
 }
 
-static  const GValue*
-row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
+static gint
+row_get_col_index (GncSqlRow* row, const gchar* col_name)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+
+    return GPOINTER_TO_INT (g_hash_table_lookup (dbi_row->columns->index,
+                                                 col_name)) - 1;
+}
+
+static GType
+row_get_col_type (GncSqlRow* row, gint col)
 {
     GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
-    gushort type;
     guint attrs;
-    GValue* value;
 
-    type = dbi_result_get_field_type (dbi_row->result, col_name);
-    attrs = dbi_result_get_field_attribs (dbi_row->result, col_name);
-    value = g_new0 (GValue, 1);
-    g_assert (value != NULL);
+    if (col < 0 || (guint)col >= dbi_row->columns->num_fields)
+        return G_TYPE_INVALID;
 
-    switch (type)
+    switch (dbi_row->columns->types[col])
     {
     case DBI_TYPE_INTEGER:
-        (void)g_value_init (value, G_TYPE_INT64);
-        g_value_set_int64 (value, dbi_result_get_longlong (dbi_row->result, col_name));
-        break;
+        return G_TYPE_INT64;
     case DBI_TYPE_DECIMAL:
-        gnc_push_locale (LC_NUMERIC, "C");
-        if ((attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE4)
-        {
-            (void)g_value_init (value, G_TYPE_FLOAT);
-            g_value_set_float (value, dbi_result_get_float (dbi_row->result, col_name));
-        }
-        else if ((attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE8)
-        {
-            (void)g_value_init (value, G_TYPE_DOUBLE);
-            g_value_set_double (value, dbi_result_get_double (dbi_row->result, col_name));
-        }
-        else
-        {
-            PERR ("Field %s: strange decimal length attrs=%d\n", col_name, attrs);
-        }
-        gnc_pop_locale (LC_NUMERIC);
-        break;
+        attrs = dbi_row->columns->attribs[col] & DBI_DECIMAL_SIZEMASK;
+        if (attrs == DBI_DECIMAL_SIZE4 || attrs == DBI_DECIMAL_SIZE8)
+            return G_TYPE_DOUBLE;
+        return G_TYPE_INVALID;
     case DBI_TYPE_STRING:
-        (void)g_value_init (value, G_TYPE_STRING);
-        g_value_take_string (value, dbi_result_get_string_copy (dbi_row->result,
-                                                                col_name));
-        break;
+        return G_TYPE_STRING;
     case DBI_TYPE_DATETIME:
-        if (dbi_result_field_is_null (dbi_row->result, col_name))
-        {
-            return NULL;
-        }
-        else
-        {
+        if (dbi_result_field_is_null_idx (dbi_row->result, col + 1))
+            return G_TYPE_INVALID;
+        return G_TYPE_INT64;
+    default:
+        return G_TYPE_INVALID;
+    }
+}
+
+static gint64
+row_get_int64_at_col (GncSqlRow* row, gint col)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+
+    if (col < 0 || (guint)col >= dbi_row->columns->num_fields)
+        return 0;
+
+    switch (dbi_row->columns->types[col])
+    {
+    case DBI_TYPE_INTEGER:
+        return dbi_result_get_longlong_idx (dbi_row->result, col + 1);
+    case DBI_TYPE_DATETIME:
+    {
+        if (dbi_result_field_is_null_idx (dbi_row->result, col + 1))
+            return 0;
 #if HAVE_LIBDBI_TO_LONGLONG
-	    /* A less evil hack than the one equrie by libdbi-0.8, but
-	     * still necessary to work around the same bug.
-	     */
-	    time64 time = dbi_result_get_as_longlong(dbi_row->result,
-						     col_name);
+        /* A less evil hack than the one equrie by libdbi-0.8, but
+         * still necessary to work around the same bug.
+         */
+        return dbi_result_get_as_longlong_idx (dbi_row->result, col + 1);
 #else
-            /* A seriously evil hack to work around libdbi bug #15
-             * https://sourceforge.net/p/libdbi/bugs/15/. When libdbi
-             * v0.9 is widely available this can be replaced with
-             * dbi_result_get_as_longlong.
-             */
-            dbi_result_t* result = (dbi_result_t*) (dbi_row->result);
-            guint64 row = dbi_result_get_currow (result);
-            guint idx = dbi_result_get_field_idx (result, col_name) - 1;
-            time64 time = result->rows[row]->field_values[idx].d_datetime;
+        /* A seriously evil hack to work around libdbi bug #15
+         * https://sourceforge.net/p/libdbi/bugs/15/. When libdbi
+         * v0.9 is widely available this can be replaced with
+         * dbi_result_get_as_longlong.
+         */
+        dbi_result_t* result = (dbi_result_t*) (dbi_row->result);
+        guint64 row = dbi_result_get_currow (result);
+        return result->rows[row]->field_values[col].d_datetime;
 #endif //HAVE_LIBDBI_TO_LONGLONG
-            (void)g_value_init (value, G_TYPE_INT64);
-            g_value_set_int64 (value, time);
-        }
-        break;
+    }
+    default:
+        return 0;
+    }
+}
+
+static gdouble
+row_get_double_at_col (GncSqlRow* row, gint col)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+    guint attrs;
+
+    if (col < 0 || (guint)col >= dbi_row->columns->num_fields)
+        return 0;
+
+    switch (dbi_row->columns->types[col])
+    {
+    case DBI_TYPE_INTEGER:
+        return (gdouble)dbi_result_get_longlong_idx (dbi_row->result, col + 1);
+    case DBI_TYPE_DECIMAL:
+        attrs = dbi_row->columns->attribs[col] & DBI_DECIMAL_SIZEMASK;
+        if (attrs == DBI_DECIMAL_SIZE4)
+            return dbi_result_get_float_idx (dbi_row->result, col + 1);
+        if (attrs == DBI_DECIMAL_SIZE8)
+            return dbi_result_get_double_idx (dbi_row->result, col + 1);
+        return 0;
     default:
-        PERR ("Field %s: unknown DBI_TYPE: %d\n", col_name, type);
-        g_free (value);
+        return 0;
+    }
+}
+
+static const gchar*
+row_get_string_at_col (GncSqlRow* row, gint col)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+
+    if (col < 0 || (guint)col >= dbi_row->columns->num_fields ||
+        dbi_row->columns->types[col] != DBI_TYPE_STRING)
+        return NULL;
+
+    return dbi_result_get_string_idx (dbi_row->result, col + 1);
+}
+
+static  const GValue*
+row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
+{
+    GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
+    gint col;
+    GType type;
+    GValue* value;
+
+    col = row_get_col_index (row, col_name);
+    type = row_get_col_type (row, col);
+    if (type == G_TYPE_INVALID)
+    {
+        if (col < 0)
+            PERR ("Field %s: not in the result\n", col_name);
+        else if (dbi_row->columns->types[col] != DBI_TYPE_DATETIME)
+            PERR ("Field %s: unknown DBI_TYPE: %d attrs=%d\n", col_name,
+                  dbi_row->columns->types[col], dbi_row->columns->attribs[col]);
         return NULL;
     }
 
+    value = g_new0 (GValue, 1);
+    g_assert (value != NULL);
+    (void)g_value_init (value, type);
+    if (type == G_TYPE_INT64)
+        g_value_set_int64 (value, row_get_int64_at_col (row, col));
+    else if (type == G_TYPE_DOUBLE)
+        g_value_set_double (value, row_get_double_at_col (row, col));
+    else
+        g_value_set_string (value, row_get_string_at_col (row, col));
+
     dbi_row->gvalue_list = g_list_prepend (dbi_row->gvalue_list, value);
     return value;
 }
 
 static GncSqlRow*
-create_dbi_row (dbi_result result)
+create_dbi_row (dbi_result result, const GncDbiSqlColumns* columns)
 {
     GncDbiSqlRow* row;
 
@@ -2278,8 +2371,14 @@ create_dbi_row (dbi_result result)
     g_assert (row != NULL);
 
     row->base.getValueAtColName = row_get_value_at_col_name;
+    row->base.getColIndex = row_get_col_index;
+    row->base.getColType = row_get_col_type;
+    row->base.getInt64AtCol = row_get_int64_at_col;
+    row->base.getDoubleAtCol = row_get_double_at_col;
+    row->base.getStringAtCol = row_get_string_at_col;
     row->base.dispose = row_dispose;
     row->result = result;
+    row->columns = columns;
 
     return (GncSqlRow*)row;
 }
@@ -2292,7 +2391,8 @@ typedef struct
     dbi_result result;
     guint num_rows;
     guint cur_row;
-    GncSqlRow* row;
+    GncDbiSqlColumns columns;
+    GncSqlRow* row;             /* Reused for each row of the result */
 } GncDbiSqlResult;
 
 static void
@@ -2315,6 +2415,9 @@ result_dispose (GncSqlResult* result)
             qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
         }
     }
+    g_hash_table_destroy (dbi_result->columns.index);
+    g_free (dbi_result->columns.types);
+    g_free (dbi_result->columns.attribs);
     g_free (result);
 }
 
@@ -2326,27 +2429,45 @@ result_get_num_rows (GncSqlResult* result)
     return dbi_result->num_rows;
 }
 
+/* Moves the result to a row, and returns it.  The drivers convert DECIMAL
+ * fields as they fetch a row, which needs the C locale. */
+static GncSqlRow*
+result_fetch_row (GncDbiSqlResult* dbi_result, gboolean is_first)
+{
+    gint status;
+
+    if (dbi_result->columns.has_decimal)
+        gnc_push_locale (LC_NUMERIC, "C");
+    if (is_first)
+        status = dbi_result_first_row (dbi_result->result);
+    else
+        status = dbi_result_next_row (dbi_result->result);
+    if (dbi_result->columns.has_decimal)
+        gnc_pop_locale (LC_NUMERIC);
+    if (status == 0)
+    {
+        PERR ("Error in %s\n", is_first ? "dbi_result_first_row()" :
+              "dbi_result_next_row()");
+        qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
+    }
+
+    if (dbi_result->row == NULL)
+        dbi_result->row = create_dbi_row (dbi_result->result,
+                                          &dbi_result->columns);
+    else
+        row_free_values ((GncDbiSqlRow*)dbi_result->row);
+    return dbi_result->row;
+}
+
 static  GncSqlRow*
 result_get_first_row (GncSqlResult* result)
 {
     GncDbiSqlResult* dbi_result = (GncDbiSqlResult*)result;
 
-    if (dbi_result->row != NULL)
-    {
-        gnc_sql_row_dispose (dbi_result->row);
-        dbi_result->row = NULL;
-    }
     if (dbi_result->num_rows > 0)
     {
-        gint status = dbi_result_first_row (dbi_result->result);
-        if (status == 0)
-        {
-            PERR ("Error in dbi_result_first_row()\n");
-            qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
-        }
         dbi_result->cur_row = 1;
-        dbi_result->row = create_dbi_row (dbi_result->result);
-        return dbi_result->row;
+        return result_fetch_row (dbi_result, TRUE);
     }
     else
     {
@@ -2359,22 +2480,10 @@ result_get_next_row (GncSqlResult* result)
 {
     GncDbiSqlResult* dbi_result = (GncDbiSqlResult*)result;
 
-    if (dbi_result->row != NULL)
-    {
-        gnc_sql_row_dispose (dbi_result->row);
-        dbi_result->row = NULL;
-    }
     if (dbi_result->cur_row < dbi_result->num_rows)
     {
-        gint status = dbi_result_next_row (dbi_result->result);
-        if (status == 0)
-        {
-            PERR ("Error in dbi_result_first_row()\n");
-            qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
-        }
         dbi_result->cur_row++;
-        dbi_result->row = create_dbi_row (dbi_result->result);
-        return dbi_result->row;
+        return result_fetch_row (dbi_result, FALSE);
     }
     else
     {
@@ -2386,6 +2495,8 @@ static GncSqlResult*
 create_dbi_result (GncDbiSqlConnection* dbi_conn,  dbi_result result)
 {
     GncDbiSqlResult* dbi_result;
+    GncDbiSqlColumns* columns;
+    guint i;
 
     dbi_result = g_new0 (GncDbiSqlResult, 1);
     g_assert (dbi_result != NULL);
@@ -2399,15 +2510,90 @@ create_dbi_result (GncDbiSqlConnection* dbi_conn,  dbi_result result)
     dbi_result->cur_row = 0;
     dbi_result->dbi_conn = dbi_conn;
 
+    columns = &dbi_result->columns;
+    columns->num_fields = dbi_result_get_numfields (result);
+    if (columns->num_fields == DBI_FIELD_ERROR)
+        columns->num_fields = 0;
+    columns->index = g_hash_table_new (g_str_hash, g_str_equal);
+    columns->types = g_new (gushort, columns->num_fields);
+    columns->attribs = g_new (guint, columns->num_fields);
+    for (i = 0; i < columns->num_fields; i++)
+    {
+        const gchar* name = dbi_result_get_field_name (result, i + 1);
+
+        columns->types[i] = dbi_result_get_field_type_idx (result, i + 1);
+        columns->attribs[i] = dbi_result_get_field_attribs_idx (result, i + 1);
+        if (columns->types[i] == DBI_TYPE_DECIMAL)
+            columns->has_decimal = TRUE;
+        // As in libdbi, the first field of a name is the one found
+        if (name != NULL && g_hash_table_lookup (columns->index, name) == NULL)
+            g_hash_table_insert (columns->index, (gpointer)name,
+                                 GINT_TO_POINTER (i + 1));
+    }
+
     return (GncSqlResult*)dbi_result;
 }
 /* --------------------------------------------------------- */
+/* libdbi can't prepare statements on the server, so a statement template
+ * is only its SQL split at the '?' of each parameter.  Binding values
+ * rebuilds the SQL with them quoted in place, and the server parses it as
+ * it would any other statement.  A '?' inside a quoted string or
+ * identifier isn't a parameter. */
+typedef struct
+{
+    gchar** fragments;      // n_params + 1 pieces of SQL around the parameters
+    guint n_params;
+} GncDbiSqlTemplate;
+
+static GncDbiSqlTemplate*
+create_dbi_sql_template (const gchar* sql)
+{
+    GncDbiSqlTemplate* sql_template = g_new0 (GncDbiSqlTemplate, 1);
+    GPtrArray* fragments = g_ptr_array_new ();
+    const gchar* start = sql;
+    const gchar* p;
+    gchar quote = '\0';
+
+    for (p = sql; *p != '\0'; p++)
+    {
+        if (quote != '\0')
+        {
+            // A doubled quote closes and opens the string again
+            if (*p == quote) quote = '\0';
+        }
+        else if (*p == '\'' || *p == '"' || *p == '`')
+        {
+            quote = *p;
+        }
+        else if (*p == '?')
+        {
+            g_ptr_array_add (fragments, g_strndup (start, p - start));
+            start = p + 1;
+        }
+    }
+    g_ptr_array_add (fragments, g_strdup (start));
+    sql_template->n_params = fragments->len - 1;
+    g_ptr_array_add (fragments, NULL);
+    sql_template->fragments = (gchar**)g_ptr_array_free (fragments, FALSE);
+    return sql_template;
+}
+
+static void
+dispose_dbi_sql_template (gpointer data)
+{
+    GncDbiSqlTemplate* sql_template = (GncDbiSqlTemplate*)data;
+
+    g_strfreev (sql_template->fragments);
+    g_free (sql_template);
+}
+
 typedef struct
 {
     GncSqlStatement base;
 
     GString* sql;
     GncSqlConnection* conn;
+    const GncDbiSqlTemplate* sql_template;  // NULL if not from a template
 } GncDbiSqlStatement;
 
 static void
@@ -2446,6 +2632,39 @@ stmt_add_where_cond (GncSqlStatement* stmt,  QofIdTypeConst type_name,
     g_free (buf);
 }
 
+static gboolean
+stmt_bind_values (GncSqlStatement* stmt, GSList* values)
+{
+    GncDbiSqlStatement* dbi_stmt = (GncDbiSqlStatement*)stmt;
+    const GncDbiSqlTemplate* sql_template = dbi_stmt->sql_template;
+    GSList* node;
+    guint i;
+
+    if (sql_template == NULL)
+    {
+        PERR ("Can't bind values to a statement without a template: %s\n",
+              dbi_stmt->sql->str);
+        return FALSE;
+    }
+    if (g_slist_length (values) != sql_template->n_params)
+    {
+        PERR ("Mismatch in number of parameters and values: %s\n",
+              sql_template->fragments[0]);
+        return FALSE;
+    }
+
+    (void)g_string_assign (dbi_stmt->sql, sql_template->fragments[0]);
+    for (node = values, i = 1; node != NULL; node = node->next, i++)
+    {
+        gchar* value_str = gnc_sql_get_sql_value (dbi_stmt->conn,
+                                                  (GValue*)node->data);
+        (void)g_string_append (dbi_stmt->sql, value_str);
+        g_free (value_str);
+        (void)g_string_append (dbi_stmt->sql, sql_template->fragments[i]);
+    }
+    return TRUE;
+}
+
 static GncSqlStatement*
 create_dbi_statement (GncSqlConnection* conn, const gchar* sql)
 {
@@ -2457,6 +2676,7 @@ create_dbi_statement (GncSqlConnection* conn, const gchar* sql)
     stmt->base.dispose = stmt_dispose;
     stmt->base.toSql = stmt_to_sql;
     stmt->base.addWhereCond = stmt_add_where_cond;
+    stmt->base.bindValues = stmt_bind_values;
     stmt->sql = g_string_new (sql);
     stmt->conn = conn;
 
@@ -2466,8 +2686,9 @@ create_dbi_statement (GncSqlConnection* conn, const gchar* sql)
 static void
 conn_dispose (GncSqlConnection* conn)
 {
-    //GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
 
+    g_hash_table_destroy (dbi_conn->templates);
     g_free (conn);
 }
 
@@ -2535,6 +2756,39 @@ conn_create_statement_from_sql (GncSqlConnection* conn, const gchar* sql)
     return create_dbi_statement (conn, sql);
 }
 
+static GncSqlStatement*
+conn_get_statement_from_template (GncSqlConnection* conn, const gchar* key)
+{
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    GncDbiSqlTemplate* sql_template;
+    GncDbiSqlStatement* stmt;
+
+    g_return_val_if_fail (key != NULL, NULL);
+
+    sql_template = (GncDbiSqlTemplate*)g_hash_table_lookup (dbi_conn->templates,
+                                                            key);
+    if (sql_template == NULL) return NULL;
+
+    stmt = (GncDbiSqlStatement*)create_dbi_statement (conn, NULL);
+    stmt->sql_template = sql_template;
+    return (GncSqlStatement*)stmt;
+}
+
+static GncSqlStatement*
+conn_add_statement_template (GncSqlConnection* conn, const gchar* key,
+                             const gchar* sql)
+{
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+
+    g_return_val_if_fail (key != NULL, NULL);
+    g_return_val_if_fail (sql != NULL, NULL);
+
+    DEBUG ("Adding template %s: %s\n", key, sql);
+    g_hash_table_replace (dbi_conn->templates, g_strdup (key),
+                          create_dbi_sql_template (sql));
+    return conn_get_statement_from_template (conn, key);
+}
+
 static gboolean
 conn_does_table_exist (GncSqlConnection* conn, const gchar* table_name)
 {
@@ -2822,7 +3076,8 @@ append_mysql_col_def (GString* ddl, GncSqlColumnInfo* info)
     }
     else if (info->type == BCT_STRING)
     {
-        type_name = "varchar";
+        // A string without a size limit can be longer than a varchar
+        type_name = (info->size != 0) ? "varchar" : "mediumtext";
     }
     else if (info->type == BCT_DATE)
     {
@@ -2920,7 +3175,7 @@ append_pgsql_col_def (GString* ddl, GncSqlColumnInfo* info)
     }
     else if (info->type == BCT_STRING)
     {
-        type_name = "varchar";
+        type_name = (info->size != 0) ? "varchar" : "text";
     }
     else if (info->type == BCT_DATE)
     {
@@ -3308,10 +3563,14 @@ create_dbi_connection (provider_functions_t* provider,
     dbi_conn->base.createIndex = conn_create_index;
     dbi_conn->base.addColumnsToTable = conn_add_columns_to_table;
     dbi_conn->base.quoteString = conn_quote_string;
+    dbi_conn->base.getStatementFromTemplate = conn_get_statement_from_template;
+    dbi_conn->base.addStatementTemplate = conn_add_statement_template;
     dbi_conn->qbe = qbe;
     dbi_conn->conn = conn;
     dbi_conn->provider = provider;
     dbi_conn->conn_ok = TRUE;
+    dbi_conn->templates = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                 dispose_dbi_sql_template);
     gnc_dbi_init_error (dbi_conn);
 
     return (GncSqlConnection*)dbi_conn;
@@ -46,17 +46,20 @@ extern "C"
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "Query.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
 #include "gncInvoice.h"
     /* For version_control */
 #include <gnc-prefs.h>
+#include <gnc-features.h>
 }
 /* For test_conn_index_functions */
 #include "test-dbi-stuff.h"
 #include "test-dbi-business-stuff.h"
 #include "../gnc-backend-dbi-priv.h"
+#include "gnc-transaction-sql.h"
 
 #if LIBDBI_VERSION >= 900
 #define HAVE_LIBDBI_R 1
@@ -423,6 +426,343 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+/* Compare an account loaded as needed with the one saved: its balances,
+ * and the running balances and balance as of the date of each split
+ * loaded. */
+static void
+compare_account_loaded_as_needed (Account* acct_2, QofBook* book_3)
+{
+    auto acct_3 = xaccAccountLookup (qof_instance_get_guid (acct_2), book_3);
+    g_assert (acct_3 != NULL);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct_2),
+                                 xaccAccountGetBalance (acct_3)));
+    g_assert (gnc_numeric_equal (xaccAccountGetClearedBalance (acct_2),
+                                 xaccAccountGetClearedBalance (acct_3)));
+    g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct_2),
+                                 xaccAccountGetReconciledBalance (acct_3)));
+    for (auto node = xaccAccountGetSplitList (acct_3); node != NULL;
+         node = node->next)
+    {
+        auto split_3 = GNC_SPLIT (node->data);
+        auto split_2 = xaccSplitLookup (qof_instance_get_guid (split_3),
+                                        qof_instance_get_book (acct_2));
+        g_assert (split_2 != NULL);
+        g_assert (gnc_numeric_equal (xaccSplitGetBalance (split_2),
+                                     xaccSplitGetBalance (split_3)));
+        g_assert (gnc_numeric_equal (xaccSplitGetClearedBalance (split_2),
+                                     xaccSplitGetClearedBalance (split_3)));
+        g_assert (gnc_numeric_equal (xaccSplitGetReconciledBalance (split_2),
+                                     xaccSplitGetReconciledBalance (split_3)));
+        auto date = xaccTransGetDate (xaccSplitGetParent (split_3));
+        g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct_2, date),
+                                     xaccAccountGetBalanceAsOfDate (acct_3, date)));
+    }
+}
+
+/* Save a book, load it back with sql-load-as-needed set, and check that
+ * asking an account for its splits loads all of them, that the balances
+ * don't change as each account's transactions are queried,
+ * whole or from a day in the middle, and dropped again, and that loading
+ * everything gives back the same book. */
+static void
+test_dbi_load_as_needed (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    gnc_prefs_set_sql_load_as_needed (TRUE);
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    gnc_prefs_set_sql_load_as_needed (FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    auto be_3 = (GncSqlBackend*)qof_session_get_backend (session_3);
+    auto book_2 = qof_session_get_book (session_2);
+    auto book_3 = qof_session_get_book (session_3);
+    auto accounts = gnc_account_get_descendants (gnc_book_get_root_account (book_2));
+    // Asking an account for its splits loads all of them
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        auto acct_2 = GNC_ACCOUNT (node->data);
+        auto acct_3 = xaccAccountLookup (qof_instance_get_guid (acct_2), book_3);
+        g_assert_cmpint (xaccAccountCountSplits (acct_3, FALSE), == ,
+                         xaccAccountCountSplits (acct_2, FALSE));
+    }
+    for (auto node = accounts; node != NULL; node = node->next)
+        compare_account_loaded_as_needed (GNC_ACCOUNT (node->data), book_3);
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        auto acct_2 = GNC_ACCOUNT (node->data);
+        auto acct_3 = xaccAccountLookup (qof_instance_get_guid (acct_2), book_3);
+        auto splits_2 = xaccAccountGetSplitList (acct_2);
+
+        // A day in the middle loads the splits after it too
+        if (splits_2 != NULL)
+        {
+            auto middle = g_list_nth_data (splits_2, g_list_length (splits_2) / 2);
+            auto date = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT (middle)));
+            auto query = qof_query_create_for (GNC_ID_SPLIT);
+            qof_query_set_book (query, book_3);
+            xaccQueryAddSingleAccountMatch (query, acct_3, QOF_QUERY_AND);
+            xaccQueryAddDateMatchTT (query, TRUE, date, TRUE, date, QOF_QUERY_AND);
+            qof_query_run (query);
+            g_assert (xaccSplitLookup (qof_instance_get_guid (middle), book_3) != NULL);
+            compare_account_loaded_as_needed (acct_2, book_3);
+            qof_query_destroy (query);
+            gnc_sql_transaction_cache_evict (be_3, 0);
+            compare_account_loaded_as_needed (acct_2, book_3);
+        }
+
+        auto query = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (query, book_3);
+        xaccQueryAddSingleAccountMatch (query, acct_3, QOF_QUERY_AND);
+        qof_query_run (query);
+        // The query's results stay while it lives
+        gnc_sql_transaction_cache_evict (be_3, 0);
+        g_assert_cmpint (g_list_length (xaccAccountGetSplitList (acct_3)), == ,
+                         g_list_length (splits_2));
+        compare_account_loaded_as_needed (acct_2, book_3);
+        qof_query_destroy (query);
+        gnc_sql_transaction_cache_evict (be_3, 0);
+        compare_account_loaded_as_needed (acct_2, book_3);
+
+        // Only the latest splits are loaded for a query limited to them
+        auto last_2 = g_list_last (splits_2);
+        if (last_2 == NULL) continue;
+        query = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (query, book_3);
+        xaccQueryAddSingleAccountMatch (query, acct_3, QOF_QUERY_AND);
+        qof_query_set_max_results (query, 1);
+        auto results = qof_query_run (query);
+        g_assert_cmpint (g_list_length (results), == , 1);
+        g_assert (guid_equal (qof_instance_get_guid (results->data),
+                              qof_instance_get_guid (last_2->data)));
+        qof_query_destroy (query);
+        compare_account_loaded_as_needed (acct_2, book_3);
+    }
+    for (auto node = accounts; node != NULL; node = node->next)
+        compare_account_loaded_as_needed (GNC_ACCOUNT (node->data), book_3);
+    g_list_free (accounts);
+
+    qof_session_ensure_all_data_loaded (session_3);
+    compare_books (book_2, book_3);
+
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Save a book, load it back, edit a transaction and some of its fields
+ * and slots, and an account's slots, and check that a fresh load has the
+ * edits, which are saved by updating only the changed columns and slots. */
+static void
+test_dbi_edit_and_reload (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+    QofSession* session_4;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_2);
+
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    auto book_3 = qof_session_get_book (session_3);
+    auto accounts = gnc_account_get_descendants (gnc_book_get_root_account (book_3));
+    Split* split = NULL;
+    for (auto node = accounts; node != NULL && split == NULL; node = node->next)
+    {
+        auto splits = xaccAccountGetSplitList (GNC_ACCOUNT (node->data));
+        if (splits != NULL)
+            split = GNC_SPLIT (splits->data);
+    }
+    g_list_free (accounts);
+    g_assert (split != NULL);
+
+    auto tx = xaccSplitGetParent (split);
+    xaccTransBeginEdit (tx);
+    xaccTransSetDescription (tx, "Edited description");
+    xaccTransSetNotes (tx, "Edited notes");
+    xaccSplitSetMemo (split, "Edited memo");
+    xaccSplitSetReconcile (split, CREC);
+    xaccSplitSetDateReconciledSecs (split, gnc_time (NULL));
+    xaccTransCommitEdit (tx);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    xaccTransBeginEdit (tx);
+    xaccTransSetNotes (tx, "Edited notes again");
+    xaccSplitSetAction (split, "Edited action");
+    xaccTransCommitEdit (tx);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    // Committing any object leaves its slots with no changes to save
+    auto acct = xaccSplitGetAccount (split);
+    xaccAccountBeginEdit (acct);
+    xaccAccountSetNotes (acct, "Edited account notes");
+    g_assert (qof_instance_get_slots (QOF_INSTANCE (acct))->is_changed ());
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    g_assert (!qof_instance_get_slots (QOF_INSTANCE (acct))->is_changed ());
+
+    session_4 = qof_session_new ();
+    qof_session_begin (session_4, url, TRUE, FALSE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    compare_books (book_3, qof_session_get_book (session_4));
+
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+}
+
+static gboolean
+book_uses_slot_blobs (QofBook* book)
+{
+    auto features = qof_book_get_features (book);
+    auto found = g_hash_table_contains (features, GNC_FEATURE_SQL_SLOT_BLOBS);
+    g_hash_table_unref (features);
+    return found;
+}
+
+/* Save a book with its slots in rows, check that opening it doesn't change
+ * their storage, convert them to blobs by saving it again with the
+ * sql-slot-blobs preference set, and check that the book loads the same
+ * from the blobs, also after an edit, and after saving it back in rows. */
+static void
+test_dbi_slot_blobs (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+    QofSession* session_4;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    g_assert (!book_uses_slot_blobs (qof_session_get_book (session_2)));
+    qof_session_end (session_2);
+
+    // Opening the db leaves its slots alone, whatever the preference
+    gnc_prefs_set_sql_slot_blobs (TRUE);
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    auto book_3 = qof_session_get_book (session_3);
+    g_assert (!book_uses_slot_blobs (book_3));
+
+    // Saving the book again converts them
+    qof_session_safe_save (session_3, NULL);
+    gnc_prefs_set_sql_slot_blobs (FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    g_assert (book_uses_slot_blobs (book_3));
+    compare_books (qof_session_get_book (session_2), book_3);
+
+    // Edit some slots, which are now saved in blobs
+    auto accounts = gnc_account_get_descendants (gnc_book_get_root_account (book_3));
+    Split* split = NULL;
+    for (auto node = accounts; node != NULL && split == NULL; node = node->next)
+    {
+        auto splits = xaccAccountGetSplitList (GNC_ACCOUNT (node->data));
+        if (splits != NULL)
+            split = GNC_SPLIT (splits->data);
+    }
+    g_list_free (accounts);
+    g_assert (split != NULL);
+    auto tx = xaccSplitGetParent (split);
+    xaccTransBeginEdit (tx);
+    xaccTransSetNotes (tx, "Notes in a blob");
+    xaccTransCommitEdit (tx);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+
+    session_4 = qof_session_new ();
+    qof_session_begin (session_4, url, TRUE, FALSE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    g_assert (book_uses_slot_blobs (qof_session_get_book (session_4)));
+    compare_books (book_3, qof_session_get_book (session_4));
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+
+    // Saving it with the preference off converts them back to rows
+    qof_session_safe_save (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    g_assert (!book_uses_slot_blobs (book_3));
+
+    session_4 = qof_session_new ();
+    qof_session_begin (session_4, url, TRUE, FALSE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_4, NULL);
+    g_assert_cmpint (qof_session_get_error (session_4), == , ERR_BACKEND_NO_ERR);
+    g_assert (!book_uses_slot_blobs (qof_session_get_book (session_4)));
+    compare_books (book_3, qof_session_get_book (session_4));
+
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+    qof_session_end (session_4);
+    qof_session_destroy (session_4);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -649,6 +989,12 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
     auto subsuite = g_strdup_printf ("%s/%s", suitename, dbm_name);
     GNC_TEST_ADD (subsuite, "store_and_reload", Fixture, url, setup,
                   test_dbi_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "load_as_needed", Fixture, url, setup,
+                  test_dbi_load_as_needed, teardown);
+    GNC_TEST_ADD (subsuite, "edit_and_reload", Fixture, url, setup,
+                  test_dbi_edit_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "slot_blobs", Fixture, url, setup,
+                  test_dbi_slot_blobs, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
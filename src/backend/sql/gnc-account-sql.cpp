@@ -290,8 +290,11 @@ load_all_accounts (GncSqlBackend* be)
             }
         }
 
-        /* Load starting balances */
-        bal_slist = gnc_sql_get_account_balances_slist (be);
+        /* Load starting balances, which stand in for the splits of the
+         * transactions which haven't been loaded */
+        bal_slist = NULL;
+        if (be->tx_cache != NULL)
+            bal_slist = gnc_sql_get_account_balances_slist (be);
         for (bal = bal_slist; bal != NULL; bal = bal->next)
         {
             acct_balances_t* balances = (acct_balances_t*)bal->data;
@@ -403,9 +406,11 @@ gnc_sql_save_account (GncSqlBackend* be, QofInstance* inst)
 static void
 load_account_guid (const GncSqlBackend* be, GncSqlRow* row,
                    QofSetterFunc setter, gpointer pObject,
-                   const GncSqlColumnTableEntry* table_row)
+                   const GncSqlColumnTableEntry* table_row,
+                   const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     Account* account = NULL;
 
@@ -414,11 +419,11 @@ load_account_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        (void)string_to_guid (g_value_get_string (val), &guid);
+        (void)string_to_guid (guid_str, &guid);
         account = xaccAccountLookup (&guid, be->book);
         if (account != NULL)
         {
@@ -436,7 +441,7 @@ load_account_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Account ref '%s' not found", g_value_get_string (val));
+            PWARN ("Account ref '%s' not found", guid_str);
         }
     }
 }
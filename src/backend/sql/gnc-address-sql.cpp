@@ -70,10 +70,9 @@ typedef GncAddress* (*AddressGetterFunc) (const gpointer);
 static void
 load_address (const GncSqlBackend* be, GncSqlRow* row,
               QofSetterFunc setter, gpointer pObject,
-              const GncSqlColumnTableEntry* table_row)
+              const GncSqlColumnTableEntry* table_row,
+              const gint* cols)
 {
-    const GValue* val;
-    gchar* buf;
     GncAddress* addr;
     AddressSetterFunc a_setter = (AddressSetterFunc)setter;
     const GncSqlColumnTableEntry* subtable;
@@ -85,19 +84,10 @@ load_address (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
 
     addr = gncAddressCreate (be->book, QOF_INSTANCE(pObject));
-    for (subtable = col_table; subtable->col_name != NULL; subtable++)
+    // The columns are in col_table order
+    for (subtable = col_table; subtable->col_name != NULL; subtable++, cols++)
     {
-        buf = g_strdup_printf ("%s_%s", table_row->col_name, subtable->col_name);
-        val = gnc_sql_row_get_value_at_col_name (row, buf);
-        g_free (buf);
-        if (val == NULL)
-        {
-            s = NULL;
-        }
-        else
-        {
-            s = g_value_get_string (val);
-        }
+        s = gnc_sql_row_get_string_at_col (row, *cols);
         if (subtable->gobj_param_name != NULL)
         {
             g_object_set (addr, subtable->gobj_param_name, s, NULL);
@@ -80,11 +80,18 @@ extern "C"
 #include "gnc-tax-table-sql.h"
 #include "gnc-vendor-sql.h"
 
+#include <kvp_frame.hpp>
+
 static void gnc_sql_init_object_handlers (void);
 static void update_progress (GncSqlBackend* be);
 static void finish_progress (GncSqlBackend* be);
 static void register_standard_col_type_handlers (void);
 static gboolean reset_version_info (GncSqlBackend* be);
+static gboolean flush_insert_batch (GncSqlBackend* be, const gchar* table_name);
+static gboolean flush_insert_batches (GncSqlBackend* be);
+static gboolean queue_insert (GncSqlBackend* be, const gchar* table_name,
+                              QofIdTypeConst obj_name, gpointer pObject,
+                              const GncSqlColumnTableEntry* table);
 static GncSqlStatement* build_insert_statement (GncSqlBackend* be,
                                                 const gchar* table_name,
                                                 QofIdTypeConst obj_name, gpointer pObject,
@@ -236,6 +243,9 @@ gnc_sql_load (GncSqlBackend* be,  QofBook* book, QofBackendLoadType loadType)
         g_assert (be->book == NULL);
         be->book = book;
 
+        // Decide whether transactions are loaded now or as queries need them
+        gnc_sql_transaction_cache_init (be);
+
         /* Load any initial stuff. Some of this needs to happen in a certain order */
         for (i = 0; fixed_load_order[i] != NULL; i++)
         {
@@ -461,6 +471,9 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
 
     /* Save all contents */
     be->book = book;
+    gnc_sql_slots_init_storage (be, book);
+    /* Writing the whole book is where its slots change storage */
+    gnc_sql_slots_set_storage (be, gnc_prefs_get_sql_slot_blobs ());
     be->obj_total = 0;
     be->obj_total += 1 + gnc_account_n_descendants (gnc_book_get_root_account (
                                                         book));
@@ -468,6 +481,7 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
     be->operations_done = 0;
 
     is_ok = gnc_sql_connection_begin_transaction (be->conn);
+    gnc_sql_begin_insert_batch (be);
 
     // FIXME: should write the set of commodities that are used
     //write_commodities( be, book );
@@ -495,6 +509,10 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
     {
         qof_object_foreach_backend (GNC_SQL_BACKEND, write_cb, be);
     }
+    if (!gnc_sql_end_insert_batch (be))
+    {
+        is_ok = FALSE;
+    }
     if (is_ok)
     {
         is_ok = gnc_sql_connection_commit_transaction (be->conn);
@@ -652,6 +670,10 @@ gnc_sql_commit_edit (GncSqlBackend* be, QofInstance* inst)
 
     qof_book_mark_session_saved (be->book);
     qof_instance_mark_clean (inst);
+    // The db has the slots now, so the next commit starts from no changes
+    auto frame = qof_instance_get_slots (inst);
+    if (frame != NULL && !is_destroying)
+        frame->clear_changed ();
 
     LEAVE ("");
 }
@@ -937,7 +959,7 @@ free_query_cb (const gchar* type, gpointer data_p, gpointer be_data_p)
 
     if (pData->free_query != NULL)
     {
-        (pData->free_query) (be_data->be, be_data->pCompiledQuery);
+        (pData->free_query) (be_data->be, be_data->pQueryInfo->pCompiledQuery);
         be_data->is_ok = TRUE;
     }
 }
@@ -963,6 +985,7 @@ gnc_sql_free_query (QofBackend* pBEnd, gpointer pQuery)
     qof_object_foreach_backend (GNC_SQL_BACKEND, free_query_cb, &be_data);
     if (be_data.is_ok)
     {
+        g_free (pQueryInfo);
         LEAVE ("");
         return;
     }
@@ -1003,6 +1026,7 @@ gnc_sql_run_query (QofBackend* pBEnd, gpointer pQuery)
     GncSqlBackend* be = (GncSqlBackend*)pBEnd;
     gnc_sql_query_info* pQueryInfo = (gnc_sql_query_info*)pQuery;
     sql_backend be_data;
+    gboolean was_loading;
 
     g_return_if_fail (pBEnd != NULL);
     g_return_if_fail (pQuery != NULL);
@@ -1010,6 +1034,7 @@ gnc_sql_run_query (QofBackend* pBEnd, gpointer pQuery)
 
     ENTER (" ");
 
+    was_loading = be->loading;
     be->loading = TRUE;
     be->in_query = TRUE;
 
@@ -1022,9 +1047,13 @@ gnc_sql_run_query (QofBackend* pBEnd, gpointer pQuery)
     be_data.pQueryInfo = pQueryInfo;
 
     qof_object_foreach_backend (GNC_SQL_BACKEND, run_query_cb, &be_data);
-    be->loading = FALSE;
+    be->loading = was_loading;
     be->in_query = FALSE;
     qof_event_resume ();
+
+    // Make room for what the query loaded once the caller is done with
+    // the results
+    gnc_sql_transaction_cache_evict_when_idle (be);
 //    if( be_data.is_ok ) {
 //        LEAVE( "" );
 //        return;
@@ -1038,6 +1067,14 @@ gnc_sql_run_query (QofBackend* pBEnd, gpointer pQuery)
     LEAVE ("");
 }
 
+void
+gnc_sql_load_related (QofBackend* pBEnd, QofInstance* inst)
+{
+    g_return_if_fail (pBEnd != NULL);
+
+    gnc_sql_transaction_load_related ((GncSqlBackend*)pBEnd, inst);
+}
+
 /* ================================================================= */
 /* Order in which business objects need to be loaded */
 static const gchar* business_fixed_load_order[] =
@@ -1123,6 +1160,31 @@ gnc_sql_get_integer_value (const GValue* value)
     return 0;
 }
 
+gint64
+gnc_sql_row_get_integer (GncSqlRow* row, gint col)
+{
+    GType type;
+
+    g_return_val_if_fail (row != NULL, 0);
+
+    type = gnc_sql_row_get_col_type (row, col);
+    if (type == G_TYPE_INT64)
+    {
+        return gnc_sql_row_get_int64_at_col (row, col);
+    }
+    else if (type == G_TYPE_STRING)
+    {
+        const gchar* s = gnc_sql_row_get_string_at_col (row, col);
+        return (s != NULL) ? g_ascii_strtoll (s, NULL, 10) : 0;
+    }
+    else if (type != G_TYPE_INVALID)
+    {
+        PWARN ("Unknown type: %s", g_type_name (type));
+    }
+
+    return 0;
+}
+
 /* ----------------------------------------------------------------- */
 static gpointer
 get_autoinc_id (void* object, const QofParam* param)
@@ -1211,9 +1273,10 @@ create_column_info (const GncSqlColumnTableEntry* table_row,
 static void
 load_string (const GncSqlBackend* be, GncSqlRow* row,
              QofSetterFunc setter, gpointer pObject,
-             const GncSqlColumnTableEntry* table_row)
+             const GncSqlColumnTableEntry* table_row,
+             const gint* cols)
 {
-    const GValue* val;
+    gint col;
     const gchar* s;
 
     g_return_if_fail (be != NULL);
@@ -1222,9 +1285,9 @@ load_string (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    g_return_if_fail (val != NULL);
-    s = g_value_get_string (val);
+    col = cols[0];
+    g_return_if_fail (col >= 0);
+    s = gnc_sql_row_get_string_at_col (row, col);
     if (table_row->gobj_param_name != NULL)
     {
         if (QOF_IS_INSTANCE (pObject))
@@ -1314,9 +1377,10 @@ typedef void (*IntSetterFunc) (const gpointer, gint);
 static void
 load_int (const GncSqlBackend* be, GncSqlRow* row,
           QofSetterFunc setter, gpointer pObject,
-          const GncSqlColumnTableEntry* table_row)
+          const GncSqlColumnTableEntry* table_row,
+          const gint* cols)
 {
-    const GValue* val;
+    gint col;
     gint int_value;
     IntSetterFunc i_setter;
 
@@ -1326,15 +1390,8 @@ load_int (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val == NULL)
-    {
-        int_value = 0;
-    }
-    else
-    {
-        int_value = (gint)gnc_sql_get_integer_value (val);
-    }
+    col = cols[0];
+    int_value = (gint)gnc_sql_row_get_integer (row, col);
     if (table_row->gobj_param_name != NULL)
     {
         if (QOF_IS_INSTANCE (pObject))
@@ -1419,9 +1476,10 @@ typedef void (*BooleanSetterFunc) (const gpointer, gboolean);
 static void
 load_boolean (const GncSqlBackend* be, GncSqlRow* row,
               QofSetterFunc setter, gpointer pObject,
-              const GncSqlColumnTableEntry* table_row)
+              const GncSqlColumnTableEntry* table_row,
+              const gint* cols)
 {
-    const GValue* val;
+    gint col;
     gint int_value;
     BooleanSetterFunc b_setter;
 
@@ -1431,15 +1489,8 @@ load_boolean (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val == NULL)
-    {
-        int_value = 0;
-    }
-    else
-    {
-        int_value = (gint)gnc_sql_get_integer_value (val);
-    }
+    col = cols[0];
+    int_value = (gint)gnc_sql_row_get_integer (row, col);
     if (table_row->gobj_param_name != NULL)
     {
         if (QOF_IS_INSTANCE (pObject))
@@ -1523,10 +1574,11 @@ typedef void (*Int64SetterFunc) (const gpointer, gint64);
 static void
 load_int64 (const GncSqlBackend* be, GncSqlRow* row,
             QofSetterFunc setter, gpointer pObject,
-            const GncSqlColumnTableEntry* table_row)
+            const GncSqlColumnTableEntry* table_row,
+            const gint* cols)
 {
-    const GValue* val;
-    gint64 i64_value = 0;
+    gint col;
+    gint64 i64_value;
     Int64SetterFunc i64_setter = (Int64SetterFunc)setter;
 
     g_return_if_fail (be != NULL);
@@ -1534,11 +1586,8 @@ load_int64 (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL)
-    {
-        i64_value = gnc_sql_get_integer_value (val);
-    }
+    col = cols[0];
+    i64_value = gnc_sql_row_get_integer (row, col);
     if (table_row->gobj_param_name != NULL)
     {
         if (QOF_IS_INSTANCE (pObject))
@@ -1617,9 +1666,11 @@ static GncSqlColumnTypeHandler int64_handler
 static void
 load_double (const GncSqlBackend* be, GncSqlRow* row,
              QofSetterFunc setter, gpointer pObject,
-             const GncSqlColumnTableEntry* table_row)
+             const GncSqlColumnTableEntry* table_row,
+             const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    GType type;
     gdouble d_value;
 
     g_return_if_fail (be != NULL);
@@ -1628,28 +1679,21 @@ load_double (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val == NULL)
+    col = cols[0];
+    type = gnc_sql_row_get_col_type (row, col);
+    if (type == G_TYPE_INVALID)
     {
         (*setter) (pObject, (gpointer)NULL);
     }
     else
     {
-        if (G_VALUE_HOLDS (val, G_TYPE_INT))
+        if (type == G_TYPE_DOUBLE || type == G_TYPE_INT64)
         {
-            d_value = (gdouble)g_value_get_int (val);
-        }
-        else if (G_VALUE_HOLDS (val, G_TYPE_FLOAT))
-        {
-            d_value = g_value_get_float (val);
-        }
-        else if (G_VALUE_HOLDS (val, G_TYPE_DOUBLE))
-        {
-            d_value = g_value_get_double (val);
+            d_value = gnc_sql_row_get_double_at_col (row, col);
         }
         else
         {
-            PWARN ("Unknown float value type: %s\n", g_type_name (G_VALUE_TYPE (val)));
+            PWARN ("Unknown float value type: %s\n", g_type_name (type));
             d_value = 0;
         }
         if (table_row->gobj_param_name != NULL)
@@ -1733,9 +1777,11 @@ static GncSqlColumnTypeHandler double_handler
 static void
 load_guid (const GncSqlBackend* be, GncSqlRow* row,
            QofSetterFunc setter, gpointer pObject,
-           const GncSqlColumnTableEntry* table_row)
+           const GncSqlColumnTableEntry* table_row,
+           const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* s;
     GncGUID guid;
     const GncGUID* pGuid;
 
@@ -1745,14 +1791,15 @@ load_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val == NULL || g_value_get_string (val) == NULL)
+    col = cols[0];
+    s = gnc_sql_row_get_string_at_col (row, col);
+    if (s == NULL)
     {
         pGuid = NULL;
     }
     else
     {
-        (void)string_to_guid (g_value_get_string (val), &guid);
+        (void)string_to_guid (s, &guid);
         pGuid = &guid;
     }
     if (pGuid != NULL)
@@ -1926,9 +1973,11 @@ gnc_sql_convert_timespec_to_string (const GncSqlBackend* be, Timespec ts)
 static void
 load_timespec (const GncSqlBackend* be, GncSqlRow* row,
                QofSetterFunc setter, gpointer pObject,
-               const GncSqlColumnTableEntry* table_row)
+               const GncSqlColumnTableEntry* table_row,
+               const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    GType type;
     Timespec ts = {0, 0};
     TimespecSetterFunc ts_setter;
     gboolean isOK = FALSE;
@@ -1940,39 +1989,39 @@ load_timespec (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
     ts_setter = (TimespecSetterFunc)setter;
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val == NULL)
+    col = cols[0];
+    type = gnc_sql_row_get_col_type (row, col);
+    if (type == G_TYPE_INVALID)
     {
         isOK = TRUE;
     }
     else
     {
-        if (G_VALUE_HOLDS_INT64 (val))
+        if (type == G_TYPE_INT64)
         {
-            timespecFromTime64 (&ts, (time64) (g_value_get_int64 (val)));
+            timespecFromTime64 (&ts, gnc_sql_row_get_int64_at_col (row, col));
             isOK = TRUE;
         }
-        else if (G_VALUE_HOLDS_STRING (val))
+        else if (type == G_TYPE_STRING)
         {
-            const gchar* s = g_value_get_string (val);
+            const gchar* s = gnc_sql_row_get_string_at_col (row, col);
             if (s != NULL)
             {
-                gchar* buf;
-                buf = g_strdup_printf ("%c%c%c%c-%c%c-%c%c %c%c:%c%c:%c%c",
-                                       s[0], s[1], s[2], s[3],
-                                       s[4], s[5],
-                                       s[6], s[7],
-                                       s[8], s[9],
-                                       s[10], s[11],
-                                       s[12], s[13]);
+                gchar buf[20];
+                g_snprintf (buf, sizeof (buf), "%c%c%c%c-%c%c-%c%c %c%c:%c%c:%c%c",
+                            s[0], s[1], s[2], s[3],
+                            s[4], s[5],
+                            s[6], s[7],
+                            s[8], s[9],
+                            s[10], s[11],
+                            s[12], s[13]);
                 ts = gnc_iso8601_to_timespec_gmt (buf);
-                g_free (buf);
                 isOK = TRUE;
             }
         }
         else
         {
-            PWARN ("Unknown timespec type: %s", G_VALUE_TYPE_NAME (val));
+            PWARN ("Unknown timespec type: %s", g_type_name (type));
         }
     }
     if (isOK)
@@ -2063,9 +2112,11 @@ static GncSqlColumnTypeHandler timespec_handler
 static void
 load_date (const GncSqlBackend* be, GncSqlRow* row,
            QofSetterFunc setter, gpointer pObject,
-           const GncSqlColumnTableEntry* table_row)
+           const GncSqlColumnTableEntry* table_row,
+           const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    GType type;
 
     g_return_if_fail (be != NULL);
     g_return_if_fail (row != NULL);
@@ -2073,15 +2124,16 @@ load_date (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL)
+    col = cols[0];
+    type = gnc_sql_row_get_col_type (row, col);
+    if (type != G_TYPE_INVALID)
     {
-        if (G_VALUE_HOLDS_INT64 (val))
+        if (type == G_TYPE_INT64)
         {
             /* timespec_to_gdate applies the tz, and gdates are saved
              * as ymd, so we don't want that.
              */
-            auto time = g_value_get_int64 (val);
+            auto time = gnc_sql_row_get_int64_at_col (row, col);
             auto tm = gnc_gmtime(&time);
 
             GDate date;
@@ -2103,10 +2155,10 @@ load_date (const GncSqlBackend* be, GncSqlRow* row,
                 (*setter) (pObject, &date);
             }
         }
-        else if (G_VALUE_HOLDS_STRING (val))
+        else if (type == G_TYPE_STRING)
         {
             // Format of date is YYYYMMDD
-            const gchar* s = g_value_get_string (val);
+            const gchar* s = gnc_sql_row_get_string_at_col (row, col);
             GDate* date;
             if (s != NULL)
             {
@@ -2146,7 +2198,7 @@ load_date (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Unknown date type: %s", G_VALUE_TYPE_NAME (val));
+            PWARN ("Unknown date type: %s", g_type_name (type));
         }
     }
 }
@@ -2229,10 +2281,9 @@ static const GncSqlColumnTableEntry numeric_col_table[] =
 static void
 load_numeric (const GncSqlBackend* be, GncSqlRow* row,
               QofSetterFunc setter, gpointer pObject,
-              const GncSqlColumnTableEntry* table_row)
+              const GncSqlColumnTableEntry* table_row,
+              const gint* cols)
 {
-    const GValue* val;
-    gchar* buf;
     gint64 num, denom;
     gnc_numeric n;
     gboolean isNull = FALSE;
@@ -2243,29 +2294,24 @@ load_numeric (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
     g_return_if_fail (table_row->gobj_param_name != NULL || setter != NULL);
 
-    buf = g_strdup_printf ("%s_num", table_row->col_name);
-    val = gnc_sql_row_get_value_at_col_name (row, buf);
-    g_free (buf);
-    if (val == NULL)
+    // The columns are in numeric_col_table order
+    if (gnc_sql_row_get_col_type (row, cols[0]) == G_TYPE_INVALID)
     {
         isNull = TRUE;
         num = 0;
     }
     else
     {
-        num = gnc_sql_get_integer_value (val);
+        num = gnc_sql_row_get_integer (row, cols[0]);
     }
-    buf = g_strdup_printf ("%s_denom", table_row->col_name);
-    val = gnc_sql_row_get_value_at_col_name (row, buf);
-    g_free (buf);
-    if (val == NULL)
+    if (gnc_sql_row_get_col_type (row, cols[1]) == G_TYPE_INVALID)
     {
         isNull = TRUE;
         denom = 1;
     }
     else
     {
-        denom = gnc_sql_get_integer_value (val);
+        denom = gnc_sql_row_get_integer (row, cols[1]);
     }
     n = gnc_numeric_create (num, denom);
     if (!isNull)
@@ -2485,6 +2531,76 @@ gnc_sql_load_tx_guid (const GncSqlBackend* be, GncSqlRow* row)
     return &guid;
 }
 
+/* The indexes in a result of the columns of a table description */
+typedef struct
+{
+    const GncSqlColumnTableEntry* table;
+    gint* cols;         /* All of the columns, entry after entry */
+    guint* entry_cols;  /* Where each entry's columns start in cols */
+} GncSqlColumnMap;
+
+static GncSqlColumnMap*
+get_col_map (GncSqlRow* row, const GncSqlColumnTableEntry* table)
+{
+    GncSqlColumnMap* map;
+    const GncSqlColumnTableEntry* table_row;
+    GArray* cols;
+    guint num_entries = 0;
+    guint entry;
+
+    for (GSList* node = row->col_maps; node != NULL; node = node->next)
+    {
+        map = static_cast<GncSqlColumnMap*> (node->data);
+        if (map->table == table)
+            return map;
+    }
+
+    for (table_row = table; table_row->col_name != NULL; table_row++)
+        num_entries++;
+    map = g_new0 (GncSqlColumnMap, 1);
+    map->table = table;
+    map->entry_cols = g_new (guint, num_entries);
+    cols = g_array_new (FALSE, FALSE, sizeof (gint));
+    for (table_row = table, entry = 0; table_row->col_name != NULL;
+         table_row++, entry++)
+    {
+        GList* colnames = NULL;
+        GncSqlColumnTypeHandler* pHandler = get_handler (table_row);
+        g_assert (pHandler != NULL);
+
+        map->entry_cols[entry] = cols->len;
+        pHandler->add_colname_to_list_fn (table_row, &colnames);
+        for (GList* node = colnames; node != NULL; node = node->next)
+        {
+            gint col = gnc_sql_row_get_col_index (row, (gchar*)node->data);
+            g_array_append_val (cols, col);
+        }
+        g_list_free_full (colnames, g_free);
+    }
+    map->cols = (gint*)g_array_free (cols, FALSE);
+    row->col_maps = g_slist_prepend (row->col_maps, map);
+    return map;
+}
+
+static void
+free_col_map (gpointer data)
+{
+    GncSqlColumnMap* map = static_cast<GncSqlColumnMap*> (data);
+
+    g_free (map->cols);
+    g_free (map->entry_cols);
+    g_free (map);
+}
+
+void
+gnc_sql_row_free_col_maps (GncSqlRow* row)
+{
+    g_return_if_fail (row != NULL);
+
+    g_slist_free_full (row->col_maps, free_col_map);
+    row->col_maps = NULL;
+}
+
 void
 gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
                      QofIdTypeConst obj_name, gpointer pObject,
@@ -2493,13 +2609,17 @@ gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
     QofSetterFunc setter;
     GncSqlColumnTypeHandler* pHandler;
     const GncSqlColumnTableEntry* table_row;
+    GncSqlColumnMap* map;
+    guint entry;
 
     g_return_if_fail (be != NULL);
     g_return_if_fail (row != NULL);
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table != NULL);
 
-    for (table_row = table; table_row->col_name != NULL; table_row++)
+    map = get_col_map (row, table);
+    for (table_row = table, entry = 0; table_row->col_name != NULL;
+         table_row++, entry++)
     {
         if ((table_row->flags & COL_AUTOINC) != 0)
         {
@@ -2517,7 +2637,8 @@ gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
         }
         pHandler = get_handler (table_row);
         g_assert (pHandler != NULL);
-        pHandler->load_fn (be, row, setter, pObject, table_row);
+        pHandler->load_fn (be, row, setter, pObject, table_row,
+                           &map->cols[map->entry_cols[entry]]);
     }
 }
 
@@ -2557,14 +2678,11 @@ create_single_col_select_statement (GncSqlBackend* be,
 
 /* ================================================================= */
 
-GncSqlResult*
-gnc_sql_execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
+static GncSqlResult*
+execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
 {
     GncSqlResult* result;
 
-    g_return_val_if_fail (be != NULL, NULL);
-    g_return_val_if_fail (stmt != NULL, NULL);
-
     result = gnc_sql_connection_execute_select_statement (be->conn, stmt);
     if (result == NULL)
     {
@@ -2575,6 +2693,16 @@ gnc_sql_execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
     return result;
 }
 
+GncSqlResult*
+gnc_sql_execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
+{
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (stmt != NULL, NULL);
+
+    (void)flush_insert_batches (be);
+    return execute_select_statement (be, stmt);
+}
+
 GncSqlStatement*
 gnc_sql_create_statement_from_sql (GncSqlBackend* be, const gchar* sql)
 {
@@ -2602,6 +2730,7 @@ gnc_sql_execute_select_sql (GncSqlBackend* be, const gchar* sql)
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (sql != NULL, NULL);
 
+    (void)flush_insert_batches (be);
     stmt = gnc_sql_create_statement_from_sql (be, sql);
     if (stmt == NULL)
     {
@@ -2627,6 +2756,7 @@ gnc_sql_execute_nonselect_sql (GncSqlBackend* be, const gchar* sql)
     g_return_val_if_fail (be != NULL, 0);
     g_return_val_if_fail (sql != NULL, 0);
 
+    (void)flush_insert_batches (be);
     stmt = gnc_sql_create_statement_from_sql (be, sql);
     if (stmt == NULL)
     {
@@ -2646,7 +2776,7 @@ execute_statement_get_count (GncSqlBackend* be, GncSqlStatement* stmt)
     g_return_val_if_fail (be != NULL, 0);
     g_return_val_if_fail (stmt != NULL, 0);
 
-    result = gnc_sql_execute_select_statement (be, stmt);
+    result = execute_select_statement (be, stmt);
     if (result != NULL)
     {
         count = gnc_sql_result_get_num_rows (result);
@@ -2702,6 +2832,8 @@ gnc_sql_object_is_it_in_db (GncSqlBackend* be, const gchar* table_name,
     g_return_val_if_fail (pObject != NULL, FALSE);
     g_return_val_if_fail (table != NULL, FALSE);
 
+    (void)flush_insert_batch (be, table_name);
+
     /* SELECT * FROM */
     sqlStmt = create_single_col_select_statement (be, table_name, table);
     g_assert (sqlStmt != NULL);
@@ -2742,6 +2874,15 @@ gnc_sql_do_db_operation (GncSqlBackend* be,
     g_return_val_if_fail (pObject != NULL, FALSE);
     g_return_val_if_fail (table != NULL, FALSE);
 
+    if (op == OP_DB_INSERT && be->insert_batch_depth > 0)
+    {
+        return queue_insert (be, table_name, obj_name, pObject, table);
+    }
+    if (!flush_insert_batch (be, table_name))
+    {
+        return FALSE;
+    }
+
     if (op == OP_DB_INSERT)
     {
         stmt = build_insert_statement (be, table_name, obj_name, pObject, table);
@@ -2774,6 +2915,10 @@ gnc_sql_do_db_operation (GncSqlBackend* be,
         }
         gnc_sql_statement_dispose (stmt);
     }
+    else
+    {
+        qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
+    }
 
     return ok;
 }
@@ -2886,32 +3031,48 @@ free_gvalue_list (GSList* list)
     g_slist_free (list);
 }
 
-static GncSqlStatement*
-build_insert_statement (GncSqlBackend* be,
-                        const gchar* table_name,
-                        QofIdTypeConst obj_name, gpointer pObject,
-                        const GncSqlColumnTableEntry* table)
+/* Returns the key of the statement template for an operation on a table,
+ * setting or selecting by the given columns. */
+static gchar*
+build_statement_key (const gchar* operation, const gchar* table_name,
+                     const GncSqlColumnTableEntry* table)
 {
-    GncSqlStatement* stmt;
-    GString* sql;
-    GSList* values;
-    GSList* node;
-    gchar* sqlbuf;
-    GList* colnames = NULL;
-    GList* colname;
+    GString* key;
     const GncSqlColumnTableEntry* table_row;
 
-    g_return_val_if_fail (be != NULL, NULL);
-    g_return_val_if_fail (table_name != NULL, NULL);
-    g_return_val_if_fail (obj_name != NULL, NULL);
-    g_return_val_if_fail (pObject != NULL, NULL);
-    g_return_val_if_fail (table != NULL, NULL);
+    key = g_string_new (operation);
+    g_string_append_printf (key, " %s", table_name);
+    for (table_row = table; table_row->col_name != NULL; table_row++)
+    {
+        (void)g_string_append_c (key, ' ');
+        (void)g_string_append (key, table_row->col_name);
+    }
+    return g_string_free (key, FALSE);
+}
+
+/* Appends a comma separated '?' for each of n parameters. */
+static void
+append_parameters (GString* sql, guint n)
+{
+    guint i;
 
-    sqlbuf = g_strdup_printf ("INSERT INTO %s(", table_name);
-    sql = g_string_new (sqlbuf);
-    g_free (sqlbuf);
+    for (i = 0; i < n; i++)
+    {
+        (void)g_string_append (sql, i == 0 ? "?" : ",?");
+    }
+}
+
+/* Appends the names of the columns that an insert sets, and returns how
+ * many there are. */
+static guint
+append_insert_colnames (GString* sql, const GncSqlColumnTableEntry* table)
+{
+    GList* colnames = NULL;
+    GList* colname;
+    const GncSqlColumnTableEntry* table_row;
+    guint count = 0;
 
-    // Get all col names and all values
+    // Get all col names
     for (table_row = table; table_row->col_name != NULL; table_row++)
     {
         if ((table_row->flags & COL_AUTOINC) == 0)
@@ -2934,10 +3095,22 @@ build_insert_statement (GncSqlBackend* be,
         }
         g_string_append (sql, (gchar*)colname->data);
         g_free (colname->data);
+        count++;
     }
     g_list_free (colnames);
+    return count;
+}
 
-    g_string_append (sql, ") VALUES(");
+/* Appends the parenthesized list of the values that an insert sets. */
+static void
+append_insert_values (GncSqlBackend* be, GString* sql,
+                      QofIdTypeConst obj_name, gpointer pObject,
+                      const GncSqlColumnTableEntry* table)
+{
+    GSList* values;
+    GSList* node;
+
+    (void)g_string_append (sql, "(");
     values = create_gslist_from_values (be, obj_name, pObject, table);
     for (node = values; node != NULL; node = node->next)
     {
@@ -2954,28 +3127,18 @@ build_insert_statement (GncSqlBackend* be,
     }
     free_gvalue_list (values);
     (void)g_string_append (sql, ")");
-
-    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql->str);
-    (void)g_string_free (sql, TRUE);
-
-    return stmt;
 }
 
 static GncSqlStatement*
-build_update_statement (GncSqlBackend* be,
+build_insert_statement (GncSqlBackend* be,
                         const gchar* table_name,
                         QofIdTypeConst obj_name, gpointer pObject,
                         const GncSqlColumnTableEntry* table)
 {
     GncSqlStatement* stmt;
-    GString* sql;
     GSList* values;
-    GList* colnames = NULL;
-    GSList* value;
-    GList* colname;
-    gboolean firstCol;
-    const GncSqlColumnTableEntry* table_row;
-    gchar* sqlbuf;
+    gchar* key;
+    gboolean is_ok;
 
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (table_name != NULL, NULL);
@@ -2983,59 +3146,295 @@ build_update_statement (GncSqlBackend* be,
     g_return_val_if_fail (pObject != NULL, NULL);
     g_return_val_if_fail (table != NULL, NULL);
 
-    // Get all col names and all values
-    for (table_row = table; table_row->col_name != NULL; table_row++)
+    key = build_statement_key ("INSERT", table_name, table);
+    stmt = gnc_sql_connection_get_statement_from_template (be->conn, key);
+    if (stmt == NULL)
     {
-        if ((table_row->flags & COL_AUTOINC) == 0)
-        {
-            GncSqlColumnTypeHandler* pHandler;
+        GString* sql = g_string_new (NULL);
+        guint count;
 
-            // Add col names to the list
-            pHandler = get_handler (table_row);
-            g_assert (pHandler != NULL);
-            pHandler->add_colname_to_list_fn (table_row, &colnames);
-        }
+        g_string_printf (sql, "INSERT INTO %s(", table_name);
+        count = append_insert_colnames (sql, table);
+        (void)g_string_append (sql, ") VALUES(");
+        append_parameters (sql, count);
+        (void)g_string_append (sql, ")");
+        stmt = gnc_sql_connection_add_statement_template (be->conn, key, sql->str);
+        (void)g_string_free (sql, TRUE);
     }
-    g_assert (colnames != NULL);
+    g_free (key);
+    if (stmt == NULL) return NULL;
+
     values = create_gslist_from_values (be, obj_name, pObject, table);
+    is_ok = gnc_sql_statement_bind_values (stmt, values);
+    free_gvalue_list (values);
+    if (!is_ok)
+    {
+        gnc_sql_statement_dispose (stmt);
+        return NULL;
+    }
 
-    // Create the SQL statement
-    sqlbuf = g_strdup_printf ("UPDATE %s SET ", table_name);
-    sql = g_string_new (sqlbuf);
-    g_free (sqlbuf);
+    return stmt;
+}
+
+/* ================================================================= */
+/* Batched inserts
+ *
+ * The rows queued for a table are kept as the text of a single
+ * multi-row INSERT, which is sent when it gets long enough, before any
+ * other statement that might read or change the table, and when the
+ * outermost batch ends.  The limits keep each statement well within
+ * what SQLite, MySQL and PostgreSQL accept.
+ */
+
+#define INSERT_BATCH_MAX_ROWS 250
+#define INSERT_BATCH_MAX_LENGTH (512 * 1024)
+
+typedef struct
+{
+    const gchar* table_name;
+    const GncSqlColumnTableEntry* table;
+    GString* sql;       /* INSERT INTO table(cols) VALUES(...),(...) */
+    gsize header_len;   /* The length of the text before the first row */
+    guint rows;
+} GncSqlInsertBatch;
 
-    firstCol = TRUE;
-    for (colname = colnames->next, value = values->next;
-         colname != NULL && value != NULL;
-         colname = colname->next, value = value->next)
+static void
+insert_batch_free (gpointer data)
+{
+    GncSqlInsertBatch* batch = static_cast<decltype (batch)> (data);
+
+    (void)g_string_free (batch->sql, TRUE);
+    g_free (batch);
+}
+
+static gboolean
+write_insert_batch (GncSqlBackend* be, GncSqlInsertBatch* batch)
+{
+    GncSqlStatement* stmt;
+    gboolean ok = FALSE;
+
+    if (batch->rows == 0)
     {
-        gchar* value_str;
-        if (!firstCol)
+        return TRUE;
+    }
+
+    stmt = gnc_sql_connection_create_statement_from_sql (be->conn,
+                                                         batch->sql->str);
+    if (stmt != NULL)
+    {
+        if (gnc_sql_connection_execute_nonselect_statement (be->conn, stmt) == -1)
         {
-            (void)g_string_append (sql, ",");
+            PERR ("SQL error: %s\n", gnc_sql_statement_to_sql (stmt));
+            qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
         }
-        (void)g_string_append (sql, (gchar*)colname->data);
-        (void)g_string_append (sql, "=");
-        value_str = gnc_sql_get_sql_value (be->conn, (GValue*) (value->data));
-        (void)g_string_append (sql, value_str);
-        g_free (value_str);
-        firstCol = FALSE;
+        else
+        {
+            ok = TRUE;
+        }
+        gnc_sql_statement_dispose (stmt);
     }
-    for (colname = colnames; colname != NULL; colname = colname->next)
+    else
     {
-        g_free (colname->data);
+        PERR ("SQL error: %s\n", batch->sql->str);
+        qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
     }
-    g_list_free (colnames);
-    if (value != NULL || colname != NULL)
+
+    (void)g_string_truncate (batch->sql, batch->header_len);
+    batch->rows = 0;
+    if (!ok)
+    {
+        be->insert_batch_ok = FALSE;
+    }
+    return ok;
+}
+
+static gboolean
+flush_insert_batch (GncSqlBackend* be, const gchar* table_name)
+{
+    GncSqlInsertBatch* batch;
+
+    if (be->insert_batches == NULL)
+    {
+        return TRUE;
+    }
+    batch = static_cast<decltype (batch)> (g_hash_table_lookup (be->insert_batches,
+                                                                table_name));
+    return batch == NULL || write_insert_batch (be, batch);
+}
+
+static gboolean
+flush_insert_batches (GncSqlBackend* be)
+{
+    GHashTableIter iter;
+    gpointer batch;
+    gboolean ok = TRUE;
+
+    if (be->insert_batches == NULL)
+    {
+        return TRUE;
+    }
+    g_hash_table_iter_init (&iter, be->insert_batches);
+    while (g_hash_table_iter_next (&iter, NULL, &batch))
+    {
+        if (!write_insert_batch (be, static_cast<GncSqlInsertBatch*> (batch)))
+        {
+            ok = FALSE;
+        }
+    }
+    return ok;
+}
+
+static gboolean
+queue_insert (GncSqlBackend* be, const gchar* table_name,
+              QofIdTypeConst obj_name, gpointer pObject,
+              const GncSqlColumnTableEntry* table)
+{
+    GncSqlInsertBatch* batch;
+
+    batch = static_cast<decltype (batch)> (g_hash_table_lookup (be->insert_batches,
+                                                                table_name));
+    if (batch != NULL && batch->table != table)
+    {
+        /* Another description of the same table may set other columns. */
+        (void)write_insert_batch (be, batch);
+        g_hash_table_remove (be->insert_batches, table_name);
+        batch = NULL;
+    }
+    if (batch == NULL)
+    {
+        batch = g_new0 (GncSqlInsertBatch, 1);
+        batch->table_name = table_name;
+        batch->table = table;
+        batch->sql = g_string_new (NULL);
+        g_string_printf (batch->sql, "INSERT INTO %s(", table_name);
+        (void)append_insert_colnames (batch->sql, table);
+        (void)g_string_append (batch->sql, ") VALUES");
+        batch->header_len = batch->sql->len;
+        g_hash_table_insert (be->insert_batches, (gpointer)batch->table_name,
+                             batch);
+    }
+
+    if (batch->rows > 0)
+    {
+        (void)g_string_append (batch->sql, ",");
+    }
+    append_insert_values (be, batch->sql, obj_name, pObject, table);
+    batch->rows++;
+
+    if (batch->rows >= INSERT_BATCH_MAX_ROWS ||
+        batch->sql->len >= INSERT_BATCH_MAX_LENGTH)
+    {
+        return write_insert_batch (be, batch);
+    }
+    return TRUE;
+}
+
+void
+gnc_sql_begin_insert_batch (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+
+    if (be->insert_batch_depth++ == 0)
+    {
+        be->insert_batches = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    NULL, insert_batch_free);
+        be->insert_batch_ok = TRUE;
+    }
+}
+
+gboolean
+gnc_sql_end_insert_batch (GncSqlBackend* be)
+{
+    gboolean ok;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (be->insert_batch_depth > 0, FALSE);
+
+    if (--be->insert_batch_depth > 0)
+    {
+        return be->insert_batch_ok;
+    }
+    (void)flush_insert_batches (be);
+    g_hash_table_destroy (be->insert_batches);
+    be->insert_batches = NULL;
+    ok = be->insert_batch_ok;
+    be->insert_batch_ok = TRUE;
+    return ok;
+}
+
+static GncSqlStatement*
+build_update_statement (GncSqlBackend* be,
+                        const gchar* table_name,
+                        QofIdTypeConst obj_name, gpointer pObject,
+                        const GncSqlColumnTableEntry* table)
+{
+    GncSqlStatement* stmt;
+    GSList* values;
+    GSList* key_value;
+    gchar* key;
+    gboolean is_ok;
+
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (table_name != NULL, NULL);
+    g_return_val_if_fail (obj_name != NULL, NULL);
+    g_return_val_if_fail (pObject != NULL, NULL);
+    g_return_val_if_fail (table != NULL, NULL);
+
+    key = build_statement_key ("UPDATE", table_name, table);
+    stmt = gnc_sql_connection_get_statement_from_template (be->conn, key);
+    if (stmt == NULL)
     {
-        PERR ("Mismatch in number of column names and values");
+        GList* colnames = NULL;
+        GList* colname;
+        const GncSqlColumnTableEntry* table_row;
+        GString* sql;
+
+        // Get all col names
+        for (table_row = table; table_row->col_name != NULL; table_row++)
+        {
+            if ((table_row->flags & COL_AUTOINC) == 0)
+            {
+                GncSqlColumnTypeHandler* pHandler;
+
+                // Add col names to the list
+                pHandler = get_handler (table_row);
+                g_assert (pHandler != NULL);
+                pHandler->add_colname_to_list_fn (table_row, &colnames);
+            }
+        }
+        g_assert (colnames != NULL);
+
+        // The first column is the one the row is found by
+        sql = g_string_new (NULL);
+        g_string_printf (sql, "UPDATE %s SET ", table_name);
+        for (colname = colnames->next; colname != NULL; colname = colname->next)
+        {
+            if (colname != colnames->next)
+            {
+                (void)g_string_append (sql, ",");
+            }
+            g_string_append_printf (sql, "%s=?", (gchar*)colname->data);
+        }
+        g_string_append_printf (sql, " WHERE %s = ?", table[0].col_name);
+        g_list_free_full (colnames, g_free);
+
+        stmt = gnc_sql_connection_add_statement_template (be->conn, key, sql->str);
+        (void)g_string_free (sql, TRUE);
     }
+    g_free (key);
+    if (stmt == NULL) return NULL;
 
-    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql->str);
-    gnc_sql_statement_add_where_cond (stmt, obj_name, pObject, &table[0],
-                                      (GValue*) (values->data));
+    // The value of the first column goes last, in the WHERE clause
+    values = create_gslist_from_values (be, obj_name, pObject, table);
+    key_value = values;
+    values = g_slist_concat (g_slist_remove_link (values, key_value), key_value);
+    is_ok = gnc_sql_statement_bind_values (stmt, values);
     free_gvalue_list (values);
-    (void)g_string_free (sql, TRUE);
+    if (!is_ok)
+    {
+        gnc_sql_statement_dispose (stmt);
+        return NULL;
+    }
 
     return stmt;
 }
@@ -3049,7 +3448,8 @@ build_delete_statement (GncSqlBackend* be,
     GncSqlStatement* stmt;
     GncSqlColumnTypeHandler* pHandler;
     GSList* list = NULL;
-    gchar* sqlbuf;
+    gchar* key;
+    gboolean is_ok;
 
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (table_name != NULL, NULL);
@@ -3057,18 +3457,31 @@ build_delete_statement (GncSqlBackend* be,
     g_return_val_if_fail (pObject != NULL, NULL);
     g_return_val_if_fail (table != NULL, NULL);
 
-    sqlbuf = g_strdup_printf ("DELETE FROM %s ", table_name);
-    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sqlbuf);
-    g_free (sqlbuf);
+    // Only the first column, which the row is found by, is used
+    key = g_strdup_printf ("DELETE %s %s", table_name, table[0].col_name);
+    stmt = gnc_sql_connection_get_statement_from_template (be->conn, key);
+    if (stmt == NULL)
+    {
+        gchar* sqlbuf = g_strdup_printf ("DELETE FROM %s WHERE %s = ?",
+                                         table_name, table[0].col_name);
+        stmt = gnc_sql_connection_add_statement_template (be->conn, key, sqlbuf);
+        g_free (sqlbuf);
+    }
+    g_free (key);
+    if (stmt == NULL) return NULL;
 
     /* WHERE */
     pHandler = get_handler (table);
     g_assert (pHandler != NULL);
     pHandler->add_gvalue_to_slist_fn (be, obj_name, pObject, table, &list);
     g_assert (list != NULL);
-    gnc_sql_statement_add_where_cond (stmt, obj_name, pObject, &table[0],
-                                      (GValue*) (list->data));
+    is_ok = gnc_sql_statement_bind_values (stmt, list);
     free_gvalue_list (list);
+    if (!is_ok)
+    {
+        gnc_sql_statement_dispose (stmt);
+        return NULL;
+    }
 
     return stmt;
 }
@@ -51,6 +51,8 @@ typedef struct GncSqlConnection GncSqlConnection;
  *
  * Main SQL backend structure.
  */
+struct GncSqlTxCache;
+
 struct GncSqlBackend
 {
     QofBackend be;           /**< QOF backend */
@@ -63,6 +65,13 @@ struct GncSqlBackend
     gint operations_done;    /**< Number of operations (save/load) done */
     GHashTable* versions;    /**< Version number for each table */
     const gchar* timespec_format;   /**< Format string for SQL for timespec values */
+    gint insert_batch_depth; /**< Nesting of gnc_sql_begin_insert_batch() */
+    GHashTable* insert_batches; /**< Rows waiting to be inserted, by table */
+    gboolean insert_batch_ok; /**< No batched insert has failed */
+    struct GncSqlTxCache* tx_cache; /**< Transactions loaded as needed, NULL
+                                     if they are all loaded up front */
+    gboolean slot_blobs;     /**< Objects' slots are stored as one
+                                serialized frame each, not in rows */
 };
 typedef struct GncSqlBackend GncSqlBackend;
 
@@ -136,6 +145,11 @@ typedef struct GncSqlRow GncSqlRow;
  *
  * Struct which represents an SQL statement.  SQL backends must provide a
  * structure which implements all of the functions.
+ *
+ * A statement made from a template has a '?' in its SQL for each
+ * parameter, and bindValues sets them, in order, from a list of GValues.
+ * It fails, leaving nothing to execute, unless there is one value for each
+ * parameter.  It can be bound and executed again for other values.
  */
 struct GncSqlStatement
 {
@@ -143,6 +157,7 @@ struct GncSqlStatement
     gchar* (*toSql) (GncSqlStatement*);
     void (*addWhereCond) (GncSqlStatement*, QofIdTypeConst, gpointer,
                           const GncSqlColumnTableEntry*, GValue*);
+    gboolean (*bindValues) (GncSqlStatement*, GSList*);  /**< From a template only */
 };
 #define gnc_sql_statement_dispose(STMT) \
         (STMT)->dispose(STMT)
@@ -150,12 +165,24 @@ struct GncSqlStatement
         (STMT)->toSql(STMT)
 #define gnc_sql_statement_add_where_cond(STMT,TYPENAME,OBJ,COLDESC,VALUE) \
         (STMT)->addWhereCond(STMT, TYPENAME, OBJ, COLDESC, VALUE)
+#define gnc_sql_statement_bind_values(STMT,VALUES) \
+        (STMT)->bindValues(STMT, VALUES)
 
 /**
  * @struct GncSqlConnection
  *
  * Struct which represents the connection to an SQL database.  SQL backends
  * must provide a structure which implements all of the functions.
+ *
+ * The connection keeps the statement templates added by
+ * addStatementTemplate, each under a key naming its table, operation and
+ * columns, for as long as it is open.  getStatementFromTemplate and
+ * addStatementTemplate return a new statement for the template under the
+ * key, which the caller binds, executes and disposes of.
+ *
+ * Templates are not server-side prepared statements.  They only spare
+ * building the SQL for each object; a backend may fill in the bound values
+ * as SQL text, which the server then parses like any other statement.
  */
 struct GncSqlConnection
 {
@@ -180,6 +207,10 @@ struct GncSqlConnection
     gboolean (*addColumnsToTable) (GncSqlConnection*, const gchar* table,
                                    GList*);  /**< Returns TRUE if successful, FALSE if error */
     gchar* (*quoteString) (const GncSqlConnection*, gchar*);
+    GncSqlStatement* (*getStatementFromTemplate) (GncSqlConnection*,
+                                                  const gchar*);  /**< Returns NULL if there is no template for the key */
+    GncSqlStatement* (*addStatementTemplate) (GncSqlConnection*, const gchar*,
+                                              const gchar*);  /**< Returns NULL if error */
 };
 #define gnc_sql_connection_dispose(CONN) (CONN)->dispose(CONN)
 #define gnc_sql_connection_execute_select_statement(CONN,STMT) \
@@ -204,20 +235,59 @@ struct GncSqlConnection
         (CONN)->addColumnsToTable(CONN,TABLENAME,COLLIST)
 #define gnc_sql_connection_quote_string(CONN,STR) \
         (CONN)->quoteString(CONN,STR)
+#define gnc_sql_connection_get_statement_from_template(CONN,KEY) \
+        (CONN)->getStatementFromTemplate(CONN,KEY)
+#define gnc_sql_connection_add_statement_template(CONN,KEY,SQL) \
+        (CONN)->addStatementTemplate(CONN,KEY,SQL)
 
 /**
  * @struct GncSqlRow
  *
  * Struct used to represent a row in the result of an SQL SELECT statement.
  * SQL backends must provide a structure which implements all of the functions.
+ *
+ * Besides getValueAtColName(), which allocates a GValue for the cell, a
+ * row's cells can be read by the index of their column.  Indexes are
+ * looked up when the result is created and hold for each of its rows; the
+ * typed getters don't allocate, and the strings they return belong to the
+ * row until the next one is fetched.
+ *
+ * getColIndex()    - index of a column, or -1 if the result has none
+ * getColType()     - G_TYPE_INT64, G_TYPE_DOUBLE or G_TYPE_STRING for the
+ *                    cell's value, G_TYPE_INVALID if it can't be read
+ *                    (a NULL date, or no such column)
+ * getInt64AtCol()  - integer or date (as time64) cell, 0 otherwise
+ * getDoubleAtCol() - decimal or integer cell, 0 otherwise
+ * getStringAtCol() - string cell, NULL if it is NULL or not a string
+ *
+ * col_maps belongs to gnc_sql_load_object(), which keeps in it the
+ * column indexes of each table description loaded from the result.
+ * Backends create rows with it NULL, reuse a row for all of a result's
+ * rows, and call gnc_sql_row_free_col_maps() when disposing of it.
  */
 struct GncSqlRow
 {
     const GValue* (*getValueAtColName) (GncSqlRow*, const gchar*);
+    gint (*getColIndex) (GncSqlRow*, const gchar*);
+    GType (*getColType) (GncSqlRow*, gint);
+    gint64 (*getInt64AtCol) (GncSqlRow*, gint);
+    gdouble (*getDoubleAtCol) (GncSqlRow*, gint);
+    const gchar* (*getStringAtCol) (GncSqlRow*, gint);
     void (*dispose) (GncSqlRow*);
+    GSList* col_maps;
 };
 #define gnc_sql_row_get_value_at_col_name(ROW,N) \
         (ROW)->getValueAtColName(ROW,N)
+#define gnc_sql_row_get_col_index(ROW,N) \
+        (ROW)->getColIndex(ROW,N)
+#define gnc_sql_row_get_col_type(ROW,C) \
+        (ROW)->getColType(ROW,C)
+#define gnc_sql_row_get_int64_at_col(ROW,C) \
+        (ROW)->getInt64AtCol(ROW,C)
+#define gnc_sql_row_get_double_at_col(ROW,C) \
+        (ROW)->getDoubleAtCol(ROW,C)
+#define gnc_sql_row_get_string_at_col(ROW,C) \
+        (ROW)->getStringAtCol(ROW,C)
 #define gnc_sql_row_dispose(ROW) \
         (ROW)->dispose(ROW)
 
@@ -373,7 +443,8 @@ typedef enum
 typedef void (*GNC_SQL_LOAD_FN) (const GncSqlBackend* be,
                                  GncSqlRow* row,
                                  QofSetterFunc setter, gpointer pObject,
-                                 const GncSqlColumnTableEntry* table);
+                                 const GncSqlColumnTableEntry* table,
+                                 const gint* cols);
 typedef void (*GNC_SQL_ADD_COL_INFO_TO_LIST_FN) (const GncSqlBackend* be,
                                                  const GncSqlColumnTableEntry* table_row,
                                                  GList** pList);
@@ -396,7 +467,10 @@ typedef void (*GNC_SQL_ADD_GVALUE_TO_SLIST_FN) (const GncSqlBackend* be,
 typedef struct
 {
     /**
-     * Routine to load a value into an object from the database row.
+     * Routine to load a value into an object from the database row.  cols
+     * holds the indexes in the row of the columns named by
+     * add_colname_to_list_fn, in the same order, -1 for those missing
+     * from the result.
      */
     GNC_SQL_LOAD_FN                 load_fn;
 
@@ -455,6 +529,28 @@ gboolean gnc_sql_do_db_operation (GncSqlBackend* be,
                                   gpointer pObject,
                                   const GncSqlColumnTableEntry* table);
 
+/**
+ * Starts batching inserts.  Until the matching gnc_sql_end_insert_batch(),
+ * the rows that gnc_sql_do_db_operation() inserts are queued by table and
+ * written several at a time by multi-row INSERT statements.  The rows
+ * queued for a table are written before any other operation on it, and
+ * all of them before any other SQL statement.  Calls may be nested.
+ *
+ * @param be SQL backend struct
+ */
+void gnc_sql_begin_insert_batch (GncSqlBackend* be);
+
+/**
+ * Ends batching inserts, writing the queued rows when the outermost batch
+ * ends.
+ *
+ * @param be SQL backend struct
+ * @return TRUE if all the rows inserted since the outermost batch began
+ * were written, FALSE if not.  When a nested batch ends, the rows are
+ * still queued and only the failure of those already written shows.
+ */
+gboolean gnc_sql_end_insert_batch (GncSqlBackend* be);
+
 /**
  * Executes an SQL SELECT statement and returns the result rows.  If an error
  * occurs, an entry is added to the log, an error status is returned to qof and
@@ -498,7 +594,9 @@ GncSqlStatement* gnc_sql_create_statement_from_sql (GncSqlBackend* be,
                                                     const gchar* sql);
 
 /**
- * Loads a Gnucash object from the database.
+ * Loads a Gnucash object from the database.  The indexes of the table's
+ * columns are looked up in the first row loaded with it, and kept in the
+ * row for the rest of the result.
  *
  * @param be SQL backend struct
  * @param row DB result row
@@ -510,6 +608,13 @@ void gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
                           QofIdTypeConst obj_name, gpointer pObject,
                           const GncSqlColumnTableEntry* table);
 
+/**
+ * Frees the column indexes gnc_sql_load_object() kept in a row.
+ *
+ * @param row DB result row
+ */
+void gnc_sql_row_free_col_maps (GncSqlRow* row);
+
 /**
  * Checks whether an object is in the database or not.
  *
@@ -719,6 +824,15 @@ gboolean gnc_sql_commit_standard_item (GncSqlBackend* be, QofInstance* inst,
  */
 gint64 gnc_sql_get_integer_value (const GValue* value);
 
+/**
+ * Gets an integer value (of any size) from a cell of a row.
+ *
+ * @param row Row
+ * @param col Index of the cell's column, from gnc_sql_row_get_col_index()
+ * @return Integer value, 0 if the cell has none
+ */
+gint64 gnc_sql_row_get_integer (GncSqlRow* row, gint col);
+
 /**
  * Converts a Timespec value to a string value for the database.
  *
@@ -769,6 +883,7 @@ void _retrieve_guid_ (gpointer pObject,  gpointer pValue);
 gpointer gnc_sql_compile_query (QofBackend* pBEnd, QofQuery* pQuery);
 void gnc_sql_free_query (QofBackend* pBEnd, gpointer pQuery);
 void gnc_sql_run_query (QofBackend* pBEnd, gpointer pQuery);
+void gnc_sql_load_related (QofBackend* pBEnd, QofInstance* inst);
 
 typedef struct
 {
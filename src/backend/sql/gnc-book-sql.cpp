@@ -156,6 +156,10 @@ load_single_book (GncSqlBackend* be, GncSqlRow* row)
     qof_book_begin_edit (pBook);
     gnc_sql_load_object (be, row, GNC_ID_BOOK, pBook, col_table);
     gnc_sql_slots_load (be, QOF_INSTANCE (pBook));
+    // The slots hold the book options, filled in behind the setters' back
+    qof_book_options_changed (pBook);
+    // Its features tell how the slots of everything else are stored
+    gnc_sql_slots_init_storage (be, pBook);
     qof_book_commit_edit (pBook);
 
     qof_instance_mark_clean (QOF_INSTANCE (pBook));
@@ -484,9 +484,11 @@ write_budgets (GncSqlBackend* be)
 static void
 load_budget_guid (const GncSqlBackend* be, GncSqlRow* row,
                   QofSetterFunc setter, gpointer pObject,
-                  const GncSqlColumnTableEntry* table_row)
+                  const GncSqlColumnTableEntry* table_row,
+                  const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     GncBudget* budget = NULL;
 
@@ -495,11 +497,11 @@ load_budget_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        (void)string_to_guid (g_value_get_string (val), &guid);
+        (void)string_to_guid (guid_str, &guid);
         budget = gnc_budget_lookup (&guid, be->book);
         if (budget != NULL)
         {
@@ -517,7 +519,7 @@ load_budget_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Budget ref '%s' not found", g_value_get_string (val));
+            PWARN ("Budget ref '%s' not found", guid_str);
         }
     }
 }
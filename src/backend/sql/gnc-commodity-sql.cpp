@@ -276,9 +276,11 @@ gnc_sql_commit_commodity (gnc_commodity* pCommodity)
 static void
 load_commodity_guid (const GncSqlBackend* be, GncSqlRow* row,
                      QofSetterFunc setter, gpointer pObject,
-                     const GncSqlColumnTableEntry* table_row)
+                     const GncSqlColumnTableEntry* table_row,
+                     const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     gnc_commodity* commodity = NULL;
 
@@ -287,11 +289,11 @@ load_commodity_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        (void)string_to_guid (g_value_get_string (val), &guid);
+        (void)string_to_guid (guid_str, &guid);
         commodity = gnc_commodity_find_commodity_by_guid (&guid, be->book);
         if (commodity != NULL)
         {
@@ -308,7 +310,7 @@ load_commodity_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Commodity ref '%s' not found", g_value_get_string (val));
+            PWARN ("Commodity ref '%s' not found", guid_str);
         }
     }
 }
@@ -287,9 +287,11 @@ write_invoices (GncSqlBackend* be)
 static void
 load_invoice_guid (const GncSqlBackend* be, GncSqlRow* row,
                    QofSetterFunc setter, gpointer pObject,
-                   const GncSqlColumnTableEntry* table_row)
+                   const GncSqlColumnTableEntry* table_row,
+                   const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     GncInvoice* invoice = NULL;
 
@@ -298,11 +300,11 @@ load_invoice_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        string_to_guid (g_value_get_string (val), &guid);
+        string_to_guid (guid_str, &guid);
         invoice = gncInvoiceLookup (be->book, &guid);
         if (invoice != NULL)
         {
@@ -319,7 +321,7 @@ load_invoice_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Invoice ref '%s' not found", g_value_get_string (val));
+            PWARN ("Invoice ref '%s' not found", guid_str);
         }
     }
 }
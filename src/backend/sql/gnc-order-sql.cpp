@@ -202,9 +202,11 @@ write_orders (GncSqlBackend* be)
 static void
 load_order_guid (const GncSqlBackend* be, GncSqlRow* row,
                  QofSetterFunc setter, gpointer pObject,
-                 const GncSqlColumnTableEntry* table_row)
+                 const GncSqlColumnTableEntry* table_row,
+                 const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     GncOrder* order = NULL;
 
@@ -213,11 +215,11 @@ load_order_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        string_to_guid (g_value_get_string (val), &guid);
+        string_to_guid (guid_str, &guid);
         order = gncOrderLookup (be->book, &guid);
         if (order != NULL)
         {
@@ -234,7 +236,7 @@ load_order_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Order ref '%s' not found", g_value_get_string (val));
+            PWARN ("Order ref '%s' not found", guid_str);
         }
     }
 }
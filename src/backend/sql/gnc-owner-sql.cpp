@@ -51,10 +51,10 @@ typedef GncOwner* (*OwnerGetterFunc) (const gpointer);
 static void
 load_owner (const GncSqlBackend* be, GncSqlRow* row,
             QofSetterFunc setter, gpointer pObject,
-            const GncSqlColumnTableEntry* table_row)
+            const GncSqlColumnTableEntry* table_row,
+            const gint* cols)
 {
-    const GValue* val;
-    gchar* buf;
+    const gchar* guid_str;
     GncOwnerType type;
     GncGUID guid;
     QofBook* book;
@@ -67,18 +67,12 @@ load_owner (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (table_row != NULL);
 
     book = be->book;
-    buf = g_strdup_printf ("%s_type", table_row->col_name);
-    val = gnc_sql_row_get_value_at_col_name (row, buf);
-    type = (GncOwnerType)gnc_sql_get_integer_value (val);
-    g_free (buf);
-    buf = g_strdup_printf ("%s_guid", table_row->col_name);
-    val = gnc_sql_row_get_value_at_col_name (row, buf);
-    g_free (buf);
-
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    // The type's column, then the guid's, as add_colname_to_list() has them
+    type = (GncOwnerType)gnc_sql_row_get_integer (row, cols[0]);
+    guid_str = gnc_sql_row_get_string_at_col (row, cols[1]);
+    if (guid_str != NULL)
     {
-        string_to_guid (g_value_get_string (val), &guid);
+        string_to_guid (guid_str, &guid);
         pGuid = &guid;
     }
 
@@ -34,6 +34,7 @@ extern "C"
 
 #include <qof.h>
 #include <gnc-engine.h>
+#include <gnc-features.h>
 
 #ifdef S_SPLINT_S
 #include "splint-defs.h"
@@ -49,6 +50,9 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define TABLE_NAME "slots"
 #define TABLE_VERSION 3
 
+#define BLOB_TABLE_NAME "slot_blobs"
+#define BLOB_TABLE_VERSION 1
+
 typedef enum
 {
     NONE,
@@ -171,6 +175,44 @@ static const GncSqlColumnTableEntry gdate_col_table[] =
     { NULL }
 };
 
+/* One serialized frame of an object's slots */
+typedef struct
+{
+    const GncGUID* guid;
+    const gchar* obj_type;
+    const gchar* data;
+} blob_info_t;
+
+static gpointer get_blob_guid (gpointer pObject);
+static gpointer get_blob_obj_type (gpointer pObject);
+static gpointer get_blob_data (gpointer pObject);
+
+#define SLOT_BLOB_MAX_TYPE_LEN 40
+enum
+{
+    blob_obj_guid_col = 0,
+    blob_obj_type_col,
+    blob_data_col
+};
+
+static const GncSqlColumnTableEntry blob_col_table[] =
+{
+    /* col_name, col_type, size, flags, g0bj_param_name, qof_param_name, getter, setter */
+    {
+        "obj_guid", CT_GUID,   0,                      COL_PKEY | COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_blob_guid,     NULL
+    },
+    {
+        "obj_type", CT_STRING, SLOT_BLOB_MAX_TYPE_LEN, COL_NNUL,            NULL, NULL,
+        (QofAccessFunc)get_blob_obj_type, NULL
+    },
+    {
+        "data",     CT_STRING, 0,                      COL_NNUL,            NULL, NULL,
+        (QofAccessFunc)get_blob_data,     NULL
+    },
+    { NULL }
+};
+
 /* ================================================================= */
 
 static gchar*
@@ -617,6 +659,478 @@ slot_info_copy (slot_info_t* pInfo, GncGUID* guid)
     return newSlot;
 }
 
+/* ================================================================= */
+/* The slots of an object can instead be kept in one row of the slot_blobs
+ * table, as its frame serialized into a string.  A value is written as a
+ * letter for its type followed by its contents:
+ *
+ *   i<int64>;   d<double>;   n<num>/<denom>;   t<sec>.<nsec>;   D<julian>;
+ *   g<guid>     s<length>:<bytes>    [<value>...]    {<slot>...}
+ *
+ * where a slot of a frame is its key, written as <length>:<bytes>, followed
+ * by its value.  The blob of an object is its frame, {...}. */
+
+static gpointer
+get_blob_guid (gpointer pObject)
+{
+    blob_info_t* pInfo = (blob_info_t*)pObject;
+
+    g_return_val_if_fail (pObject != NULL, NULL);
+
+    return (gpointer)pInfo->guid;
+}
+
+static gpointer
+get_blob_obj_type (gpointer pObject)
+{
+    blob_info_t* pInfo = (blob_info_t*)pObject;
+
+    g_return_val_if_fail (pObject != NULL, NULL);
+
+    return (gpointer)pInfo->obj_type;
+}
+
+static gpointer
+get_blob_data (gpointer pObject)
+{
+    blob_info_t* pInfo = (blob_info_t*)pObject;
+
+    g_return_val_if_fail (pObject != NULL, NULL);
+
+    return (gpointer)pInfo->data;
+}
+
+static gboolean
+value_is_serializable (const KvpValue* value)
+{
+    switch (value->get_type ())
+    {
+    case KvpValue::Type::INVALID:
+    case KvpValue::Type::PLACEHOLDER_DONT_USE:
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
+static void
+serialize_string (GString* blob, const gchar* str)
+{
+    gsize len = (str != NULL) ? strlen (str) : 0;
+
+    g_string_append_printf (blob, "%" G_GSIZE_FORMAT ":", len);
+    (void)g_string_append_len (blob, str, len);
+}
+
+static void serialize_value (GString* blob, const KvpValue* value);
+
+static void
+serialize_slot (const gchar* key, KvpValue* value, gpointer data)
+{
+    GString* blob = (GString*)data;
+
+    if (!value_is_serializable (value)) return;
+    serialize_string (blob, key);
+    serialize_value (blob, value);
+}
+
+static void
+serialize_value (GString* blob, const KvpValue* value)
+{
+    switch (value->get_type ())
+    {
+    case KvpValue::Type::INT64:
+        g_string_append_printf (blob, "i%" G_GINT64_FORMAT ";",
+                                (gint64)value->get<int64_t> ());
+        break;
+    case KvpValue::Type::DOUBLE:
+    {
+        gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+        g_string_append_printf (blob, "d%s;",
+                                g_ascii_dtostr (buf, sizeof (buf),
+                                                value->get<double> ()));
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        gnc_numeric n = value->get<gnc_numeric> ();
+        g_string_append_printf (blob, "n%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT ";",
+                                n.num, n.denom);
+        break;
+    }
+    case KvpValue::Type::STRING:
+        (void)g_string_append_c (blob, 's');
+        serialize_string (blob, value->get<const char*> ());
+        break;
+    case KvpValue::Type::GUID:
+    {
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+        GncGUID* guid = value->get<GncGUID*> ();
+        (void)guid_to_string_buff (guid != NULL ? guid : guid_null (), guid_buf);
+        g_string_append_printf (blob, "g%s", guid_buf);
+        break;
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        Timespec ts = value->get<Timespec> ();
+        g_string_append_printf (blob, "t%" G_GINT64_FORMAT ".%" G_GINT64_FORMAT ";",
+                                (gint64)ts.tv_sec, (gint64)ts.tv_nsec);
+        break;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        GDate date = value->get<GDate> ();
+        g_string_append_printf (blob, "D%u;",
+                                g_date_valid (&date) ? g_date_get_julian (&date) : 0);
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        (void)g_string_append_c (blob, '[');
+        for (auto cursor = value->get<GList*> (); cursor; cursor = cursor->next)
+        {
+            auto val = static_cast<KvpValue*> (cursor->data);
+            if (value_is_serializable (val))
+                serialize_value (blob, val);
+        }
+        (void)g_string_append_c (blob, ']');
+        break;
+    case KvpValue::Type::FRAME:
+        (void)g_string_append_c (blob, '{');
+        value->get<KvpFrame*> ()->for_each_slot (serialize_slot, blob);
+        (void)g_string_append_c (blob, '}');
+        break;
+    default:
+        break;
+    }
+}
+
+typedef struct
+{
+    const gchar* pos;
+    const gchar* end;
+} blob_reader_t;
+
+static gboolean
+read_int64 (blob_reader_t* reader, gchar terminator, gint64* value)
+{
+    gchar* endptr;
+
+    *value = g_ascii_strtoll (reader->pos, &endptr, 10);
+    if (endptr == reader->pos || endptr >= reader->end || *endptr != terminator)
+        return FALSE;
+    reader->pos = endptr + 1;
+    return TRUE;
+}
+
+static gchar*
+read_string (blob_reader_t* reader)
+{
+    gint64 len;
+    gchar* str;
+
+    if (!read_int64 (reader, ':', &len) || len < 0 ||
+        len > reader->end - reader->pos)
+        return NULL;
+    str = g_strndup (reader->pos, len);
+    reader->pos += len;
+    return str;
+}
+
+static void
+delete_kvp_value (gpointer data)
+{
+    delete static_cast<KvpValue*> (data);
+}
+
+static gboolean read_slots (blob_reader_t* reader, KvpFrame* frame);
+
+static KvpValue*
+read_value (blob_reader_t* reader)
+{
+    if (reader->pos >= reader->end) return NULL;
+
+    switch (*reader->pos++)
+    {
+    case 'i':
+    {
+        gint64 i;
+        if (!read_int64 (reader, ';', &i)) return NULL;
+        return new KvpValue {i};
+    }
+    case 'd':
+    {
+        gchar* endptr;
+        double d = g_ascii_strtod (reader->pos, &endptr);
+        if (endptr == reader->pos || endptr >= reader->end || *endptr != ';')
+            return NULL;
+        reader->pos = endptr + 1;
+        return new KvpValue {d};
+    }
+    case 'n':
+    {
+        gint64 num, denom;
+        if (!read_int64 (reader, '/', &num) || !read_int64 (reader, ';', &denom))
+            return NULL;
+        return new KvpValue {gnc_numeric_create (num, denom)};
+    }
+    case 's':
+    {
+        gchar* str = read_string (reader);
+        if (str == NULL) return NULL;
+        return new KvpValue {str};
+    }
+    case 'g':
+    {
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+        GncGUID guid;
+        if (reader->end - reader->pos < GUID_ENCODING_LENGTH) return NULL;
+        memcpy (guid_buf, reader->pos, GUID_ENCODING_LENGTH);
+        guid_buf[GUID_ENCODING_LENGTH] = '\0';
+        if (!string_to_guid (guid_buf, &guid)) return NULL;
+        reader->pos += GUID_ENCODING_LENGTH;
+        return new KvpValue {guid_copy (&guid)};
+    }
+    case 't':
+    {
+        gint64 sec, nsec;
+        Timespec ts;
+        if (!read_int64 (reader, '.', &sec) || !read_int64 (reader, ';', &nsec))
+            return NULL;
+        ts.tv_sec = sec;
+        ts.tv_nsec = nsec;
+        return new KvpValue {ts};
+    }
+    case 'D':
+    {
+        gint64 julian;
+        GDate date;
+        if (!read_int64 (reader, ';', &julian)) return NULL;
+        g_date_clear (&date, 1);
+        if (julian > 0)
+            g_date_set_julian (&date, (guint32)julian);
+        return new KvpValue {date};
+    }
+    case '[':
+    {
+        GList* list = NULL;
+        while (reader->pos < reader->end && *reader->pos != ']')
+        {
+            KvpValue* value = read_value (reader);
+            if (value == NULL)
+            {
+                g_list_free_full (list, delete_kvp_value);
+                return NULL;
+            }
+            list = g_list_prepend (list, value);
+        }
+        if (reader->pos >= reader->end)
+        {
+            g_list_free_full (list, delete_kvp_value);
+            return NULL;
+        }
+        reader->pos++;
+        return new KvpValue {g_list_reverse (list)};
+    }
+    case '{':
+    {
+        auto frame = new KvpFrame;
+        if (!read_slots (reader, frame))
+        {
+            delete frame;
+            return NULL;
+        }
+        return new KvpValue {frame};
+    }
+    default:
+        return NULL;
+    }
+}
+
+/* Reads the slots of a frame, after its opening brace, into frame. */
+static gboolean
+read_slots (blob_reader_t* reader, KvpFrame* frame)
+{
+    while (reader->pos < reader->end && *reader->pos != '}')
+    {
+        gchar* key = read_string (reader);
+        KvpValue* value;
+
+        if (key == NULL) return FALSE;
+        value = read_value (reader);
+        if (value == NULL)
+        {
+            g_free (key);
+            return FALSE;
+        }
+        delete frame->set (key, value);
+        g_free (key);
+    }
+    if (reader->pos >= reader->end) return FALSE;
+    reader->pos++;
+    return TRUE;
+}
+
+/* The book's slots, which hold its features, are always in rows. */
+static gboolean
+uses_blob (const GncSqlBackend* be, const GncGUID* guid)
+{
+    return be->slot_blobs &&
+           (be->book == NULL ||
+            !guid_equal (guid, qof_instance_get_guid (QOF_INSTANCE (be->book))));
+}
+
+static gboolean
+delete_blob (GncSqlBackend* be, const GncGUID* guid)
+{
+    blob_info_t blob_info = { guid, NULL, NULL };
+
+    return gnc_sql_do_db_operation (be, OP_DB_DELETE, BLOB_TABLE_NAME,
+                                    BLOB_TABLE_NAME, &blob_info, blob_col_table);
+}
+
+static gboolean
+save_blob (GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
+           QofInstance* inst)
+{
+    blob_info_t blob_info = { guid, inst->e_type, NULL };
+    KvpFrame* pFrame = qof_instance_get_slots (inst);
+    GString* blob;
+    gboolean is_ok = TRUE;
+
+    // If this is not saving into a new db, clear out the old saved blob first
+    if (!be->is_pristine_db && !is_infant)
+    {
+        is_ok = delete_blob (be, guid);
+    }
+    if (!is_ok || pFrame->empty ()) return is_ok;
+
+    blob = g_string_new ("{");
+    pFrame->for_each_slot (serialize_slot, blob);
+    (void)g_string_append_c (blob, '}');
+    blob_info.data = blob->str;
+    is_ok = gnc_sql_do_db_operation (be, OP_DB_INSERT, BLOB_TABLE_NAME,
+                                     BLOB_TABLE_NAME, &blob_info, blob_col_table);
+    (void)g_string_free (blob, TRUE);
+
+    return is_ok;
+}
+
+static void
+load_blob (QofInstance* inst, const gchar* data)
+{
+    blob_reader_t reader = { data, data + strlen (data) };
+    gboolean is_ok = (*reader.pos == '{');
+
+    if (is_ok)
+    {
+        reader.pos++;
+        is_ok = read_slots (&reader, qof_instance_get_slots (inst)) &&
+                reader.pos == reader.end;
+    }
+    if (!is_ok)
+    {
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+        (void)guid_to_string_buff (qof_instance_get_guid (inst), guid_buf);
+        PERR ("Invalid slots for %s %s\n", inst->e_type, guid_buf);
+    }
+}
+
+/**
+ * Loads the blobs selected by an SQL statement, for the objects in coll, or
+ * else those which lookup_fn finds.  Blobs of objects not in memory are
+ * skipped.
+ *
+ * @param be SQL backend
+ * @param sql SQL statement selecting obj_guid and data from the blob table
+ * @param coll Collection of the objects, or NULL
+ * @param lookup_fn Lookup function used when coll is NULL
+ */
+static void
+load_blobs_for_sql (GncSqlBackend* be, const gchar* sql, QofCollection* coll,
+                    BookLookupFn lookup_fn)
+{
+    GncSqlStatement* stmt;
+    GncSqlResult* result;
+    GncSqlRow* row;
+    gint guid_col = -1;
+    gint data_col = -1;
+
+    stmt = gnc_sql_create_statement_from_sql (be, sql);
+    if (stmt == NULL)
+    {
+        PERR ("stmt == NULL, SQL = '%s'\n", sql);
+        return;
+    }
+    result = gnc_sql_execute_select_statement (be, stmt);
+    gnc_sql_statement_dispose (stmt);
+    if (result == NULL) return;
+
+    for (row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        const gchar* guid_str;
+        const gchar* data;
+        GncGUID guid;
+        QofInstance* inst;
+
+        if (guid_col < 0)
+        {
+            guid_col = gnc_sql_row_get_col_index (row,
+                                                  blob_col_table[blob_obj_guid_col].col_name);
+            data_col = gnc_sql_row_get_col_index (row,
+                                                  blob_col_table[blob_data_col].col_name);
+        }
+        guid_str = gnc_sql_row_get_string_at_col (row, guid_col);
+        data = gnc_sql_row_get_string_at_col (row, data_col);
+        if (guid_str == NULL || data == NULL || !string_to_guid (guid_str, &guid))
+            continue;
+
+        if (coll != NULL)
+            inst = qof_collection_lookup_entity (coll, &guid);
+        else
+            inst = lookup_fn (&guid, be->book);
+        if (inst != NULL)
+            load_blob (inst, data);
+    }
+    gnc_sql_result_dispose (result);
+}
+
+/**
+ * Loads the blobs of a list of objects.  While the book is being loaded, a
+ * list holding most of the objects of its type is loaded by reading the
+ * blobs of the whole type in one scan, instead of looking each one up.
+ *
+ * @param be SQL backend
+ * @param list List of objects
+ * @param coll Collection of the objects
+ */
+static void
+load_blobs_for_list (GncSqlBackend* be, GList* list, QofCollection* coll)
+{
+    GString* sql;
+    guint count = g_list_length (list);
+
+    sql = g_string_sized_new (80 + (GUID_ENCODING_LENGTH + 3) * count);
+    g_string_printf (sql, "SELECT %s, %s FROM %s WHERE ",
+                     blob_col_table[blob_obj_guid_col].col_name,
+                     blob_col_table[blob_data_col].col_name, BLOB_TABLE_NAME);
+    if (be->loading && !be->in_query && count >= qof_collection_count (coll) / 2)
+    {
+        g_string_append_printf (sql, "%s='%s'",
+                                blob_col_table[blob_obj_type_col].col_name,
+                                qof_collection_get_type (coll));
+    }
+    else
+    {
+        g_string_append_printf (sql, "%s IN (",
+                                blob_col_table[blob_obj_guid_col].col_name);
+        (void)gnc_sql_append_guid_list_to_sql (sql, list, G_MAXUINT);
+        (void)g_string_append (sql, ")");
+    }
+    load_blobs_for_sql (be, sql->str, coll, NULL);
+    (void)g_string_free (sql, TRUE);
+}
+
 static void
 save_slot (const gchar* key, KvpValue* value, gpointer data)
 {
@@ -709,6 +1223,12 @@ gnc_sql_slots_save (GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
     g_return_val_if_fail (guid != NULL, FALSE);
     g_return_val_if_fail (pFrame != NULL, FALSE);
 
+    if (uses_blob (be, guid))
+    {
+        (void)g_string_free (slot_info.path, TRUE);
+        return save_blob (be, guid, is_infant, inst);
+    }
+
     // If this is not saving into a new db, clear out the old saved slots first
     if (!be->is_pristine_db && !is_infant)
     {
@@ -717,16 +1237,31 @@ gnc_sql_slots_save (GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
 
     slot_info.be = be;
     slot_info.guid = guid;
+    gnc_sql_begin_insert_batch (be);
     pFrame->for_each_slot (save_slot, &slot_info);
+    if (!gnc_sql_end_insert_batch (be))
+    {
+        slot_info.is_ok = FALSE;
+    }
     (void)g_string_free (slot_info.path, TRUE);
 
     return slot_info.is_ok;
 }
 
-gboolean
-gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
+/**
+ * Deletes the slots of an object, or only its slot with the given name,
+ * together with the slots of the frames and lists among them.
+ *
+ * @param be SQL backend
+ * @param guid Object guid
+ * @param name Name of the slot to delete, or NULL for all of them
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+delete_slots (GncSqlBackend* be, const GncGUID* guid, const gchar* name)
 {
     gchar* buf;
+    gchar* name_cond = NULL;
     GncSqlResult* result;
     gchar guid_buf[GUID_ENCODING_LENGTH + 1];
     GncSqlStatement* stmt;
@@ -737,8 +1272,17 @@ gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
 
     (void)guid_to_string_buff (guid, guid_buf);
 
-    buf = g_strdup_printf ("SELECT * FROM %s WHERE obj_guid='%s' and slot_type in ('%d', '%d') and not guid_val is null",
-                           TABLE_NAME, guid_buf, KvpValue::Type::FRAME, KvpValue::Type::GLIST);
+    if (name != NULL)
+    {
+        gchar* quoted = gnc_sql_connection_quote_string (be->conn,
+                                                         (gchar*)name);
+        name_cond = g_strdup_printf (" and name=%s", quoted);
+        g_free (quoted);
+    }
+
+    buf = g_strdup_printf ("SELECT * FROM %s WHERE obj_guid='%s'%s and slot_type in ('%d', '%d') and not guid_val is null",
+                           TABLE_NAME, guid_buf, name_cond != NULL ? name_cond : "",
+                           KvpValue::Type::FRAME, KvpValue::Type::GLIST);
     stmt = gnc_sql_create_statement_from_sql (be, buf);
     g_free (buf);
     if (stmt != NULL)
@@ -759,7 +1303,7 @@ gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
                     continue;
 
                 (void)string_to_guid (g_value_get_string (val), &child_guid);
-                gnc_sql_slots_delete (be, &child_guid);
+                delete_slots (be, &child_guid, NULL);
                 row = gnc_sql_result_get_next_row (result);
             }
             gnc_sql_result_dispose (result);
@@ -769,8 +1313,83 @@ gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
     slot_info.be = be;
     slot_info.guid = guid;
     slot_info.is_ok = TRUE;
-    slot_info.is_ok = gnc_sql_do_db_operation (be, OP_DB_DELETE, TABLE_NAME,
-                                               TABLE_NAME, &slot_info, obj_guid_col_table);
+    if (name == NULL)
+    {
+        slot_info.is_ok = gnc_sql_do_db_operation (be, OP_DB_DELETE, TABLE_NAME,
+                                                   TABLE_NAME, &slot_info, obj_guid_col_table);
+    }
+    else
+    {
+        buf = g_strdup_printf ("DELETE FROM %s WHERE obj_guid='%s'%s",
+                               TABLE_NAME, guid_buf, name_cond);
+        slot_info.is_ok = gnc_sql_execute_nonselect_sql (be, buf) != -1;
+        g_free (buf);
+    }
+    g_free (name_cond);
+    (void)g_string_free (slot_info.path, TRUE);
+
+    return slot_info.is_ok;
+}
+
+gboolean
+gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
+{
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (guid != NULL, FALSE);
+
+    if (uses_blob (be, guid))
+        return delete_blob (be, guid);
+    return delete_slots (be, guid, NULL);
+}
+
+gboolean
+gnc_sql_slots_save_changed (GncSqlBackend* be, const GncGUID* guid,
+                            gboolean is_infant, QofInstance* inst)
+{
+    slot_info_t slot_info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID, NULL, FRAME, NULL, g_string_new (NULL) };
+    KvpFrame* pFrame = qof_instance_get_slots (inst);
+
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (guid != NULL, FALSE);
+    g_return_val_if_fail (pFrame != NULL, FALSE);
+
+    // Nothing of the object's is in the db yet
+    if (be->is_pristine_db || is_infant)
+    {
+        (void)g_string_free (slot_info.path, TRUE);
+        return gnc_sql_slots_save (be, guid, is_infant, inst);
+    }
+
+    // A blob holds all of the slots, so it is rewritten if any of them changed
+    if (uses_blob (be, guid))
+    {
+        (void)g_string_free (slot_info.path, TRUE);
+        return pFrame->is_changed () ? save_blob (be, guid, FALSE, inst) : TRUE;
+    }
+
+    // Which of the removed slots to delete isn't known, so replace them all
+    if (pFrame->all_changed ())
+    {
+        (void)g_string_free (slot_info.path, TRUE);
+        return gnc_sql_slots_save (be, guid, FALSE, inst);
+    }
+
+    slot_info.be = be;
+    slot_info.guid = guid;
+    gnc_sql_begin_insert_batch (be);
+    for (const auto& key : pFrame->get_changed_keys ())
+    {
+        if (!slot_info.is_ok) break;
+        slot_info.is_ok = delete_slots (be, guid, key.c_str ());
+        auto value = pFrame->get_slot (key.c_str ());
+        if (slot_info.is_ok && value != nullptr)
+            save_slot (key.c_str (), value, &slot_info);
+    }
+    if (!gnc_sql_end_insert_batch (be))
+    {
+        slot_info.is_ok = FALSE;
+    }
+    (void)g_string_free (slot_info.path, TRUE);
 
     return slot_info.is_ok;
 }
@@ -812,10 +1431,28 @@ load_slot (slot_info_t* pInfo, GncSqlRow* row)
 void
 gnc_sql_slots_load (GncSqlBackend* be, QofInstance* inst)
 {
-    slot_info_t info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID, NULL, FRAME, NULL, g_string_new (NULL) };
+    slot_info_t info = { NULL, NULL, TRUE, NULL, KvpValue::Type::INVALID, NULL, FRAME, NULL, NULL };
     g_return_if_fail (be != NULL);
     g_return_if_fail (inst != NULL);
 
+    if (uses_blob (be, qof_instance_get_guid (inst)))
+    {
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+        gchar* sql;
+
+        (void)guid_to_string_buff (qof_instance_get_guid (inst), guid_buf);
+        sql = g_strdup_printf ("SELECT %s, %s FROM %s WHERE %s='%s'",
+                               blob_col_table[blob_obj_guid_col].col_name,
+                               blob_col_table[blob_data_col].col_name,
+                               BLOB_TABLE_NAME,
+                               blob_col_table[blob_obj_guid_col].col_name,
+                               guid_buf);
+        load_blobs_for_sql (be, sql, qof_instance_get_collection (inst), NULL);
+        g_free (sql);
+        return;
+    }
+    info.path = g_string_new (NULL);
+
     info.be = be;
     info.guid = qof_instance_get_guid (inst);
     info.pKvpFrame = qof_instance_get_slots (inst);
@@ -917,6 +1554,11 @@ gnc_sql_slots_load_for_list (GncSqlBackend* be, GList* list)
     if (list == NULL) return;
 
     coll = qof_instance_get_collection (QOF_INSTANCE (list->data));
+    if (be->slot_blobs)
+    {
+        load_blobs_for_list (be, list, coll);
+        return;
+    }
 
     // Create the query for all slots for all items on the list
     sql = g_string_sized_new (40 + (GUID_ENCODING_LENGTH + 3) * g_list_length (
@@ -1014,6 +1656,19 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* be,
     // Ignore empty subquery
     if (subquery == NULL) return;
 
+    if (be->slot_blobs)
+    {
+        sql = g_strdup_printf ("SELECT %s, %s FROM %s WHERE %s IN (%s)",
+                               blob_col_table[blob_obj_guid_col].col_name,
+                               blob_col_table[blob_data_col].col_name,
+                               BLOB_TABLE_NAME,
+                               blob_col_table[blob_obj_guid_col].col_name,
+                               subquery);
+        load_blobs_for_sql (be, sql, NULL, lookup_fn);
+        g_free (sql);
+        return;
+    }
+
     sql = g_strdup_printf ("SELECT * FROM %s WHERE %s IN (%s)",
                            TABLE_NAME, obj_guid_col_table[0].col_name,
                            subquery);
@@ -1042,6 +1697,54 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* be,
     }
 }
 
+/* ================================================================= */
+void
+gnc_sql_slots_init_storage (GncSqlBackend* be, QofBook* book)
+{
+    KvpFrame* frame;
+
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (book != NULL);
+
+    frame = qof_instance_get_slots (QOF_INSTANCE (book));
+    be->slot_blobs = frame->get_slot ({"features", GNC_FEATURE_SQL_SLOT_BLOBS})
+                     != nullptr;
+}
+
+/* Sets or clears the book's feature without committing the book, whose
+ * slots are written with the converted ones. */
+static void
+set_storage_feature (GncSqlBackend* be, gboolean use_blobs)
+{
+    gboolean was_loading = be->loading;
+
+    be->loading = TRUE;
+    if (use_blobs)
+    {
+        gnc_features_set_used (be->book, GNC_FEATURE_SQL_SLOT_BLOBS);
+    }
+    else
+    {
+        KvpFrame* frame = qof_instance_get_slots (QOF_INSTANCE (be->book));
+        delete frame->set ({"features", GNC_FEATURE_SQL_SLOT_BLOBS}, nullptr);
+    }
+    be->loading = was_loading;
+}
+
+void
+gnc_sql_slots_set_storage (GncSqlBackend* be, gboolean use_blobs)
+{
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (be->book != NULL);
+    g_return_if_fail (be->is_pristine_db);
+
+    use_blobs = use_blobs ? TRUE : FALSE;
+    if (use_blobs == be->slot_blobs) return;
+
+    set_storage_feature (be, use_blobs);
+    be->slot_blobs = use_blobs;
+}
+
 /* ================================================================= */
 static void
 create_slots_tables (GncSqlBackend* be)
@@ -1091,6 +1794,13 @@ create_slots_tables (GncSqlBackend* be)
         PINFO ("Slots table upgraded from version %d to version %d\n", version,
                TABLE_VERSION);
     }
+
+    version = gnc_sql_get_table_version (be, BLOB_TABLE_NAME);
+    if (version == 0)
+    {
+        (void)gnc_sql_create_table (be, BLOB_TABLE_NAME, BLOB_TABLE_VERSION,
+                                    blob_col_table);
+    }
 }
 
 /* ================================================================= */
@@ -48,6 +48,21 @@ extern "C"
 gboolean gnc_sql_slots_save (GncSqlBackend* be, const GncGUID* guid,
                              gboolean is_infant, QofInstance* inst);
 
+/**
+ * gnc_sql_slots_save_changed - Saves the slots of an object which changed
+ * since its KvpFrame's changes were last cleared, replacing only their rows.
+ * Saves all of them into a new db or for an infant object.  The caller
+ * clears the changes once the save is committed.
+ *
+ * @param be SQL backend
+ * @param guid Object guid
+ * @param is_infant Is this an infant object?
+ * @param inst The QofInstance owning the slots.
+ * @return TRUE if successful, FALSE if error
+ */
+gboolean gnc_sql_slots_save_changed (GncSqlBackend* be, const GncGUID* guid,
+                                     gboolean is_infant, QofInstance* inst);
+
 /**
  * gnc_sql_slots_delete - Deletes slots for an object from the db.
  *
@@ -89,6 +104,30 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* be,
                                           const gchar* subquery,
                                           BookLookupFn lookup_fn);
 
+/**
+ * gnc_sql_slots_init_storage - Sets how the slots of the book's objects are
+ * stored from the book's GNC_FEATURE_SQL_SLOT_BLOBS feature: either in rows
+ * of the slots table, one per value, or as one serialized frame per object
+ * in the slot_blobs table.  The book's own slots are always kept in rows, so
+ * that its features can be read before anything else is loaded.
+ *
+ * @param be SQL backend
+ * @param book The book being loaded or saved
+ */
+void gnc_sql_slots_init_storage (GncSqlBackend* be, QofBook* book);
+
+/**
+ * gnc_sql_slots_set_storage - Sets how the slots of the book's objects are
+ * stored in a db which is being written from scratch, and records it in the
+ * book's features.  Slots already in a db are never converted in place: a
+ * book changes mode when it is saved again, e.g. with Save As.
+ *
+ * @param be SQL backend, whose db must be pristine
+ * @param use_blobs TRUE to store one serialized frame per object, FALSE to
+ * store rows
+ */
+void gnc_sql_slots_set_storage (GncSqlBackend* be, gboolean use_blobs);
+
 void gnc_sql_init_slots_handler (void);
 
 #endif /* GNC_SLOTS_SQL_H */
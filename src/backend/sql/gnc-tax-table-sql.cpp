@@ -511,9 +511,11 @@ write_taxtables (GncSqlBackend* be)
 static void
 load_taxtable_guid (const GncSqlBackend* be, GncSqlRow* row,
                     QofSetterFunc setter, gpointer pObject,
-                    const GncSqlColumnTableEntry* table_row)
+                    const GncSqlColumnTableEntry* table_row,
+                    const gint* cols)
 {
-    const GValue* val;
+    gint col;
+    const gchar* guid_str;
     GncGUID guid;
     GncTaxTable* taxtable = NULL;
 
@@ -522,11 +524,11 @@ load_taxtable_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    if (val != NULL && G_VALUE_HOLDS_STRING (val) &&
-        g_value_get_string (val) != NULL)
+    col = cols[0];
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
+    if (guid_str != NULL)
     {
-        string_to_guid (g_value_get_string (val), &guid);
+        string_to_guid (guid_str, &guid);
         taxtable = gncTaxTableLookup (be->book, &guid);
         if (taxtable != NULL)
         {
@@ -543,7 +545,7 @@ load_taxtable_guid (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            PWARN ("Taxtable ref '%s' not found", g_value_get_string (val));
+            PWARN ("Taxtable ref '%s' not found", guid_str);
         }
     }
 }
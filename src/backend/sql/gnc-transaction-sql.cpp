@@ -38,26 +38,26 @@ extern "C"
 
 #include "Account.h"
 #include "Transaction.h"
+#include "TransactionP.h"
+#include "TransLog.h"
 #include <Scrub.h>
 #include "gnc-lot.h"
 #include "engine-helpers.h"
 #include "gnc-commodity.h"
 #include "gnc-engine.h"
+#include "gnc-prefs.h"
 
 #ifdef S_SPLINT_S
 #include "splint-defs.h"
 #endif
 }
 
-#include "escape.h"
-
 #include "gnc-backend-sql.h"
 #include "gnc-transaction-sql.h"
 #include "gnc-commodity-sql.h"
 #include "gnc-slots-sql.h"
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
+#include <kvp_frame.hpp>
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
@@ -87,6 +87,17 @@ static const GncSqlColumnTableEntry tx_col_table[] =
     { NULL }
 };
 
+/* The TRANS_DIRTY_* field stored in each column of tx_col_table */
+static const guint tx_col_fields[] =
+{
+    0,
+    TRANS_DIRTY_CURRENCY,
+    TRANS_DIRTY_NUM,
+    TRANS_DIRTY_DATE_POSTED,
+    TRANS_DIRTY_DATE_ENTERED,
+    TRANS_DIRTY_DESCRIPTION
+};
+
 static  gpointer get_split_reconcile_state (gpointer pObject);
 static void set_split_reconcile_state (gpointer pObject,  gpointer pValue);
 static void set_split_lot (gpointer pObject,  gpointer pLot);
@@ -115,6 +126,26 @@ static const GncSqlColumnTableEntry split_col_table[] =
     { NULL }
 };
 
+/* The SPLIT_DIRTY_* field stored in each column of split_col_table */
+static const guint split_col_fields[] =
+{
+    0,
+    SPLIT_DIRTY_PARENT,
+    SPLIT_DIRTY_ACCOUNT,
+    SPLIT_DIRTY_MEMO,
+    SPLIT_DIRTY_ACTION,
+    SPLIT_DIRTY_RECONCILE,
+    SPLIT_DIRTY_DATE_RECONCILED,
+    SPLIT_DIRTY_VALUE,
+    SPLIT_DIRTY_AMOUNT,
+    SPLIT_DIRTY_LOT
+};
+
+G_STATIC_ASSERT (G_N_ELEMENTS (tx_col_fields) ==
+                 G_N_ELEMENTS (tx_col_table) - 1);
+G_STATIC_ASSERT (G_N_ELEMENTS (split_col_fields) ==
+                 G_N_ELEMENTS (split_col_table) - 1);
+
 static const GncSqlColumnTableEntry post_date_col_table[] =
 {
     { "post_date", CT_TIMESPEC, 0, 0, "post-date" },
@@ -212,6 +243,7 @@ load_single_split (GncSqlBackend* be, GncSqlRow* row)
     if (!qof_instance_is_dirty (QOF_INSTANCE (pSplit)))
     {
         gnc_sql_load_object (be, row, GNC_ID_SPLIT, pSplit, split_col_table);
+        xaccSplitClearDirtyFields (pSplit);
     }
 
     /*# -ifempty */
@@ -226,6 +258,13 @@ load_single_split (GncSqlBackend* be, GncSqlRow* row)
     return pSplit;
 }
 
+/* The slots just loaded are those in the db. */
+static void
+clear_slots_changes (gpointer data, gpointer user_data)
+{
+    qof_instance_get_slots (QOF_INSTANCE (data))->clear_changed ();
+}
+
 static void
 load_splits_for_tx_list (GncSqlBackend* be, GList* list)
 {
@@ -265,6 +304,7 @@ load_splits_for_tx_list (GncSqlBackend* be, GList* list)
         if (split_list != NULL)
         {
             gnc_sql_slots_load_for_list (be, split_list);
+            g_list_foreach (split_list, clear_slots_changes, NULL);
             g_list_free (split_list);
         }
 
@@ -297,6 +337,7 @@ load_single_tx (GncSqlBackend* be, GncSqlRow* row)
     pTx = xaccMallocTransaction (be->book);
     xaccTransBeginEdit (pTx);
     gnc_sql_load_object (be, row, GNC_ID_TRANS, pTx, tx_col_table);
+    xaccTransClearDirtyFields (pTx);
 
     if (pTx != xaccTransLookup (&tx_guid, be->book))
     {
@@ -310,302 +351,1108 @@ load_single_tx (GncSqlBackend* be, GncSqlRow* row)
     return pTx;
 }
 
-/**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
+/* ----------------------------------------------------------------- */
+/* Loading transactions as needed
+ *
+ * When the sql-load-as-needed preference is set, the initial load reads
+ * no transactions.  Queries read them instead, a unit at a time: the
+ * transactions with a split matching the query's SQL condition, for
+ * instance those in an account, or in an account and a range of posted
+ * dates.  Each unit records the transactions it matched and the units are
+ * kept in most recently used order.  A query holds the unit it loaded for
+ * as long as the query lives, so its results stay in memory.
+ *
+ * The accounts' start balances stand in for the splits which haven't been
+ * loaded.  For running, cleared and reconciled balances and balances as
+ * of a date to be right, those splits must all be older than the ones
+ * which have been, so each account has a horizon: the start of the day
+ * from which all of its splits are in memory.  Loading a split from
+ * before its account's horizon also loads the splits in between, and
+ * only the splits before a later horizon are dropped again.
+ *
+ * Once the units hold more transactions than the sql-cache-size
+ * preference, the least recently used units no query holds are dropped,
+ * and with them, in memory only, the transactions that no other unit
+ * holds, which haven't been edited this session and which nothing else
+ * has a reference to.  That is done when the program is idle, as no
+ * caller can then be using the transactions without a reference, or when
+ * gnc_sql_transaction_cache_evict() is called.
  */
 typedef struct
 {
-    Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
+    gchar* condition;           /* SQL condition on t and s */
+    GArray* guids;              /* GncGUID of each transaction matched */
+    gint refs;                  /* The cache's and each query's using it */
+} tx_cache_unit_t;
+
+struct GncSqlTxCache
+{
+    GQueue units;               /* tx_cache_unit_t, most recently used first */
+    GHashTable* unit_index;     /* condition -> link in units */
+    GHashTable* holds;          /* GncGUID -> number of units holding it */
+    GHashTable* pinned;         /* GncGUID of transactions to keep */
+    GHashTable* horizons;       /* GncGUID of an account -> time64 from
+                                   which all of its splits are loaded */
+    GHashTable* edited_days;    /* GncGUID of an account -> time64 of an
+                                   edited split before its horizon */
+    GHashTable* loaded_accounts; /* GncGUID of accounts whose transactions
+                                   are all loaded and pinned */
+    guint max_transactions;
+    guint evict_source;         /* Idle source dropping transactions, or 0 */
+    gboolean all_loaded;
+    gboolean evicting;
+};
+
+static void
+tx_cache_unit_unref (tx_cache_unit_t* unit)
+{
+    if (--unit->refs > 0) return;
+
+    g_free (unit->condition);
+    g_array_free (unit->guids, TRUE);
+    g_free (unit);
+}
+
+static void
+tx_cache_hold (GncSqlTxCache* cache, const GncGUID* guid)
+{
+    gint count = GPOINTER_TO_INT (g_hash_table_lookup (cache->holds, guid));
+
+    if (count == 0)
+        g_hash_table_insert (cache->holds, guid_copy (guid), GINT_TO_POINTER (1));
+    else
+        g_hash_table_replace (cache->holds, guid_copy (guid),
+                              GINT_TO_POINTER (count + 1));
+}
+
+/* Holds the transactions from the first'th of a unit's on. */
+static void
+tx_cache_hold_unit (GncSqlTxCache* cache, tx_cache_unit_t* unit, guint first)
+{
+    guint i;
+
+    for (i = first; i < unit->guids->len; i++)
+        tx_cache_hold (cache, &g_array_index (unit->guids, GncGUID, i));
+}
+
+/* Returns TRUE if no unit holds the transaction any more. */
+static gboolean
+tx_cache_release (GncSqlTxCache* cache, const GncGUID* guid)
+{
+    gint count = GPOINTER_TO_INT (g_hash_table_lookup (cache->holds, guid));
+
+    if (count > 1)
+    {
+        g_hash_table_replace (cache->holds, guid_copy (guid),
+                              GINT_TO_POINTER (count - 1));
+        return FALSE;
+    }
+    g_hash_table_remove (cache->holds, guid);
+    return TRUE;
+}
+
+static void
+tx_cache_pin (GncSqlBackend* be, const GncGUID* guid)
+{
+    if (be->tx_cache != NULL && !be->tx_cache->all_loaded)
+        g_hash_table_add (be->tx_cache->pinned, guid_copy (guid));
+}
+
+static GHashTable*
+new_account_day_table (void)
+{
+    return g_hash_table_new_full (guid_hash_to_guint, guid_g_hash_table_equal,
+                                  (GDestroyNotify)guid_free, g_free);
+}
+
+static time64
+tx_day (Transaction* tx)
+{
+    return gnc_time64_get_day_start (xaccTransGetDate (tx));
+}
 
 /**
- * Executes a transaction query statement and loads the transactions and all
- * of the splits.
+ * Notes, for each account of a transaction's splits whose horizon is
+ * after the transaction's day, the earliest such day.
  *
- * @param be SQL backend
- * @param stmt SQL statement
+ * @param cache Transaction cache
+ * @param days Account GUID -> day
+ * @param tx Transaction
  */
 static void
-query_transactions (GncSqlBackend* be, GncSqlStatement* stmt)
+note_days_before_horizons (GncSqlTxCache* cache, GHashTable* days,
+                           Transaction* tx)
 {
-    GncSqlResult* result;
-
-    g_return_if_fail (be != NULL);
-    g_return_if_fail (stmt != NULL);
+    time64 day = tx_day (tx);
+    GList* node;
 
-    result = gnc_sql_execute_select_statement (be, stmt);
-    if (result != NULL)
+    for (node = xaccTransGetSplitList (tx); node != NULL; node = node->next)
     {
-        GList* tx_list = NULL;
-        GList* node;
-        GncSqlRow* row;
-        Transaction* tx;
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        GSList* bal_list = NULL;
-        GSList* nextbal;
-        Account* root = gnc_book_get_root_account (be->book);
-
-        qof_event_suspend ();
-        xaccAccountBeginEdit (root);
-
-        // Save the start/ending balances (balance, cleared and reconciled) for
-        // every account.
-        gnc_account_foreach_descendant (gnc_book_get_root_account (be->primary_book),
-                                        save_account_balances,
-                                        &bal_list);
-#endif
-
-        // Load the transactions
-        row = gnc_sql_result_get_first_row (result);
-        while (row != NULL)
+        Account* acc = xaccSplitGetAccount (GNC_SPLIT (node->data));
+        const GncGUID* guid;
+        time64* horizon;
+        time64* noted;
+
+        if (acc == NULL) continue;
+        guid = qof_instance_get_guid (QOF_INSTANCE (acc));
+        horizon = (time64*)g_hash_table_lookup (cache->horizons, guid);
+        if (horizon != NULL && day >= *horizon) continue;
+
+        noted = (time64*)g_hash_table_lookup (days, guid);
+        if (noted == NULL)
         {
-            tx = load_single_tx (be, row);
-            if (tx != NULL)
-            {
-                tx_list = g_list_prepend (tx_list, tx);
-                xaccTransScrubPostedDate (tx);
-            }
-            row = gnc_sql_result_get_next_row (result);
+            noted = g_new (time64, 1);
+            *noted = day;
+            g_hash_table_insert (days, guid_copy (guid), noted);
         }
-        gnc_sql_result_dispose (result);
-
-        // Load all splits and slots for the transactions
-        if (tx_list != NULL)
+        else if (day < *noted)
         {
-            gnc_sql_slots_load_for_list (be, tx_list);
-            load_splits_for_tx_list (be, tx_list);
+            *noted = day;
         }
+    }
+}
 
-        // Commit all of the transactions
-        for (node = tx_list; node != NULL; node = node->next)
-        {
-            Transaction* pTx = GNC_TRANSACTION (node->data);
-            xaccTransCommitEdit (pTx);
-        }
-        g_list_free (tx_list);
+/* An edited transaction mustn't be dropped from memory, and its splits
+ * may now be before their accounts' horizons. */
+static void
+tx_cache_note_edit (GncSqlBackend* be, Transaction* tx)
+{
+    GncSqlTxCache* cache = be->tx_cache;
+
+    if (cache == NULL || cache->all_loaded) return;
+
+    g_hash_table_add (cache->pinned, guid_copy (qof_instance_get_guid (tx)));
+    if (!qof_instance_get_destroying (tx))
+        note_days_before_horizons (cache, cache->edited_days, tx);
+}
+
+typedef struct
+{
+    gnc_numeric balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+} start_balances_t;
+
+static void
+shift_account_start_balances (gpointer key, gpointer value, gpointer user_data)
+{
+    Account* acc = GNC_ACCOUNT (key);
+    start_balances_t* shift = (start_balances_t*)value;
+    gnc_numeric* start_bal;
+    gnc_numeric* start_cleared_bal;
+    gnc_numeric* start_reconciled_bal;
+
+    g_object_get (acc,
+                  "start-balance", &start_bal,
+                  "start-cleared-balance", &start_cleared_bal,
+                  "start-reconciled-balance", &start_reconciled_bal,
+                  NULL);
+    gnc_account_set_start_balance (acc,
+                                   gnc_numeric_add (*start_bal, shift->balance,
+                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD));
+    gnc_account_set_start_cleared_balance (acc,
+                                           gnc_numeric_add (*start_cleared_bal,
+                                                            shift->cleared_balance,
+                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD));
+    gnc_account_set_start_reconciled_balance (acc,
+                                              gnc_numeric_add (*start_reconciled_bal,
+                                                               shift->reconciled_balance,
+                                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD));
+    xaccAccountRecomputeBalance (acc);
+    g_free (start_bal);
+    g_free (start_cleared_bal);
+    g_free (start_reconciled_bal);
+}
+
+/**
+ * Moves the start balances of the accounts of the transactions' splits so
+ * that the accounts' balances don't change when the transactions are added
+ * to (loaded is TRUE) or removed from the book.
+ *
+ * @param tx_list List of transactions
+ * @param loaded TRUE if the transactions have just been loaded
+ */
+static void
+shift_start_balances (GList* tx_list, gboolean loaded)
+{
+    GHashTable* shifts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                NULL, g_free);
+    GList* node;
+
+    for (node = tx_list; node != NULL; node = node->next)
+    {
+        GList* snode;
 
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        // Update the account balances based on the loaded splits.  If the end
-        // balance has changed, update the start balance so that the end
-        // balance is the same as it was before the splits were loaded.
-        // Repeat for cleared and reconciled balances.
-        for (nextbal = bal_list; nextbal != NULL; nextbal = nextbal->next)
+        for (snode = xaccTransGetSplitList (GNC_TRANSACTION (node->data));
+             snode != NULL; snode = snode->next)
         {
-            full_acct_balances_t* balns = (full_acct_balances_t*)nextbal->data;
-            gnc_numeric* pnew_end_bal;
-            gnc_numeric* pnew_end_c_bal;
-            gnc_numeric* pnew_end_r_bal;
-            gnc_numeric adj;
-
-            g_object_get (balns->acc,
-                          "end-balance", &pnew_end_bal,
-                          "end-cleared-balance", &pnew_end_c_bal,
-                          "end-reconciled-balance", &pnew_end_r_bal,
-                          NULL);
-
-            qof_instance_increase_editlevel (balns - acc);
-            if (!gnc_numeric_eq (*pnew_end_bal, balns->end_bal))
-            {
-                adj = gnc_numeric_sub (balns->end_bal, *pnew_end_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_bal = gnc_numeric_add (balns->start_bal, adj,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-balance", &balns->start_bal, NULL);
-                qof_instance_decrease_editlevel (balns - acc);
-            }
-            if (!gnc_numeric_eq (*pnew_end_c_bal, balns->end_cleared_bal))
-            {
-                adj = gnc_numeric_sub (balns->end_cleared_bal, *pnew_end_c_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_cleared_bal = gnc_numeric_add (balns->start_cleared_bal, adj,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-cleared-balance", &balns->start_cleared_bal,
-                              NULL);
-            }
-            if (!gnc_numeric_eq (*pnew_end_r_bal, balns->end_reconciled_bal))
+            Split* split = GNC_SPLIT (snode->data);
+            Account* acc = xaccSplitGetAccount (split);
+            gnc_numeric amount = xaccSplitGetAmount (split);
+            char state = xaccSplitGetReconcile (split);
+            start_balances_t* shift;
+
+            if (acc == NULL) continue;
+            if (loaded) amount = gnc_numeric_neg (amount);
+
+            shift = (start_balances_t*)g_hash_table_lookup (shifts, acc);
+            if (shift == NULL)
             {
-                adj = gnc_numeric_sub (balns->end_reconciled_bal, *pnew_end_r_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_reconciled_bal = gnc_numeric_add (balns->start_reconciled_bal,
-                                                               adj,
-                                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-reconciled-balance",
-                              &balns->start_reconciled_bal, NULL);
+                shift = g_new (start_balances_t, 1);
+                shift->balance = gnc_numeric_zero ();
+                shift->cleared_balance = gnc_numeric_zero ();
+                shift->reconciled_balance = gnc_numeric_zero ();
+                g_hash_table_insert (shifts, acc, shift);
             }
-            qof_instance_decrease_editlevel (balns - acc);
-            xaccAccountRecomputeBalance (balns->acc);
-            g_free (pnew_end_bal);
-            g_free (pnew_end_c_bal);
-            g_free (pnew_end_r_bal);
-            g_free (balns);
-        }
-        if (bal_list != NULL)
-        {
-            g_slist_free (bal_list);
+            shift->balance = gnc_numeric_add (shift->balance, amount,
+                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            if (state != NREC)
+                shift->cleared_balance = gnc_numeric_add (shift->cleared_balance,
+                                                          amount, GNC_DENOM_AUTO,
+                                                          GNC_HOW_DENOM_LCD);
+            if (state == YREC || state == FREC)
+                shift->reconciled_balance = gnc_numeric_add (shift->reconciled_balance,
+                                                             amount, GNC_DENOM_AUTO,
+                                                             GNC_HOW_DENOM_LCD);
         }
-
-        xaccAccountCommitEdit (root);
-        qof_event_resume ();
-#endif
     }
+    g_hash_table_foreach (shifts, shift_account_start_balances, NULL);
+    g_hash_table_destroy (shifts);
 }
 
-/* ================================================================= */
 /**
- * Creates the transaction and split tables.
+ * Executes a transaction query statement and loads the transactions and all
+ * of the splits.
  *
  * @param be SQL backend
+ * @param stmt SQL statement
+ * @param guids If not NULL, the GUIDs of all of the transactions selected,
+ * whether loaded now or before, are appended to it
+ * @param loaded If not NULL, set to a list of the transactions loaded now,
+ * which the caller frees
+ * @return TRUE if the query was executed
  */
-static void
-create_transaction_tables (GncSqlBackend* be)
+static gboolean
+query_transactions (GncSqlBackend* be, GncSqlStatement* stmt, GArray* guids,
+                    GList** loaded)
 {
-    gint version;
-    gboolean ok;
+    GncSqlResult* result;
+    GList* tx_list = NULL;
+    GList* node;
+    GncSqlRow* row;
+    Transaction* tx;
 
-    g_return_if_fail (be != NULL);
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (stmt != NULL, FALSE);
 
-    version = gnc_sql_get_table_version (be, TRANSACTION_TABLE);
-    if (version == 0)
+    result = gnc_sql_execute_select_statement (be, stmt);
+    if (result == NULL) return FALSE;
+
+    // Load the transactions
+    row = gnc_sql_result_get_first_row (result);
+    while (row != NULL)
     {
-        (void)gnc_sql_create_table (be, TRANSACTION_TABLE, TX_TABLE_VERSION,
-                                    tx_col_table);
-        ok = gnc_sql_create_index (be, "tx_post_date_index", TRANSACTION_TABLE,
-                                   post_date_col_table);
-        if (!ok)
+        if (guids != NULL)
         {
-            PERR ("Unable to create index\n");
+            const GncGUID* guid = gnc_sql_load_guid (be, row);
+            if (guid != NULL) g_array_append_val (guids, *guid);
+        }
+        tx = load_single_tx (be, row);
+        if (tx != NULL)
+        {
+            tx_list = g_list_prepend (tx_list, tx);
+            xaccTransScrubPostedDate (tx);
         }
+        row = gnc_sql_result_get_next_row (result);
     }
-    else if (version < TX_TABLE_VERSION)
+    gnc_sql_result_dispose (result);
+
+    // Load all splits and slots for the transactions
+    if (tx_list != NULL)
     {
-        /* Upgrade:
-            1->2: 64 bit int handling
-            2->3: allow dates to be NULL
-        */
-        gnc_sql_upgrade_table (be, TRANSACTION_TABLE, tx_col_table);
-        (void)gnc_sql_set_table_version (be, TRANSACTION_TABLE, TX_TABLE_VERSION);
-        PINFO ("Transactions table upgraded from version %d to version %d\n", version,
-               TX_TABLE_VERSION);
+        gnc_sql_slots_load_for_list (be, tx_list);
+        g_list_foreach (tx_list, clear_slots_changes, NULL);
+        load_splits_for_tx_list (be, tx_list);
     }
 
-    version = gnc_sql_get_table_version (be, SPLIT_TABLE);
-    if (version == 0)
+    // The start balances of the accounts already count the splits of
+    // transactions which haven't been loaded.
+    if (be->tx_cache != NULL)
+        shift_start_balances (tx_list, TRUE);
+
+    // Commit all of the transactions
+    for (node = tx_list; node != NULL; node = node->next)
     {
-        (void)gnc_sql_create_table (be, SPLIT_TABLE, SPLIT_TABLE_VERSION,
-                                    split_col_table);
-        ok = gnc_sql_create_index (be, "splits_tx_guid_index", SPLIT_TABLE,
-                                   tx_guid_col_table);
-        if (!ok)
-        {
-            PERR ("Unable to create index\n");
-        }
-        ok = gnc_sql_create_index (be, "splits_account_guid_index", SPLIT_TABLE,
-                                   account_guid_col_table);
-        if (!ok)
-        {
-            PERR ("Unable to create index\n");
-        }
+        Transaction* pTx = GNC_TRANSACTION (node->data);
+        xaccTransCommitEdit (pTx);
     }
-    else if (version < SPLIT_TABLE_VERSION)
+    if (loaded != NULL)
+        *loaded = tx_list;
+    else
+        g_list_free (tx_list);
+
+    return TRUE;
+}
+
+/**
+ * Moves the horizons of accounts back to the days given, loading the
+ * splits in between, then does the same for the accounts whose horizons
+ * the transactions loaded are before, until none are.
+ *
+ * @param be SQL backend
+ * @param days Account GUID -> day, destroyed
+ * @param guids If not NULL, the GUIDs of the transactions selected are
+ * appended to it
+ */
+static void
+extend_horizons (GncSqlBackend* be, GHashTable* days, GArray* guids)
+{
+    GncSqlTxCache* cache = be->tx_cache;
+
+    while (g_hash_table_size (days) > 0)
     {
+        GHashTable* next_days = new_account_day_table ();
+        GHashTableIter iter;
+        gpointer key;
+        gpointer value;
 
-        /* Upgrade:
-           1->2: 64 bit int handling
-           3->4: Split reconcile date can be NULL */
-        gnc_sql_upgrade_table (be, SPLIT_TABLE, split_col_table);
-        ok = gnc_sql_create_index (be, "splits_tx_guid_index", SPLIT_TABLE,
-                                   tx_guid_col_table);
-        if (!ok)
-        {
-            PERR ("Unable to create index\n");
-        }
-        ok = gnc_sql_create_index (be, "splits_account_guid_index", SPLIT_TABLE,
-                                   account_guid_col_table);
-        if (!ok)
+        g_hash_table_iter_init (&iter, days);
+        while (g_hash_table_iter_next (&iter, &key, &value))
         {
-            PERR ("Unable to create index\n");
+            const GncGUID* acct_guid = (const GncGUID*)key;
+            Timespec day = { *(time64*)value, 0 };
+            time64* horizon = (time64*)g_hash_table_lookup (cache->horizons,
+                                                             acct_guid);
+            gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+            gchar* day_buf;
+            gchar* query_sql;
+            GncSqlStatement* stmt;
+            GList* loaded = NULL;
+            GList* node;
+
+            if (horizon != NULL && day.tv_sec >= *horizon) continue;
+
+            (void)guid_to_string_buff (acct_guid, guid_buf);
+            day_buf = gnc_sql_convert_timespec_to_string (be, day);
+            if (horizon != NULL)
+            {
+                Timespec until = { *horizon, 0 };
+                gchar* until_buf = gnc_sql_convert_timespec_to_string (be, until);
+
+                query_sql = g_strdup_printf (
+                                "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND s.account_guid='%s' AND t.post_date >= '%s' AND t.post_date < '%s'",
+                                TRANSACTION_TABLE, SPLIT_TABLE, guid_buf, day_buf,
+                                until_buf);
+                g_free (until_buf);
+            }
+            else
+            {
+                // The transactions without a date are given one when loaded
+                query_sql = g_strdup_printf (
+                                "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND s.account_guid='%s' AND (t.post_date IS NULL OR t.post_date >= '%s')",
+                                TRANSACTION_TABLE, SPLIT_TABLE, guid_buf, day_buf);
+                horizon = g_new (time64, 1);
+                g_hash_table_insert (cache->horizons, guid_copy (acct_guid),
+                                     horizon);
+            }
+            g_free (day_buf);
+            // Before loading, so that the account's own splits don't count
+            *horizon = day.tv_sec;
+
+            stmt = gnc_sql_create_statement_from_sql (be, query_sql);
+            g_free (query_sql);
+            if (stmt == NULL) continue;
+            if (query_transactions (be, stmt, guids, &loaded))
+            {
+                for (node = loaded; node != NULL; node = node->next)
+                    note_days_before_horizons (cache, next_days,
+                                               GNC_TRANSACTION (node->data));
+                g_list_free (loaded);
+            }
+            gnc_sql_statement_dispose (stmt);
         }
-        (void)gnc_sql_set_table_version (be, SPLIT_TABLE, SPLIT_TABLE_VERSION);
-        PINFO ("Splits table upgraded from version %d to version %d\n", version,
-               SPLIT_TABLE_VERSION);
+        g_hash_table_destroy (days);
+        days = next_days;
     }
+    g_hash_table_destroy (days);
 }
-/* ================================================================= */
-/**
- * Callback function to delete slots for a split
- *
- * @param data Split
- * @param user_data split_info_t structure contain operation info
- */
+
+/* Loads the splits between those of the transactions edited since the
+ * last query and their accounts' horizons, holding them in a unit. */
 static void
-delete_split_slots_cb (gpointer data, gpointer user_data)
+extend_horizons_for_edits (GncSqlBackend* be, tx_cache_unit_t* unit)
 {
-    split_info_t* split_info = (split_info_t*)user_data;
-    Split* pSplit = GNC_SPLIT (data);
+    GncSqlTxCache* cache = be->tx_cache;
+    GHashTable* days;
+    guint first;
 
-    g_return_if_fail (data != NULL);
-    g_return_if_fail (GNC_IS_SPLIT (data));
-    g_return_if_fail (user_data != NULL);
+    if (cache->all_loaded || g_hash_table_size (cache->edited_days) == 0)
+        return;
 
-    if (split_info->is_ok)
+    days = cache->edited_days;
+    cache->edited_days = new_account_day_table ();
+    if (unit == NULL)
     {
-        split_info->is_ok = gnc_sql_slots_delete (split_info->be,
-                                                  qof_instance_get_guid (QOF_INSTANCE (pSplit)));
+        extend_horizons (be, days, NULL);
+        return;
     }
+    first = unit->guids->len;
+    extend_horizons (be, days, unit->guids);
+    tx_cache_hold_unit (cache, unit, first);
 }
 
 /**
- * Deletes all of the splits for a transaction
+ * Executes a transaction query statement for transactions which are to be
+ * kept in memory for the rest of the session, and loads them.
  *
  * @param be SQL backend
- * @param pTx Transaction
- * @return TRUE if successful, FALSE if unsuccessful
+ * @param stmt SQL statement
  */
-static gboolean
-delete_splits (GncSqlBackend* be, Transaction* pTx)
+static void
+query_pinned_transactions (GncSqlBackend* be, GncSqlStatement* stmt)
 {
-    split_info_t split_info;
-
-    g_return_val_if_fail (be != NULL, FALSE);
-    g_return_val_if_fail (pTx != NULL, FALSE);
+    GArray* guids;
+    GList* loaded = NULL;
+    guint i;
 
-    if (!gnc_sql_do_db_operation (be, OP_DB_DELETE, SPLIT_TABLE,
-                                  SPLIT_TABLE, pTx, tx_guid_col_table))
+    if (be->tx_cache == NULL || be->tx_cache->all_loaded)
     {
-        return FALSE;
+        (void)query_transactions (be, stmt, NULL, NULL);
+        return;
     }
-    split_info.be = be;
-    split_info.is_ok = TRUE;
 
-    g_list_foreach (xaccTransGetSplitList (pTx), delete_split_slots_cb,
-                    &split_info);
+    guids = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+    if (query_transactions (be, stmt, guids, &loaded))
+    {
+        GHashTable* days = new_account_day_table ();
+        GList* node;
 
-    return split_info.is_ok;
+        for (node = loaded; node != NULL; node = node->next)
+            note_days_before_horizons (be->tx_cache, days,
+                                       GNC_TRANSACTION (node->data));
+        g_list_free (loaded);
+        extend_horizons (be, days, guids);
+    }
+    for (i = 0; i < guids->len; i++)
+        tx_cache_pin (be, &g_array_index (guids, GncGUID, i));
+    g_array_free (guids, TRUE);
 }
 
 /**
- * Commits a split to the database
+ * Loads the transactions with a split matching an SQL condition, unless
+ * they were loaded by an earlier call with the same condition and are
+ * still held.
  *
  * @param be SQL backend
- * @param inst Split
- * @return TRUE if successful, FALSE if error
+ * @param condition SQL condition on the transaction t and its split s, or
+ * NULL to load all of the transactions
+ * @return The unit holding the transactions, or NULL
  */
-static gboolean
-commit_split (GncSqlBackend* be, QofInstance* inst)
+static tx_cache_unit_t*
+load_tx_where (GncSqlBackend* be, const gchar* condition)
 {
-    E_DB_OPERATION op;
-    gboolean is_infant;
-    gboolean is_ok;
-    GncGUID* guid = (GncGUID*)qof_instance_get_guid (inst);
+    GncSqlTxCache* cache = be->tx_cache;
+    GncSqlStatement* stmt;
+    gchar* query_sql;
+    tx_cache_unit_t* unit;
+    GList* loaded = NULL;
+    GList* link;
+
+    if (cache->all_loaded) return NULL;
+
+    if (condition == NULL)
+    {
+        query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
+        stmt = gnc_sql_create_statement_from_sql (be, query_sql);
+        g_free (query_sql);
+        if (stmt == NULL) return NULL;
+        if (query_transactions (be, stmt, NULL, NULL))
+        {
+            // Everything is in memory now, and stays there
+            cache->all_loaded = TRUE;
+            g_hash_table_remove_all (cache->unit_index);
+            g_queue_foreach (&cache->units, (GFunc)tx_cache_unit_unref, NULL);
+            g_queue_clear (&cache->units);
+            g_hash_table_remove_all (cache->holds);
+            g_hash_table_remove_all (cache->pinned);
+            g_hash_table_remove_all (cache->horizons);
+            g_hash_table_remove_all (cache->edited_days);
+            g_hash_table_remove_all (cache->loaded_accounts);
+        }
+        gnc_sql_statement_dispose (stmt);
+        return NULL;
+    }
+
+    link = (GList*)g_hash_table_lookup (cache->unit_index, condition);
+    if (link != NULL)
+    {
+        g_queue_unlink (&cache->units, link);
+        g_queue_push_head_link (&cache->units, link);
+        return (tx_cache_unit_t*)link->data;
+    }
+
+    query_sql = g_strdup_printf (
+                    "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s)",
+                    TRANSACTION_TABLE, SPLIT_TABLE, condition);
+    stmt = gnc_sql_create_statement_from_sql (be, query_sql);
+    g_free (query_sql);
+    if (stmt == NULL) return NULL;
+
+    unit = g_new (tx_cache_unit_t, 1);
+    unit->condition = g_strdup (condition);
+    unit->guids = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+    unit->refs = 1;
+    if (query_transactions (be, stmt, unit->guids, &loaded))
+    {
+        GHashTable* days = new_account_day_table ();
+        GList* node;
+
+        gnc_sql_statement_dispose (stmt);
+        for (node = loaded; node != NULL; node = node->next)
+            note_days_before_horizons (cache, days, GNC_TRANSACTION (node->data));
+        g_list_free (loaded);
+        extend_horizons (be, days, unit->guids);
+
+        tx_cache_hold_unit (cache, unit, 0);
+        g_queue_push_head (&cache->units, unit);
+        g_hash_table_insert (cache->unit_index, unit->condition,
+                             cache->units.head);
+        return unit;
+    }
+    gnc_sql_statement_dispose (stmt);
+    tx_cache_unit_unref (unit);
+    return NULL;
+}
+
+/* Transactions which can be dropped: held by no unit, unedited, with no
+ * split in a lot, so that neither lots nor capital gains transactions
+ * lose anything, and with no reference to them or their splits but the
+ * book's. */
+static gboolean
+tx_can_be_dropped (GncSqlTxCache* cache, const GncGUID* guid, Transaction* tx)
+{
+    GList* node;
+
+    if (tx == NULL || g_hash_table_contains (cache->holds, guid) ||
+        g_hash_table_contains (cache->pinned, guid) ||
+        xaccTransIsOpen (tx) || qof_instance_is_dirty (QOF_INSTANCE (tx)) ||
+        G_OBJECT (tx)->ref_count > 1)
+        return FALSE;
+    for (node = xaccTransGetSplitList (tx); node != NULL; node = node->next)
+    {
+        Split* split = GNC_SPLIT (node->data);
+
+        if (xaccSplitGetLot (split) != NULL || G_OBJECT (split)->ref_count > 1)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Sets keep_from to the first day of an account's splits whose
+ * transactions aren't to be dropped; FALSE if there are none. */
+static gboolean
+account_keep_from (Account* acc, GHashTable* drop, time64* keep_from)
+{
+    gboolean found = FALSE;
+    GList* node;
+
+    for (node = xaccAccountGetSplitList (acc); node != NULL; node = node->next)
+    {
+        Transaction* tx = xaccSplitGetParent (GNC_SPLIT (node->data));
+        time64 day;
+
+        if (tx == NULL || g_hash_table_contains (drop, tx)) continue;
+        day = tx_day (tx);
+        if (!found || day < *keep_from) *keep_from = day;
+        found = TRUE;
+    }
+    return found;
+}
+
+/* Keeps the transactions to be dropped with a split on or after the first
+ * day its account keeps a split from, so that the splits left in each
+ * account are still all of those from some day on. */
+static void
+keep_horizons (GHashTable* drop)
+{
+    gboolean changed = TRUE;
+
+    while (changed)
+    {
+        GHashTable* keep_from = g_hash_table_new_full (g_direct_hash,
+                                                       g_direct_equal,
+                                                       NULL, g_free);
+        GHashTableIter iter;
+        gpointer key;
+
+        changed = FALSE;
+        g_hash_table_iter_init (&iter, drop);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+            Transaction* tx = GNC_TRANSACTION (key);
+            time64 day = tx_day (tx);
+            GList* node;
+
+            for (node = xaccTransGetSplitList (tx); node != NULL;
+                 node = node->next)
+            {
+                Account* acc = xaccSplitGetAccount (GNC_SPLIT (node->data));
+                gpointer from;
+
+                if (acc == NULL) continue;
+                if (!g_hash_table_lookup_extended (keep_from, acc, NULL, &from))
+                {
+                    time64 day_from;
+
+                    from = NULL;
+                    if (account_keep_from (acc, drop, &day_from))
+                    {
+                        from = g_new (time64, 1);
+                        *(time64*)from = day_from;
+                    }
+                    g_hash_table_insert (keep_from, acc, from);
+                }
+                if (from != NULL && day >= *(time64*)from)
+                {
+                    // The days kept from may now be earlier: check again
+                    g_hash_table_iter_remove (&iter);
+                    changed = TRUE;
+                    break;
+                }
+            }
+        }
+        g_hash_table_destroy (keep_from);
+    }
+}
+
+/**
+ * Removes a unit's transactions which nothing else holds from the book,
+ * without touching the database.
+ *
+ * @param be SQL backend
+ * @param unit Unit being dropped
+ */
+static void
+drop_unit_transactions (GncSqlBackend* be, tx_cache_unit_t* unit)
+{
+    GncSqlTxCache* cache = be->tx_cache;
+    GHashTable* drop = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GHashTable* accounts;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    GList* tx_list;
+    GList* kept = NULL;
+    GList* node;
+    guint i;
+
+    for (i = 0; i < unit->guids->len; i++)
+    {
+        const GncGUID* guid = &g_array_index (unit->guids, GncGUID, i);
+        Transaction* tx;
+
+        if (!tx_cache_release (cache, guid)) continue;
+        tx = xaccTransLookup (guid, be->book);
+        if (tx_can_be_dropped (cache, guid, tx))
+            g_hash_table_insert (drop, tx, (gpointer)guid);
+    }
+    keep_horizons (drop);
+    if (g_hash_table_size (drop) == 0)
+    {
+        g_hash_table_destroy (drop);
+        return;
+    }
+
+    // Move the horizons of the accounts to the splits they keep
+    tx_list = g_hash_table_get_keys (drop);
+    accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = tx_list; node != NULL; node = node->next)
+    {
+        GList* snode;
+
+        for (snode = xaccTransGetSplitList (GNC_TRANSACTION (node->data));
+             snode != NULL; snode = snode->next)
+        {
+            Account* acc = xaccSplitGetAccount (GNC_SPLIT (snode->data));
+            if (acc != NULL) g_hash_table_add (accounts, acc);
+        }
+    }
+    g_hash_table_iter_init (&iter, accounts);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+        const GncGUID* acct_guid = qof_instance_get_guid (QOF_INSTANCE (key));
+        time64* horizon = (time64*)g_hash_table_lookup (cache->horizons,
+                                                         acct_guid);
+        time64 keep_from;
+
+        if (!account_keep_from (GNC_ACCOUNT (key), drop, &keep_from))
+            g_hash_table_remove (cache->horizons, acct_guid);
+        else if (horizon != NULL && keep_from > *horizon)
+            *horizon = keep_from;
+    }
+    g_hash_table_destroy (accounts);
+
+    shift_start_balances (tx_list, FALSE);
+
+    // Handlers of the destroy events may run queries which load some of
+    // the transactions again, so look each one up before destroying it.
+    xaccLogDisable ();
+    g_hash_table_iter_init (&iter, drop);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        const GncGUID* guid = (const GncGUID*)value;
+        Transaction* tx = xaccTransLookup (guid, be->book);
+        gboolean loading = be->loading;
+
+        if (cache->all_loaded || !tx_can_be_dropped (cache, guid, tx))
+        {
+            if (tx != NULL) kept = g_list_prepend (kept, tx);
+            continue;
+        }
+        be->loading = TRUE;
+        xaccTransBeginEdit (tx);
+        qof_instance_set_destroying (tx, TRUE);
+        xaccTransCommitEdit (tx);
+        be->loading = loading;
+    }
+    xaccLogEnable ();
+
+    if (kept != NULL)
+    {
+        // The splits between these and the horizons are loaded again
+        shift_start_balances (kept, TRUE);
+        for (node = kept; node != NULL && !cache->all_loaded; node = node->next)
+            note_days_before_horizons (cache, cache->edited_days,
+                                       GNC_TRANSACTION (node->data));
+        g_list_free (kept);
+    }
+    g_list_free (tx_list);
+    g_hash_table_destroy (drop);
+}
+
+void
+gnc_sql_transaction_cache_init (GncSqlBackend* be)
+{
+    GncSqlTxCache* cache;
+
+    g_return_if_fail (be != NULL);
+
+    gnc_sql_transaction_cache_free (be);
+    if (!gnc_prefs_get_sql_load_as_needed ()) return;
+
+    cache = g_new0 (GncSqlTxCache, 1);
+    g_queue_init (&cache->units);
+    cache->unit_index = g_hash_table_new (g_str_hash, g_str_equal);
+    cache->holds = g_hash_table_new_full (guid_hash_to_guint,
+                                          guid_g_hash_table_equal,
+                                          (GDestroyNotify)guid_free, NULL);
+    cache->pinned = g_hash_table_new_full (guid_hash_to_guint,
+                                           guid_g_hash_table_equal,
+                                           (GDestroyNotify)guid_free, NULL);
+    cache->horizons = new_account_day_table ();
+    cache->edited_days = new_account_day_table ();
+    cache->loaded_accounts = g_hash_table_new_full (guid_hash_to_guint,
+                                                    guid_g_hash_table_equal,
+                                                    (GDestroyNotify)guid_free,
+                                                    NULL);
+    cache->max_transactions = (guint)gnc_prefs_get_sql_cache_size ();
+    be->tx_cache = cache;
+}
+
+void
+gnc_sql_transaction_cache_free (GncSqlBackend* be)
+{
+    GncSqlTxCache* cache;
+
+    g_return_if_fail (be != NULL);
+
+    cache = be->tx_cache;
+    if (cache == NULL) return;
+
+    if (cache->evict_source != 0)
+        g_source_remove (cache->evict_source);
+    g_hash_table_destroy (cache->unit_index);
+    g_queue_foreach (&cache->units, (GFunc)tx_cache_unit_unref, NULL);
+    g_queue_clear (&cache->units);
+    g_hash_table_destroy (cache->holds);
+    g_hash_table_destroy (cache->pinned);
+    g_hash_table_destroy (cache->horizons);
+    g_hash_table_destroy (cache->edited_days);
+    g_hash_table_destroy (cache->loaded_accounts);
+    g_free (cache);
+    be->tx_cache = NULL;
+}
+
+void
+gnc_sql_transaction_cache_evict (GncSqlBackend* be, guint max_transactions)
+{
+    GncSqlTxCache* cache;
+    gboolean was_saved;
+    GList* link;
+
+    g_return_if_fail (be != NULL);
+
+    cache = be->tx_cache;
+    if (cache == NULL || cache->all_loaded || cache->evicting) return;
+
+    cache->evicting = TRUE;
+    was_saved = !qof_book_session_not_saved (be->book);
+    link = cache->units.tail;
+    while (link != NULL && g_hash_table_size (cache->holds) > max_transactions)
+    {
+        tx_cache_unit_t* unit = (tx_cache_unit_t*)link->data;
+        GList* prev = link->prev;
+
+        // The units of live queries hold their results
+        if (unit->refs == 1)
+        {
+            g_queue_delete_link (&cache->units, link);
+            g_hash_table_remove (cache->unit_index, unit->condition);
+            drop_unit_transactions (be, unit);
+            tx_cache_unit_unref (unit);
+            // A handler of the destroy events may have loaded everything
+            if (cache->all_loaded) break;
+        }
+        link = prev;
+    }
+    cache->evicting = FALSE;
+
+    // Dropping transactions from memory doesn't change the book
+    if (was_saved && qof_book_session_not_saved (be->book))
+        qof_book_mark_session_saved (be->book);
+}
+
+static gboolean
+evict_idle_cb (gpointer user_data)
+{
+    GncSqlBackend* be = (GncSqlBackend*)user_data;
+
+    be->tx_cache->evict_source = 0;
+    gnc_sql_transaction_cache_evict (be, be->tx_cache->max_transactions);
+    return FALSE;
+}
+
+void
+gnc_sql_transaction_cache_evict_when_idle (GncSqlBackend* be)
+{
+    GncSqlTxCache* cache;
+
+    g_return_if_fail (be != NULL);
+
+    cache = be->tx_cache;
+    if (cache == NULL || cache->all_loaded || cache->evict_source != 0 ||
+        g_hash_table_size (cache->holds) <= cache->max_transactions)
+        return;
+
+    cache->evict_source = g_idle_add_full (G_PRIORITY_LOW, evict_idle_cb, be,
+                                           NULL);
+}
+
+/* ================================================================= */
+/**
+ * Creates the transaction and split tables.
+ *
+ * @param be SQL backend
+ */
+static void
+create_transaction_tables (GncSqlBackend* be)
+{
+    gint version;
+    gboolean ok;
+
+    g_return_if_fail (be != NULL);
+
+    version = gnc_sql_get_table_version (be, TRANSACTION_TABLE);
+    if (version == 0)
+    {
+        (void)gnc_sql_create_table (be, TRANSACTION_TABLE, TX_TABLE_VERSION,
+                                    tx_col_table);
+        ok = gnc_sql_create_index (be, "tx_post_date_index", TRANSACTION_TABLE,
+                                   post_date_col_table);
+        if (!ok)
+        {
+            PERR ("Unable to create index\n");
+        }
+    }
+    else if (version < TX_TABLE_VERSION)
+    {
+        /* Upgrade:
+            1->2: 64 bit int handling
+            2->3: allow dates to be NULL
+        */
+        gnc_sql_upgrade_table (be, TRANSACTION_TABLE, tx_col_table);
+        (void)gnc_sql_set_table_version (be, TRANSACTION_TABLE, TX_TABLE_VERSION);
+        PINFO ("Transactions table upgraded from version %d to version %d\n", version,
+               TX_TABLE_VERSION);
+    }
+
+    version = gnc_sql_get_table_version (be, SPLIT_TABLE);
+    if (version == 0)
+    {
+        (void)gnc_sql_create_table (be, SPLIT_TABLE, SPLIT_TABLE_VERSION,
+                                    split_col_table);
+        ok = gnc_sql_create_index (be, "splits_tx_guid_index", SPLIT_TABLE,
+                                   tx_guid_col_table);
+        if (!ok)
+        {
+            PERR ("Unable to create index\n");
+        }
+        ok = gnc_sql_create_index (be, "splits_account_guid_index", SPLIT_TABLE,
+                                   account_guid_col_table);
+        if (!ok)
+        {
+            PERR ("Unable to create index\n");
+        }
+    }
+    else if (version < SPLIT_TABLE_VERSION)
+    {
+
+        /* Upgrade:
+           1->2: 64 bit int handling
+           3->4: Split reconcile date can be NULL */
+        gnc_sql_upgrade_table (be, SPLIT_TABLE, split_col_table);
+        ok = gnc_sql_create_index (be, "splits_tx_guid_index", SPLIT_TABLE,
+                                   tx_guid_col_table);
+        if (!ok)
+        {
+            PERR ("Unable to create index\n");
+        }
+        ok = gnc_sql_create_index (be, "splits_account_guid_index", SPLIT_TABLE,
+                                   account_guid_col_table);
+        if (!ok)
+        {
+            PERR ("Unable to create index\n");
+        }
+        (void)gnc_sql_set_table_version (be, SPLIT_TABLE, SPLIT_TABLE_VERSION);
+        PINFO ("Splits table upgraded from version %d to version %d\n", version,
+               SPLIT_TABLE_VERSION);
+    }
+}
+/* ================================================================= */
+/**
+ * Callback function to delete slots for a split
+ *
+ * @param data Split
+ * @param user_data split_info_t structure contain operation info
+ */
+static void
+delete_split_slots_cb (gpointer data, gpointer user_data)
+{
+    split_info_t* split_info = (split_info_t*)user_data;
+    Split* pSplit = GNC_SPLIT (data);
+
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (GNC_IS_SPLIT (data));
+    g_return_if_fail (user_data != NULL);
+
+    if (split_info->is_ok)
+    {
+        split_info->is_ok = gnc_sql_slots_delete (split_info->be,
+                                                  qof_instance_get_guid (QOF_INSTANCE (pSplit)));
+    }
+}
+
+/**
+ * Deletes all of the splits for a transaction
+ *
+ * @param be SQL backend
+ * @param pTx Transaction
+ * @return TRUE if successful, FALSE if unsuccessful
+ */
+static gboolean
+delete_splits (GncSqlBackend* be, Transaction* pTx)
+{
+    split_info_t split_info;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (pTx != NULL, FALSE);
+
+    if (!gnc_sql_do_db_operation (be, OP_DB_DELETE, SPLIT_TABLE,
+                                  SPLIT_TABLE, pTx, tx_guid_col_table))
+    {
+        return FALSE;
+    }
+    split_info.be = be;
+    split_info.is_ok = TRUE;
+
+    g_list_foreach (xaccTransGetSplitList (pTx), delete_split_slots_cb,
+                    &split_info);
+
+    return split_info.is_ok;
+}
+
+/**
+ * Updates the columns of an object's row which hold its dirty fields.
+ *
+ * @param be SQL backend
+ * @param table_name Table name
+ * @param obj_name QOF object type name
+ * @param pObject Object
+ * @param table DB table description, whose first column is the key
+ * @param col_fields Dirty field bit of each column of table
+ * @param dirty Dirty field bits of the object
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+update_dirty_columns (GncSqlBackend* be, const gchar* table_name,
+                      QofIdTypeConst obj_name, gpointer pObject,
+                      const GncSqlColumnTableEntry* table,
+                      const guint* col_fields, guint dirty)
+{
+    GncSqlColumnTableEntry* cols;
+    guint num_cols = 0;
+    guint col;
+
+    while (table[num_cols].col_name != NULL)
+    {
+        num_cols++;
+    }
+    cols = g_newa (GncSqlColumnTableEntry, num_cols + 1);
+
+    cols[0] = table[0];
+    num_cols = 1;
+    for (col = 1; table[col].col_name != NULL; col++)
+    {
+        if ((col_fields[col] & dirty) != 0)
+        {
+            cols[num_cols++] = table[col];
+        }
+    }
+    if (num_cols == 1)
+    {
+        return TRUE;
+    }
+    cols[num_cols] = table[col];
+
+    return gnc_sql_do_db_operation (be, OP_DB_UPDATE, table_name, obj_name,
+                                    pObject, cols);
+}
+
+/* The db now has the split's changes. */
+static void
+clear_split_changes (gpointer data, gpointer user_data)
+{
+    xaccSplitClearDirtyFields (GNC_SPLIT (data));
+    clear_slots_changes (data, user_data);
+}
+
+/**
+ * Writes a split to the database.  A new split is inserted, as is every
+ * split into a new db; otherwise only the columns of the split's dirty
+ * fields and its changed slots are updated.  The caller clears the
+ * split's changes.
+ *
+ * @param be SQL backend
+ * @param inst Split
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+write_split (GncSqlBackend* be, QofInstance* inst)
+{
+    E_DB_OPERATION op;
+    gboolean is_infant;
+    gboolean is_ok;
+    GncGUID* guid = (GncGUID*)qof_instance_get_guid (inst);
 
     g_return_val_if_fail (inst != NULL, FALSE);
     g_return_val_if_fail (be != NULL, FALSE);
@@ -630,12 +1477,48 @@ commit_split (GncSqlBackend* be, QofInstance* inst)
         qof_instance_set_guid (inst, guid);
     }
 
-    is_ok = gnc_sql_do_db_operation (be, op, SPLIT_TABLE, GNC_ID_SPLIT,
-                                     inst, split_col_table);
+    if (xaccSplitGetParent (GNC_SPLIT (inst)) != NULL)
+        tx_cache_pin (be, qof_instance_get_guid (xaccSplitGetParent (GNC_SPLIT (inst))));
+
+    if (op == OP_DB_UPDATE)
+    {
+        is_ok = update_dirty_columns (be, SPLIT_TABLE, GNC_ID_SPLIT, inst,
+                                      split_col_table, split_col_fields,
+                                      xaccSplitGetDirtyFields (GNC_SPLIT (inst)));
+    }
+    else
+    {
+        is_ok = gnc_sql_do_db_operation (be, op, SPLIT_TABLE, GNC_ID_SPLIT,
+                                         inst, split_col_table);
+    }
 
     if (is_ok && !qof_instance_get_destroying (inst))
     {
-        is_ok = gnc_sql_slots_save (be, guid, is_infant, inst);
+        is_ok = gnc_sql_slots_save_changed (be, guid, is_infant, inst);
+    }
+
+    return is_ok;
+}
+
+/**
+ * Commits a split to the database
+ *
+ * @param be SQL backend
+ * @param inst Split
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+commit_split (GncSqlBackend* be, QofInstance* inst)
+{
+    gboolean is_ok;
+
+    g_return_val_if_fail (inst != NULL, FALSE);
+    g_return_val_if_fail (be != NULL, FALSE);
+
+    is_ok = write_split (be, inst);
+    if (is_ok && !qof_instance_get_destroying (inst))
+    {
+        clear_split_changes (inst, NULL);
     }
 
     return is_ok;
@@ -653,7 +1536,7 @@ save_split_cb (gpointer data, gpointer user_data)
 
     if (split_info->is_ok)
     {
-        split_info->is_ok = commit_split (split_info->be, QOF_INSTANCE (pSplit));
+        split_info->is_ok = write_split (split_info->be, QOF_INSTANCE (pSplit));
     }
 }
 
@@ -674,6 +1557,49 @@ save_splits (GncSqlBackend* be, const GncGUID* tx_guid, SplitList* pSplitList)
     return split_info.is_ok;
 }
 
+/**
+ * Writes the changes to the existing splits of a transaction being
+ * committed, so that they reach the database in the same DB transaction
+ * as the transaction's own.  Committing the splits afterwards then finds
+ * nothing left to write unless the engine changed them again.  New and
+ * deleted splits are left to their own commits.
+ *
+ * @param be SQL backend
+ * @param pTx Transaction
+ * @param written Returns the splits written, to clear once committed
+ * @return TRUE if successful, FALSE if error
+ */
+static gboolean
+save_dirty_splits (GncSqlBackend* be, Transaction* pTx, GList** written)
+{
+    GList* node;
+    gboolean is_ok = TRUE;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (pTx != NULL, FALSE);
+    g_return_val_if_fail (written != NULL, FALSE);
+
+    if (be->is_pristine_db) return TRUE;
+
+    for (node = xaccTransGetSplitList (pTx); node != NULL && is_ok;
+         node = node->next)
+    {
+        QofInstance* inst = QOF_INSTANCE (node->data);
+
+        if (!qof_instance_get_dirty_flag (inst) ||
+            qof_instance_get_infant (inst) ||
+            qof_instance_get_destroying (inst) ||
+            xaccSplitGetParent (GNC_SPLIT (inst)) != pTx)
+            continue;
+
+        is_ok = write_split (be, inst);
+        if (is_ok)
+            *written = g_list_prepend (*written, inst);
+    }
+
+    return is_ok;
+}
+
 static gboolean
 save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
 {
@@ -683,12 +1609,15 @@ save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
     QofInstance* inst;
     gboolean is_ok = TRUE;
     const char* err = NULL;
+    guint dirty;
+    GList* written_splits = NULL;
 
     g_return_val_if_fail (be != NULL, FALSE);
     g_return_val_if_fail (pTx != NULL, FALSE);
 
     inst = QOF_INSTANCE (pTx);
     is_infant = qof_instance_get_infant (inst);
+    dirty = xaccTransGetDirtyFields (pTx);
     if (qof_instance_get_destroying (inst))
     {
         op = OP_DB_DELETE;
@@ -702,7 +1631,11 @@ save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
         op = OP_DB_UPDATE;
     }
 
-    if (op != OP_DB_DELETE)
+    // Write the transaction, its splits and their slots a table at a time
+    gnc_sql_begin_insert_batch (be);
+
+    if (op == OP_DB_INSERT ||
+        (op == OP_DB_UPDATE && (dirty & TRANS_DIRTY_CURRENCY) != 0))
     {
         gnc_commodity* commodity = xaccTransGetCurrency (pTx);
         // Ensure the commodity is in the db
@@ -716,8 +1649,17 @@ save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
 
     if (is_ok)
     {
-        is_ok = gnc_sql_do_db_operation (be, op, TRANSACTION_TABLE, GNC_ID_TRANS, pTx,
-                                         tx_col_table);
+        if (op == OP_DB_UPDATE)
+        {
+            is_ok = update_dirty_columns (be, TRANSACTION_TABLE, GNC_ID_TRANS,
+                                          pTx, tx_col_table, tx_col_fields,
+                                          dirty);
+        }
+        else
+        {
+            is_ok = gnc_sql_do_db_operation (be, op, TRANSACTION_TABLE,
+                                             GNC_ID_TRANS, pTx, tx_col_table);
+        }
         if (! is_ok)
         {
             err = "Transaction header save failed. Check trace log for SQL errors";
@@ -730,14 +1672,17 @@ save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
         guid = qof_instance_get_guid (inst);
         if (!qof_instance_get_destroying (inst))
         {
-            is_ok = gnc_sql_slots_save (be, guid, is_infant, inst);
+            is_ok = gnc_sql_slots_save_changed (be, guid, is_infant, inst);
             if (! is_ok)
             {
                 err = "Slots save failed. Check trace log for SQL errors";
             }
-            if (is_ok && do_save_splits)
+            if (is_ok)
             {
-                is_ok = save_splits (be, guid, xaccTransGetSplitList (pTx));
+                if (do_save_splits)
+                    is_ok = save_splits (be, guid, xaccTransGetSplitList (pTx));
+                else
+                    is_ok = save_dirty_splits (be, pTx, &written_splits);
                 if (! is_ok)
                 {
                     err = "Split save failed. Check trace log for SQL errors";
@@ -761,6 +1706,19 @@ save_transaction (GncSqlBackend* be, Transaction* pTx, gboolean do_save_splits)
             }
         }
     }
+    if (!gnc_sql_end_insert_batch (be) && is_ok)
+    {
+        is_ok = FALSE;
+        err = "Batched insert failed. Check trace log for SQL errors";
+    }
+    if (is_ok && op != OP_DB_DELETE)
+    {
+        xaccTransClearDirtyFields (pTx);
+        clear_slots_changes (pTx, NULL);
+        g_list_foreach (do_save_splits ? xaccTransGetSplitList (pTx) :
+                        written_splits, clear_split_changes, NULL);
+    }
+    g_list_free (written_splits);
     if (! is_ok)
     {
         Split* split = xaccTransGetSplit (pTx, 0);
@@ -802,6 +1760,7 @@ commit_transaction (GncSqlBackend* be, QofInstance* inst)
     g_return_val_if_fail (inst != NULL, FALSE);
     g_return_val_if_fail (GNC_IS_TRANS (inst), FALSE);
 
+    tx_cache_note_edit (be, GNC_TRANS (inst));
     return save_transaction (be, GNC_TRANS (inst), /* do_save_splits */FALSE);
 }
 
@@ -824,6 +1783,11 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* be,
     g_return_if_fail (account != NULL);
 
     guid = qof_instance_get_guid (QOF_INSTANCE (account));
+    if (be->tx_cache != NULL &&
+        (be->tx_cache->all_loaded ||
+         g_hash_table_lookup (be->tx_cache->loaded_accounts, guid) != NULL))
+        return;
+
     (void)guid_to_string_buff (guid, guid_buf);
     query_sql = g_strdup_printf (
                     "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND s.account_guid ='%s'",
@@ -832,11 +1796,46 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* be,
     g_free (query_sql);
     if (stmt != NULL)
     {
-        query_transactions (be, stmt);
+        query_pinned_transactions (be, stmt);
         gnc_sql_statement_dispose (stmt);
+        if (be->tx_cache != NULL && !be->tx_cache->all_loaded)
+            g_hash_table_insert (be->tx_cache->loaded_accounts,
+                                 guid_copy (guid), GINT_TO_POINTER (1));
     }
 }
 
+void
+gnc_sql_transaction_load_related (GncSqlBackend* be, QofInstance* inst)
+{
+    GncSqlTxCache* cache;
+
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (inst != NULL);
+
+    // Whatever the engine asks for while loading is on its way
+    cache = be->tx_cache;
+    if (cache == NULL || cache->all_loaded || be->loading || be->in_query)
+        return;
+    if (GNC_IS_ACCOUNT (inst) &&
+        g_hash_table_lookup (cache->loaded_accounts,
+                             qof_instance_get_guid (inst)) != NULL)
+        return;
+
+    ENTER ("inst=%p", inst);
+    be->loading = TRUE;
+    qof_event_suspend ();
+    if (QOF_IS_BOOK (inst))
+        gnc_sql_transaction_load_all_tx (be);
+    else if (GNC_IS_ACCOUNT (inst))
+        gnc_sql_transaction_load_tx_for_account (be, GNC_ACCOUNT (inst));
+    be->loading = FALSE;
+    qof_event_resume ();
+
+    // Loading doesn't change the book
+    qof_instance_mark_clean (QOF_INSTANCE (be->book));
+    LEAVE ("");
+}
+
 /**
  * Loads all transactions.  This might be used during a save-as operation to ensure that
  * all data is in memory and ready to be saved.
@@ -850,433 +1849,842 @@ void gnc_sql_transaction_load_all_tx (GncSqlBackend* be)
 
     g_return_if_fail (be != NULL);
 
+    if (be->tx_cache != NULL)
+    {
+        load_tx_where (be, NULL);
+        return;
+    }
+
     query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
     stmt = gnc_sql_create_statement_from_sql (be, query_sql);
     g_free (query_sql);
     if (stmt != NULL)
     {
-        query_transactions (be, stmt);
-        gnc_sql_statement_dispose (stmt);
+        query_transactions (be, stmt, NULL, NULL);
+        gnc_sql_statement_dispose (stmt);
+    }
+}
+
+/**
+ * Loads all transactions on the initial load, unless they are to be loaded
+ * as needed.
+ *
+ * @param be SQL backend
+ */
+static void
+load_initial_tx (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+
+    if (be->tx_cache == NULL)
+        gnc_sql_transaction_load_all_tx (be);
+}
+
+/* ----------------------------------------------------------------- */
+/* Queries on splits only load anything when transactions are loaded as
+ * needed.  Each term of a query is put in SQL as two conditions on the
+ * split s and its transaction t: a wider one, which holds for every split
+ * the term can match, and a narrower one, which holds only for splits the
+ * term matches.  A term which can't be put in SQL has neither: it might
+ * match any split, or none.  Negating a term swaps its conditions, so each
+ * is written to be true or false for every row, never NULL.
+ *
+ * The transactions with a split matching the query's wider condition are
+ * loaded, and the query is then run on them in memory as usual.  When the
+ * query only wants its last few splits in date order, the narrower
+ * condition gives the date from which there are enough of them, and the
+ * transactions before it are left in the database. */
+typedef struct
+{
+    gchar* wider;               /* NULL if any split can match */
+    gchar* narrower;            /* NULL if no split is known to match */
+} sql_condition_t;
+
+typedef struct
+{
+    QofQuery* query;            /* NULL to load all of the transactions */
+    sql_condition_t condition;
+    tx_cache_unit_t* unit;      /* Holds the transactions loaded, or NULL */
+} split_query_info_t;
+
+/* The columns the split parameters are stored in */
+typedef struct
+{
+    const gchar* param;
+    const gchar* sub_param;     /* Parameter of param's object, or NULL */
+    const gchar* column;
+    QofType type;
+    gboolean nullable;
+} split_query_column_t;
+
+static const split_query_column_t split_query_col_table[] =
+{
+    { QOF_PARAM_GUID,        NULL,               "s.guid",            QOF_TYPE_GUID,    FALSE },
+    { SPLIT_ACCOUNT,         QOF_PARAM_GUID,     "s.account_guid",    QOF_TYPE_GUID,    FALSE },
+    { SPLIT_ACCOUNT_GUID,    NULL,               "s.account_guid",    QOF_TYPE_GUID,    FALSE },
+    { SPLIT_TRANS,           QOF_PARAM_GUID,     "s.tx_guid",         QOF_TYPE_GUID,    FALSE },
+    { SPLIT_MEMO,            NULL,               "s.memo",            QOF_TYPE_STRING,  FALSE },
+    { SPLIT_ACTION,          NULL,               "s.action",          QOF_TYPE_STRING,  FALSE },
+    { SPLIT_RECONCILE,       NULL,               "s.reconcile_state", QOF_TYPE_CHAR,    FALSE },
+    { SPLIT_DATE_RECONCILED, NULL,               "s.reconcile_date",  QOF_TYPE_DATE,    TRUE },
+    { SPLIT_VALUE,           NULL,               "s.value",           QOF_TYPE_NUMERIC, FALSE },
+    { SPLIT_AMOUNT,          NULL,               "s.quantity",        QOF_TYPE_NUMERIC, FALSE },
+    { SPLIT_TRANS,           TRANS_NUM,          "t.num",             QOF_TYPE_STRING,  FALSE },
+    { SPLIT_TRANS,           TRANS_DESCRIPTION,  "t.description",     QOF_TYPE_STRING,  TRUE },
+    { SPLIT_TRANS,           TRANS_DATE_POSTED,  "t.post_date",       QOF_TYPE_DATE,    TRUE },
+    { SPLIT_TRANS,           TRANS_DATE_ENTERED, "t.enter_date",      QOF_TYPE_DATE,    TRUE },
+    { NULL }
+};
+
+/* Numeric columns are compared as floating point numbers, within this of
+ * the exact value. */
+#define NUMERIC_SLOP 2e-5
+
+/* Characters with a meaning in extended regular expressions */
+#define REGEX_SPECIAL_CHARS ".[]()*+?{}|\\^$"
+
+static void
+sql_condition_free (sql_condition_t* cond)
+{
+    g_free (cond->wider);
+    g_free (cond->narrower);
+    cond->wider = NULL;
+    cond->narrower = NULL;
+}
+
+/* Sets both conditions of a term which SQL matches exactly */
+static void
+sql_condition_set_exact (sql_condition_t* cond, gchar* sql)
+{
+    cond->wider = sql;
+    cond->narrower = g_strdup (sql);
+}
+
+static void
+sql_condition_negate (sql_condition_t* cond)
+{
+    gchar* wider = NULL;
+    gchar* narrower = NULL;
+
+    if (cond->narrower != NULL)
+        wider = g_strdup_printf ("NOT (%s)", cond->narrower);
+    if (cond->wider != NULL)
+        narrower = g_strdup_printf ("NOT (%s)", cond->wider);
+    sql_condition_free (cond);
+    cond->wider = wider;
+    cond->narrower = narrower;
+}
+
+static gchar*
+join_sql_conditions (gchar* left, const gchar* op, const gchar* right)
+{
+    gchar* sql = g_strdup_printf ("(%s) %s (%s)", left, op, right);
+
+    g_free (left);
+    return sql;
+}
+
+static void
+sql_condition_and (sql_condition_t* cond, const sql_condition_t* term)
+{
+    if (term->wider != NULL)
+        cond->wider = (cond->wider == NULL) ? g_strdup (term->wider) :
+                      join_sql_conditions (cond->wider, "AND", term->wider);
+    if (cond->narrower != NULL && term->narrower != NULL)
+    {
+        cond->narrower = join_sql_conditions (cond->narrower, "AND",
+                                              term->narrower);
+    }
+    else
+    {
+        g_free (cond->narrower);
+        cond->narrower = NULL;
+    }
+}
+
+static void
+sql_condition_or (sql_condition_t* cond, const sql_condition_t* term)
+{
+    if (cond->wider != NULL && term->wider != NULL)
+    {
+        cond->wider = join_sql_conditions (cond->wider, "OR", term->wider);
+    }
+    else
+    {
+        g_free (cond->wider);
+        cond->wider = NULL;
     }
+    if (term->narrower != NULL)
+        cond->narrower = (cond->narrower == NULL) ? g_strdup (term->narrower) :
+                         join_sql_conditions (cond->narrower, "OR",
+                                              term->narrower);
 }
 
+/* Makes the conditions of a term on a column which can be NULL hold
+ * for the rows where it is: the column's value is then unknown. */
 static void
-convert_query_comparison_to_sql (QofQueryPredData* pPredData,
-                                 gboolean isInverted, GString* sql)
+sql_condition_allow_null (sql_condition_t* cond, const gchar* column)
 {
-    if (pPredData->how == QOF_COMPARE_LT
-        || (isInverted && pPredData->how == QOF_COMPARE_GTE))
+    gchar* sql;
+
+    if (cond->wider != NULL)
     {
-        g_string_append (sql, "<");
+        sql = g_strdup_printf ("(%s IS NULL OR %s)", column, cond->wider);
+        g_free (cond->wider);
+        cond->wider = sql;
     }
-    else if (pPredData->how == QOF_COMPARE_LTE
-             || (isInverted && pPredData->how == QOF_COMPARE_GT))
+    if (cond->narrower != NULL)
     {
-        g_string_append (sql, "<=");
+        sql = g_strdup_printf ("(%s IS NOT NULL AND %s)", column,
+                               cond->narrower);
+        g_free (cond->narrower);
+        cond->narrower = sql;
     }
-    else if (pPredData->how == QOF_COMPARE_EQUAL
-             || (isInverted && pPredData->how == QOF_COMPARE_NEQ))
+}
+
+/* TRUE if a parameter path is the NULL terminated list of parameters */
+static gboolean
+param_path_is (GSList* path, ...)
+{
+    va_list args;
+    const gchar* param;
+    gboolean is_match = TRUE;
+
+    va_start (args, path);
+    while ((param = va_arg (args, const gchar*)) != NULL)
     {
-        g_string_append (sql, "=");
+        if (path == NULL || strcmp ((const gchar*)path->data, param) != 0)
+        {
+            is_match = FALSE;
+            break;
+        }
+        path = path->next;
     }
-    else if (pPredData->how == QOF_COMPARE_GT
-             || (isInverted && pPredData->how == QOF_COMPARE_LTE))
+    va_end (args);
+
+    return is_match && path == NULL;
+}
+
+static const split_query_column_t*
+find_split_query_column (GSList* path)
+{
+    const split_query_column_t* col;
+
+    for (col = split_query_col_table; col->param != NULL; col++)
     {
-        g_string_append (sql, ">");
+        if (param_path_is (path, col->param, col->sub_param, NULL))
+            return col;
     }
-    else if (pPredData->how == QOF_COMPARE_GTE
-             || (isInverted && pPredData->how == QOF_COMPARE_LT))
+    return NULL;
+}
+
+static gchar*
+guid_list_to_sql (GList* guids)
+{
+    GString* sql = g_string_new ("");
+    GList* node;
+
+    for (node = guids; node != NULL; node = node->next)
     {
-        g_string_append (sql, ">=");
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+
+        (void)guid_to_string_buff (static_cast<GncGUID*> (node->data), guid_buf);
+        if (node != guids) g_string_append (sql, ",");
+        g_string_append_printf (sql, "'%s'", guid_buf);
     }
-    else if (pPredData->how == QOF_COMPARE_NEQ
-             || (isInverted && pPredData->how == QOF_COMPARE_EQUAL))
+    return g_string_free (sql, FALSE);
+}
+
+static void
+guid_term_to_sql (const gchar* column, QofQueryPredData* pPredData,
+                  sql_condition_t* cond)
+{
+    query_guid_t guid_data = (query_guid_t)pPredData;
+    gchar* guids;
+
+    if (guid_data->options != QOF_GUID_MATCH_ANY &&
+        guid_data->options != QOF_GUID_MATCH_NONE)
+        return;
+
+    if (guid_data->guids == NULL)
     {
-        g_string_append (sql, "~=");
+        sql_condition_set_exact (cond, g_strdup ("1=0"));
     }
     else
     {
-        PERR ("Unknown comparison type\n");
-        g_string_append (sql, "??");
+        guids = guid_list_to_sql (guid_data->guids);
+        sql_condition_set_exact (cond, g_strdup_printf ("%s IN (%s)", column,
+                                                        guids));
+        g_free (guids);
     }
+    if (guid_data->options == QOF_GUID_MATCH_NONE)
+        sql_condition_negate (cond);
 }
 
+/* Matches the transactions with a split in each of a list of accounts */
 static void
-convert_query_term_to_sql (const GncSqlBackend* be, const gchar* fieldName,
-                           QofQueryTerm* pTerm, GString* sql)
+split_list_term_to_sql (QofQueryPredData* pPredData, sql_condition_t* cond)
 {
-    QofQueryPredData* pPredData;
-    gboolean isInverted;
-
-    g_return_if_fail (pTerm != NULL);
-    g_return_if_fail (sql != NULL);
+    query_guid_t guid_data = (query_guid_t)pPredData;
+    GString* sql;
+    GList* node;
 
-    pPredData = qof_query_term_get_pred_data (pTerm);
-    isInverted = qof_query_term_is_inverted (pTerm);
+    if (guid_data->options != QOF_GUID_MATCH_ALL) return;
 
-    if (g_strcmp0 (pPredData->type_name, QOF_TYPE_GUID) == 0)
+    sql = g_string_new ("1=1");
+    for (node = guid_data->guids; node != NULL; node = node->next)
     {
-        query_guid_t guid_data = (query_guid_t)pPredData;
-        GList* guid_entry;
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
 
-        g_string_append (sql, "(");
-        g_string_append (sql, fieldName);
-
-        switch (guid_data->options)
-        {
-        case QOF_GUID_MATCH_ANY:
-            if (isInverted) g_string_append (sql, " NOT IN (");
-            else g_string_append (sql, " IN (");
-            break;
+        (void)guid_to_string_buff (static_cast<GncGUID*> (node->data), guid_buf);
+        g_string_append_printf (sql,
+                                " AND t.guid IN (SELECT tx_guid FROM %s WHERE account_guid='%s')",
+                                SPLIT_TABLE, guid_buf);
+    }
+    sql_condition_set_exact (cond, g_string_free (sql, FALSE));
+}
 
-        case QOF_GUID_MATCH_NONE:
-            if (isInverted) g_string_append (sql, " IN (");
-            else g_string_append (sql, " NOT IN (");
-            break;
+static void
+char_term_to_sql (const gchar* column, QofQueryPredData* pPredData,
+                  sql_condition_t* cond)
+{
+    query_char_t char_data = (query_char_t)pPredData;
+    GString* sql;
+    const gchar* c;
 
-        default:
-            PERR ("Unexpected GncGUID match type: %d\n", guid_data->options);
-        }
+    if (strpbrk (char_data->char_list, "\\'") != NULL) return;
 
-        for (guid_entry = guid_data->guids; guid_entry != NULL;
-             guid_entry = guid_entry->next)
+    if (char_data->char_list[0] == '\0')
+    {
+        sql_condition_set_exact (cond, g_strdup ("1=0"));
+    }
+    else
+    {
+        sql = g_string_new ("");
+        g_string_append_printf (sql, "%s IN (", column);
+        for (c = char_data->char_list; *c != '\0'; c++)
         {
-            gchar guid_buf[GUID_ENCODING_LENGTH + 1];
-
-            if (guid_entry != guid_data->guids) g_string_append (sql, ",");
-            (void)guid_to_string_buff (static_cast<GncGUID*> (guid_entry->data),
-                                       guid_buf);
-            g_string_append_printf (sql, "'%s'", guid_buf);
+            if (c != char_data->char_list) g_string_append (sql, ",");
+            g_string_append_printf (sql, "'%c'", *c);
         }
-        g_string_append (sql, "))");
+        g_string_append (sql, ")");
+        sql_condition_set_exact (cond, g_string_free (sql, FALSE));
+    }
+    if (char_data->options == QOF_CHAR_MATCH_NONE)
+        sql_condition_negate (cond);
+}
 
+static void
+date_term_to_sql (const GncSqlBackend* be, const gchar* column,
+                  QofQueryPredData* pPredData, sql_condition_t* cond)
+{
+    query_date_t date_data = (query_date_t)pPredData;
+    Timespec first;             /* The stored times equal to the date */
+    Timespec last;
+    gchar* first_buf;
+    gchar* last_buf;
+    gchar* sql = NULL;
+
+    if (date_data->options == QOF_DATE_MATCH_DAY)
+    {
+        first.tv_sec = gnc_time64_get_day_start (date_data->date.tv_sec);
+        last.tv_sec = gnc_time64_get_day_end (date_data->date.tv_sec);
+    }
+    else if (date_data->date.tv_nsec == 0)
+    {
+        first.tv_sec = date_data->date.tv_sec;
+        last.tv_sec = date_data->date.tv_sec;
     }
-    else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_CHAR) == 0)
+    else
     {
-        query_char_t char_data = (query_char_t)pPredData;
-        int i;
+        // Times are stored in whole seconds, so none is equal
+        first.tv_sec = date_data->date.tv_sec + 1;
+        last.tv_sec = date_data->date.tv_sec;
+    }
+    first.tv_nsec = 0;
+    last.tv_nsec = 0;
+    first_buf = gnc_sql_convert_timespec_to_string (be, first);
+    last_buf = gnc_sql_convert_timespec_to_string (be, last);
 
-        if (isInverted)
-        {
-            g_string_append (sql, "NOT(");
-        }
-        if (char_data->options == QOF_CHAR_MATCH_NONE)
-        {
-            g_string_append (sql, "NOT ");
-        }
-        g_string_append (sql, "(");
-        for (i = 0; char_data->char_list[i] != '\0'; i++)
-        {
-            if (i != 0)
-            {
-                g_string_append (sql, " OR ");
-            }
-            g_string_append (sql, fieldName);
-            g_string_append (sql, " = '");
-            g_string_append_c (sql, char_data->char_list[i]);
-            g_string_append (sql, "'");
-        }
-        g_string_append (sql, ") ");
-        if (isInverted)
-        {
-            g_string_append (sql, ") ");
-        }
+    switch (pPredData->how)
+    {
+    case QOF_COMPARE_LT:
+        sql = g_strdup_printf ("%s < '%s'", column, first_buf);
+        break;
+    case QOF_COMPARE_LTE:
+        sql = g_strdup_printf ("%s <= '%s'", column, last_buf);
+        break;
+    case QOF_COMPARE_GT:
+        sql = g_strdup_printf ("%s > '%s'", column, last_buf);
+        break;
+    case QOF_COMPARE_GTE:
+        sql = g_strdup_printf ("%s >= '%s'", column, first_buf);
+        break;
+    case QOF_COMPARE_EQUAL:
+    case QOF_COMPARE_NEQ:
+        sql = g_strdup_printf ("(%s >= '%s' AND %s <= '%s')", column, first_buf,
+                               column, last_buf);
+        break;
+    default:
+        break;
+    }
+    g_free (first_buf);
+    g_free (last_buf);
+
+    if (sql == NULL) return;
+    sql_condition_set_exact (cond, sql);
+    if (pPredData->how == QOF_COMPARE_NEQ)
+        sql_condition_negate (cond);
+}
 
+/* The condition that a value is within lower and upper, either of which
+ * is left out if its operator is NULL. */
+static gchar*
+numeric_range_to_sql (const gchar* value, const gchar* lower_op,
+                      gdouble lower, const gchar* upper_op, gdouble upper)
+{
+    gchar lower_buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar upper_buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    (void)g_ascii_formatd (lower_buf, sizeof (lower_buf), "%.6f", lower);
+    (void)g_ascii_formatd (upper_buf, sizeof (upper_buf), "%.6f", upper);
+    if (lower_op == NULL)
+        return g_strdup_printf ("%s %s %s", value, upper_op, upper_buf);
+    if (upper_op == NULL)
+        return g_strdup_printf ("%s %s %s", value, lower_op, lower_buf);
+    return g_strdup_printf ("(%s %s %s AND %s %s %s)", value, lower_op,
+                            lower_buf, value, upper_op, upper_buf);
+}
+
+static void
+numeric_term_to_sql (const gchar* column, QofQueryPredData* pPredData,
+                     sql_condition_t* cond)
+{
+    query_numeric_t numeric_data = (query_numeric_t)pPredData;
+    gdouble amount = gnc_numeric_to_double (numeric_data->amount);
+    const gdouble epsilon = 1e-4;     /* As numeric_match_predicate() */
+    gchar* value;
+
+    // numeric_match_predicate() compares the absolute value of the split's
+    value = g_strdup_printf ("ABS(%s_num * 1.0 / %s_denom)", column, column);
+    switch (pPredData->how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+    {
+        const gchar* op = (pPredData->how == QOF_COMPARE_LT) ? "<" : "<=";
+        cond->wider = numeric_range_to_sql (value, NULL, 0, op,
+                                            amount + NUMERIC_SLOP);
+        cond->narrower = numeric_range_to_sql (value, NULL, 0, op,
+                                               amount - NUMERIC_SLOP);
+        break;
     }
-    else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_STRING) == 0)
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
     {
-        query_string_t string_data = (query_string_t)pPredData;
-        sqlEscape* escape = sqlEscape_new ();
-
-        if (isInverted)
-        {
-            g_string_append (sql, "NOT(");
-        }
-        if (pPredData->how == QOF_COMPARE_NEQ)
-        {
-            g_string_append (sql, "NOT(");
-        }
-        g_string_append (sql, fieldName);
-        if (string_data->is_regex ||
-            string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE)
-        {
-            PWARN ("String is_regex || option = QOF_STRING_MATCH_INSENSITIVE\n");
-        }
-//          g_string_append( sql, " ~" );
-//      } else {
-        g_string_append (sql, " =");
-//      }
-//      if( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE ) {
-//          g_string_append( sql, "*" );
-//      }
-        g_string_append (sql, "'");
-        g_string_append (sql, sqlEscapeString (escape, string_data->matchstring));
-        g_string_append (sql, "'");
+        const gchar* op = (pPredData->how == QOF_COMPARE_GT) ? ">" : ">=";
+        cond->wider = numeric_range_to_sql (value, op, amount - NUMERIC_SLOP,
+                                            NULL, 0);
+        cond->narrower = numeric_range_to_sql (value, op, amount + NUMERIC_SLOP,
+                                               NULL, 0);
+        break;
+    }
+    case QOF_COMPARE_EQUAL:
+    case QOF_COMPARE_NEQ:
+        amount = ABS (amount);
+        cond->wider = numeric_range_to_sql (value,
+                                            ">", amount - epsilon - NUMERIC_SLOP,
+                                            "<", amount + epsilon + NUMERIC_SLOP);
+        cond->narrower = numeric_range_to_sql (value,
+                                               ">", amount - epsilon + NUMERIC_SLOP,
+                                               "<", amount + epsilon - NUMERIC_SLOP);
         if (pPredData->how == QOF_COMPARE_NEQ)
-        {
-            g_string_append (sql, ")");
-        }
-        if (isInverted)
-        {
-            g_string_append (sql, ")");
-        }
-        sqlEscape_destroy (escape);
-
+            sql_condition_negate (cond);
+        break;
+    default:
+        break;
     }
-    else
+    g_free (value);
+
+    if (numeric_data->options == QOF_NUMERIC_MATCH_CREDIT ||
+        numeric_data->options == QOF_NUMERIC_MATCH_DEBIT)
     {
-        g_string_append (sql, "(");
-        g_string_append (sql, fieldName);
-        convert_query_comparison_to_sql (pPredData, isInverted, sql);
+        sql_condition_t sign = { NULL, NULL };
 
-        if (strcmp (pPredData->type_name, QOF_TYPE_NUMERIC) == 0)
-        {
-            query_numeric_t pData = (query_numeric_t)pPredData;
-            double d = gnc_numeric_to_double (pData->amount);
+        sql_condition_set_exact (&sign, g_strdup_printf ("%s_num %s 0", column,
+                                                         (numeric_data->options == QOF_NUMERIC_MATCH_CREDIT) ? "<=" : ">="));
+        sql_condition_and (cond, &sign);
+        sql_condition_free (&sign);
+    }
+}
 
-            g_string_append_printf (sql, "%f", d);
+/* The text a regular expression matches when it has no special
+ * characters but anchors, or NULL. */
+static gchar*
+regex_literal (const gchar* regex, gboolean* at_start, gboolean* at_end)
+{
+    gsize len;
+    gchar* literal;
 
-        }
-        else if (g_strcmp0 (pPredData->type_name, QOF_TYPE_DATE) == 0)
-        {
-            query_date_t date_data = (query_date_t)pPredData;
-            gchar* datebuf;
+    *at_start = (regex[0] == '^');
+    if (*at_start) regex++;
+    len = strlen (regex);
+    *at_end = (len > 0 && regex[len - 1] == '$');
+    if (*at_end) len--;
 
-            datebuf = gnc_sql_convert_timespec_to_string (be, date_data->date);
-            g_string_append_printf (sql, "'%s'", datebuf);
+    literal = g_strndup (regex, len);
+    if (strpbrk (literal, REGEX_SPECIAL_CHARS) != NULL)
+    {
+        g_free (literal);
+        return NULL;
+    }
+    return literal;
+}
 
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_INT32) == 0)
-        {
-            query_int32_t pData = (query_int32_t)pPredData;
+static gchar*
+like_pattern (const gchar* literal, gboolean at_start, gboolean at_end)
+{
+    GString* pattern = g_string_new (at_start ? "" : "%");
+    const gchar* c;
 
-            g_string_append_printf (sql, "%d", pData->val);
+    for (c = literal; *c != '\0'; c++)
+    {
+        if (strchr ("%_!", *c) != NULL) g_string_append_c (pattern, '!');
+        g_string_append_c (pattern, *c);
+    }
+    if (!at_end) g_string_append_c (pattern, '%');
+    return g_string_free (pattern, FALSE);
+}
 
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_INT64) == 0)
-        {
-            query_int64_t pData = (query_int64_t)pPredData;
+/* Only sets the wider condition: SQL collations can find strings which
+ * differ from the text.  Case-insensitive matches are left to the
+ * query, as it folds and normalizes Unicode text. */
+static void
+string_term_to_sql (const GncSqlBackend* be, const gchar* column,
+                    QofQueryPredData* pPredData, sql_condition_t* cond)
+{
+    query_string_t string_data = (query_string_t)pPredData;
+    gboolean at_start;
+    gboolean at_end;
+    gchar* literal;
+    gchar* text;
+    gchar* quoted;
 
-            g_string_append_printf (sql, "%" G_GINT64_FORMAT, pData->val);
+    if (string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE) return;
 
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_DOUBLE) == 0)
-        {
-            query_double_t pData = (query_double_t)pPredData;
+    if (string_data->is_regex)
+    {
+        literal = regex_literal (string_data->matchstring, &at_start, &at_end);
+        if (literal == NULL) return;
+    }
+    else if (pPredData->how == QOF_COMPARE_CONTAINS ||
+             pPredData->how == QOF_COMPARE_NCONTAINS)
+    {
+        literal = g_strdup (string_data->matchstring);
+        at_start = at_end = FALSE;
+    }
+    else if (pPredData->how == QOF_COMPARE_EQUAL ||
+             pPredData->how == QOF_COMPARE_NEQ)
+    {
+        literal = g_strdup (string_data->matchstring);
+        at_start = at_end = TRUE;
+    }
+    else
+    {
+        return;
+    }
 
-            g_string_append_printf (sql, "%f", pData->val);
+    text = (at_start && at_end) ? g_strdup (literal) :
+           like_pattern (literal, at_start, at_end);
+    g_free (literal);
+    quoted = gnc_sql_connection_quote_string (be->conn, text);
+    g_free (text);
+    if (quoted == NULL) return;
 
-        }
-        else if (strcmp (pPredData->type_name, QOF_TYPE_BOOLEAN) == 0)
-        {
-            query_boolean_t pData = (query_boolean_t)pPredData;
+    if (at_start && at_end)
+        cond->wider = g_strdup_printf ("%s = %s", column, quoted);
+    else
+        cond->wider = g_strdup_printf ("%s LIKE %s ESCAPE '!'", column, quoted);
+    g_free (quoted);
 
-            g_string_append_printf (sql, "%d", pData->val);
+    if (pPredData->how == QOF_COMPARE_NEQ ||
+        pPredData->how == QOF_COMPARE_NCONTAINS)
+        sql_condition_negate (cond);
+}
 
-        }
-        else
-        {
-            PERR ("Unknown query predicate type: %s\n", pPredData->type_name);
-        }
+/* The notes are kept in a slot, which transactions without notes lack */
+static void
+notes_term_to_sql (const GncSqlBackend* be, QofQueryPredData* pPredData,
+                   sql_condition_t* cond)
+{
+    query_string_t string_data = (query_string_t)pPredData;
+    gboolean matches_empty;
+    gchar* sql;
 
-        g_string_append (sql, ")");
+    // Slots serialized into blobs can't be searched in SQL
+    if (be->slot_blobs) return;
+
+    string_term_to_sql (be, "string_val", pPredData, cond);
+    if (cond->wider == NULL && cond->narrower == NULL) return;
+
+    if (string_data->is_regex)
+        matches_empty = (regexec (&string_data->compiled, "", 0, NULL, 0) == 0);
+    else
+        matches_empty = (string_data->matchstring[0] == '\0');
+    if (pPredData->how == QOF_COMPARE_NEQ ||
+        pPredData->how == QOF_COMPARE_NCONTAINS)
+        matches_empty = !matches_empty;
+
+    g_free (cond->narrower);
+    cond->narrower = NULL;
+    if (matches_empty || cond->wider == NULL)
+    {
+        g_free (cond->wider);
+        cond->wider = NULL;
+        return;
     }
+    sql = g_strdup_printf ("t.guid IN (SELECT obj_guid FROM slots WHERE name='notes' AND %s)",
+                           cond->wider);
+    g_free (cond->wider);
+    cond->wider = sql;
 }
 
-typedef struct
+/**
+ * Puts a query term on splits in SQL, as far as it can be.
+ *
+ * @param be SQL backend
+ * @param pTerm Query term
+ * @param cond Conditions for the term
+ */
+static void
+convert_split_query_term (const GncSqlBackend* be, QofQueryTerm* pTerm,
+                          sql_condition_t* cond)
 {
-    GncSqlStatement* stmt;
-    gboolean has_been_run;
-} split_query_info_t;
+    GSList* paramPath = qof_query_term_get_param_path (pTerm);
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data (pTerm);
+    const split_query_column_t* col;
+
+    if (param_path_is (paramPath, SPLIT_TRANS, TRANS_SPLITLIST,
+                       SPLIT_ACCOUNT_GUID, NULL))
+    {
+        if (g_strcmp0 (pPredData->type_name, QOF_TYPE_GUID) == 0)
+            split_list_term_to_sql (pPredData, cond);
+    }
+    else if (param_path_is (paramPath, SPLIT_TRANS, TRANS_NOTES, NULL))
+    {
+        if (g_strcmp0 (pPredData->type_name, QOF_TYPE_STRING) == 0)
+            notes_term_to_sql (be, pPredData, cond);
+    }
+    else
+    {
+        col = find_split_query_column (paramPath);
+        if (col == NULL || g_strcmp0 (pPredData->type_name, col->type) != 0)
+            return;
+
+        if (strcmp (col->type, QOF_TYPE_GUID) == 0)
+            guid_term_to_sql (col->column, pPredData, cond);
+        else if (strcmp (col->type, QOF_TYPE_CHAR) == 0)
+            char_term_to_sql (col->column, pPredData, cond);
+        else if (strcmp (col->type, QOF_TYPE_DATE) == 0)
+            date_term_to_sql (be, col->column, pPredData, cond);
+        else if (strcmp (col->type, QOF_TYPE_NUMERIC) == 0)
+            numeric_term_to_sql (col->column, pPredData, cond);
+        else if (strcmp (col->type, QOF_TYPE_STRING) == 0)
+            string_term_to_sql (be, col->column, pPredData, cond);
+
+        if (col->nullable)
+            sql_condition_allow_null (cond, col->column);
+    }
 
-#define TX_GUID_CHECK 0
+    if (qof_query_term_is_inverted (pTerm))
+        sql_condition_negate (cond);
+}
 
-G_GNUC_UNUSED static  gpointer
+static gpointer
 compile_split_query (GncSqlBackend* be, QofQuery* query)
 {
-    split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    split_query_info_t* query_info;
+    GList* orTerm;
 
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (query != NULL, NULL);
 
-    query_info = static_cast<decltype (query_info)> (
-                     g_malloc (sizeof (split_query_info_t)));
-    g_assert (query_info != NULL);
-    query_info->has_been_run = FALSE;
+    if (be->tx_cache == NULL) return NULL;
 
-    if (qof_query_has_terms (query))
+    query_info = g_new0 (split_query_info_t, 1);
+    query_info->query = query;
+    if (!qof_query_has_terms (query))
     {
-        GList* orterms = qof_query_get_terms (query);
-        GList* orTerm;
-        GString* sql = g_string_new ("");
-        gboolean need_OR = FALSE;
-
-        for (orTerm = orterms; orTerm != NULL; orTerm = orTerm->next)
-        {
-            GList* andterms = (GList*)orTerm->data;
-            GList* andTerm;
-            gboolean need_AND = FALSE;
-#if TX_GUID_CHECK
-            gboolean has_tx_guid_check = FALSE;
-#endif
-            if (need_OR)
-            {
-                g_string_append (sql, " OR ");
-            }
-            g_string_append (sql, "(");
-            for (andTerm = andterms; andTerm != NULL; andTerm = andTerm->next)
-            {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path (term);
-                const char* path = static_cast<decltype (path)> (paramPath->data);
-                const char* next_path =
-                    static_cast<decltype (next_path)> (paramPath->next->data);
-                if (strcmp (path, QOF_PARAM_BOOK) == 0) continue;
-
-#if SIMPLE_QUERY_COMPILATION
-                if (strcmp (path, SPLIT_ACCOUNT) != 0 ||
-                    strcmp (next_path, QOF_PARAM_GUID) != 0) continue;
-#endif
-
-                if (need_AND) g_string_append (sql, " AND ");
-
-                if (strcmp (path, SPLIT_ACCOUNT) == 0 &&
-                    strcmp (next_path, QOF_PARAM_GUID) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.account_guid", term, sql);
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
-
-                }
-                else if (strcmp (path, SPLIT_RECONCILE) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.reconcile_state", term, sql);
-
-                }
-                else if (strcmp (path, SPLIT_TRANS) == 0)
-                {
-#if TX_GUID_CHECK
-                    if (!has_tx_guid_check)
-                    {
-                        g_string_append (sql, "(splits.tx_guid = transactions.guid) AND ");
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if (strcmp (next_path, TRANS_DATE_POSTED) == 0)
-                    {
-                        convert_query_term_to_sql (be, "t.post_date", term, sql);
-                    }
-                    else if (strcmp (next_path, TRANS_DESCRIPTION) == 0)
-                    {
-                        convert_query_term_to_sql (be, "t.description", term, sql);
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
-
-                }
-                else if (strcmp (path, SPLIT_VALUE) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.value_num/s.value_denom", term, sql);
+        query_info->condition.narrower = g_strdup ("1=1");
+        return query_info;
+    }
 
-                }
-                else
-                {
-                    unknownPath = TRUE;
-                }
+    for (orTerm = qof_query_get_terms (query); orTerm != NULL;
+         orTerm = orTerm->next)
+    {
+        sql_condition_t and_cond = { NULL, NULL };
+        GList* andTerm;
 
-                if (unknownPath)
-                {
-                    GString* name = g_string_new ((gchar*)paramPath->data);
-                    while (paramPath->next != NULL)
-                    {
-                        g_string_append (name, ".");
-                        g_string_append (name, next_path);
-                        paramPath = paramPath->next;
-                    }
-                    PERR ("Unknown SPLIT query field: %s\n", name->str);
-                    g_string_free (name, TRUE);
-                }
-                need_AND = TRUE;
-            }
+        for (andTerm = (GList*)orTerm->data; andTerm != NULL;
+             andTerm = andTerm->next)
+        {
+            sql_condition_t term_cond = { NULL, NULL };
 
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-            if (sql->str[sql->len - 1] == '(')
+            convert_split_query_term (be, (QofQueryTerm*)andTerm->data,
+                                      &term_cond);
+            if (andTerm == orTerm->data)
             {
-                g_string_truncate (sql, sql->len - 1);
-                need_OR = FALSE;
+                and_cond = term_cond;
             }
             else
             {
-                g_string_append (sql, ")");
-                need_OR = TRUE;
+                sql_condition_and (&and_cond, &term_cond);
+                sql_condition_free (&term_cond);
             }
         }
-
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-        if (sql->len != 0)
+        if (orTerm == qof_query_get_terms (query))
         {
-#if SIMPLE_QUERY_COMPILATION
-            g_string_append (sql, ")");
-#endif
-            query_sql = g_strdup_printf (
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
-                            TRANSACTION_TABLE, SPLIT_TABLE, sql->str);
+            query_info->condition = and_cond;
         }
         else
         {
-            query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
+            sql_condition_or (&query_info->condition, &and_cond);
+            sql_condition_free (&and_cond);
         }
-        query_info->stmt = gnc_sql_create_statement_from_sql (be, query_sql);
-
-        g_string_free (sql, TRUE);
-        g_free (query_sql);
-
-    }
-    else
-    {
-        query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
-        query_info->stmt = gnc_sql_create_statement_from_sql (be, query_sql);
-        g_free (query_sql);
     }
 
     return query_info;
 }
 
-G_GNUC_UNUSED static void
+/* Queries on transactions load all of them. */
+static gpointer
+compile_tx_query (GncSqlBackend* be, QofQuery* query)
+{
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (query != NULL, NULL);
+
+    if (be->tx_cache == NULL) return NULL;
+
+    return g_new0 (split_query_info_t, 1);
+}
+
+/**
+ * Returns the date column a query on splits is sorted on first, if it is
+ * sorted on one which is stored exactly.
+ *
+ * @param query Query
+ * @param increasing Set to TRUE if the query's last splits have the
+ * latest dates
+ * @return Column, or NULL
+ */
+static const gchar*
+split_query_sort_column (QofQuery* query, gboolean* increasing)
+{
+    QofQuerySort* primary;
+    QofQuerySort* secondary;
+    QofQuerySort* tertiary;
+    GSList* sortPath;
+    const split_query_column_t* col;
+
+    qof_query_get_sorts (query, &primary, &secondary, &tertiary);
+    sortPath = qof_query_sort_get_param_path (primary);
+    if (sortPath == NULL) return NULL;
+    *increasing = qof_query_sort_get_increasing (primary);
+
+    // The default order of splits is their transactions' posted dates first
+    if (param_path_is (sortPath, QUERY_DEFAULT_SORT, NULL))
+        return "t.post_date";
+
+    if (qof_query_sort_get_sort_options (primary) == QOF_DATE_MATCH_DAY)
+        return NULL;
+    col = find_split_query_column (sortPath);
+    if (col == NULL || strcmp (col->type, QOF_TYPE_DATE) != 0) return NULL;
+    return col->column;
+}
+
+/* The query holds the unit with the transactions it loaded, so that they
+ * stay in memory while it lives. */
+static void
+split_query_use_unit (split_query_info_t* query_info, tx_cache_unit_t* unit)
+{
+    if (unit == NULL || unit == query_info->unit) return;
+
+    unit->refs++;
+    if (query_info->unit != NULL)
+        tx_cache_unit_unref (query_info->unit);
+    query_info->unit = unit;
+}
+
+/**
+ * Loads the transactions a query on splits can match.
+ *
+ * @param be SQL backend
+ * @param query_info Compiled query
+ * @return The unit holding the transactions, or NULL
+ */
+static tx_cache_unit_t*
+load_split_query_tx (GncSqlBackend* be, split_query_info_t* query_info)
+{
+    const sql_condition_t* cond;
+    const gchar* sort_column;
+    gboolean increasing = TRUE;
+    gint max_results;
+    gchar* condition;
+    tx_cache_unit_t* unit;
+
+    if (query_info->query == NULL)
+        return load_tx_where (be, NULL);
+
+    cond = &query_info->condition;
+    max_results = qof_query_get_max_results (query_info->query);
+    if (max_results == 0) return NULL;
+    sort_column = split_query_sort_column (query_info->query, &increasing);
+    if (max_results < 0 || sort_column == NULL || cond->narrower == NULL)
+        return load_tx_where (be, cond->wider);
+
+    // Only the splits sorted from the last max_results matching ones on
+    // can be among the results.  The splits without a date are sorted by
+    // the date they are given when loaded, so they are all loaded.
+    condition = g_strdup_printf (
+                    "(%s) AND (%s IS NULL OR %s %s COALESCE((SELECT %s FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s) AND %s IS NOT NULL ORDER BY %s %s LIMIT 1 OFFSET %d), %s))",
+                    cond->wider != NULL ? cond->wider : "1=1",
+                    sort_column, sort_column, increasing ? ">=" : "<=",
+                    sort_column, TRANSACTION_TABLE, SPLIT_TABLE, cond->narrower,
+                    sort_column, sort_column, increasing ? "DESC" : "ASC",
+                    max_results - 1, sort_column);
+    unit = load_tx_where (be, condition);
+    g_free (condition);
+    return unit;
+}
+
+static void
 run_split_query (GncSqlBackend* be, gpointer pQuery)
 {
     split_query_info_t* query_info = (split_query_info_t*)pQuery;
+    tx_cache_unit_t* unit;
 
     g_return_if_fail (be != NULL);
-    g_return_if_fail (pQuery != NULL);
 
-    if (!query_info->has_been_run)
-    {
-        query_transactions (be, query_info->stmt);
-        query_info->has_been_run = TRUE;
-        gnc_sql_statement_dispose (query_info->stmt);
-        query_info->stmt = NULL;
-    }
+    if (query_info == NULL || be->tx_cache == NULL) return;
+
+    unit = load_split_query_tx (be, query_info);
+    extend_horizons_for_edits (be, unit);
+    split_query_use_unit (query_info, unit);
 }
 
-G_GNUC_UNUSED static void
+static void
 free_split_query (GncSqlBackend* be, gpointer pQuery)
 {
+    split_query_info_t* query_info = (split_query_info_t*)pQuery;
+
     g_return_if_fail (be != NULL);
-    g_return_if_fail (pQuery != NULL);
 
-    g_free (pQuery);
+    if (query_info == NULL) return;
+
+    if (query_info->unit != NULL)
+        tx_cache_unit_unref (query_info->unit);
+    sql_condition_free (&query_info->condition);
+    g_free (query_info);
 }
 
 /* ----------------------------------------------------------------- */
@@ -1330,7 +2738,7 @@ static const GncSqlColumnTableEntry acct_balances_col_table[] =
     { NULL }
 };
 
-G_GNUC_UNUSED static  single_acct_balance_t*
+static  single_acct_balance_t*
 load_single_acct_balances (const GncSqlBackend* be, GncSqlRow* row)
 {
     single_acct_balance_t* bal = NULL;
@@ -1350,7 +2758,6 @@ load_single_acct_balances (const GncSqlBackend* be, GncSqlRow* row)
 GSList*
 gnc_sql_get_account_balances_slist (GncSqlBackend* be)
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     GncSqlResult* result;
     GncSqlStatement* stmt;
     gchar* buf;
@@ -1381,36 +2788,29 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* be)
             {
                 if (bal != NULL && bal->acct != single_bal->acct)
                 {
-                    bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
-                                                            bal->reconciled_balance,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                    bal->balance = gnc_numeric_add (bal->balance, bal->cleared_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                    bal_slist = g_slist_append (bal_slist, bal);
+                    bal_slist = g_slist_prepend (bal_slist, bal);
                     bal = NULL;
                 }
                 if (bal == NULL)
                 {
-                    bal = g_malloc ((gsize)sizeof (acct_balances_t));
-                    g_assert (bal != NULL);
-
+                    bal = g_new (acct_balances_t, 1);
                     bal->acct = single_bal->acct;
                     bal->balance = gnc_numeric_zero ();
                     bal->cleared_balance = gnc_numeric_zero ();
                     bal->reconciled_balance = gnc_numeric_zero ();
                 }
-                if (single_bal->reconcile_state == 'n')
-                {
-                    bal->balance = gnc_numeric_add (bal->balance, single_bal->balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                }
-                else if (single_bal->reconcile_state == 'c')
+                // As in xaccAccountRecomputeBalance(): anything but 'n' is
+                // cleared, and frozen splits are reconciled
+                bal->balance = gnc_numeric_add (bal->balance, single_bal->balance,
+                                                GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+                if (single_bal->reconcile_state != NREC)
                 {
                     bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
                                                             single_bal->balance,
                                                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
                 }
-                else if (single_bal->reconcile_state == 'y')
+                if (single_bal->reconcile_state == YREC ||
+                    single_bal->reconcile_state == FREC)
                 {
                     bal->reconciled_balance = gnc_numeric_add (bal->reconciled_balance,
                                                                single_bal->balance,
@@ -1424,29 +2824,22 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* be)
         // Add the final balance
         if (bal != NULL)
         {
-            bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
-                                                    bal->reconciled_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            bal->balance = gnc_numeric_add (bal->balance, bal->cleared_balance,
-                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            bal_slist = g_slist_append (bal_slist, bal);
+            bal_slist = g_slist_prepend (bal_slist, bal);
         }
         gnc_sql_result_dispose (result);
     }
 
-    return bal_slist;
-#else
-    return NULL;
-#endif
+    return g_slist_reverse (bal_slist);
 }
 
 /* ----------------------------------------------------------------- */
 static void
 load_tx_guid (const GncSqlBackend* be, GncSqlRow* row,
               QofSetterFunc setter, gpointer pObject,
-              const GncSqlColumnTableEntry* table_row)
+              const GncSqlColumnTableEntry* table_row,
+              const gint* cols)
 {
-    const GValue* val;
+    gint col;
     GncGUID guid;
     Transaction* tx;
     const gchar* guid_str;
@@ -1456,9 +2849,9 @@ load_tx_guid (const GncSqlBackend* be, GncSqlRow* row,
     g_return_if_fail (pObject != NULL);
     g_return_if_fail (table_row != NULL);
 
-    val = gnc_sql_row_get_value_at_col_name (row, table_row->col_name);
-    g_assert (val != NULL);
-    guid_str = g_value_get_string (val);
+    col = cols[0];
+    g_assert (col >= 0);
+    guid_str = gnc_sql_row_get_string_at_col (row, col);
     if (guid_str != NULL)
     {
         (void)string_to_guid (guid_str, &guid);
@@ -1474,7 +2867,11 @@ load_tx_guid (const GncSqlBackend* be, GncSqlRow* row,
                                    TRANSACTION_TABLE, guid_str);
             stmt = gnc_sql_create_statement_from_sql ((GncSqlBackend*)be, buf);
             g_free (buf);
-            query_transactions ((GncSqlBackend*)be, stmt);
+            if (stmt != NULL)
+            {
+                query_pinned_transactions ((GncSqlBackend*)be, stmt);
+                gnc_sql_statement_dispose (stmt);
+            }
             tx = xaccTransLookup (&guid, be->book);
         }
 
@@ -1510,15 +2907,11 @@ gnc_sql_init_transaction_handler (void)
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_TRANS,
         commit_transaction,          /* commit */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        NULL,                        /* initial load */
-#else
-        gnc_sql_transaction_load_all_tx,
-#endif
+        load_initial_tx,             /* initial load */
         create_transaction_tables,   /* create tables */
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
+        compile_tx_query,            /* compile_query */
+        run_split_query,             /* run_query */
+        free_split_query,            /* free_query */
         NULL                         /* write */
     };
     static GncSqlObjectBackend be_data_split =
@@ -1528,15 +2921,9 @@ gnc_sql_init_transaction_handler (void)
         commit_split,                /* commit */
         NULL,                        /* initial_load */
         NULL,                        /* create tables */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        compile_split_query,
-        run_split_query,
-        free_split_query,
-#else
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
-#endif
+        compile_split_query,         /* compile_query */
+        run_split_query,             /* run_query */
+        free_split_query,            /* free_query */
         NULL                         /* write */
     };
 
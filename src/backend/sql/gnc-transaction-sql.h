@@ -56,7 +56,9 @@ void gnc_sql_transaction_commit_splits (GncSqlBackend* be, Transaction* pTx);
 gboolean gnc_sql_save_transaction (GncSqlBackend* be, QofInstance* inst);
 
 /**
- * Loads all transactions which have splits for a specific account.
+ * Loads all transactions which have splits for a specific account.  When
+ * transactions are loaded as needed, they are kept in memory for the rest
+ * of the session, and loading them again does nothing.
  *
  * @param be SQL backend
  * @param account Account
@@ -71,6 +73,55 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* be,
  */
 void gnc_sql_transaction_load_all_tx (GncSqlBackend* be);
 
+/**
+ * Loads the transactions the engine needs before it walks an instance's
+ * splits itself: all of them for the book, those with splits in an
+ * account for an account.  Does nothing unless transactions are loaded
+ * as needed.
+ *
+ * @param be SQL backend
+ * @param inst The book or an account
+ */
+void gnc_sql_transaction_load_related (GncSqlBackend* be, QofInstance* inst);
+
+/**
+ * Sets up loading transactions as needed, when the sql-load-as-needed
+ * preference is set, keeping about as many of them in memory as the
+ * sql-cache-size preference.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_transaction_cache_init (GncSqlBackend* be);
+
+/**
+ * Stops loading transactions as needed.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_transaction_cache_free (GncSqlBackend* be);
+
+/**
+ * Drops the least recently used transactions from memory while more than
+ * max_transactions are loaded.  Transactions which a live query has
+ * found, which have been edited, or which something else holds a
+ * reference to are kept.  The caller must not be using any transactions
+ * it doesn't hold one of those ways.
+ *
+ * @param be SQL backend
+ * @param max_transactions Number of transactions to keep
+ */
+void gnc_sql_transaction_cache_evict (GncSqlBackend* be,
+                                      guint max_transactions);
+
+/**
+ * Drops the least recently used transactions from memory the next time
+ * the main loop is idle, if more are loaded than the sql-cache-size
+ * preference.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_transaction_cache_evict_when_idle (GncSqlBackend* be);
+
 typedef struct
 {
     Account* acct;
@@ -81,7 +132,7 @@ typedef struct
 
 /**
  * Returns a list of acct_balances_t structures, one for each account which
- * has splits.
+ * has splits, with the balances of all of the splits in the database.
  *
  * @param be SQL backend
  * @return GSList of acct_balances_t structures
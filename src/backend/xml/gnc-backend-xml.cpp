@@ -91,6 +91,7 @@ extern "C"
 #include <qofbackend-p.h>
 #include "gnc-xml-helper.h"
 #include "io-gncxml.h"
+#include "io-gncsnapshot.h"
 
 #include "gnc-address-xml-v2.h"
 #include "gnc-bill-term-xml-v2.h"
@@ -840,6 +841,14 @@ gnc_xml_be_write_to_file (FileBackend* fbe,
         }
         g_free (tmp_name);
 
+        /* The snapshot only speeds up opening the file, so failing to
+         * write it doesn't fail the save.  One left from when the
+         * preference was set no longer matches the file, and is kept
+         * for the user to remove. */
+        if (gnc_snapshot_enabled () &&
+            !gnc_snapshot_write (book, datafile))
+            PWARN ("unable to write the snapshot of %s", datafile);
+
         /* Since we successfully saved the book,
          * we should mark it clean. */
         qof_book_mark_session_saved (book);
@@ -1133,6 +1142,7 @@ gnc_xml_be_load_from_file (QofBackend* bend, QofBook* book,
     QofBackendError error;
     gboolean rc;
     FileBackend* be = (FileBackend*) bend;
+    gnc_snapshot* snapshot;
 
     if (loadType != LOAD_TYPE_INITIAL_LOAD) return;
 
@@ -1142,7 +1152,26 @@ gnc_xml_be_load_from_file (QofBackend* bend, QofBook* book,
     switch (gnc_xml_be_determine_file_type (be->fullpath))
     {
     case GNC_BOOK_XML2_FILE:
-        rc = qof_session_load_from_xml_file_v2 (be, book, GNC_BOOK_XML2_FILE);
+        snapshot = gnc_snapshot_enabled () && !be->snapshot_failed ?
+                   gnc_snapshot_open (be->fullpath) : NULL;
+        if (snapshot)
+        {
+            rc = gnc_snapshot_load (snapshot, be, book);
+            gnc_snapshot_close (snapshot);
+            if (FALSE == rc)
+            {
+                /* The book is partly filled by now; have the session
+                 * give us an empty one to load the XML into. */
+                PWARN ("Discarding the snapshot of %s", be->fullpath);
+                gnc_snapshot_remove (be->fullpath);
+                be->snapshot_failed = TRUE;
+                error = ERR_FILEIO_RELOAD;
+                break;
+            }
+        }
+        else
+            rc = qof_session_load_from_xml_file_v2 (be, book, GNC_BOOK_XML2_FILE);
+        be->snapshot_failed = FALSE;
         if (FALSE == rc)
         {
             PWARN ("Syntax error in Xml File %s", be->fullpath);
@@ -1262,6 +1291,7 @@ QofXmlBackendProvider::create_backend(void)
     gnc_be->lockfile = NULL;
     gnc_be->linkfile = NULL;
     gnc_be->lockfd = -1;
+    gnc_be->snapshot_failed = FALSE;
 
     gnc_be->book = NULL;
 
@@ -65,6 +65,7 @@ struct FileBackend_struct
     char* lockfile;
     char* linkfile;
     int lockfd;
+    gboolean snapshot_failed; /* Load the XML, not the snapshot */
 
     QofBook* book;  /* The primary, main open book */
 };
@@ -36,6 +36,7 @@ extern "C"
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-parsers.h"
 #include "io-gncxml-gen.h"
 #include "io-gncxml-v2.h"
 
@@ -231,12 +232,251 @@ cleanup_gnc_price (sixtp_child_result* result)
     if (result->data) gnc_price_unref ((GNCPrice*) result->data);
 }
 
+/* The streaming <price> parser reads the same sub-nodes as
+   price_parse_xml_sub_node, straight from the SAX events. */
+
+struct price_stream_data
+{
+    GNCPrice* price;
+    QofBook* book;
+    sixtp_stream_reader* reader;
+    gboolean ok;
+    gboolean seen_child;
+};
+
+static gboolean
+price_id_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    GncGUID id;
+
+    if (!sixtp_stream_to_guid (reader, &id)) return FALSE;
+    gnc_price_set_guid (sdata->price, &id);
+    return TRUE;
+}
+
+static gboolean
+price_commodity_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    gnc_commodity* c = sixtp_stream_to_commodity_ref (reader, sdata->book);
+
+    if (!c) return FALSE;
+    gnc_price_set_commodity (sdata->price, c);
+    return TRUE;
+}
+
+static gboolean
+price_currency_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    gnc_commodity* c = sixtp_stream_to_commodity_ref (reader, sdata->book);
+
+    if (!c) return FALSE;
+    gnc_price_set_currency (sdata->price, c);
+    return TRUE;
+}
+
+static gboolean
+price_time_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    Timespec t = sixtp_stream_to_timespec (reader);
+
+    if (!dom_tree_valid_timespec (&t, BAD_CAST sixtp_stream_field_tag (reader)))
+        return FALSE;
+    gnc_price_set_time (sdata->price, t);
+    return TRUE;
+}
+
+static gboolean
+price_source_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    gnc_price_set_source_string (sdata->price, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+static gboolean
+price_type_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    gnc_price_set_typestr (sdata->price, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+static gboolean
+price_value_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct price_stream_data* sdata = static_cast<decltype (sdata)> (data);
+    gnc_numeric value;
+
+    if (!sixtp_stream_to_gnc_numeric (reader, &value)) return FALSE;
+    gnc_price_set_value (sdata->price, value);
+    return TRUE;
+}
+
+static const struct sixtp_stream_field price_stream_fields[] =
+{
+    { "price:id", SIXTP_STREAM_GUID, price_id_stream_handler, FALSE },
+    {
+        "price:commodity", SIXTP_STREAM_COMMODITY,
+        price_commodity_stream_handler, FALSE
+    },
+    {
+        "price:currency", SIXTP_STREAM_COMMODITY,
+        price_currency_stream_handler, FALSE
+    },
+    { "price:time", SIXTP_STREAM_TIMESPEC, price_time_stream_handler, FALSE },
+    { "price:source", SIXTP_STREAM_TEXT, price_source_stream_handler, FALSE },
+    { "price:type", SIXTP_STREAM_TEXT, price_type_stream_handler, FALSE },
+    { "price:value", SIXTP_STREAM_TEXT, price_value_stream_handler, FALSE },
+    { NULL, SIXTP_STREAM_TEXT, NULL, FALSE },
+};
+
+static gboolean
+price_stream_start (gpointer data_for_children, const gchar* tag,
+                    gchar** attrs)
+{
+    struct price_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    /* unknown sub-nodes are skipped, as price_parse_xml_sub_node does */
+    sdata->seen_child = TRUE;
+    sixtp_stream_reader_start (sdata->reader, tag, attrs);
+    return TRUE;
+}
+
+static gboolean
+price_stream_characters (gpointer data_for_children, const char* text,
+                         int length)
+{
+    struct price_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    sixtp_stream_reader_characters (sdata->reader, text, length);
+    return TRUE;
+}
+
+static gboolean
+price_stream_end (gpointer data_for_children, const gchar* tag)
+{
+    struct price_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    if (!sixtp_stream_reader_end (sdata->reader, tag))
+        sdata->ok = FALSE;
+    return TRUE;
+}
+
+static const sixtp_stream_handlers price_stream_handlers =
+{
+    price_stream_start,
+    price_stream_characters,
+    price_stream_end,
+};
+
+static void
+price_stream_data_free (struct price_stream_data* sdata)
+{
+    sixtp_stream_reader_free (sdata->reader);
+    g_free (sdata);
+}
+
+static gboolean
+price_stream_start_handler (GSList* sibling_data,
+                            gpointer parent_data,
+                            gpointer global_data,
+                            gpointer* data_for_children,
+                            gpointer* result,
+                            const gchar* tag,
+                            gchar** attrs)
+{
+    gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
+    QofBook* book = static_cast<decltype (book)> (gdata->bookdata);
+    struct price_stream_data* sdata;
+    GNCPrice* p;
+
+    /* the document, when we're the top level parser */
+    if (!tag) return TRUE;
+
+    p = gnc_price_create (book);
+    if (!p) return FALSE;
+
+    sdata = g_new0 (struct price_stream_data, 1);
+    sdata->price = p;
+    sdata->book = book;
+    sdata->ok = TRUE;
+    sdata->reader = sixtp_stream_reader_new (price_stream_fields);
+    sixtp_stream_reader_reset (sdata->reader, sdata, QOF_INSTANCE (p));
+    gnc_price_begin_edit (p);
+
+    *data_for_children = sdata;
+    *result = NULL;
+    return TRUE;
+}
+
+static gboolean
+price_stream_end_handler (gpointer data_for_children,
+                          GSList* data_from_children,
+                          GSList* sibling_data,
+                          gpointer parent_data,
+                          gpointer global_data,
+                          gpointer* result,
+                          const gchar* tag)
+{
+    struct price_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+    gboolean ok;
+
+    if (!tag) return TRUE;
+
+    *result = NULL;
+    if (!sdata) return FALSE;
+
+    ok = sdata->ok && sdata->seen_child;
+    gnc_price_commit_edit (sdata->price);
+    if (ok)
+        *result = sdata->price;
+    else
+        gnc_price_unref (sdata->price);
+
+    price_stream_data_free (sdata);
+    return ok;
+}
+
+static void
+price_stream_fail_handler (gpointer data_for_children,
+                           GSList* data_from_children,
+                           GSList* sibling_data,
+                           gpointer parent_data,
+                           gpointer global_data,
+                           gpointer* result,
+                           const gchar* tag)
+{
+    struct price_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    if (!sdata) return;
+
+    gnc_price_commit_edit (sdata->price);
+    gnc_price_unref (sdata->price);
+    price_stream_data_free (sdata);
+}
+
 static sixtp*
 gnc_price_parser_new (void)
 {
-    return sixtp_dom_parser_new (price_parse_xml_end_handler,
-                                 cleanup_gnc_price,
-                                 cleanup_gnc_price);
+    if (!sixtp_use_stream_parsers ())
+        return sixtp_dom_parser_new (price_parse_xml_end_handler,
+                                     cleanup_gnc_price,
+                                     cleanup_gnc_price);
+
+    return sixtp_stream_parser_new (price_stream_start_handler,
+                                    &price_stream_handlers,
+                                    price_stream_end_handler,
+                                    price_stream_fail_handler,
+                                    cleanup_gnc_price);
 }
 
 
@@ -42,6 +42,7 @@ extern "C"
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-parsers.h"
 
 #include "gnc-xml.h"
 
@@ -49,6 +50,9 @@ extern "C"
 
 #include "sixtp-dom-parsers.h"
 
+/* This static indicates the debugging module that this .o belongs to.  */
+static QofLogModule log_module = GNC_MOD_IO;
+
 const gchar* transaction_version_string = "2.0.0";
 
 static void
@@ -195,6 +199,81 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+static void
+split_to_xml_text (GString* out, int level, const gchar* tag, Split* spl)
+{
+    auto children = xml_text_open (out, level, tag, NULL);
+    ++level;
+
+    guid_to_xml_text (out, level, "split:id", xaccSplitGetGUID (spl));
+
+    auto memo = xaccSplitGetMemo (spl);
+    if (memo && g_strcmp0 (memo, "") != 0)
+        xml_text_leaf (out, level, "split:memo", NULL, memo, TRUE);
+
+    auto action = xaccSplitGetAction (spl);
+    if (action && g_strcmp0 (action, "") != 0)
+        xml_text_leaf (out, level, "split:action", NULL, action, TRUE);
+
+    char tmp[2];
+    tmp[0] = xaccSplitGetReconcile (spl);
+    tmp[1] = '\0';
+    xml_text_leaf (out, level, "split:reconciled-state", NULL, tmp, FALSE);
+
+    auto ts = xaccSplitRetDateReconciledTS (spl);
+    if (ts.tv_sec != 0 || ts.tv_nsec != 0)
+        timespec_to_xml_text (out, level, "split:reconcile-date", NULL, &ts);
+
+    auto value = xaccSplitGetValue (spl);
+    gnc_numeric_to_xml_text (out, level, "split:value", &value);
+    auto amount = xaccSplitGetAmount (spl);
+    gnc_numeric_to_xml_text (out, level, "split:quantity", &amount);
+
+    guid_to_xml_text (out, level, "split:account",
+                      xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+    auto lot = xaccSplitGetLot (spl);
+    if (lot)
+        guid_to_xml_text (out, level, "split:lot", gnc_lot_get_guid (lot));
+
+    qof_instance_slots_to_xml_text (out, level, "split:slots",
+                                    QOF_INSTANCE (spl));
+    xml_text_close (out, level - 1, tag, children);
+}
+
+/* Kept in step with gnc_transaction_dom_tree_create, for the writer. */
+void
+gnc_transaction_to_xml_text (Transaction* trn, GString* out)
+{
+    g_string_append_printf (out, "<gnc:transaction version=\"%s\">\n",
+                            transaction_version_string);
+
+    guid_to_xml_text (out, 1, "trn:id", xaccTransGetGUID (trn));
+    commodity_ref_to_xml_text (out, 1, "trn:currency",
+                               xaccTransGetCurrency (trn));
+
+    auto num = xaccTransGetNum (trn);
+    if (num && g_strcmp0 (num, "") != 0)
+        xml_text_leaf (out, 1, "trn:num", NULL, num, TRUE);
+
+    auto posted = xaccTransRetDatePostedTS (trn);
+    timespec_to_xml_text (out, 1, "trn:date-posted", NULL, &posted);
+    auto entered = xaccTransRetDateEnteredTS (trn);
+    timespec_to_xml_text (out, 1, "trn:date-entered", NULL, &entered);
+
+    auto description = xaccTransGetDescription (trn);
+    if (description)
+        xml_text_leaf (out, 1, "trn:description", NULL, description, TRUE);
+
+    qof_instance_slots_to_xml_text (out, 1, "trn:slots", QOF_INSTANCE (trn));
+
+    auto children = xml_text_open (out, 1, "trn:splits", NULL);
+    for (auto n = xaccTransGetSplitList (trn); n; n = n->next)
+        split_to_xml_text (out, 2, "trn:split", static_cast<Split*> (n->data));
+    xml_text_close (out, 1, "trn:splits", children);
+
+    g_string_append (out, "</gnc:transaction>\n");
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -302,16 +381,10 @@ spl_quantity_handler (xmlNodePtr node, gpointer data)
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
 
-static gboolean
-spl_account_handler (xmlNodePtr node, gpointer data)
+static void
+set_spl_account (struct split_pdata* pdata, const GncGUID* id)
 {
-    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* id = dom_tree_to_guid (node);
-    Account* account;
-
-    g_return_val_if_fail (id, FALSE);
-
-    account = xaccAccountLookup (id, pdata->book);
+    Account* account = xaccAccountLookup (id, pdata->book);
     if (!account && gnc_transaction_xml_v2_testing &&
         !guid_equal (id, guid_null ()))
     {
@@ -322,22 +395,27 @@ spl_account_handler (xmlNodePtr node, gpointer data)
     }
 
     xaccAccountInsertSplit (account, pdata->split);
-
-    g_free (id);
-
-    return TRUE;
 }
 
 static gboolean
-spl_lot_handler (xmlNodePtr node, gpointer data)
+spl_account_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     GncGUID* id = dom_tree_to_guid (node);
-    GNCLot* lot;
 
     g_return_val_if_fail (id, FALSE);
 
-    lot = gnc_lot_lookup (id, pdata->book);
+    set_spl_account (pdata, id);
+
+    g_free (id);
+
+    return TRUE;
+}
+
+static void
+set_spl_lot (struct split_pdata* pdata, const GncGUID* id)
+{
+    GNCLot* lot = gnc_lot_lookup (id, pdata->book);
     if (!lot && gnc_transaction_xml_v2_testing &&
         !guid_equal (id, guid_null ()))
     {
@@ -346,6 +424,17 @@ spl_lot_handler (xmlNodePtr node, gpointer data)
     }
 
     gnc_lot_add_split (lot, pdata->split);
+}
+
+static gboolean
+spl_lot_handler (xmlNodePtr node, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID* id = dom_tree_to_guid (node);
+
+    g_return_val_if_fail (id, FALSE);
+
+    set_spl_lot (pdata, id);
 
     g_free (id);
 
@@ -643,8 +732,472 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     return trn;
 }
 
+/***********************************************************************/
+/* The streaming parser: the same fields and checks as the DOM handlers
+   above, read straight from the SAX events. */
+
+static gboolean
+spl_id_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID id;
+
+    if (!sixtp_stream_to_guid (reader, &id)) return FALSE;
+
+    xaccSplitSetGUID (pdata->split, &id);
+    return TRUE;
+}
+
+static gboolean
+spl_memo_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    xaccSplitSetMemo (pdata->split, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+static gboolean
+spl_action_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    xaccSplitSetAction (pdata->split, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+static gboolean
+spl_reconciled_state_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    xaccSplitSetReconcile (pdata->split, sixtp_stream_to_text (reader)[0]);
+    return TRUE;
+}
+
+static gboolean
+spl_reconcile_date_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    Timespec ts = sixtp_stream_to_timespec (reader);
+
+    if (!dom_tree_valid_timespec (&ts, BAD_CAST sixtp_stream_field_tag (reader)))
+        return FALSE;
+
+    xaccSplitSetDateReconciledTS (pdata->split, &ts);
+    return TRUE;
+}
+
+static gboolean
+spl_value_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    gnc_numeric num;
+
+    if (!sixtp_stream_to_gnc_numeric (reader, &num)) return FALSE;
+
+    xaccSplitSetValue (pdata->split, num);
+    return TRUE;
+}
+
+static gboolean
+spl_quantity_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    gnc_numeric num;
+
+    if (!sixtp_stream_to_gnc_numeric (reader, &num)) return FALSE;
+
+    xaccSplitSetAmount (pdata->split, num);
+    return TRUE;
+}
+
+static gboolean
+spl_account_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID id;
+
+    if (!sixtp_stream_to_guid (reader, &id)) return FALSE;
+
+    set_spl_account (pdata, &id);
+    return TRUE;
+}
+
+static gboolean
+spl_lot_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID id;
+
+    if (!sixtp_stream_to_guid (reader, &id)) return FALSE;
+
+    set_spl_lot (pdata, &id);
+    return TRUE;
+}
+
+static const struct sixtp_stream_field spl_stream_fields[] =
+{
+    { "split:id", SIXTP_STREAM_GUID, spl_id_stream_handler, TRUE },
+    { "split:memo", SIXTP_STREAM_TEXT, spl_memo_stream_handler, FALSE },
+    { "split:action", SIXTP_STREAM_TEXT, spl_action_stream_handler, FALSE },
+    {
+        "split:reconciled-state", SIXTP_STREAM_TEXT,
+        spl_reconciled_state_stream_handler, TRUE
+    },
+    {
+        "split:reconcile-date", SIXTP_STREAM_TIMESPEC,
+        spl_reconcile_date_stream_handler, FALSE
+    },
+    { "split:value", SIXTP_STREAM_TEXT, spl_value_stream_handler, TRUE },
+    { "split:quantity", SIXTP_STREAM_TEXT, spl_quantity_stream_handler, TRUE },
+    { "split:account", SIXTP_STREAM_GUID, spl_account_stream_handler, TRUE },
+    { "split:lot", SIXTP_STREAM_GUID, spl_lot_stream_handler, FALSE },
+    { "split:slots", SIXTP_STREAM_SLOTS, NULL, FALSE },
+    { NULL, SIXTP_STREAM_TEXT, NULL, FALSE },
+};
+
+static gboolean
+trn_id_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID id;
+
+    if (!sixtp_stream_to_guid (reader, &id)) return FALSE;
+
+    xaccTransSetGUID (pdata->trans, &id);
+    return TRUE;
+}
+
+static gboolean
+trn_currency_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+
+    xaccTransSetCurrency (pdata->trans,
+                          sixtp_stream_to_commodity_ref (reader, pdata->book));
+    return TRUE;
+}
+
+static gboolean
+trn_num_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+    xaccTransSetNum (pdata->trans, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+static inline gboolean
+set_tran_stream_date (sixtp_stream_reader* reader, Transaction* trn,
+                      void (*func) (Transaction* trn, const Timespec* tm))
+{
+    Timespec tm = sixtp_stream_to_timespec (reader);
+
+    if (!dom_tree_valid_timespec (&tm, BAD_CAST sixtp_stream_field_tag (reader)))
+        return FALSE;
+
+    func (trn, &tm);
+    return TRUE;
+}
+
+static gboolean
+trn_date_posted_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+    return set_tran_stream_date (reader, pdata->trans, xaccTransSetDatePostedTS);
+}
+
+static gboolean
+trn_date_entered_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+    return set_tran_stream_date (reader, pdata->trans, xaccTransSetDateEnteredTS);
+}
+
+static gboolean
+trn_description_stream_handler (sixtp_stream_reader* reader, gpointer data)
+{
+    struct trans_pdata* pdata = static_cast<decltype (pdata)> (data);
+    xaccTransSetDescription (pdata->trans, sixtp_stream_to_text (reader));
+    return TRUE;
+}
+
+/* trn:splits is handled by the parser itself */
+static const struct sixtp_stream_field trn_stream_fields[] =
+{
+    { "trn:id", SIXTP_STREAM_GUID, trn_id_stream_handler, TRUE },
+    { "trn:currency", SIXTP_STREAM_COMMODITY, trn_currency_stream_handler, FALSE },
+    { "trn:num", SIXTP_STREAM_TEXT, trn_num_stream_handler, FALSE },
+    {
+        "trn:date-posted", SIXTP_STREAM_TIMESPEC,
+        trn_date_posted_stream_handler, TRUE
+    },
+    {
+        "trn:date-entered", SIXTP_STREAM_TIMESPEC,
+        trn_date_entered_stream_handler, TRUE
+    },
+    {
+        "trn:description", SIXTP_STREAM_TEXT,
+        trn_description_stream_handler, FALSE
+    },
+    { "trn:slots", SIXTP_STREAM_SLOTS, NULL, FALSE },
+    { NULL, SIXTP_STREAM_TEXT, NULL, FALSE },
+};
+
+struct trans_stream_data
+{
+    struct trans_pdata trans;
+    struct split_pdata split; /* split is set inside <trn:split> */
+    sixtp_stream_reader* trn_reader;
+    sixtp_stream_reader* spl_reader;
+    gboolean successful;
+
+    gboolean in_splits;
+    gboolean seen_splits;
+    /* Like trn_splits_handler, stop at the first bad split, dropping
+       the rest */
+    gboolean splits_failed;
+    gboolean split_successful;
+    int skip_depth;
+};
+
+static void
+trans_stream_data_free (struct trans_stream_data* sdata)
+{
+    sixtp_stream_reader_free (sdata->trn_reader);
+    sixtp_stream_reader_free (sdata->spl_reader);
+    g_free (sdata);
+}
+
+static void
+destroy_parsed_transaction (Transaction* trn)
+{
+    xaccTransBeginEdit (trn);
+    xaccTransDestroy (trn);
+    xaccTransCommitEdit (trn);
+}
+
+static gboolean
+trn_stream_start (gpointer data_for_children, const gchar* tag, gchar** attrs)
+{
+    struct trans_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    if (!sdata->in_splits)
+    {
+        if (!sixtp_stream_reader_busy (sdata->trn_reader) &&
+            g_strcmp0 (tag, "trn:splits") == 0)
+        {
+            sdata->in_splits = TRUE;
+            sdata->seen_splits = TRUE;
+        }
+        else if (!sixtp_stream_reader_start (sdata->trn_reader, tag, attrs))
+        {
+            PERR ("Unhandled tag: %s", tag ? tag : "(null)");
+            sdata->successful = FALSE;
+        }
+        return TRUE;
+    }
+
+    if (sdata->split.split)
+    {
+        if (!sixtp_stream_reader_start (sdata->spl_reader, tag, attrs))
+        {
+            PERR ("Unhandled tag: %s", tag ? tag : "(null)");
+            sdata->split_successful = FALSE;
+        }
+    }
+    else if (sdata->skip_depth > 0 || sdata->splits_failed ||
+             g_strcmp0 (tag, "trn:split") != 0)
+    {
+        sdata->splits_failed = TRUE;
+        sdata->skip_depth++;
+    }
+    else
+    {
+        sdata->split.split = xaccMallocSplit (sdata->split.book);
+        sdata->split_successful = TRUE;
+        sixtp_stream_reader_reset (sdata->spl_reader, &sdata->split,
+                                   QOF_INSTANCE (sdata->split.split));
+    }
+    return TRUE;
+}
+
+static gboolean
+trn_stream_characters (gpointer data_for_children, const char* text,
+                       int length)
+{
+    struct trans_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    if (sdata->split.split)
+        sixtp_stream_reader_characters (sdata->spl_reader, text, length);
+    else if (!sdata->in_splits)
+        sixtp_stream_reader_characters (sdata->trn_reader, text, length);
+    return TRUE;
+}
+
+static gboolean
+trn_stream_end (gpointer data_for_children, const gchar* tag)
+{
+    struct trans_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+    Split* spl = sdata->split.split;
+
+    if (!sdata->in_splits)
+    {
+        /* field handler failures are ignored, as by dom_tree_generic_parse */
+        sixtp_stream_reader_end (sdata->trn_reader, tag);
+        return TRUE;
+    }
+
+    if (spl && sixtp_stream_reader_busy (sdata->spl_reader))
+    {
+        sixtp_stream_reader_end (sdata->spl_reader, tag);
+    }
+    else if (spl)
+    {
+        /* </trn:split> */
+        if (sdata->split_successful &&
+            sixtp_stream_reader_all_gotten (sdata->spl_reader))
+        {
+            xaccTransAppendSplit (sdata->trans.trans, spl);
+        }
+        else
+        {
+            PERR ("didn't find all of the expected tags in the input");
+            xaccSplitDestroy (spl);
+            sdata->splits_failed = TRUE;
+        }
+        sdata->split.split = NULL;
+    }
+    else if (sdata->skip_depth > 0)
+    {
+        sdata->skip_depth--;
+    }
+    else
+    {
+        /* </trn:splits> */
+        sdata->in_splits = FALSE;
+    }
+    return TRUE;
+}
+
+static const sixtp_stream_handlers trn_stream_handlers =
+{
+    trn_stream_start,
+    trn_stream_characters,
+    trn_stream_end,
+};
+
+static gboolean
+gnc_transaction_stream_start_handler (GSList* sibling_data,
+                                      gpointer parent_data,
+                                      gpointer global_data,
+                                      gpointer* data_for_children,
+                                      gpointer* result,
+                                      const gchar* tag,
+                                      gchar** attrs)
+{
+    gxpf_data* gdata = (gxpf_data*)global_data;
+    QofBook* book = static_cast<QofBook*> (gdata->bookdata);
+    struct trans_stream_data* sdata;
+
+    /* the document, when we're the top level parser */
+    if (!tag)
+        return TRUE;
+
+    g_return_val_if_fail (book, FALSE);
+
+    sdata = g_new0 (struct trans_stream_data, 1);
+    sdata->trans.trans = xaccMallocTransaction (book);
+    sdata->trans.book = book;
+    sdata->split.book = book;
+    sdata->successful = TRUE;
+    sdata->trn_reader = sixtp_stream_reader_new (trn_stream_fields);
+    sdata->spl_reader = sixtp_stream_reader_new (spl_stream_fields);
+    sixtp_stream_reader_reset (sdata->trn_reader, &sdata->trans,
+                               QOF_INSTANCE (sdata->trans.trans));
+    xaccTransBeginEdit (sdata->trans.trans);
+
+    *data_for_children = sdata;
+    *result = NULL;
+    return TRUE;
+}
+
+static gboolean
+gnc_transaction_stream_end_handler (gpointer data_for_children,
+                                    GSList* data_from_children,
+                                    GSList* sibling_data,
+                                    gpointer parent_data,
+                                    gpointer global_data,
+                                    gpointer* result,
+                                    const gchar* tag)
+{
+    struct trans_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+    gxpf_data* gdata = (gxpf_data*)global_data;
+    Transaction* trn;
+    gboolean successful;
+
+    if (!tag)
+        return TRUE;
+
+    g_return_val_if_fail (sdata, FALSE);
+
+    trn = sdata->trans.trans;
+    successful = sdata->successful;
+    if (!sixtp_stream_reader_all_gotten (sdata->trn_reader))
+        successful = FALSE;
+    if (!sdata->seen_splits)
+    {
+        PERR ("Not defined and it should be: trn:splits");
+        successful = FALSE;
+    }
+
+    xaccTransCommitEdit (trn);
+
+    if (successful)
+    {
+        gdata->cb (tag, gdata->parsedata, trn);
+    }
+    else
+    {
+        PERR ("didn't find all of the expected tags in the input");
+        destroy_parsed_transaction (trn);
+    }
+
+    trans_stream_data_free (sdata);
+    return successful;
+}
+
+static void
+gnc_transaction_stream_fail_handler (gpointer data_for_children,
+                                     GSList* data_from_children,
+                                     GSList* sibling_data,
+                                     gpointer parent_data,
+                                     gpointer global_data,
+                                     gpointer* result,
+                                     const gchar* tag)
+{
+    struct trans_stream_data* sdata =
+        static_cast<decltype (sdata)> (data_for_children);
+
+    if (!sdata) return;
+
+    if (sdata->split.split)
+        xaccSplitDestroy (sdata->split.split);
+    xaccTransCommitEdit (sdata->trans.trans);
+    destroy_parsed_transaction (sdata->trans.trans);
+    trans_stream_data_free (sdata);
+}
+
 sixtp*
 gnc_transaction_sixtp_parser_create (void)
 {
-    return sixtp_dom_parser_new (gnc_transaction_end_handler, NULL, NULL);
+    if (!sixtp_use_stream_parsers ())
+        return sixtp_dom_parser_new (gnc_transaction_end_handler, NULL, NULL);
+
+    return sixtp_stream_parser_new (gnc_transaction_stream_start_handler,
+                                    &trn_stream_handlers,
+                                    gnc_transaction_stream_end_handler,
+                                    gnc_transaction_stream_fail_handler,
+                                    NULL);
 }
@@ -63,6 +63,8 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/* Append what xmlElemDump writes for the tree above, and a newline */
+void gnc_transaction_to_xml_text (Transaction* txn, GString* out);
 sixtp* gnc_transaction_sixtp_parser_create (void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
@@ -0,0 +1,1411 @@
+/********************************************************************
+ * io-gncsnapshot.cpp -- binary snapshots of XML books              *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "gnc-engine.h"
+#include "gnc-prefs.h"
+#include "gnc-commodity.h"
+#include "gnc-lot.h"
+#include "gnc-pricedb.h"
+#include "gnc-pricedb-p.h"
+#include "Account.h"
+#include "Split.h"
+#include "SplitP.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+}
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <kvp_frame.hpp>
+
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-generators.h"
+#include "sixtp-utils.h"
+#include "io-gncxml-v2.h"
+#include "io-gncsnapshot.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* The file starts with a header locating its sections, each a column
+   of fixed size values (or, for the strings, slots and XML, of bytes)
+   aligned on 8 bytes.  Values are in the byte order of the machine that
+   wrote the file, which is checked through byte_order.
+
+   Strings, commodities, accounts and lots are referred to by their
+   index in their table, or by SNAPSHOT_NONE.  Commodities are pairs of
+   strings, accounts and lots GUIDs.  The transactions' splits are the
+   range of the split columns given by TRN_SPLITS, which has one more
+   value than there are transactions.
+
+   Slots are frames in SLOTS, referred to by their offset: a guint32
+   count of slots, then for each the string index of its key and its
+   value, a guint8 KvpValue::Type followed by the value's data.  The
+   empty frame is at offset 0. */
+
+#define SNAPSHOT_MAGIC "GNCSNAP\n"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_NONE G_MAXUINT32
+#define SNAPSHOT_ALIGN 8
+
+typedef enum
+{
+    SECTION_XML_HEAD,
+    SECTION_XML_TAIL,
+    SECTION_STRING_OFFSETS,
+    SECTION_STRING_DATA,
+    SECTION_SLOTS,
+    SECTION_COMMODITY_SPACE,
+    SECTION_COMMODITY_ID,
+    SECTION_ACCOUNT_GUID,
+    SECTION_LOT_GUID,
+    SECTION_TRN_GUID,
+    SECTION_TRN_CURRENCY,
+    SECTION_TRN_NUM,
+    SECTION_TRN_DESCRIPTION,
+    SECTION_TRN_POSTED,
+    SECTION_TRN_ENTERED,
+    SECTION_TRN_SLOTS,
+    SECTION_TRN_SPLITS,
+    SECTION_SPLIT_GUID,
+    SECTION_SPLIT_MEMO,
+    SECTION_SPLIT_ACTION,
+    SECTION_SPLIT_RECONCILE,
+    SECTION_SPLIT_RECONCILE_DATE,
+    SECTION_SPLIT_VALUE,
+    SECTION_SPLIT_AMOUNT,
+    SECTION_SPLIT_ACCOUNT,
+    SECTION_SPLIT_LOT,
+    SECTION_SPLIT_SLOTS,
+    SECTION_PRICE_GUID,
+    SECTION_PRICE_COMMODITY,
+    SECTION_PRICE_CURRENCY,
+    SECTION_PRICE_TIME,
+    SECTION_PRICE_SOURCE,
+    SECTION_PRICE_TYPE,
+    SECTION_PRICE_VALUE,
+    N_SECTIONS
+} snapshot_section_id;
+
+typedef struct
+{
+    guint64 offset;
+    guint64 size;
+} snapshot_section;
+
+typedef struct
+{
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint64 xml_size;
+    guint32 xml_crc;
+    guint32 body_crc;
+    snapshot_section sections[N_SECTIONS];
+} snapshot_header;
+
+typedef struct
+{
+    gint64 sec;
+    gint64 nsec;
+} snapshot_timespec;
+
+typedef struct
+{
+    gint64 num;
+    gint64 denom;
+} snapshot_numeric;
+
+struct gnc_snapshot
+{
+    GMappedFile* file;
+    const char* data;
+    gsize length;
+    snapshot_header header;
+    guint32 n_strings;
+    guint32 n_commodities;
+    guint32 n_accounts;
+    guint32 n_lots;
+    guint32 n_trns;
+    guint32 n_splits;
+    guint32 n_prices;
+};
+
+gboolean
+gnc_snapshot_enabled (void)
+{
+    return gnc_prefs_get_file_snapshot ();
+}
+
+gchar*
+gnc_snapshot_filename (const char* datafile)
+{
+    return g_strconcat (datafile, ".snapshot", NULL);
+}
+
+void
+gnc_snapshot_remove (const char* datafile)
+{
+    gchar* filename = gnc_snapshot_filename (datafile);
+    g_unlink (filename);
+    g_free (filename);
+}
+
+/* crc32 takes a uInt length */
+static guint32
+update_crc (guint32 crc, const char* data, gsize length)
+{
+    while (length > 0)
+    {
+        uInt chunk = length > (1 << 30) ? (1 << 30) : (uInt) length;
+        crc = crc32 (crc, reinterpret_cast<const Bytef*> (data), chunk);
+        data += chunk;
+        length -= chunk;
+    }
+    return crc;
+}
+
+/* The size and checksum of the rest of the file from the current
+   position */
+static gboolean
+stream_checksum (FILE* file, guint64* size, guint32* crc)
+{
+    char buffer[65536];
+    size_t n;
+
+    *size = 0;
+    *crc = crc32 (0, Z_NULL, 0);
+    while ((n = fread (buffer, 1, sizeof (buffer), file)) > 0)
+    {
+        *crc = update_crc (*crc, buffer, n);
+        *size += n;
+    }
+    return !ferror (file);
+}
+
+static gboolean
+file_checksum (const char* filename, guint64* size, guint32* crc)
+{
+    FILE* file = g_fopen (filename, "rb");
+    gboolean ok;
+
+    if (!file)
+        return FALSE;
+    ok = stream_checksum (file, size, crc);
+    fclose (file);
+    return ok;
+}
+
+/***********************************************************************/
+/* Writing */
+
+struct snapshot_builder
+{
+    std::vector<guint64> string_offsets;
+    std::string string_data;
+    std::unordered_map<std::string, guint32> string_ids;
+    std::string slots;
+
+    std::vector<guint32> commodity_space;
+    std::vector<guint32> commodity_id;
+    std::unordered_map<const gnc_commodity*, guint32> commodity_ids;
+    std::vector<GncGUID> account_guid;
+    std::unordered_map<const Account*, guint32> account_ids;
+    std::vector<GncGUID> lot_guid;
+    std::unordered_map<const GNCLot*, guint32> lot_ids;
+
+    std::vector<GncGUID> trn_guid;
+    std::vector<guint32> trn_currency;
+    std::vector<guint32> trn_num;
+    std::vector<guint32> trn_description;
+    std::vector<snapshot_timespec> trn_posted;
+    std::vector<snapshot_timespec> trn_entered;
+    std::vector<guint64> trn_slots;
+    std::vector<guint32> trn_splits;
+
+    std::vector<GncGUID> split_guid;
+    std::vector<guint32> split_memo;
+    std::vector<guint32> split_action;
+    std::vector<char> split_reconcile;
+    std::vector<snapshot_timespec> split_reconcile_date;
+    std::vector<snapshot_numeric> split_value;
+    std::vector<snapshot_numeric> split_amount;
+    std::vector<guint32> split_account;
+    std::vector<guint32> split_lot;
+    std::vector<guint64> split_slots;
+
+    std::vector<GncGUID> price_guid;
+    std::vector<guint32> price_commodity;
+    std::vector<guint32> price_currency;
+    std::vector<snapshot_timespec> price_time;
+    std::vector<guint32> price_source;
+    std::vector<guint32> price_type;
+    std::vector<snapshot_numeric> price_value;
+};
+
+static guint32
+add_string (snapshot_builder* b, const char* str)
+{
+    auto found = b->string_ids.find (str);
+    if (found != b->string_ids.end ())
+        return found->second;
+
+    guint32 id = b->string_offsets.size ();
+    b->string_offsets.push_back (b->string_data.size ());
+    b->string_data.append (str);
+    b->string_data.push_back ('\0');
+    b->string_ids.emplace (str, id);
+    return id;
+}
+
+/* Text as the XML file holds it, see checked_char_cast */
+static guint32
+add_text (snapshot_builder* b, const char* text)
+{
+    for (auto p = reinterpret_cast<const guchar*> (text); *p; ++p)
+    {
+        if (*p >= 0x80 || (*p < 0x20 && *p != '\t' && *p != '\n' && *p != '\r'))
+        {
+            gchar* copy = g_strdup (text);
+            guint32 id = add_string (b, (const char*) checked_char_cast (copy));
+            g_free (copy);
+            return id;
+        }
+    }
+    return add_string (b, text);
+}
+
+/* Text written by xml_text_leaf only when it isn't empty */
+static guint32
+add_optional_text (snapshot_builder* b, const char* text)
+{
+    return text && *text ? add_text (b, text) : SNAPSHOT_NONE;
+}
+
+/* A commodity reference, written only with both of its names */
+static guint32
+add_commodity (snapshot_builder* b, const gnc_commodity* c)
+{
+    if (!c || !gnc_commodity_get_namespace (c) || !gnc_commodity_get_mnemonic (c))
+        return SNAPSHOT_NONE;
+
+    auto found = b->commodity_ids.find (c);
+    if (found != b->commodity_ids.end ())
+        return found->second;
+
+    guint32 id = b->commodity_space.size ();
+    b->commodity_space.push_back (add_text (b, gnc_commodity_get_namespace_compat (c)));
+    b->commodity_id.push_back (add_text (b, gnc_commodity_get_mnemonic (c)));
+    b->commodity_ids.emplace (c, id);
+    return id;
+}
+
+static guint32
+add_account (snapshot_builder* b, const Account* acc)
+{
+    auto found = b->account_ids.find (acc);
+    if (found != b->account_ids.end ())
+        return found->second;
+
+    guint32 id = b->account_guid.size ();
+    b->account_guid.push_back (acc ? *xaccAccountGetGUID (acc) : *guid_null ());
+    b->account_ids.emplace (acc, id);
+    return id;
+}
+
+static guint32
+add_lot (snapshot_builder* b, GNCLot* lot)
+{
+    if (!lot)
+        return SNAPSHOT_NONE;
+
+    auto found = b->lot_ids.find (lot);
+    if (found != b->lot_ids.end ())
+        return found->second;
+
+    guint32 id = b->lot_guid.size ();
+    b->lot_guid.push_back (*gnc_lot_get_guid (lot));
+    b->lot_ids.emplace (lot, id);
+    return id;
+}
+
+/* The seconds and the nanoseconds timespec_to_xml_text writes */
+static snapshot_timespec
+make_timespec (Timespec ts)
+{
+    snapshot_timespec sts = { ts.tv_sec, ts.tv_nsec > 0 ? ts.tv_nsec : 0 };
+    return sts;
+}
+
+static snapshot_numeric
+make_numeric (gnc_numeric n)
+{
+    snapshot_numeric sn = { n.num, n.denom };
+    return sn;
+}
+
+template <typename T> static void
+append_slot_data (snapshot_builder* b, T value)
+{
+    b->slots.append (reinterpret_cast<const char*> (&value), sizeof (T));
+}
+
+struct slot_frame_data
+{
+    snapshot_builder* builder;
+    guint32 count;
+};
+
+static void add_slot_frame (snapshot_builder* b, KvpFrame* frame);
+
+/* The value as read back from the XML file, or FALSE if it would be
+   dropped there */
+static gboolean
+add_slot_value (snapshot_builder* b, KvpValue* val)
+{
+    auto type = val->get_type ();
+
+    switch (type)
+    {
+    case KvpValue::Type::INT64:
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, (gint64) val->get<int64_t> ());
+        return TRUE;
+    case KvpValue::Type::DOUBLE:
+    {
+        gchar* str = double_to_string (val->get<double> ());
+        double d;
+        gboolean ok = str && string_to_double (str, &d);
+
+        g_free (str);
+        if (!ok)
+            return FALSE;
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, d);
+        return TRUE;
+    }
+    case KvpValue::Type::NUMERIC:
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, make_numeric (val->get<gnc_numeric> ()));
+        return TRUE;
+    case KvpValue::Type::STRING:
+    {
+        auto str = val->get<const char*> ();
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, add_text (b, str ? str : ""));
+        return TRUE;
+    }
+    case KvpValue::Type::GUID:
+    {
+        auto guid = val->get<GncGUID*> ();
+        if (!guid)
+            return FALSE;
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, *guid);
+        return TRUE;
+    }
+    case KvpValue::Type::TIMESPEC:
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, make_timespec (val->get<Timespec> ()));
+        return TRUE;
+    case KvpValue::Type::GDATE:
+    {
+        auto date = val->get<GDate> ();
+        if (!g_date_valid (&date))
+            return FALSE;
+        append_slot_data (b, (guint8) type);
+        append_slot_data (b, (guint32) g_date_get_julian (&date));
+        return TRUE;
+    }
+    case KvpValue::Type::GLIST:
+    {
+        guint32 count = 0;
+        gsize count_at;
+
+        append_slot_data (b, (guint8) type);
+        count_at = b->slots.size ();
+        append_slot_data (b, count);
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+        {
+            auto mark = b->slots.size ();
+            if (add_slot_value (b, static_cast<KvpValue*> (cursor->data)))
+                count++;
+            else
+                b->slots.resize (mark);
+        }
+        memcpy (&b->slots[count_at], &count, sizeof (count));
+        return TRUE;
+    }
+    case KvpValue::Type::FRAME:
+        append_slot_data (b, (guint8) type);
+        add_slot_frame (b, val->get<KvpFrame*> ());
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static void
+add_slot (const char* key, KvpValue* value, void* data)
+{
+    auto fd = static_cast<slot_frame_data*> (data);
+    auto b = fd->builder;
+    auto mark = b->slots.size ();
+
+    append_slot_data (b, add_text (b, key));
+    if (value && add_slot_value (b, value))
+        fd->count++;
+    else
+        b->slots.resize (mark);
+}
+
+static void
+add_slot_frame (snapshot_builder* b, KvpFrame* frame)
+{
+    slot_frame_data fd = { b, 0 };
+    gsize count_at = b->slots.size ();
+
+    append_slot_data (b, fd.count);
+    if (frame)
+        frame->for_each_slot (add_slot, &fd);
+    memcpy (&b->slots[count_at], &fd.count, sizeof (fd.count));
+}
+
+static guint64
+add_instance_slots (snapshot_builder* b, QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    guint64 offset;
+
+    if (!frame || frame->empty ())
+        return 0;
+    offset = b->slots.size ();
+    add_slot_frame (b, frame);
+    return offset;
+}
+
+static void
+add_split_columns (snapshot_builder* b, Split* spl)
+{
+    b->split_guid.push_back (*xaccSplitGetGUID (spl));
+    b->split_memo.push_back (add_optional_text (b, xaccSplitGetMemo (spl)));
+    b->split_action.push_back (add_optional_text (b, xaccSplitGetAction (spl)));
+    b->split_reconcile.push_back (xaccSplitGetReconcile (spl));
+    b->split_reconcile_date.push_back (
+        make_timespec (xaccSplitRetDateReconciledTS (spl)));
+    b->split_value.push_back (make_numeric (xaccSplitGetValue (spl)));
+    b->split_amount.push_back (make_numeric (xaccSplitGetAmount (spl)));
+    b->split_account.push_back (add_account (b, xaccSplitGetAccount (spl)));
+    b->split_lot.push_back (add_lot (b, xaccSplitGetLot (spl)));
+    b->split_slots.push_back (add_instance_slots (b, QOF_INSTANCE (spl)));
+}
+
+/* In the order of write_transactions */
+static int
+add_transaction_columns (Transaction* trn, void* data)
+{
+    auto b = static_cast<snapshot_builder*> (data);
+    auto description = xaccTransGetDescription (trn);
+
+    b->trn_guid.push_back (*xaccTransGetGUID (trn));
+    b->trn_currency.push_back (add_commodity (b, xaccTransGetCurrency (trn)));
+    b->trn_num.push_back (add_optional_text (b, xaccTransGetNum (trn)));
+    b->trn_description.push_back (description ? add_text (b, description)
+                                  : SNAPSHOT_NONE);
+    b->trn_posted.push_back (make_timespec (xaccTransRetDatePostedTS (trn)));
+    b->trn_entered.push_back (make_timespec (xaccTransRetDateEnteredTS (trn)));
+    b->trn_slots.push_back (add_instance_slots (b, QOF_INSTANCE (trn)));
+    b->trn_splits.push_back (b->split_guid.size ());
+    for (auto n = xaccTransGetSplitList (trn); n; n = n->next)
+        add_split_columns (b, static_cast<Split*> (n->data));
+    return 0;
+}
+
+static gboolean
+add_price_columns (GNCPrice* p, gpointer data)
+{
+    auto b = static_cast<snapshot_builder*> (data);
+
+    b->price_guid.push_back (*gnc_price_get_guid (p));
+    b->price_commodity.push_back (add_commodity (b, gnc_price_get_commodity (p)));
+    b->price_currency.push_back (add_commodity (b, gnc_price_get_currency (p)));
+    b->price_time.push_back (make_timespec (gnc_price_get_time (p)));
+    b->price_source.push_back (add_optional_text (b,
+                                                  gnc_price_get_source_string (p)));
+    b->price_type.push_back (add_optional_text (b, gnc_price_get_typestr (p)));
+    b->price_value.push_back (make_numeric (gnc_price_get_value (p)));
+    return TRUE;
+}
+
+static gboolean
+build_snapshot (snapshot_builder* b, QofBook* book)
+{
+    guint32 empty_frame = 0;
+
+    b->slots.append (reinterpret_cast<const char*> (&empty_frame),
+                     sizeof (empty_frame));
+    if (!gnc_pricedb_foreach_price (gnc_pricedb_get_db (book), add_price_columns, b,
+                                    TRUE))
+        return FALSE;
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       add_transaction_columns, b);
+    b->trn_splits.push_back (b->split_guid.size ());
+    b->string_offsets.push_back (b->string_data.size ());
+
+    /* the indexes are guint32s */
+    return b->string_offsets.size () < SNAPSHOT_NONE &&
+           b->split_guid.size () < SNAPSHOT_NONE &&
+           b->trn_guid.size () < SNAPSHOT_NONE &&
+           b->price_guid.size () < SNAPSHOT_NONE;
+}
+
+static gboolean
+begin_section (FILE* out, snapshot_header* header, snapshot_section_id id)
+{
+    static const char padding[SNAPSHOT_ALIGN] = { 0 };
+    long pos = ftell (out);
+
+    if (pos < 0)
+        return FALSE;
+    if (pos % SNAPSHOT_ALIGN)
+    {
+        if (fwrite (padding, SNAPSHOT_ALIGN - pos % SNAPSHOT_ALIGN, 1, out) != 1)
+            return FALSE;
+        pos += SNAPSHOT_ALIGN - pos % SNAPSHOT_ALIGN;
+    }
+    header->sections[id].offset = pos;
+    return TRUE;
+}
+
+static gboolean
+end_section (FILE* out, snapshot_header* header, snapshot_section_id id)
+{
+    long pos = ftell (out);
+
+    if (pos < 0)
+        return FALSE;
+    header->sections[id].size = pos - header->sections[id].offset;
+    return TRUE;
+}
+
+static gboolean
+write_section (FILE* out, snapshot_header* header, snapshot_section_id id,
+               const void* data, gsize size)
+{
+    return begin_section (out, header, id) &&
+           (size == 0 || fwrite (data, size, 1, out) == 1) &&
+           end_section (out, header, id);
+}
+
+template <typename T> static gboolean
+write_column (FILE* out, snapshot_header* header, snapshot_section_id id,
+              const std::vector<T>& column)
+{
+    return write_section (out, header, id, column.data (),
+                          column.size () * sizeof (T));
+}
+
+static gboolean
+write_snapshot (FILE* out, QofBook* book, snapshot_builder* b,
+                snapshot_header* header)
+{
+    guint64 body_size;
+
+    memcpy (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic));
+    header->version = SNAPSHOT_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+
+    /* a placeholder until the sections are written */
+    if (fwrite (header, sizeof (*header), 1, out) != 1)
+        return FALSE;
+
+    if (!begin_section (out, header, SECTION_XML_HEAD) ||
+        !gnc_book_write_xml_head_v2 (book, out) ||
+        !end_section (out, header, SECTION_XML_HEAD) ||
+        !begin_section (out, header, SECTION_XML_TAIL) ||
+        !gnc_book_write_xml_tail_v2 (book, out) ||
+        !end_section (out, header, SECTION_XML_TAIL))
+        return FALSE;
+
+    if (!write_column (out, header, SECTION_STRING_OFFSETS, b->string_offsets) ||
+        !write_section (out, header, SECTION_STRING_DATA, b->string_data.data (),
+                        b->string_data.size ()) ||
+        !write_section (out, header, SECTION_SLOTS, b->slots.data (),
+                        b->slots.size ()) ||
+        !write_column (out, header, SECTION_COMMODITY_SPACE, b->commodity_space) ||
+        !write_column (out, header, SECTION_COMMODITY_ID, b->commodity_id) ||
+        !write_column (out, header, SECTION_ACCOUNT_GUID, b->account_guid) ||
+        !write_column (out, header, SECTION_LOT_GUID, b->lot_guid) ||
+        !write_column (out, header, SECTION_TRN_GUID, b->trn_guid) ||
+        !write_column (out, header, SECTION_TRN_CURRENCY, b->trn_currency) ||
+        !write_column (out, header, SECTION_TRN_NUM, b->trn_num) ||
+        !write_column (out, header, SECTION_TRN_DESCRIPTION, b->trn_description) ||
+        !write_column (out, header, SECTION_TRN_POSTED, b->trn_posted) ||
+        !write_column (out, header, SECTION_TRN_ENTERED, b->trn_entered) ||
+        !write_column (out, header, SECTION_TRN_SLOTS, b->trn_slots) ||
+        !write_column (out, header, SECTION_TRN_SPLITS, b->trn_splits) ||
+        !write_column (out, header, SECTION_SPLIT_GUID, b->split_guid) ||
+        !write_column (out, header, SECTION_SPLIT_MEMO, b->split_memo) ||
+        !write_column (out, header, SECTION_SPLIT_ACTION, b->split_action) ||
+        !write_column (out, header, SECTION_SPLIT_RECONCILE, b->split_reconcile) ||
+        !write_column (out, header, SECTION_SPLIT_RECONCILE_DATE,
+                       b->split_reconcile_date) ||
+        !write_column (out, header, SECTION_SPLIT_VALUE, b->split_value) ||
+        !write_column (out, header, SECTION_SPLIT_AMOUNT, b->split_amount) ||
+        !write_column (out, header, SECTION_SPLIT_ACCOUNT, b->split_account) ||
+        !write_column (out, header, SECTION_SPLIT_LOT, b->split_lot) ||
+        !write_column (out, header, SECTION_SPLIT_SLOTS, b->split_slots) ||
+        !write_column (out, header, SECTION_PRICE_GUID, b->price_guid) ||
+        !write_column (out, header, SECTION_PRICE_COMMODITY, b->price_commodity) ||
+        !write_column (out, header, SECTION_PRICE_CURRENCY, b->price_currency) ||
+        !write_column (out, header, SECTION_PRICE_TIME, b->price_time) ||
+        !write_column (out, header, SECTION_PRICE_SOURCE, b->price_source) ||
+        !write_column (out, header, SECTION_PRICE_TYPE, b->price_type) ||
+        !write_column (out, header, SECTION_PRICE_VALUE, b->price_value))
+        return FALSE;
+
+    /* checksum what was written, then fill in the header */
+    if (fflush (out) != 0 ||
+        fseek (out, sizeof (*header), SEEK_SET) != 0 ||
+        !stream_checksum (out, &body_size, &header->body_crc) ||
+        fseek (out, 0, SEEK_SET) != 0 ||
+        fwrite (header, sizeof (*header), 1, out) != 1)
+        return FALSE;
+    return fflush (out) == 0;
+}
+
+gboolean
+gnc_snapshot_write (QofBook* book, const char* datafile)
+{
+    snapshot_header header;
+    snapshot_builder builder;
+    gchar* filename, *tmp_name;
+    gboolean success;
+    FILE* out;
+
+    g_return_val_if_fail (book && datafile, FALSE);
+    ENTER ("book=%p, datafile=%s", book, datafile);
+
+    memset (&header, 0, sizeof (header));
+    filename = gnc_snapshot_filename (datafile);
+    tmp_name = g_strconcat (filename, ".tmp", NULL);
+
+    success = file_checksum (datafile, &header.xml_size, &header.xml_crc) &&
+              build_snapshot (&builder, book);
+    out = success ? g_fopen (tmp_name, "w+b") : NULL;
+    success = out && write_snapshot (out, book, &builder, &header);
+    if (out && fclose (out) != 0)
+        success = FALSE;
+
+    /* an older snapshot doesn't match the file any more */
+    g_unlink (filename);
+    if (success && g_rename (tmp_name, filename) != 0)
+        success = FALSE;
+    if (!success)
+    {
+        PWARN ("unable to write the snapshot %s", filename);
+        g_unlink (tmp_name);
+    }
+
+    g_free (tmp_name);
+    g_free (filename);
+    LEAVE ("%s", success ? "written" : "failed");
+    return success;
+}
+
+/***********************************************************************/
+/* Reading */
+
+template <typename T> static const T*
+column (const gnc_snapshot* snap, snapshot_section_id id)
+{
+    return reinterpret_cast<const T*> (snap->data +
+                                       snap->header.sections[id].offset);
+}
+
+static const char*
+snapshot_string (const gnc_snapshot* snap, guint32 id)
+{
+    if (id == SNAPSHOT_NONE)
+        return NULL;
+    return column<char> (snap, SECTION_STRING_DATA) +
+           column<guint64> (snap, SECTION_STRING_OFFSETS)[id];
+}
+
+static Timespec
+snapshot_ts (const snapshot_timespec& sts)
+{
+    Timespec ts = { sts.sec, (long) sts.nsec };
+    return ts;
+}
+
+static gnc_numeric
+snapshot_num (const snapshot_numeric& sn)
+{
+    return gnc_numeric_create (sn.num, sn.denom);
+}
+
+/* The number of elem_size values in the section, which must be count if
+   that isn't SNAPSHOT_NONE */
+static gboolean
+section_count (const gnc_snapshot* snap, snapshot_section_id id,
+               gsize elem_size, guint32* count)
+{
+    guint64 size = snap->header.sections[id].size;
+
+    if (size % elem_size || size / elem_size >= SNAPSHOT_NONE)
+        return FALSE;
+    if (*count != SNAPSHOT_NONE)
+        return size / elem_size == *count;
+    *count = size / elem_size;
+    return TRUE;
+}
+
+template <typename T> static gboolean
+check_column (const gnc_snapshot* snap, snapshot_section_id id, guint32 count)
+{
+    return section_count (snap, id, sizeof (T), &count);
+}
+
+static gboolean
+check_indexes (const gnc_snapshot* snap, snapshot_section_id id,
+               guint32 count, guint32 limit, gboolean none_ok)
+{
+    if (!check_column<guint32> (snap, id, count))
+        return FALSE;
+
+    auto indexes = column<guint32> (snap, id);
+    for (guint32 i = 0; i < count; ++i)
+        if (indexes[i] >= limit && !(none_ok && indexes[i] == SNAPSHOT_NONE))
+            return FALSE;
+    return TRUE;
+}
+
+static gboolean
+check_slot_offsets (const gnc_snapshot* snap, snapshot_section_id id,
+                    guint32 count)
+{
+    guint64 slots_size = snap->header.sections[SECTION_SLOTS].size;
+
+    if (!check_column<guint64> (snap, id, count))
+        return FALSE;
+
+    auto offsets = column<guint64> (snap, id);
+    for (guint32 i = 0; i < count; ++i)
+        if (offsets[i] + sizeof (guint32) > slots_size)
+            return FALSE;
+    return TRUE;
+}
+
+static gboolean
+check_strings (gnc_snapshot* snap)
+{
+    guint32 n_offsets = SNAPSHOT_NONE;
+    guint64 data_size = snap->header.sections[SECTION_STRING_DATA].size;
+
+    if (!section_count (snap, SECTION_STRING_OFFSETS, sizeof (guint64),
+                        &n_offsets) || n_offsets == 0)
+        return FALSE;
+    snap->n_strings = n_offsets - 1;
+
+    auto offsets = column<guint64> (snap, SECTION_STRING_OFFSETS);
+    auto data = column<char> (snap, SECTION_STRING_DATA);
+    if (offsets[0] != 0 || offsets[snap->n_strings] != data_size)
+        return FALSE;
+    for (guint32 i = 0; i < snap->n_strings; ++i)
+        if (offsets[i + 1] <= offsets[i] || data[offsets[i + 1] - 1] != '\0')
+            return FALSE;
+    return TRUE;
+}
+
+static gboolean
+check_sections (gnc_snapshot* snap)
+{
+    const snapshot_header* header = &snap->header;
+
+    for (int i = 0; i < N_SECTIONS; ++i)
+    {
+        const snapshot_section* s = &header->sections[i];
+        if (s->offset % SNAPSHOT_ALIGN || s->offset < sizeof (*header) ||
+            s->offset > snap->length || s->size > snap->length - s->offset)
+            return FALSE;
+    }
+
+    if (!check_strings (snap))
+        return FALSE;
+
+    snap->n_commodities = SNAPSHOT_NONE;
+    snap->n_accounts = SNAPSHOT_NONE;
+    snap->n_lots = SNAPSHOT_NONE;
+    snap->n_trns = SNAPSHOT_NONE;
+    snap->n_splits = SNAPSHOT_NONE;
+    snap->n_prices = SNAPSHOT_NONE;
+    if (!section_count (snap, SECTION_COMMODITY_SPACE, sizeof (guint32),
+                        &snap->n_commodities) ||
+        !section_count (snap, SECTION_ACCOUNT_GUID, sizeof (GncGUID),
+                        &snap->n_accounts) ||
+        !section_count (snap, SECTION_LOT_GUID, sizeof (GncGUID),
+                        &snap->n_lots) ||
+        !section_count (snap, SECTION_TRN_GUID, sizeof (GncGUID),
+                        &snap->n_trns) ||
+        !section_count (snap, SECTION_SPLIT_GUID, sizeof (GncGUID),
+                        &snap->n_splits) ||
+        !section_count (snap, SECTION_PRICE_GUID, sizeof (GncGUID),
+                        &snap->n_prices))
+        return FALSE;
+
+    if (!check_indexes (snap, SECTION_COMMODITY_SPACE, snap->n_commodities,
+                        snap->n_strings, FALSE) ||
+        !check_indexes (snap, SECTION_COMMODITY_ID, snap->n_commodities,
+                        snap->n_strings, FALSE))
+        return FALSE;
+
+    if (!check_indexes (snap, SECTION_TRN_CURRENCY, snap->n_trns,
+                        snap->n_commodities, TRUE) ||
+        !check_indexes (snap, SECTION_TRN_NUM, snap->n_trns,
+                        snap->n_strings, TRUE) ||
+        !check_indexes (snap, SECTION_TRN_DESCRIPTION, snap->n_trns,
+                        snap->n_strings, TRUE) ||
+        !check_column<snapshot_timespec> (snap, SECTION_TRN_POSTED, snap->n_trns) ||
+        !check_column<snapshot_timespec> (snap, SECTION_TRN_ENTERED, snap->n_trns) ||
+        !check_slot_offsets (snap, SECTION_TRN_SLOTS, snap->n_trns) ||
+        !check_column<guint32> (snap, SECTION_TRN_SPLITS, snap->n_trns + 1))
+        return FALSE;
+
+    auto trn_splits = column<guint32> (snap, SECTION_TRN_SPLITS);
+    if (trn_splits[0] != 0 || trn_splits[snap->n_trns] != snap->n_splits)
+        return FALSE;
+    for (guint32 i = 0; i < snap->n_trns; ++i)
+        if (trn_splits[i + 1] < trn_splits[i])
+            return FALSE;
+
+    if (!check_indexes (snap, SECTION_SPLIT_MEMO, snap->n_splits,
+                        snap->n_strings, TRUE) ||
+        !check_indexes (snap, SECTION_SPLIT_ACTION, snap->n_splits,
+                        snap->n_strings, TRUE) ||
+        !check_column<char> (snap, SECTION_SPLIT_RECONCILE, snap->n_splits) ||
+        !check_column<snapshot_timespec> (snap, SECTION_SPLIT_RECONCILE_DATE,
+                                          snap->n_splits) ||
+        !check_column<snapshot_numeric> (snap, SECTION_SPLIT_VALUE,
+                                         snap->n_splits) ||
+        !check_column<snapshot_numeric> (snap, SECTION_SPLIT_AMOUNT,
+                                         snap->n_splits) ||
+        !check_indexes (snap, SECTION_SPLIT_ACCOUNT, snap->n_splits,
+                        snap->n_accounts, FALSE) ||
+        !check_indexes (snap, SECTION_SPLIT_LOT, snap->n_splits,
+                        snap->n_lots, TRUE) ||
+        !check_slot_offsets (snap, SECTION_SPLIT_SLOTS, snap->n_splits))
+        return FALSE;
+
+    return check_indexes (snap, SECTION_PRICE_COMMODITY, snap->n_prices,
+                          snap->n_commodities, TRUE) &&
+           check_indexes (snap, SECTION_PRICE_CURRENCY, snap->n_prices,
+                          snap->n_commodities, TRUE) &&
+           check_column<snapshot_timespec> (snap, SECTION_PRICE_TIME,
+                                            snap->n_prices) &&
+           check_indexes (snap, SECTION_PRICE_SOURCE, snap->n_prices,
+                          snap->n_strings, TRUE) &&
+           check_indexes (snap, SECTION_PRICE_TYPE, snap->n_prices,
+                          snap->n_strings, TRUE) &&
+           check_column<snapshot_numeric> (snap, SECTION_PRICE_VALUE,
+                                           snap->n_prices);
+}
+
+static gboolean
+check_snapshot (gnc_snapshot* snap, const char* datafile, guint64 file_size)
+{
+    const snapshot_header* header = &snap->header;
+    guint64 xml_size;
+    guint32 xml_crc;
+
+    if (snap->length < sizeof (*header))
+        return FALSE;
+    memcpy (&snap->header, snap->data, sizeof (snap->header));
+    if (memcmp (header->magic, SNAPSHOT_MAGIC, sizeof (header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->byte_order != SNAPSHOT_BYTE_ORDER)
+    {
+        PINFO ("not a snapshot this version can read");
+        return FALSE;
+    }
+
+    if (header->xml_size != file_size ||
+        !file_checksum (datafile, &xml_size, &xml_crc) ||
+        xml_size != header->xml_size || xml_crc != header->xml_crc)
+    {
+        PINFO ("the snapshot doesn't match %s", datafile);
+        return FALSE;
+    }
+
+    if (update_crc (crc32 (0, Z_NULL, 0), snap->data + sizeof (*header),
+                    snap->length - sizeof (*header)) != header->body_crc ||
+        !check_sections (snap))
+    {
+        PWARN ("the snapshot of %s is damaged", datafile);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gnc_snapshot*
+gnc_snapshot_open (const char* datafile)
+{
+    gchar* filename;
+    GMappedFile* file;
+    gnc_snapshot* snap;
+    struct stat file_stat, snap_stat;
+
+    g_return_val_if_fail (datafile, NULL);
+
+    /* The snapshot is written after the file, so a file changed since
+     * then is newer. */
+    filename = gnc_snapshot_filename (datafile);
+    if (g_stat (filename, &snap_stat) != 0 ||
+        g_stat (datafile, &file_stat) != 0 ||
+        file_stat.st_mtime > snap_stat.st_mtime)
+    {
+        g_free (filename);
+        return NULL;
+    }
+    file = g_mapped_file_new (filename, FALSE, NULL);
+    g_free (filename);
+    if (!file)
+        return NULL;
+
+    snap = g_new0 (gnc_snapshot, 1);
+    snap->file = file;
+    snap->data = g_mapped_file_get_contents (file);
+    snap->length = g_mapped_file_get_length (file);
+    if (!snap->data || !check_snapshot (snap, datafile, file_stat.st_size))
+    {
+        gnc_snapshot_close (snap);
+        return NULL;
+    }
+    return snap;
+}
+
+void
+gnc_snapshot_close (gnc_snapshot* snap)
+{
+    if (!snap)
+        return;
+    g_mapped_file_unref (snap->file);
+    g_free (snap);
+}
+
+struct slot_cursor
+{
+    const gnc_snapshot* snap;
+    const char* p;
+    const char* end;
+};
+
+template <typename T> static gboolean
+read_slot_data (slot_cursor* c, T* value)
+{
+    if ((gsize) (c->end - c->p) < sizeof (T))
+        return FALSE;
+    memcpy (value, c->p, sizeof (T));
+    c->p += sizeof (T);
+    return TRUE;
+}
+
+static gboolean
+read_slot_string (slot_cursor* c, const char** str)
+{
+    guint32 id;
+
+    if (!read_slot_data (c, &id) || id >= c->snap->n_strings)
+        return FALSE;
+    *str = snapshot_string (c->snap, id);
+    return TRUE;
+}
+
+static gboolean read_slot_frame (slot_cursor* c, KvpFrame* frame);
+
+/* The values take_slot_value makes of what add_slot_value wrote */
+static KvpValue*
+read_slot_value (slot_cursor* c)
+{
+    guint8 type;
+
+    if (!read_slot_data (c, &type))
+        return NULL;
+
+    switch (static_cast<KvpValue::Type> (type))
+    {
+    case KvpValue::Type::INT64:
+    {
+        gint64 i;
+        return read_slot_data (c, &i) ? new KvpValue {i} : NULL;
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        double d;
+        return read_slot_data (c, &d) ? new KvpValue {d} : NULL;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        snapshot_numeric n;
+        return read_slot_data (c, &n) ? new KvpValue {snapshot_num (n)} : NULL;
+    }
+    case KvpValue::Type::STRING:
+    {
+        const char* str;
+        if (!read_slot_string (c, &str))
+            return NULL;
+        gchar* datext = g_strdup (str);
+        return new KvpValue {datext};
+    }
+    case KvpValue::Type::GUID:
+    {
+        GncGUID guid;
+        if (!read_slot_data (c, &guid))
+            return NULL;
+        auto daguid = guid_new ();
+        *daguid = guid;
+        return new KvpValue {daguid};
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        snapshot_timespec ts;
+        return read_slot_data (c, &ts) ? new KvpValue {snapshot_ts (ts)} : NULL;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        guint32 julian;
+        if (!read_slot_data (c, &julian) || !g_date_valid_julian (julian))
+            return NULL;
+        GDate date;
+        g_date_clear (&date, 1);
+        g_date_set_julian (&date, julian);
+        return new KvpValue {date};
+    }
+    case KvpValue::Type::GLIST:
+    {
+        guint32 count;
+        GList* list = NULL;
+
+        if (!read_slot_data (c, &count))
+            return NULL;
+        for (guint32 i = 0; i < count; ++i)
+        {
+            KvpValue* value = read_slot_value (c);
+            if (!value)
+            {
+                g_list_free_full (list, [] (gpointer v)
+                {
+                    delete static_cast<KvpValue*> (v);
+                });
+                return NULL;
+            }
+            list = g_list_prepend (list, value);
+        }
+        return new KvpValue {g_list_reverse (list)};
+    }
+    case KvpValue::Type::FRAME:
+    {
+        auto frame = new KvpFrame;
+        if (!read_slot_frame (c, frame))
+        {
+            delete frame;
+            return NULL;
+        }
+        return new KvpValue {frame};
+    }
+    default:
+        return NULL;
+    }
+}
+
+static gboolean
+read_slot_frame (slot_cursor* c, KvpFrame* frame)
+{
+    guint32 count;
+
+    if (!read_slot_data (c, &count))
+        return FALSE;
+    for (guint32 i = 0; i < count; ++i)
+    {
+        const char* key;
+        KvpValue* value;
+
+        if (!read_slot_string (c, &key) || !(value = read_slot_value (c)))
+            return FALSE;
+        //We're deleting the old KvpValue returned by replace_nc().
+        delete frame->set (key, value);
+    }
+    return TRUE;
+}
+
+static gboolean
+load_instance_slots (const gnc_snapshot* snap, guint64 offset,
+                     QofInstance* inst)
+{
+    slot_cursor c;
+
+    if (offset == 0)
+        return TRUE;
+    c.snap = snap;
+    c.p = column<char> (snap, SECTION_SLOTS) + offset;
+    c.end = column<char> (snap, SECTION_SLOTS) +
+            snap->header.sections[SECTION_SLOTS].size;
+    return read_slot_frame (&c, qof_instance_get_slots (inst));
+}
+
+/* As sixtp_stream_to_commodity_ref looks them up */
+static gboolean
+lookup_commodities (const gnc_snapshot* snap, QofBook* book,
+                    std::vector<gnc_commodity*>& commodities)
+{
+    auto table = gnc_commodity_table_get_table (book);
+    auto space = column<guint32> (snap, SECTION_COMMODITY_SPACE);
+    auto id = column<guint32> (snap, SECTION_COMMODITY_ID);
+
+    g_return_val_if_fail (table, FALSE);
+    commodities.reserve (snap->n_commodities);
+    for (guint32 i = 0; i < snap->n_commodities; ++i)
+    {
+        gchar* s = g_strstrip (g_strdup (snapshot_string (snap, space[i])));
+        gchar* m = g_strstrip (g_strdup (snapshot_string (snap, id[i])));
+        commodities.push_back (gnc_commodity_table_lookup (table, s, m));
+        g_free (s);
+        g_free (m);
+    }
+    return TRUE;
+}
+
+static gboolean
+load_prices (const gnc_snapshot* snap, QofBook* book,
+             const std::vector<gnc_commodity*>& commodities)
+{
+    auto db = gnc_pricedb_get_db (book);
+    auto guid = column<GncGUID> (snap, SECTION_PRICE_GUID);
+    auto commodity = column<guint32> (snap, SECTION_PRICE_COMMODITY);
+    auto currency = column<guint32> (snap, SECTION_PRICE_CURRENCY);
+    auto time = column<snapshot_timespec> (snap, SECTION_PRICE_TIME);
+    auto source = column<guint32> (snap, SECTION_PRICE_SOURCE);
+    auto type = column<guint32> (snap, SECTION_PRICE_TYPE);
+    auto value = column<snapshot_numeric> (snap, SECTION_PRICE_VALUE);
+
+    g_return_val_if_fail (db, FALSE);
+    for (guint32 i = 0; i < snap->n_prices; ++i)
+    {
+        Timespec ts = snapshot_ts (time[i]);
+
+        /* the price parser fails on these */
+        if ((commodity[i] != SNAPSHOT_NONE && !commodities[commodity[i]]) ||
+            (currency[i] != SNAPSHOT_NONE && !commodities[currency[i]]) ||
+            (ts.tv_sec == 0 && ts.tv_nsec == 0))
+        {
+            PERR ("bad price %u in the snapshot", i);
+            return FALSE;
+        }
+    }
+
+    gnc_pricedb_set_bulk_update (db, TRUE);
+    for (guint32 i = 0; i < snap->n_prices; ++i)
+    {
+        auto p = gnc_price_create (book);
+
+        gnc_price_begin_edit (p);
+        gnc_price_set_guid (p, &guid[i]);
+        if (commodity[i] != SNAPSHOT_NONE)
+            gnc_price_set_commodity (p, commodities[commodity[i]]);
+        if (currency[i] != SNAPSHOT_NONE)
+            gnc_price_set_currency (p, commodities[currency[i]]);
+        gnc_price_set_time (p, snapshot_ts (time[i]));
+        if (source[i] != SNAPSHOT_NONE)
+            gnc_price_set_source_string (p, snapshot_string (snap, source[i]));
+        if (type[i] != SNAPSHOT_NONE)
+            gnc_price_set_typestr (p, snapshot_string (snap, type[i]));
+        gnc_price_set_value (p, snapshot_num (value[i]));
+        gnc_price_commit_edit (p);
+        gnc_pricedb_add_price (db, p);
+        gnc_price_unref (p);
+    }
+    gnc_pricedb_set_bulk_update (db, FALSE);
+    return TRUE;
+}
+
+/* The splits' setters in the order of the stream parser's fields */
+static gboolean
+load_split (const gnc_snapshot* snap, guint32 i, Transaction* trn,
+            QofBook* book, const std::vector<Account*>& accounts,
+            const std::vector<GNCLot*>& lots)
+{
+    auto spl = xaccMallocSplit (book);
+    auto memo = column<guint32> (snap, SECTION_SPLIT_MEMO)[i];
+    auto action = column<guint32> (snap, SECTION_SPLIT_ACTION)[i];
+    auto lot = column<guint32> (snap, SECTION_SPLIT_LOT)[i];
+    auto reconciled = snapshot_ts (
+                          column<snapshot_timespec> (snap,
+                                                     SECTION_SPLIT_RECONCILE_DATE)[i]);
+
+    xaccSplitSetGUID (spl, &column<GncGUID> (snap, SECTION_SPLIT_GUID)[i]);
+    if (memo != SNAPSHOT_NONE)
+        xaccSplitSetMemo (spl, snapshot_string (snap, memo));
+    if (action != SNAPSHOT_NONE)
+        xaccSplitSetAction (spl, snapshot_string (snap, action));
+    xaccSplitSetReconcile (spl, column<char> (snap, SECTION_SPLIT_RECONCILE)[i]);
+    if (reconciled.tv_sec || reconciled.tv_nsec)
+        xaccSplitSetDateReconciledTS (spl, &reconciled);
+    xaccSplitSetValue (spl, snapshot_num (
+                           column<snapshot_numeric> (snap, SECTION_SPLIT_VALUE)[i]));
+    xaccSplitSetAmount (spl, snapshot_num (
+                            column<snapshot_numeric> (snap, SECTION_SPLIT_AMOUNT)[i]));
+    xaccAccountInsertSplit (accounts[column<guint32> (snap,
+                                                      SECTION_SPLIT_ACCOUNT)[i]],
+                            spl);
+    if (lot != SNAPSHOT_NONE)
+        gnc_lot_add_split (lots[lot], spl);
+    if (!load_instance_slots (snap, column<guint64> (snap,
+                                                     SECTION_SPLIT_SLOTS)[i],
+                              QOF_INSTANCE (spl)))
+    {
+        xaccSplitDestroy (spl);
+        return FALSE;
+    }
+    xaccTransAppendSplit (trn, spl);
+    return TRUE;
+}
+
+static gboolean
+load_transaction (const gnc_snapshot* snap, guint32 i, QofBook* book,
+                  const std::vector<gnc_commodity*>& commodities,
+                  const std::vector<Account*>& accounts,
+                  const std::vector<GNCLot*>& lots, Transaction** result)
+{
+    auto trn = xaccMallocTransaction (book);
+    auto currency = column<guint32> (snap, SECTION_TRN_CURRENCY)[i];
+    auto num = column<guint32> (snap, SECTION_TRN_NUM)[i];
+    auto description = column<guint32> (snap, SECTION_TRN_DESCRIPTION)[i];
+    auto posted = snapshot_ts (column<snapshot_timespec> (snap,
+                                                          SECTION_TRN_POSTED)[i]);
+    auto entered = snapshot_ts (column<snapshot_timespec> (snap,
+                                                           SECTION_TRN_ENTERED)[i]);
+    auto splits = column<guint32> (snap, SECTION_TRN_SPLITS);
+    gboolean ok;
+
+    xaccTransBeginEdit (trn);
+    xaccTransSetGUID (trn, &column<GncGUID> (snap, SECTION_TRN_GUID)[i]);
+    if (currency != SNAPSHOT_NONE)
+        xaccTransSetCurrency (trn, commodities[currency]);
+    if (num != SNAPSHOT_NONE)
+        xaccTransSetNum (trn, snapshot_string (snap, num));
+    if (posted.tv_sec || posted.tv_nsec)
+        xaccTransSetDatePostedTS (trn, &posted);
+    if (entered.tv_sec || entered.tv_nsec)
+        xaccTransSetDateEnteredTS (trn, &entered);
+    if (description != SNAPSHOT_NONE)
+        xaccTransSetDescription (trn, snapshot_string (snap, description));
+    ok = load_instance_slots (snap, column<guint64> (snap, SECTION_TRN_SLOTS)[i],
+                              QOF_INSTANCE (trn));
+    for (guint32 s = splits[i]; ok && s < splits[i + 1]; ++s)
+        ok = load_split (snap, s, trn, book, accounts, lots);
+    xaccTransCommitEdit (trn);
+
+    if (!ok)
+    {
+        xaccTransBeginEdit (trn);
+        xaccTransDestroy (trn);
+        xaccTransCommitEdit (trn);
+        return FALSE;
+    }
+    *result = trn;
+    return TRUE;
+}
+
+static gboolean
+snapshot_fill (QofBook* book, gpointer user_data,
+               void (*add_transaction) (Transaction* trn, gpointer loader),
+               gpointer loader)
+{
+    auto snap = static_cast<const gnc_snapshot*> (user_data);
+    std::vector<gnc_commodity*> commodities;
+    std::vector<Account*> accounts;
+    std::vector<GNCLot*> lots;
+
+    if (!lookup_commodities (snap, book, commodities))
+        return FALSE;
+
+    auto account_guid = column<GncGUID> (snap, SECTION_ACCOUNT_GUID);
+    accounts.reserve (snap->n_accounts);
+    for (guint32 i = 0; i < snap->n_accounts; ++i)
+        accounts.push_back (xaccAccountLookup (&account_guid[i], book));
+
+    auto lot_guid = column<GncGUID> (snap, SECTION_LOT_GUID);
+    lots.reserve (snap->n_lots);
+    for (guint32 i = 0; i < snap->n_lots; ++i)
+        lots.push_back (gnc_lot_lookup (&lot_guid[i], book));
+
+    if (!load_prices (snap, book, commodities))
+        return FALSE;
+
+    for (guint32 i = 0; i < snap->n_trns; ++i)
+    {
+        Transaction* trn;
+
+        if (!load_transaction (snap, i, book, commodities, accounts, lots, &trn))
+        {
+            PERR ("bad slots in transaction %u of the snapshot", i);
+            return FALSE;
+        }
+        add_transaction (trn, loader);
+    }
+    return TRUE;
+}
+
+gboolean
+gnc_snapshot_load (gnc_snapshot* snap, FileBackend* fbe, QofBook* book)
+{
+    const snapshot_section* head;
+    const snapshot_section* tail;
+    gboolean success;
+
+    g_return_val_if_fail (snap && fbe && book, FALSE);
+    ENTER ("snapshot of %s", fbe->fullpath);
+
+    head = &snap->header.sections[SECTION_XML_HEAD];
+    tail = &snap->header.sections[SECTION_XML_TAIL];
+
+    success = qof_session_load_from_xml_parts_v2 (fbe, book,
+                                                  snap->data + head->offset,
+                                                  head->size,
+                                                  snap->data + tail->offset,
+                                                  tail->size,
+                                                  snapshot_fill, snap);
+    LEAVE ("%s", success ? "loaded" : "failed");
+    return success;
+}
@@ -0,0 +1,80 @@
+/********************************************************************
+ * io-gncsnapshot.h -- binary snapshots of XML books                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+/** @file io-gncsnapshot.h
+ *  @brief A binary companion of an XML data file, for opening it fast
+ *
+ * A snapshot, written next to the data file as <file>.snapshot when it
+ * is saved, holds the same book as the file.  The transactions, their
+ * splits and the prices are kept as columns of fixed size values
+ * (GUIDs, dates, amounts, and indexes into tables of the strings,
+ * commodities, accounts and lots they refer to) that are read straight
+ * from the mapped file; the rest of the book is kept as the XML that
+ * comes before and after the transactions in the data file, and read
+ * with the XML parsers.
+ *
+ * The XML file stays the book's canonical form: a snapshot records the
+ * size and checksum of the file it was written with, and is used only
+ * while the file still matches them and its own checksum is right.
+ * Snapshots are written and read only while the file-snapshot
+ * preference is set.
+ */
+
+#ifndef IO_GNCSNAPSHOT_H
+#define IO_GNCSNAPSHOT_H
+extern "C"
+{
+#include <glib.h>
+
+#include "qof.h"
+}
+
+#include "gnc-backend-xml.h"
+
+typedef struct gnc_snapshot gnc_snapshot;
+
+/** TRUE if snapshots are written when books are saved, and read when
+ * they are loaded. */
+gboolean gnc_snapshot_enabled (void);
+
+/** The snapshot's file name for a data file, to be freed. */
+gchar* gnc_snapshot_filename (const char* datafile);
+
+/** Write the snapshot of a book just saved to datafile. */
+gboolean gnc_snapshot_write (QofBook* book, const char* datafile);
+
+/** Remove the snapshot of datafile, if there is one. */
+void gnc_snapshot_remove (const char* datafile);
+
+/** Map and check the snapshot of datafile; NULL if there is none or it
+ * doesn't match the file.  A snapshot older than the file or written
+ * with a file of another size is rejected before the checksums are
+ * computed. */
+gnc_snapshot* gnc_snapshot_open (const char* datafile);
+void gnc_snapshot_close (gnc_snapshot* snapshot);
+
+/** Load the book from an open snapshot.  On failure the book is left
+ * partly filled: the backend then removes the snapshot and has the
+ * session load the XML file into a new book. */
+gboolean gnc_snapshot_load (gnc_snapshot* snapshot, FileBackend* fbe,
+                            QofBook* book);
+
+#endif /* IO_GNCSNAPSHOT_H */
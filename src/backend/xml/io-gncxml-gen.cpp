@@ -60,3 +60,21 @@ gnc_xml_parse_fd (sixtp* top_parser, FILE* fd,
     return sixtp_parse_fd (top_parser, fd,
                            NULL, &gpdata, &parse_result);
 }
+
+gboolean
+gnc_xml_parse_fd_parallel (sixtp* top_parser, FILE* fd,
+                           const char* shard_tag, const char* skip_tag,
+                           guint n_threads,
+                           gxpf_callback callback, gpointer parsedata,
+                           gpointer bookdata)
+{
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+
+    gpdata.cb = callback;
+    gpdata.parsedata = parsedata;
+    gpdata.bookdata = bookdata;
+
+    return sixtp_parse_fd_parallel (top_parser, fd, shard_tag, skip_tag,
+                                    n_threads, NULL, &gpdata, &parse_result);
+}
@@ -53,4 +53,13 @@ gnc_xml_parse_fd (sixtp* top_parser, FILE* fd,
                   gxpf_callback callback, gpointer parsedata,
                   gpointer bookdata);
 
+/* As gnc_xml_parse_fd, tokenizing the shard_tag elements on worker
+   threads; see sixtp_parse_fd_parallel. */
+gboolean
+gnc_xml_parse_fd_parallel (sixtp* top_parser, FILE* fd,
+                           const char* shard_tag, const char* skip_tag,
+                           guint n_threads,
+                           gxpf_callback callback, gpointer parsedata,
+                           gpointer bookdata);
+
 #endif /* IO_GNCXML_GEN_H */
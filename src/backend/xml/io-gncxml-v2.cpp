@@ -55,6 +55,7 @@ extern "C"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gnc-prefs.h"
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
 #undef __STRICT_ANSI_UNSET__
@@ -67,6 +68,11 @@ extern "C"
 #endif
 }
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-utils.h"
@@ -813,8 +819,18 @@ qof_session_load_from_xml_file_v2_full (
         }
         else
         {
-            retval = gnc_xml_parse_fd (top_parser, file,
-                                       generic_callback, gd, book);
+            /* Worker threads may tokenize the transactions, which are
+             * still added to the book in order on this thread. */
+            guint n_threads = gnc_prefs_get_file_load_threads ();
+            if (n_threads > 0)
+                retval = gnc_xml_parse_fd_parallel (top_parser, file,
+                                                    TRANSACTION_TAG,
+                                                    TEMPLATE_TRANSACTION_TAG,
+                                                    n_threads,
+                                                    generic_callback, gd, book);
+            else
+                retval = gnc_xml_parse_fd (top_parser, file,
+                                           generic_callback, gd, book);
             fclose (file);
             if (is_compressed)
                 wait_for_gzip (file);
@@ -878,6 +894,69 @@ qof_session_load_from_xml_file_v2 (FileBackend* fbe, QofBook* book,
     return qof_session_load_from_xml_file_v2_full (fbe, book, NULL, NULL, type);
 }
 
+typedef struct
+{
+    const char* head;
+    gsize head_len;
+    const char* tail;
+    gsize tail_len;
+    GncXmlPartsFiller filler;
+    gpointer user_data;
+} parts_push_data;
+
+static void
+add_transaction_part (Transaction* trn, gpointer loader)
+{
+    add_transaction_local (static_cast<sixtp_gdv2*> (loader), trn);
+}
+
+/* The head's last element is complete, so the push parser has handed
+   all of it to the handlers before xmlParseChunk returns: the accounts
+   and lots the filler's splits refer to are in the book. */
+static void
+parts_push_handler (xmlParserCtxtPtr xml_context, parts_push_data* push_data)
+{
+    sixtp_sax_data* sax_data = static_cast<decltype (sax_data)> (
+                                   xml_context->userData);
+    gxpf_data* gpdata = static_cast<decltype (gpdata)> (sax_data->global_data);
+
+    if (xmlParseChunk (xml_context, push_data->head,
+                       (int) push_data->head_len, 0) != 0
+        || !sax_data->parsing_ok)
+        return;
+
+    if (!push_data->filler (static_cast<QofBook*> (gpdata->bookdata),
+                            push_data->user_data, add_transaction_part,
+                            gpdata->parsedata))
+    {
+        sax_data->parsing_ok = FALSE;
+        return;
+    }
+
+    xmlParseChunk (xml_context, push_data->tail, (int) push_data->tail_len, 1);
+}
+
+gboolean
+qof_session_load_from_xml_parts_v2 (FileBackend* fbe, QofBook* book,
+                                    const char* head, gsize head_len,
+                                    const char* tail, gsize tail_len,
+                                    GncXmlPartsFiller filler,
+                                    gpointer user_data)
+{
+    parts_push_data push_data;
+
+    push_data.head = head;
+    push_data.head_len = head_len;
+    push_data.tail = tail;
+    push_data.tail_len = tail_len;
+    push_data.filler = filler;
+    push_data.user_data = user_data;
+
+    return qof_session_load_from_xml_file_v2_full (
+               fbe, book, (sixtp_push_handler) parts_push_handler,
+               &push_data, GNC_BOOK_XML2_FILE);
+}
+
 /***********************************************************************/
 
 static gboolean
@@ -991,8 +1070,11 @@ write_data_cb (const char* type, gpointer data_p, gpointer be_data_p)
         (data->write) (be_data->out, be_data->book);
 }
 
+/* The book's element up to and including its accounts; a snapshot
+   keeps the prices itself. */
 static gboolean
-write_book (FILE* out, QofBook* book, sixtp_gdv2* gd)
+write_book_head (FILE* out, QofBook* book, sixtp_gdv2* gd,
+                 gboolean with_prices)
 {
     struct file_backend be_data;
 
@@ -1053,10 +1135,24 @@ write_book (FILE* out, QofBook* book, sixtp_gdv2* gd)
 
     if (ferror (out)
         || !write_commodities (out, book, gd)
-        || !write_pricedb (out, book, gd)
-        || !write_accounts (out, book, gd)
-        || !write_transactions (out, book, gd)
-        || !write_template_transaction_data (out, book, gd)
+        || (with_prices && !write_pricedb (out, book, gd))
+        || !write_accounts (out, book, gd))
+        return FALSE;
+
+    return TRUE;
+}
+
+/* The rest of the book's element after its transactions */
+static gboolean
+write_book_tail (FILE* out, QofBook* book, sixtp_gdv2* gd)
+{
+    struct file_backend be_data;
+
+    be_data.out = out;
+    be_data.book = book;
+    be_data.gd = gd;
+
+    if (!write_template_transaction_data (out, book, gd)
         || !write_schedXactions (out, book, gd))
 
         return FALSE;
@@ -1076,6 +1172,14 @@ write_book (FILE* out, QofBook* book, sixtp_gdv2* gd)
     return TRUE;
 }
 
+static gboolean
+write_book (FILE* out, QofBook* book, sixtp_gdv2* gd)
+{
+    return write_book_head (out, book, gd, TRUE)
+           && write_transactions (out, book, gd)
+           && write_book_tail (out, book, gd);
+}
+
 gboolean
 write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
@@ -1203,10 +1307,151 @@ xml_add_trn_data (Transaction* t, gpointer data)
     return 0;
 }
 
+/* Transactions serialized by a worker at a time */
+static const guint trn_batch_size = 256;
+/* Batches serialized ahead of the writer, per worker */
+static const guint trn_batches_ahead = 4;
+
+struct trn_writer
+{
+    GPtrArray* trns;
+    std::vector<GString*> chunks; /* per batch, once serialized */
+    guint next;                   /* the next batch to serialize */
+    guint written;                /* batches written */
+    guint window;
+    guint busy;                   /* workers serializing a batch */
+    bool paused;                  /* while the progress callback runs */
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+static int
+collect_trn (Transaction* t, gpointer data)
+{
+    g_ptr_array_add (static_cast<GPtrArray*> (data), t);
+    return 0;
+}
+
+static void
+trn_writer_func (trn_writer* w)
+{
+    std::unique_lock<std::mutex> lock (w->mutex);
+
+    while (true)
+    {
+        w->changed.wait (lock, [w]
+        {
+            return w->stop || w->next >= w->chunks.size () ||
+                   (!w->paused && w->next < w->written + w->window);
+        });
+        if (w->stop || w->next >= w->chunks.size ())
+            return;
+
+        auto batch = w->next++;
+        ++w->busy;
+        lock.unlock ();
+        auto end = MIN ((batch + 1) * trn_batch_size, w->trns->len);
+        auto text = g_string_sized_new (1024 * trn_batch_size);
+        for (auto i = batch * trn_batch_size; i < end; ++i)
+            gnc_transaction_to_xml_text (static_cast<Transaction*>
+                                         (g_ptr_array_index (w->trns, i)),
+                                         text);
+        lock.lock ();
+        w->chunks[batch] = text;
+        --w->busy;
+        w->changed.notify_all ();
+    }
+}
+
+/* Write the same text as xml_add_trn_data does for each transaction,
+ * serialized straight from the transactions on worker threads.
+ *
+ * The workers only read the engine: the getters used return fields,
+ * gnc_print_time64() only reads the time zones loaded at startup, the
+ * slots are walked with KvpFrame::for_each_slot(), which changes
+ * nothing, and KvpPathImpl::intern() takes a lock.  Nothing else may
+ * change the book meanwhile, so the progress callback, which can run
+ * the GUI's main loop, is only called while the workers are paused. */
+static gboolean
+write_transactions_parallel (FILE* out, Account* root, sixtp_gdv2* gd,
+                             guint n_threads)
+{
+    trn_writer w;
+    std::vector<std::thread> workers;
+    gboolean ok = TRUE;
+
+    w.trns = g_ptr_array_new ();
+    xaccAccountTreeForEachTransaction (root, collect_trn, w.trns);
+    w.chunks.resize ((w.trns->len + trn_batch_size - 1) / trn_batch_size,
+                     nullptr);
+    w.next = w.written = w.busy = 0;
+    w.window = trn_batches_ahead * n_threads;
+    w.paused = w.stop = false;
+
+    for (guint i = 0; i < n_threads; ++i)
+        workers.push_back (std::thread (trn_writer_func, &w));
+
+    for (guint batch = 0; ok && batch < w.chunks.size (); ++batch)
+    {
+        GString* text;
+        {
+            std::unique_lock<std::mutex> lock (w.mutex);
+            w.changed.wait (lock, [&w, batch] { return w.chunks[batch] != nullptr; });
+            text = w.chunks[batch];
+            w.chunks[batch] = nullptr;
+            w.written = batch + 1;
+            w.changed.notify_all ();
+        }
+
+        ok = fwrite (text->str, 1, text->len, out) == text->len &&
+             !ferror (out);
+        g_string_free (text, TRUE);
+        if (!ok)
+            break;
+
+        {
+            std::unique_lock<std::mutex> lock (w.mutex);
+            w.paused = true;
+            w.changed.wait (lock, [&w] { return w.busy == 0; });
+        }
+        for (auto i = batch * trn_batch_size;
+             i < MIN ((batch + 1) * trn_batch_size, w.trns->len); ++i)
+        {
+            gd->counter.transactions_loaded++;
+            sixtp_run_callback (gd, "transaction");
+        }
+        {
+            std::lock_guard<std::mutex> lock (w.mutex);
+            w.paused = false;
+            w.changed.notify_all ();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (w.mutex);
+        w.stop = true;
+        w.changed.notify_all ();
+    }
+    for (auto& worker : workers)
+        worker.join ();
+    for (auto text : w.chunks)
+        if (text)
+            g_string_free (text, TRUE);
+    g_ptr_array_free (w.trns, TRUE);
+    return ok;
+}
+
 static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     struct file_backend be_data;
+    guint n_threads = gnc_prefs_get_file_save_threads ();
+
+    if (n_threads > 0)
+        return write_transactions_parallel (out,
+                                            gnc_book_get_root_account (book),
+                                            gd, n_threads);
 
     be_data.out = out;
     be_data.gd = gd;
@@ -1377,6 +1622,41 @@ gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
     return success;
 }
 
+gboolean
+gnc_book_write_xml_head_v2 (QofBook* book, FILE* out)
+{
+    sixtp_gdv2* gd;
+    gboolean success = TRUE;
+
+    if (!out) return FALSE;
+
+    gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    if (!write_v2_header (out)
+        || !write_counts (out, "book", 1, NULL)
+        || !write_book_head (out, book, gd, FALSE))
+        success = FALSE;
+
+    g_free (gd);
+    return success;
+}
+
+gboolean
+gnc_book_write_xml_tail_v2 (QofBook* book, FILE* out)
+{
+    sixtp_gdv2* gd;
+    gboolean success = TRUE;
+
+    if (!out) return FALSE;
+
+    gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    if (!write_book_tail (out, book, gd)
+        || fprintf (out, "</" GNC_V2_STRING ">\n\n") < 0)
+        success = FALSE;
+
+    g_free (gd);
+    return success;
+}
+
 /*
  * This function is called by the "export" code.
  */
@@ -1415,14 +1695,15 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be, QofBook* book,
     return success;
 }
 
-#define BUFLEN 4096
+/* Large enough for the pipe not to be the bottleneck of a load */
+#define BUFLEN (64 * 1024)
 
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
-    gchar buffer[BUFLEN];
+    gchar* buffer = static_cast<gchar*> (g_malloc (BUFLEN));
     gssize bytes;
     gint gzval;
     gzFile file;
@@ -1532,6 +1813,7 @@ gz_thread_func (gz_thread_params_t* params)
     }
 
 cleanup_gz_thread_func:
+    g_free (buffer);
     close (params->fd);
     g_free (params->filename);
     g_free (params->perms);
@@ -1558,7 +1840,7 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
         FILE* file;
 
 #ifdef G_OS_WIN32
-        if (_pipe (filedes, 4096, _O_BINARY) < 0)
+        if (_pipe (filedes, BUFLEN, _O_BINARY) < 0)
         {
 #else
         if (pipe (filedes) < 0)
@@ -95,6 +95,31 @@ gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
 gboolean gnc_book_write_accounts_to_xml_file_v2 (QofBackend* be, QofBook* book,
                                                  const char* filename);
 
+/** Write the parts of the book's document before and after its
+ * transactions, leaving out the price database, for a snapshot (see
+ * io-gncsnapshot.h).
+ */
+gboolean gnc_book_write_xml_head_v2 (QofBook* book, FILE* fh);
+gboolean gnc_book_write_xml_tail_v2 (QofBook* book, FILE* fh);
+
+/** Called by qof_session_load_from_xml_parts_v2 between the head and
+ * the tail, to add the transactions, through add_transaction, and the
+ * prices; FALSE fails the load.
+ */
+typedef gboolean (*GncXmlPartsFiller) (QofBook* book, gpointer user_data,
+                                       void (*add_transaction) (Transaction* trn,
+                                                                gpointer loader),
+                                       gpointer loader);
+
+/** Load a book from the head and tail written by the functions above,
+ * with the filler adding what lies between them.
+ */
+gboolean qof_session_load_from_xml_parts_v2 (FileBackend* fbe, QofBook* book,
+                                             const char* head, gsize head_len,
+                                             const char* tail, gsize tail_len,
+                                             GncXmlPartsFiller filler,
+                                             gpointer user_data);
+
 /** The is_gncxml_file() routine checks to see if the first few
  * chars of the file look like gnc-xml data.
  */
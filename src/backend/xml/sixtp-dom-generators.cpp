@@ -370,3 +370,314 @@ qof_instance_slots_to_dom_tree (const char* tag, const QofInstance* inst)
     frame->for_each_slot (add_kvp_slot, static_cast<void*> (ret));
     return ret;
 }
+
+/***********************************************************************/
+/* The text generators */
+
+/* libxml2 stops indenting at this depth */
+static const int max_indent_level = 30;
+
+static void
+xml_text_indent (GString* out, int level)
+{
+    for (int i = MIN (level, max_indent_level); i > 0; --i)
+        g_string_append (out, "  ");
+}
+
+static void
+xml_text_tag_start (GString* out, int level, const char* tag,
+                    const char* type)
+{
+    xml_text_indent (out, level);
+    g_string_append_c (out, '<');
+    g_string_append (out, tag);
+    if (type)
+    {
+        g_string_append (out, " type=\"");
+        g_string_append (out, type);
+        g_string_append_c (out, '"');
+    }
+}
+
+/* Escape text the way libxml2 does when writing UTF-8. */
+static void
+xml_text_escape (GString* out, const char* text)
+{
+    const char* run = text;
+
+    for (auto p = text; *p; ++p)
+    {
+        const char* entity;
+        switch (*p)
+        {
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '&':
+            entity = "&amp;";
+            break;
+        case '\r':
+            entity = "&#13;";
+            break;
+        default:
+            continue;
+        }
+        g_string_append_len (out, run, p - run);
+        g_string_append (out, entity);
+        run = p + 1;
+    }
+    g_string_append (out, run);
+}
+
+static gboolean
+needs_check (const char* text)
+{
+    for (auto p = reinterpret_cast<const guchar*> (text); *p; ++p)
+        if (*p >= 0x80 || (*p < 0x20 && *p != 0x09 && *p != 0x0a && *p != 0x0d))
+            return TRUE;
+    return FALSE;
+}
+
+gsize
+xml_text_open (GString* out, int level, const char* tag, const char* type)
+{
+    xml_text_tag_start (out, level, tag, type);
+    g_string_append (out, ">\n");
+    return out->len;
+}
+
+void
+xml_text_close (GString* out, int level, const char* tag, gsize children)
+{
+    if (out->len == children)
+    {
+        /* No children: libxml2 writes an empty element tag. */
+        g_string_truncate (out, children - 2);
+        g_string_append (out, "/>\n");
+        return;
+    }
+    xml_text_indent (out, level);
+    g_string_append (out, "</");
+    g_string_append (out, tag);
+    g_string_append (out, ">\n");
+}
+
+void
+xml_text_leaf (GString* out, int level, const char* tag, const char* type,
+               const char* text, gboolean checked)
+{
+    xml_text_tag_start (out, level, tag, type);
+    if (!text)
+    {
+        g_string_append (out, "/>\n");
+        return;
+    }
+    g_string_append_c (out, '>');
+    if (checked && needs_check (text))
+    {
+        auto copy = g_strdup (text);
+        xml_text_escape (out, (const char*) checked_char_cast (copy));
+        g_free (copy);
+    }
+    else
+        xml_text_escape (out, text);
+    g_string_append (out, "</");
+    g_string_append (out, tag);
+    g_string_append (out, ">\n");
+}
+
+/* What xmlNodeAddContent and xmlNodeSetContent leave: no text node
+   for an empty string */
+static const char*
+content_text (const char* text)
+{
+    return text && *text ? text : NULL;
+}
+
+void
+guid_to_xml_text (GString* out, int level, const char* tag,
+                  const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+    {
+        PERR ("guid_to_string_buff failed\n");
+        return;
+    }
+    xml_text_leaf (out, level, tag, "guid", guid_str, FALSE);
+}
+
+void
+commodity_ref_to_xml_text (GString* out, int level, const char* tag,
+                           const gnc_commodity* c)
+{
+    g_return_if_fail (c);
+
+    if (!gnc_commodity_get_namespace (c) || !gnc_commodity_get_mnemonic (c))
+        return;
+
+    auto children = xml_text_open (out, level, tag, NULL);
+    xml_text_leaf (out, level + 1, "cmdty:space",
+                   NULL, gnc_commodity_get_namespace_compat (c), TRUE);
+    xml_text_leaf (out, level + 1, "cmdty:id",
+                   NULL, gnc_commodity_get_mnemonic (c), TRUE);
+    xml_text_close (out, level, tag, children);
+}
+
+void
+timespec_to_xml_text (GString* out, int level, const char* tag,
+                      const char* type, const Timespec* spec)
+{
+    g_return_if_fail (spec);
+
+    auto date_str = timespec_sec_to_string (spec);
+    if (!date_str)
+        return;
+
+    auto children = xml_text_open (out, level, tag, type);
+    xml_text_leaf (out, level + 1, "ts:date", NULL, date_str, TRUE);
+    if (spec->tv_nsec > 0)
+    {
+        auto ns_str = timespec_nsec_to_string (spec);
+        if (ns_str)
+            xml_text_leaf (out, level + 1, "ts:ns", NULL, ns_str, TRUE);
+        g_free (ns_str);
+    }
+    xml_text_close (out, level, tag, children);
+    g_free (date_str);
+}
+
+void
+gdate_to_xml_text (GString* out, int level, const char* tag,
+                   const char* type, const GDate* date)
+{
+    gchar date_str[512];
+
+    g_return_if_fail (date);
+
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+    auto children = xml_text_open (out, level, tag, type);
+    xml_text_leaf (out, level + 1, "gdate", NULL, date_str, TRUE);
+    xml_text_close (out, level, tag, children);
+}
+
+void
+gnc_numeric_to_xml_text (GString* out, int level, const char* tag,
+                         const gnc_numeric* num)
+{
+    g_return_if_fail (num);
+
+    auto numstr = gnc_numeric_to_string (*num);
+    g_return_if_fail (numstr);
+
+    xml_text_leaf (out, level, tag, NULL, content_text (numstr), TRUE);
+    g_free (numstr);
+}
+
+struct kvp_text_data
+{
+    GString* out;
+    int level;
+};
+
+static void add_kvp_slot_text (const char* key, KvpValue* value, void* data);
+
+static void
+kvp_value_to_xml_text (GString* out, int level, const gchar* tag,
+                       KvpValue* val)
+{
+    gchar* str = NULL;
+
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::STRING:
+        xml_text_leaf (out, level, tag, "string", val->get<const char*> (),
+                       TRUE);
+        break;
+    case KvpValue::Type::INT64:
+        str = g_strdup_printf ("%" G_GINT64_FORMAT, val->get<int64_t> ());
+        xml_text_leaf (out, level, tag, "integer", content_text (str), TRUE);
+        break;
+    case KvpValue::Type::DOUBLE:
+        str = double_to_string (val->get<double> ());
+        xml_text_leaf (out, level, tag, "double", content_text (str), TRUE);
+        break;
+    case KvpValue::Type::NUMERIC:
+        str = gnc_numeric_to_string (val->get<gnc_numeric> ());
+        xml_text_leaf (out, level, tag, "numeric", content_text (str), TRUE);
+        break;
+    case KvpValue::Type::GUID:
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (val->get<GncGUID*> (), guidstr);
+        xml_text_leaf (out, level, tag, "guid", content_text (guidstr), TRUE);
+        break;
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        auto ts = val->get<Timespec> ();
+        timespec_to_xml_text (out, level, tag, "timespec", &ts);
+        break;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        gdate_to_xml_text (out, level, tag, "gdate", &d);
+        break;
+    }
+    case KvpValue::Type::GLIST:
+    {
+        auto children = xml_text_open (out, level, tag, "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            kvp_value_to_xml_text (out, level + 1, "slot:value",
+                                   static_cast<KvpValue*> (cursor->data));
+        xml_text_close (out, level, tag, children);
+        break;
+    }
+    case KvpValue::Type::FRAME:
+    {
+        auto children = xml_text_open (out, level, tag, "frame");
+        auto frame = val->get<KvpFrame*> ();
+        if (frame)
+        {
+            kvp_text_data data = { out, level + 1 };
+            frame->for_each_slot (add_kvp_slot_text, &data);
+        }
+        xml_text_close (out, level, tag, children);
+        break;
+    }
+    default:
+        xml_text_leaf (out, level, tag, NULL, NULL, FALSE);
+        break;
+    }
+    g_free (str);
+}
+
+static void
+add_kvp_slot_text (const char* key, KvpValue* value, void* data)
+{
+    auto td = static_cast<kvp_text_data*> (data);
+    auto children = xml_text_open (td->out, td->level, "slot", NULL);
+
+    xml_text_leaf (td->out, td->level + 1, "slot:key", NULL, key, TRUE);
+    kvp_value_to_xml_text (td->out, td->level + 1, "slot:value", value);
+    xml_text_close (td->out, td->level, "slot", children);
+}
+
+void
+qof_instance_slots_to_xml_text (GString* out, int level, const char* tag,
+                                const QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    if (!frame)
+        return;
+
+    auto children = xml_text_open (out, level, tag, NULL);
+    kvp_text_data data = { out, level + 1 };
+    frame->for_each_slot (add_kvp_slot_text, &data);
+    xml_text_close (out, level, tag, children);
+}
@@ -52,4 +52,32 @@ xmlNodePtr recurrence_to_dom_tree (const gchar* tag, const Recurrence* r);
 
 gchar* double_to_string (double value);
 
+/* The text generators append to out the text xmlElemDump writes for
+   the tree built by the matching *_to_dom_tree generator, indented for
+   the element's level and followed by a newline, so that the writer
+   can skip building the tree.  type is the element's type attribute,
+   or NULL. */
+gsize xml_text_open (GString* out, int level, const char* tag,
+                     const char* type);
+/* children is the length returned by xml_text_open */
+void xml_text_close (GString* out, int level, const char* tag,
+                     gsize children);
+/* An element holding text, passed through checked_char_cast if
+   checked; NULL for an empty element. */
+void xml_text_leaf (GString* out, int level, const char* tag,
+                    const char* type, const char* text, gboolean checked);
+void guid_to_xml_text (GString* out, int level, const char* tag,
+                       const GncGUID* gid);
+void commodity_ref_to_xml_text (GString* out, int level, const char* tag,
+                                const gnc_commodity* c);
+void timespec_to_xml_text (GString* out, int level, const char* tag,
+                           const char* type, const Timespec* spec);
+void gdate_to_xml_text (GString* out, int level, const char* tag,
+                        const char* type, const GDate* date);
+void gnc_numeric_to_xml_text (GString* out, int level, const char* tag,
+                              const gnc_numeric* num);
+void qof_instance_slots_to_xml_text (GString* out, int level,
+                                     const char* tag,
+                                     const QofInstance* inst);
+
 #endif /* _SIXTP_DOM_GENERATORS_H_ */
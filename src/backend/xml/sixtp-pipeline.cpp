@@ -0,0 +1,609 @@
+/********************************************************************
+ * sixtp-pipeline.cpp -- tokenize the elements of an XML stream on  *
+ *                       worker threads                             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+#include <stdio.h>
+}
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sixtp-pipeline.h"
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "gnc.backend.file.sixtp"
+
+/* How far the splitter may run ahead of the parser */
+static const size_t max_shards_per_thread = 64;
+static const size_t max_residual_bytes = 1024 * 1024;
+static const size_t read_size = 64 * 1024;
+
+static const char placeholder[] = "<" SIXTP_PIPELINE_PLACEHOLDER "/>";
+/* Each shard is parsed inside this element, which carries the namespace
+   declarations of the shard's ancestors. */
+static const char shard_root[] = "sixtp-shard-root";
+
+typedef enum
+{
+    SHARD_START,
+    SHARD_CHARACTERS,
+    SHARD_END,
+} shard_event_type;
+
+struct shard_event
+{
+    shard_event_type type;
+    const gchar* text; /* the tag, or the characters */
+    int length;        /* of the characters */
+    int attrs;         /* start of the attributes in shard::attrs, or -1 */
+};
+
+struct shard
+{
+    std::string text;
+    std::vector<shard_event> events;
+    std::vector<const gchar*> attrs; /* NULL terminated runs */
+    GStringChunk* strings;
+    bool done;
+    bool ok;
+};
+
+struct sixtp_pipeline
+{
+    FILE* fd;
+    std::string shard_tag;
+    std::string skip_tag;
+    size_t max_shards;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::string> residual; /* for libxml2, in order */
+    size_t residual_bytes;
+    std::deque<shard*> shards;        /* cut and not yet replayed */
+    std::deque<shard*> jobs;          /* not yet tokenized */
+    bool eof;
+    bool stop;
+
+    /* Only used by the parsing thread */
+    std::string reading;
+    size_t reading_pos;
+
+    std::thread splitter;
+    std::vector<std::thread> workers;
+};
+
+/************************************************************************/
+/* The workers: tokenize a shard into SAX events. */
+
+static void
+shard_start_element (void* user_data, const xmlChar* name,
+                     const xmlChar** attrs)
+{
+    auto s = static_cast<shard*> (user_data);
+    shard_event ev = { SHARD_START,
+                       g_string_chunk_insert_const (s->strings, (gchar*) name),
+                       0, -1
+                     };
+
+    if (attrs)
+    {
+        ev.attrs = s->attrs.size ();
+        for (auto attr = attrs; *attr; ++attr)
+            s->attrs.push_back (g_string_chunk_insert (s->strings,
+                                                       (gchar*) *attr));
+        s->attrs.push_back (NULL);
+    }
+    s->events.push_back (ev);
+}
+
+static void
+shard_characters (void* user_data, const xmlChar* text, int len)
+{
+    auto s = static_cast<shard*> (user_data);
+    shard_event ev = { SHARD_CHARACTERS,
+                       g_string_chunk_insert_len (s->strings, (gchar*) text,
+                                                  len),
+                       len, -1
+                     };
+    s->events.push_back (ev);
+}
+
+static void
+shard_end_element (void* user_data, const xmlChar* name)
+{
+    auto s = static_cast<shard*> (user_data);
+    shard_event ev = { SHARD_END,
+                       g_string_chunk_insert_const (s->strings, (gchar*) name),
+                       0, -1
+                     };
+    s->events.push_back (ev);
+}
+
+static void
+tokenize_shard (shard* s)
+{
+    xmlSAXHandler handler;
+
+    memset (&handler, 0, sizeof (handler));
+    handler.startElement = shard_start_element;
+    handler.endElement = shard_end_element;
+    handler.characters = shard_characters;
+    handler.getEntity = sixtp_sax_get_entity_handler;
+
+    s->strings = g_string_chunk_new (s->text.size () + 64);
+    s->ok = xmlSAXUserParseMemory (&handler, s, s->text.data (),
+                                   s->text.size ()) == 0;
+    /* The text isn't needed any more */
+    std::string ().swap (s->text);
+    /* Nor the events of the shard root. */
+    if (s->ok && s->events.size () >= 2)
+    {
+        s->events.pop_back ();
+        s->events.erase (s->events.begin ());
+    }
+}
+
+static void
+worker_func (sixtp_pipeline* pipeline)
+{
+    std::unique_lock<std::mutex> lock (pipeline->mutex);
+
+    while (true)
+    {
+        pipeline->changed.wait (lock, [pipeline]
+        {
+            return pipeline->stop || pipeline->eof || !pipeline->jobs.empty ();
+        });
+        if (pipeline->jobs.empty ())
+        {
+            if (pipeline->stop || pipeline->eof)
+                return;
+            continue;
+        }
+
+        auto s = pipeline->jobs.front ();
+        pipeline->jobs.pop_front ();
+        lock.unlock ();
+        tokenize_shard (s);
+        lock.lock ();
+        s->done = true;
+        pipeline->changed.notify_all ();
+    }
+}
+
+/************************************************************************/
+/* The splitter: cut the shards out of the stream. */
+
+/* Wait for room, then queue residual text, and the shard it ends with
+   if any.  FALSE if the pipeline is being stopped. */
+static bool
+queue_output (sixtp_pipeline* pipeline, std::string&& text, shard* s)
+{
+    std::unique_lock<std::mutex> lock (pipeline->mutex);
+
+    pipeline->changed.wait (lock, [pipeline]
+    {
+        return pipeline->stop ||
+               (pipeline->shards.size () < pipeline->max_shards &&
+                pipeline->residual_bytes < max_residual_bytes);
+    });
+    if (pipeline->stop)
+    {
+        delete s;
+        return false;
+    }
+
+    if (s)
+    {
+        pipeline->shards.push_back (s);
+        pipeline->jobs.push_back (s);
+        text.append (placeholder);
+    }
+    if (!text.empty ())
+    {
+        pipeline->residual_bytes += text.size ();
+        pipeline->residual.push_back (std::move (text));
+    }
+    pipeline->changed.notify_all ();
+    return true;
+}
+
+typedef enum
+{
+    CONSTRUCT_OTHER,
+    CONSTRUCT_START,
+    CONSTRUCT_END,
+    CONSTRUCT_EMPTY,
+    CONSTRUCT_NO_SHARDS,
+} construct_type;
+
+/* Find the end of the markup starting at buf[lt], a '<', and say what
+   it is; std::string::npos if it isn't complete yet. */
+static size_t
+scan_construct (const std::string& buf, size_t lt, bool at_eof,
+                construct_type* type, size_t* name, size_t* name_len)
+{
+    size_t end;
+
+    *type = CONSTRUCT_OTHER;
+    if (!at_eof && buf.size () - lt < 9)
+        return std::string::npos;
+
+    if (buf.compare (lt, 4, "<!--") == 0)
+        end = buf.find ("-->", lt + 4);
+    else if (buf.compare (lt, 9, "<![CDATA[") == 0)
+        end = buf.find ("]]>", lt + 9);
+    else if (buf.compare (lt, 2, "<!") == 0)
+    {
+        /* A DOCTYPE may declare entities the shards can't see. */
+        *type = CONSTRUCT_NO_SHARDS;
+        return buf.size ();
+    }
+    else if (buf.compare (lt, 2, "<?") == 0)
+    {
+        end = buf.find ("?>", lt + 2);
+        if (end != std::string::npos && buf.compare (lt, 5, "<?xml") == 0)
+        {
+            auto enc = buf.find ("encoding", lt);
+            if (enc < end)
+            {
+                auto decl = g_ascii_strdown (buf.c_str () + enc, end - enc);
+                if (!strstr (decl, "utf-8"))
+                    *type = CONSTRUCT_NO_SHARDS;
+                g_free (decl);
+            }
+        }
+    }
+    else
+    {
+        size_t i = lt + 1;
+        char quote = 0;
+
+        *type = CONSTRUCT_START;
+        if (i < buf.size () && buf[i] == '/')
+        {
+            *type = CONSTRUCT_END;
+            ++i;
+        }
+        *name = i;
+        while (i < buf.size () && !g_ascii_isspace (buf[i]) &&
+               buf[i] != '/' && buf[i] != '>')
+            ++i;
+        *name_len = i - *name;
+        /* Attribute values may hold a '>' */
+        for (; i < buf.size (); ++i)
+        {
+            if (quote)
+            {
+                if (buf[i] == quote)
+                    quote = 0;
+            }
+            else if (buf[i] == '"' || buf[i] == '\'')
+                quote = buf[i];
+            else if (buf[i] == '>')
+                break;
+        }
+        if (i == buf.size ())
+            return std::string::npos;
+        if (*type == CONSTRUCT_START && buf[i - 1] == '/')
+            *type = CONSTRUCT_EMPTY;
+        return i + 1;
+    }
+
+    if (end == std::string::npos)
+        return end;
+    return buf.find ('>', end) + 1;
+}
+
+static bool
+is_tag (const std::string& buf, size_t name, size_t name_len,
+        const std::string& tag)
+{
+    return name_len == tag.size () && buf.compare (name, name_len, tag) == 0;
+}
+
+/* The xmlns attributes of the start tag buf[attrs, end), each preceded
+   by a space. */
+static std::string
+namespace_decls (const std::string& buf, size_t attrs, size_t end)
+{
+    std::string decls;
+    size_t i = attrs;
+
+    while (i < end)
+    {
+        while (i < end && g_ascii_isspace (buf[i]))
+            ++i;
+        auto attr = i;
+        while (i < end && buf[i] != '=' && buf[i] != '>' &&
+               buf[i] != '/' && !g_ascii_isspace (buf[i]))
+            ++i;
+        auto attr_len = i - attr;
+        while (i < end && g_ascii_isspace (buf[i]))
+            ++i;
+        if (i == end || buf[i] != '=')
+        {
+            ++i;
+            continue;
+        }
+        ++i;
+        while (i < end && g_ascii_isspace (buf[i]))
+            ++i;
+        if (i == end || (buf[i] != '"' && buf[i] != '\''))
+            continue;
+        auto value_end = buf.find (buf[i], i + 1);
+        if (value_end == std::string::npos || value_end >= end)
+            break;
+        i = value_end + 1;
+        if (buf.compare (attr, 5, "xmlns") == 0 &&
+            (attr_len == 5 || buf[attr + 5] == ':'))
+            decls.append (" ").append (buf, attr, i - attr);
+    }
+    return decls;
+}
+
+static void
+splitter_func (sixtp_pipeline* pipeline)
+{
+    std::string buf;
+    std::vector<char> chunk (read_size);
+    size_t pos = 0;          /* scanned up to here */
+    size_t out = 0;          /* residual text not yet queued from here */
+    size_t shard_start = 0;  /* of the shard being cut */
+    bool in_shard = false;
+    bool sharding = true;
+    int skip_depth = 0;
+    bool at_eof = false;
+    /* The namespace declarations of the open elements around the shards,
+       and those in scope at the start of the shard being cut */
+    std::vector<std::string> open_decls;
+    std::string shard_decls;
+
+    while (!at_eof)
+    {
+        auto bytes = fread (chunk.data (), 1, chunk.size (), pipeline->fd);
+        if (bytes > 0)
+            buf.append (chunk.data (), bytes);
+        else
+            at_eof = true;
+
+        while (sharding)
+        {
+            construct_type type;
+            size_t name = 0, name_len = 0;
+            auto lt = buf.find ('<', pos);
+
+            if (lt == std::string::npos)
+            {
+                pos = buf.size ();
+                break;
+            }
+            auto end = scan_construct (buf, lt, at_eof, &type, &name,
+                                       &name_len);
+            if (end == std::string::npos)
+            {
+                pos = lt;
+                break;
+            }
+
+            if (type == CONSTRUCT_NO_SHARDS)
+            {
+                sharding = false;
+            }
+            else if (in_shard)
+            {
+                if (type == CONSTRUCT_END &&
+                    is_tag (buf, name, name_len, pipeline->shard_tag))
+                {
+                    auto s = new shard ();
+                    s->text = std::string ("<") + shard_root + shard_decls +
+                              ">";
+                    s->text.append (buf, shard_start, end - shard_start);
+                    s->text.append ("</").append (shard_root).append (">");
+                    in_shard = false;
+                    out = end;
+                    if (!queue_output (pipeline, std::string (), s))
+                        return;
+                }
+            }
+            else if (type == CONSTRUCT_START && skip_depth == 0 &&
+                     is_tag (buf, name, name_len, pipeline->shard_tag))
+            {
+                if (!queue_output (pipeline, buf.substr (out, lt - out), NULL))
+                    return;
+                shard_start = out = lt;
+                in_shard = true;
+                shard_decls.clear ();
+                for (const auto& decls : open_decls)
+                    shard_decls.append (decls);
+            }
+            else
+            {
+                if (is_tag (buf, name, name_len, pipeline->skip_tag))
+                {
+                    if (type == CONSTRUCT_START)
+                        ++skip_depth;
+                    else if (type == CONSTRUCT_END && skip_depth > 0)
+                        --skip_depth;
+                }
+                if (type == CONSTRUCT_START)
+                    open_decls.push_back (namespace_decls (buf,
+                                                           name + name_len,
+                                                           end));
+                else if (type == CONSTRUCT_END && !open_decls.empty ())
+                    open_decls.pop_back ();
+            }
+            pos = end;
+        }
+
+        /* Pass on what has been scanned, or everything at the end, when
+           an unfinished shard is left to libxml2 to complain about. */
+        if (!sharding || at_eof)
+        {
+            pos = buf.size ();
+            in_shard = false;
+        }
+        if (!in_shard)
+        {
+            if (!queue_output (pipeline, buf.substr (out, pos - out), NULL))
+                return;
+            out = pos;
+        }
+        buf.erase (0, out);
+        pos -= out;
+        shard_start -= MIN (shard_start, out);
+        out = 0;
+    }
+
+    std::lock_guard<std::mutex> lock (pipeline->mutex);
+    pipeline->eof = true;
+    pipeline->changed.notify_all ();
+}
+
+/************************************************************************/
+
+sixtp_pipeline*
+sixtp_pipeline_new (FILE* fd, const char* shard_tag, const char* skip_tag,
+                    guint n_threads)
+{
+    auto pipeline = new sixtp_pipeline ();
+
+    /* libxml2 must be set up before it is used from several threads. */
+    xmlInitParser ();
+
+    pipeline->fd = fd;
+    pipeline->shard_tag = shard_tag;
+    pipeline->skip_tag = skip_tag ? skip_tag : "";
+    pipeline->max_shards = max_shards_per_thread * MAX (n_threads, 1);
+    pipeline->residual_bytes = 0;
+    pipeline->eof = false;
+    pipeline->stop = false;
+    pipeline->reading_pos = 0;
+
+    pipeline->splitter = std::thread (splitter_func, pipeline);
+    for (guint i = 0; i < MAX (n_threads, 1); ++i)
+        pipeline->workers.push_back (std::thread (worker_func, pipeline));
+    return pipeline;
+}
+
+void
+sixtp_pipeline_free (sixtp_pipeline* pipeline)
+{
+    {
+        std::lock_guard<std::mutex> lock (pipeline->mutex);
+        pipeline->stop = true;
+        pipeline->changed.notify_all ();
+    }
+    pipeline->splitter.join ();
+    for (auto& worker : pipeline->workers)
+        worker.join ();
+
+    for (auto s : pipeline->shards)
+    {
+        if (s->strings)
+            g_string_chunk_free (s->strings);
+        delete s;
+    }
+    delete pipeline;
+}
+
+int
+sixtp_pipeline_read (void* context, char* buffer, int len)
+{
+    auto pipeline = static_cast<sixtp_pipeline*> (context);
+
+    if (pipeline->reading_pos == pipeline->reading.size ())
+    {
+        std::unique_lock<std::mutex> lock (pipeline->mutex);
+        pipeline->changed.wait (lock, [pipeline]
+        {
+            return pipeline->eof || !pipeline->residual.empty ();
+        });
+        if (pipeline->residual.empty ())
+            return 0;
+
+        pipeline->reading = std::move (pipeline->residual.front ());
+        pipeline->residual.pop_front ();
+        pipeline->residual_bytes -= pipeline->reading.size ();
+        pipeline->reading_pos = 0;
+        pipeline->changed.notify_all ();
+    }
+
+    auto bytes = MIN ((size_t) len,
+                      pipeline->reading.size () - pipeline->reading_pos);
+    memcpy (buffer, pipeline->reading.data () + pipeline->reading_pos, bytes);
+    pipeline->reading_pos += bytes;
+    return bytes;
+}
+
+gboolean
+sixtp_pipeline_replay (sixtp_pipeline* pipeline, sixtp_sax_data* pdata)
+{
+    shard* s;
+
+    {
+        std::unique_lock<std::mutex> lock (pipeline->mutex);
+        if (pipeline->shards.empty ())
+        {
+            g_warning ("Unexpected <%s> element", SIXTP_PIPELINE_PLACEHOLDER);
+            return FALSE;
+        }
+        s = pipeline->shards.front ();
+        pipeline->changed.wait (lock, [s] { return s->done; });
+        pipeline->shards.pop_front ();
+        pipeline->changed.notify_all ();
+    }
+
+    for (auto& ev : s->events)
+    {
+        switch (ev.type)
+        {
+        case SHARD_START:
+            sixtp_sax_start_handler (pdata, (xmlChar*) ev.text,
+                                     ev.attrs < 0 ? NULL :
+                                     (const xmlChar**) &s->attrs[ev.attrs]);
+            break;
+        case SHARD_CHARACTERS:
+            sixtp_sax_characters_handler (pdata, (xmlChar*) ev.text,
+                                          ev.length);
+            break;
+        case SHARD_END:
+            sixtp_sax_end_handler (pdata, (xmlChar*) ev.text);
+            break;
+        }
+    }
+
+    auto ok = s->ok;
+    g_string_chunk_free (s->strings);
+    delete s;
+    return ok;
+}
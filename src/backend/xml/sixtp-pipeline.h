@@ -0,0 +1,68 @@
+/********************************************************************
+ * sixtp-pipeline.h -- tokenize the elements of an XML stream on    *
+ *                     worker threads                               *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef SIXTP_PIPELINE_H
+#define SIXTP_PIPELINE_H
+extern "C"
+{
+#include <glib.h>
+#include <stdio.h>
+}
+
+#include "sixtp.h"
+
+/* A pipeline splits the XML stream read from a file into shards, the
+   elements with the shard tag that are not inside an element with the
+   skip tag, and the rest of the document.  A splitter thread cuts the
+   shards out of the stream and hands them to worker threads, which
+   tokenize them into lists of SAX events, each inside an element
+   declaring the namespaces in scope where it was cut; in the rest of
+   the document, read by libxml2 through sixtp_pipeline_read(), each
+   shard is replaced by an empty placeholder element.  When the parser meets a
+   placeholder, sixtp_pipeline_replay() waits for that shard's events
+   and feeds them to the sixtp handlers, so the objects are built and
+   added to the book in file order on the parsing thread, exactly as
+   they would be by sixtp_parse_fd().
+
+   Sharding is switched off for documents with a DOCTYPE (whose
+   entities the shards could not see) or a declared encoding other than
+   UTF-8. */
+
+#define SIXTP_PIPELINE_PLACEHOLDER "sixtp:shard"
+
+sixtp_pipeline* sixtp_pipeline_new (FILE* fd, const char* shard_tag,
+                                    const char* skip_tag, guint n_threads);
+
+/* Stop the threads and free the pipeline.  The file is not closed. */
+void sixtp_pipeline_free (sixtp_pipeline* pipeline);
+
+/* The libxml2 input callback, reading the document with the shards
+   replaced by placeholders. */
+int sixtp_pipeline_read (void* pipeline, char* buffer, int len);
+
+/* Feed the next shard's events to the parser; FALSE if the shard was
+   not well formed. */
+gboolean sixtp_pipeline_replay (sixtp_pipeline* pipeline,
+                                sixtp_sax_data* pdata);
+
+#endif /* SIXTP_PIPELINE_H */
@@ -0,0 +1,738 @@
+/********************************************************************
+ * sixtp-stream-parsers.cpp                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gnc-engine.h>
+}
+
+#include "sixtp-utils.h"
+#include "sixtp-stream-parsers.h"
+#include <kvp_frame.hpp>
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+static gboolean use_stream_parsers = TRUE;
+
+gboolean
+sixtp_use_stream_parsers (void)
+{
+    return use_stream_parsers;
+}
+
+void
+sixtp_set_use_stream_parsers (gboolean use)
+{
+    use_stream_parsers = use;
+}
+
+sixtp*
+sixtp_stream_parser_new (sixtp_start_handler starter,
+                         const sixtp_stream_handlers* stream,
+                         sixtp_end_handler ender,
+                         sixtp_fail_handler failer,
+                         sixtp_result_handler cleanup_result_func)
+{
+    sixtp* parser;
+
+    g_return_val_if_fail (stream, NULL);
+
+    if (! (parser = sixtp_set_any (sixtp_new (), FALSE,
+                                   SIXTP_START_HANDLER_ID, starter,
+                                   SIXTP_END_HANDLER_ID, ender,
+                                   SIXTP_FAIL_HANDLER_ID, failer,
+                                   SIXTP_NO_MORE_HANDLERS)))
+    {
+        return NULL;
+    }
+
+    sixtp_set_stream (parser, stream);
+    if (cleanup_result_func)
+    {
+        sixtp_set_cleanup_result (parser, cleanup_result_func);
+        sixtp_set_result_fail (parser, cleanup_result_func);
+    }
+
+    if (!sixtp_add_sub_parser (parser, SIXTP_MAGIC_CATCHER, parser))
+    {
+        sixtp_destroy (parser);
+        return NULL;
+    }
+
+    return parser;
+}
+
+/***********************************************************************/
+
+/* What an open element inside an object is.  Each has an entry on the
+   reader's stack of levels, the object's child (the field) at the
+   bottom. */
+typedef enum
+{
+    STREAM_IGNORE,      /* contents don't matter */
+    STREAM_FIELD,       /* a child of the object */
+    STREAM_LEAF,        /* text part of a value: <ts:date>, <slot:key>... */
+    STREAM_SLOT,        /* <slot> */
+    STREAM_SLOT_VALUE,  /* <slot:value> of a non-container type */
+    STREAM_SLOT_FRAME,  /* <slot:value type="frame"> */
+    STREAM_SLOT_LIST,   /* <slot:value type="list"> */
+} stream_level_kind;
+
+typedef enum
+{
+    SLOT_UNKNOWN,
+    SLOT_INTEGER,
+    SLOT_DOUBLE,
+    SLOT_NUMERIC,
+    SLOT_STRING,
+    SLOT_GUID,
+    SLOT_TIMESPEC,
+    SLOT_GDATE,
+} stream_slot_type;
+
+typedef struct
+{
+    stream_level_kind kind;
+    stream_slot_type slot_type;
+
+    /* STREAM_FIELD of SIXTP_STREAM_SLOTS and STREAM_SLOT_FRAME */
+    KvpFrame* frame;
+    /* STREAM_SLOT_LIST */
+    GList* list;
+    /* STREAM_SLOT */
+    gchar* key;
+    KvpValue* value;
+
+    /* the values with parts: timespecs, dates and commodity refs */
+    Timespec ts;
+    gboolean seen_s;
+    gboolean seen_ns;
+    GDate date;
+    gboolean seen_date;
+    gchar* space;
+    gchar* id;
+    gboolean failed;
+} stream_level;
+
+struct sixtp_stream_reader
+{
+    const struct sixtp_stream_field* fields;
+    const struct sixtp_stream_field* field;
+    guint64 gotten;
+    gpointer data;
+    QofInstance* inst;
+
+    /* Text of the innermost element whose text matters; only one is
+       ever open, a value's text children being read one at a time. */
+    GString* text;
+    gboolean guid_ok;
+    GArray* levels;
+};
+
+static inline stream_level*
+reader_level (sixtp_stream_reader* reader, guint depth)
+{
+    return &g_array_index (reader->levels, stream_level, depth);
+}
+
+static inline stream_level*
+reader_top (sixtp_stream_reader* reader)
+{
+    return reader_level (reader, reader->levels->len - 1);
+}
+
+static stream_level*
+reader_push (sixtp_stream_reader* reader, stream_level_kind kind)
+{
+    stream_level* level;
+
+    g_array_set_size (reader->levels, reader->levels->len + 1);
+    level = reader_top (reader);
+    memset (level, 0, sizeof (stream_level));
+    level->kind = kind;
+    return level;
+}
+
+static void
+level_clear (stream_level* level)
+{
+    if (level->kind == STREAM_SLOT_FRAME)
+        delete level->frame;
+    for (GList* node = level->list; node; node = node->next)
+        delete static_cast<KvpValue*> (node->data);
+    g_list_free (level->list);
+    delete level->value;
+    g_free (level->key);
+    g_free (level->space);
+    g_free (level->id);
+    memset (level, 0, sizeof (stream_level));
+}
+
+static void
+reader_pop (sixtp_stream_reader* reader)
+{
+    level_clear (reader_top (reader));
+    g_array_set_size (reader->levels, reader->levels->len - 1);
+}
+
+sixtp_stream_reader*
+sixtp_stream_reader_new (const struct sixtp_stream_field* fields)
+{
+    sixtp_stream_reader* reader = g_new0 (sixtp_stream_reader, 1);
+    guint n = 0;
+
+    for (const struct sixtp_stream_field* f = fields; f->tag; f++)
+        n++;
+    g_return_val_if_fail (n <= 64, NULL);
+
+    reader->fields = fields;
+    reader->text = g_string_sized_new (64);
+    reader->levels = g_array_sized_new (FALSE, TRUE, sizeof (stream_level), 8);
+    return reader;
+}
+
+void
+sixtp_stream_reader_reset (sixtp_stream_reader* reader, gpointer data,
+                           QofInstance* inst)
+{
+    while (reader->levels->len)
+        reader_pop (reader);
+    reader->field = NULL;
+    reader->gotten = 0;
+    reader->data = data;
+    reader->inst = inst;
+}
+
+void
+sixtp_stream_reader_free (sixtp_stream_reader* reader)
+{
+    if (!reader) return;
+    sixtp_stream_reader_reset (reader, NULL, NULL);
+    g_string_free (reader->text, TRUE);
+    g_array_free (reader->levels, TRUE);
+    g_free (reader);
+}
+
+gboolean
+sixtp_stream_reader_busy (const sixtp_stream_reader* reader)
+{
+    return reader->levels->len > 0;
+}
+
+static const gchar*
+find_attr (gchar** attrs, const gchar* name)
+{
+    for (; attrs && attrs[0]; attrs += 2)
+        if (g_strcmp0 (attrs[0], name) == 0)
+            return attrs[1];
+    return NULL;
+}
+
+/* dom_tree_to_guid checks the attribute before reading the text. */
+static gboolean
+guid_attrs_ok (gchar** attrs)
+{
+    if (!attrs || !attrs[0])
+        return FALSE;
+    if (strcmp (attrs[0], "type") != 0)
+    {
+        PERR ("Unknown attribute for id tag: %s", attrs[0]);
+        return FALSE;
+    }
+    if (g_strcmp0 (attrs[1], "guid") != 0 && g_strcmp0 (attrs[1], "new") != 0)
+    {
+        PERR ("Unknown type %s for attribute type for tag type",
+              attrs[1] ? attrs[1] : "(null)");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+push_leaf (sixtp_stream_reader* reader)
+{
+    reader_push (reader, STREAM_LEAF);
+    g_string_truncate (reader->text, 0);
+}
+
+static void
+push_slot_value (sixtp_stream_reader* reader, gchar** attrs)
+{
+    static const struct
+    {
+        const char* tag;
+        stream_slot_type type;
+    } slot_types[] =
+    {
+        { "integer", SLOT_INTEGER },
+        { "double", SLOT_DOUBLE },
+        { "numeric", SLOT_NUMERIC },
+        { "string", SLOT_STRING },
+        { "guid", SLOT_GUID },
+        { "timespec", SLOT_TIMESPEC },
+        { "gdate", SLOT_GDATE },
+    };
+    const gchar* type = find_attr (attrs, "type");
+    stream_level* level;
+
+    if (g_strcmp0 (type, "frame") == 0)
+    {
+        level = reader_push (reader, STREAM_SLOT_FRAME);
+        level->frame = new KvpFrame;
+        return;
+    }
+    if (g_strcmp0 (type, "list") == 0)
+    {
+        reader_push (reader, STREAM_SLOT_LIST);
+        return;
+    }
+
+    level = reader_push (reader, STREAM_SLOT_VALUE);
+    for (guint i = 0; i < G_N_ELEMENTS (slot_types); i++)
+        if (g_strcmp0 (type, slot_types[i].tag) == 0)
+            level->slot_type = slot_types[i].type;
+    g_string_truncate (reader->text, 0);
+}
+
+gboolean
+sixtp_stream_reader_start (sixtp_stream_reader* reader, const gchar* tag,
+                           gchar** attrs)
+{
+    stream_level* top;
+
+    if (!reader->levels->len)
+    {
+        for (reader->field = reader->fields; reader->field->tag; reader->field++)
+            if (g_strcmp0 (tag, reader->field->tag) == 0)
+                break;
+        if (!reader->field->tag)
+        {
+            reader->field = NULL;
+            reader_push (reader, STREAM_IGNORE);
+            return FALSE;
+        }
+
+        top = reader_push (reader, STREAM_FIELD);
+        if (reader->field->type == SIXTP_STREAM_SLOTS)
+            top->frame = qof_instance_get_slots (reader->inst);
+        if (reader->field->type == SIXTP_STREAM_GUID)
+            reader->guid_ok = guid_attrs_ok (attrs);
+        g_string_truncate (reader->text, 0);
+        return TRUE;
+    }
+
+    top = reader_top (reader);
+    switch (top->kind)
+    {
+    case STREAM_FIELD:
+        switch (reader->field->type)
+        {
+        case SIXTP_STREAM_TIMESPEC:
+            if (g_strcmp0 (tag, "ts:date") == 0 || g_strcmp0 (tag, "ts:ns") == 0)
+            {
+                push_leaf (reader);
+                return TRUE;
+            }
+            break;
+        case SIXTP_STREAM_COMMODITY:
+            if (g_strcmp0 (tag, "cmdty:space") == 0 ||
+                g_strcmp0 (tag, "cmdty:id") == 0)
+            {
+                push_leaf (reader);
+                return TRUE;
+            }
+            break;
+        case SIXTP_STREAM_SLOTS:
+            if (g_strcmp0 (tag, "slot") == 0)
+            {
+                reader_push (reader, STREAM_SLOT);
+                return TRUE;
+            }
+            break;
+        default:
+            break;
+        }
+        break;
+    case STREAM_SLOT_FRAME:
+        if (g_strcmp0 (tag, "slot") == 0)
+        {
+            reader_push (reader, STREAM_SLOT);
+            return TRUE;
+        }
+        break;
+    case STREAM_SLOT:
+        if (g_strcmp0 (tag, "slot:key") == 0)
+        {
+            push_leaf (reader);
+            return TRUE;
+        }
+        if (g_strcmp0 (tag, "slot:value") == 0)
+        {
+            push_slot_value (reader, attrs);
+            return TRUE;
+        }
+        break;
+    case STREAM_SLOT_LIST:
+        /* like dom_tree_to_list_kvp_value, take any element */
+        push_slot_value (reader, attrs);
+        return TRUE;
+    case STREAM_SLOT_VALUE:
+        if ((top->slot_type == SLOT_TIMESPEC &&
+             (g_strcmp0 (tag, "ts:date") == 0 || g_strcmp0 (tag, "ts:ns") == 0)) ||
+            (top->slot_type == SLOT_GDATE && g_strcmp0 (tag, "gdate") == 0))
+        {
+            push_leaf (reader);
+            return TRUE;
+        }
+        break;
+    default:
+        break;
+    }
+
+    reader_push (reader, STREAM_IGNORE);
+    return TRUE;
+}
+
+void
+sixtp_stream_reader_characters (sixtp_stream_reader* reader, const char* text,
+                                int length)
+{
+    stream_level* top;
+
+    if (!reader->levels->len)
+        return;
+
+    top = reader_top (reader);
+    switch (top->kind)
+    {
+    case STREAM_FIELD:
+        if (reader->field->type != SIXTP_STREAM_TEXT &&
+            reader->field->type != SIXTP_STREAM_GUID)
+            return;
+        break;
+    case STREAM_LEAF:
+    case STREAM_SLOT_VALUE:
+        break;
+    default:
+        return;
+    }
+    g_string_append_len (reader->text, text, length);
+}
+
+/* A text part closed; store it in the value it belongs to, with the
+   checks of dom_tree_to_timespec, dom_tree_to_gdate and
+   dom_tree_to_commodity_ref_no_engine. */
+static void
+end_leaf (sixtp_stream_reader* reader, const gchar* tag)
+{
+    stream_level* parent = reader_level (reader, reader->levels->len - 2);
+    const gchar* text = reader->text->str;
+
+    if (g_strcmp0 (tag, "slot:key") == 0)
+    {
+        g_free (parent->key);
+        parent->key = g_strdup (text);
+    }
+    else if (g_strcmp0 (tag, "ts:date") == 0)
+    {
+        if (parent->seen_s || !string_to_timespec_secs (text, &parent->ts))
+            parent->failed = TRUE;
+        parent->seen_s = TRUE;
+    }
+    else if (g_strcmp0 (tag, "ts:ns") == 0)
+    {
+        if (parent->seen_ns || !string_to_timespec_nsecs (text, &parent->ts))
+            parent->failed = TRUE;
+        parent->seen_ns = TRUE;
+    }
+    else if (g_strcmp0 (tag, "gdate") == 0)
+    {
+        gint year, month, day;
+
+        if (parent->seen_date ||
+            sscanf (text, "%d-%d-%d", &year, &month, &day) != 3)
+        {
+            parent->failed = TRUE;
+        }
+        else
+        {
+            g_date_clear (&parent->date, 1);
+            g_date_set_dmy (&parent->date, day, static_cast<GDateMonth> (month),
+                            year);
+            if (!g_date_valid (&parent->date))
+            {
+                PWARN ("invalid date");
+                parent->failed = TRUE;
+            }
+        }
+        parent->seen_date = TRUE;
+    }
+    else if (g_strcmp0 (tag, "cmdty:space") == 0)
+    {
+        if (parent->space)
+            parent->failed = TRUE;
+        else
+            parent->space = g_strdup (text);
+    }
+    else if (g_strcmp0 (tag, "cmdty:id") == 0)
+    {
+        if (parent->id)
+            parent->failed = TRUE;
+        else
+            parent->id = g_strdup (text);
+    }
+}
+
+static Timespec
+level_timespec (stream_level* level)
+{
+    Timespec ts = level->ts;
+
+    if (level->failed || !level->seen_s)
+    {
+        if (!level->failed)
+            PERR ("no ts:date node found.");
+        ts.tv_sec = 0;
+        ts.tv_nsec = 0;
+    }
+    return ts;
+}
+
+/* Builds the value of a closed <slot:value> the way
+   dom_tree_to_kvp_value does, taking the containers' contents. */
+static KvpValue*
+take_slot_value (sixtp_stream_reader* reader, stream_level* level)
+{
+    const gchar* text = reader->text->str;
+
+    switch (level->kind)
+    {
+    case STREAM_SLOT_FRAME:
+    {
+        auto frame = level->frame;
+        level->frame = NULL;
+        return new KvpValue {frame};
+    }
+    case STREAM_SLOT_LIST:
+    {
+        auto list = level->list;
+        level->list = NULL;
+        return new KvpValue {list};
+    }
+    default:
+        break;
+    }
+
+    switch (level->slot_type)
+    {
+    case SLOT_INTEGER:
+    {
+        gint64 daint;
+        if (string_to_gint64 (text, &daint))
+            return new KvpValue {daint};
+        break;
+    }
+    case SLOT_DOUBLE:
+    {
+        double dadoub;
+        if (string_to_double (text, &dadoub))
+            return new KvpValue {dadoub};
+        break;
+    }
+    case SLOT_NUMERIC:
+    {
+        gnc_numeric danum;
+        if (string_to_gnc_numeric (text, &danum))
+            return new KvpValue {danum};
+        break;
+    }
+    case SLOT_STRING:
+    {
+        gchar* datext = g_strdup (text);
+        return new KvpValue {datext};
+    }
+    case SLOT_GUID:
+    {
+        auto daguid = guid_new ();
+        string_to_guid (text, daguid);
+        return new KvpValue {daguid};
+    }
+    case SLOT_TIMESPEC:
+        return new KvpValue {level_timespec (level)};
+    case SLOT_GDATE:
+        if (level->seen_date && !level->failed)
+            return new KvpValue {level->date};
+        PWARN ("no valid gdate node found.");
+        break;
+    default:
+        break;
+    }
+    return NULL;
+}
+
+gboolean
+sixtp_stream_reader_end (sixtp_stream_reader* reader, const gchar* tag)
+{
+    stream_level* top;
+    stream_level* parent;
+    gboolean ok = TRUE;
+
+    g_return_val_if_fail (reader->levels->len, FALSE);
+
+    top = reader_top (reader);
+    parent = reader->levels->len > 1 ?
+             reader_level (reader, reader->levels->len - 2) : NULL;
+
+    switch (top->kind)
+    {
+    case STREAM_LEAF:
+        end_leaf (reader, tag);
+        break;
+
+    case STREAM_SLOT_VALUE:
+    case STREAM_SLOT_FRAME:
+    case STREAM_SLOT_LIST:
+    {
+        KvpValue* value = take_slot_value (reader, top);
+
+        if (!value)
+            break;
+        if (parent->kind == STREAM_SLOT_LIST)
+        {
+            parent->list = g_list_append (parent->list, value);
+        }
+        else
+        {
+            delete parent->value;
+            parent->value = value;
+        }
+        break;
+    }
+
+    case STREAM_SLOT:
+        if (top->key && top->value)
+        {
+            //We're deleting the old KvpValue returned by replace_nc().
+            delete parent->frame->set (top->key, top->value);
+            top->value = NULL;
+        }
+        break;
+
+    case STREAM_FIELD:
+        if (reader->field->handler)
+            ok = reader->field->handler (reader, reader->data);
+        reader->gotten |= G_GUINT64_CONSTANT (1) << (reader->field - reader->fields);
+        reader->field = NULL;
+        break;
+
+    default:
+        break;
+    }
+
+    reader_pop (reader);
+    return ok;
+}
+
+gboolean
+sixtp_stream_reader_all_gotten (sixtp_stream_reader* reader)
+{
+    gboolean ret = TRUE;
+    guint i = 0;
+
+    for (const struct sixtp_stream_field* f = reader->fields; f->tag; f++, i++)
+    {
+        if (f->required && !(reader->gotten & (G_GUINT64_CONSTANT (1) << i)))
+        {
+            PERR ("Not defined and it should be: %s", f->tag);
+            ret = FALSE;
+        }
+    }
+    return ret;
+}
+
+/***********************************************************************/
+
+const gchar*
+sixtp_stream_field_tag (sixtp_stream_reader* reader)
+{
+    return reader->field ? reader->field->tag : NULL;
+}
+
+const gchar*
+sixtp_stream_to_text (sixtp_stream_reader* reader)
+{
+    return reader->text->str;
+}
+
+gboolean
+sixtp_stream_to_guid (sixtp_stream_reader* reader, GncGUID* guid)
+{
+    if (!reader->guid_ok)
+        return FALSE;
+
+    /* like dom_tree_to_guid, a bad string leaves a new guid */
+    *guid = guid_new_return ();
+    string_to_guid (reader->text->str, guid);
+    return TRUE;
+}
+
+gboolean
+sixtp_stream_to_gnc_numeric (sixtp_stream_reader* reader, gnc_numeric* num)
+{
+    return string_to_gnc_numeric (reader->text->str, num);
+}
+
+Timespec
+sixtp_stream_to_timespec (sixtp_stream_reader* reader)
+{
+    return level_timespec (reader_level (reader, 0));
+}
+
+gnc_commodity*
+sixtp_stream_to_commodity_ref (sixtp_stream_reader* reader, QofBook* book)
+{
+    stream_level* level = reader_level (reader, 0);
+    gnc_commodity_table* table;
+    gnc_commodity* ret;
+
+    if (level->failed || !level->space || !level->id)
+        return NULL;
+
+    table = gnc_commodity_table_get_table (book);
+    g_return_val_if_fail (table != NULL, NULL);
+
+    /* The lookup maps the namespace as dom_tree_to_commodity_ref's
+       throwaway commodity would, without creating one. */
+    g_strstrip (level->space);
+    g_strstrip (level->id);
+    ret = gnc_commodity_table_lookup (table, level->space, level->id);
+
+    g_return_val_if_fail (ret != NULL, NULL);
+
+    return ret;
+}
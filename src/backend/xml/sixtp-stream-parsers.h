@@ -0,0 +1,123 @@
+/********************************************************************
+ * sixtp-stream-parsers.h                                           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef SIXTP_STREAM_PARSERS_H
+#define SIXTP_STREAM_PARSERS_H
+extern "C"
+{
+#include <glib.h>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include "sixtp.h"
+
+/* The stream parsers fill an engine object straight from the SAX
+   events of its element, where a DOM parser (see sixtp-parsers.h)
+   first builds an xmlNode tree of the element and then walks it with
+   the dom_tree_* converters.  The readers below give the object
+   parsers the same field values the converters would, and are fed the
+   events through the sixtp_stream_handlers of the object's parser.
+
+   The high volume objects (transactions and their splits, prices and
+   the slots of those) are read this way unless
+   sixtp_set_use_stream_parsers (FALSE) has been called.
+   test-xml-transaction reads each of its transactions with both
+   parsers and checks that they agree. */
+
+gboolean sixtp_use_stream_parsers (void);
+void sixtp_set_use_stream_parsers (gboolean use);
+
+/* Create a parser for an object read through the given stream
+   handlers.  Like a DOM parser it also works as the top level parser,
+   getting the document's element as its own child; the start and end
+   handlers are then called without a tag for the document and should
+   do nothing. */
+sixtp* sixtp_stream_parser_new (sixtp_start_handler starter,
+                                const sixtp_stream_handlers* stream,
+                                sixtp_end_handler ender,
+                                sixtp_fail_handler failer,
+                                sixtp_result_handler cleanup_result_func);
+
+/* How a field's element is read */
+typedef enum
+{
+    SIXTP_STREAM_TEXT,      /* <tag>text</tag> */
+    SIXTP_STREAM_GUID,      /* <tag type="guid">hex</tag> */
+    SIXTP_STREAM_TIMESPEC,  /* <tag><ts:date/><ts:ns/></tag> */
+    SIXTP_STREAM_COMMODITY, /* <tag><cmdty:space/><cmdty:id/></tag> */
+    SIXTP_STREAM_SLOTS,     /* <tag><slot/>...</tag>, into the instance */
+} sixtp_stream_type;
+
+typedef struct sixtp_stream_reader sixtp_stream_reader;
+
+/* Called when a field's closing tag is read, with the reader holding
+   its value; the return value is that of the DOM handler. */
+typedef gboolean (*sixtp_stream_field_handler) (sixtp_stream_reader* reader,
+                                                gpointer data);
+
+struct sixtp_stream_field
+{
+    const char* tag;
+    sixtp_stream_type type;
+    sixtp_stream_field_handler handler;
+    gboolean required;
+};
+
+/* A reader for the child elements of an object, dispatching them to a
+   table of fields ended by a NULL tag.  Reset it before each object:
+   data is passed to the handlers and inst receives the slots. */
+sixtp_stream_reader* sixtp_stream_reader_new (const struct sixtp_stream_field* fields);
+void sixtp_stream_reader_free (sixtp_stream_reader* reader);
+void sixtp_stream_reader_reset (sixtp_stream_reader* reader, gpointer data,
+                                QofInstance* inst);
+
+/* TRUE while inside one of the object's child elements. */
+gboolean sixtp_stream_reader_busy (const sixtp_stream_reader* reader);
+
+/* Feed the events of the object's children.  _start returns FALSE for
+   a child not in the table, whose subtree is then skipped; _end returns
+   FALSE if a field handler failed. */
+gboolean sixtp_stream_reader_start (sixtp_stream_reader* reader,
+                                    const gchar* tag, gchar** attrs);
+void sixtp_stream_reader_characters (sixtp_stream_reader* reader,
+                                     const char* text, int length);
+gboolean sixtp_stream_reader_end (sixtp_stream_reader* reader,
+                                  const gchar* tag);
+
+/* Check for the required fields after the object's end tag. */
+gboolean sixtp_stream_reader_all_gotten (sixtp_stream_reader* reader);
+
+/* The value of the field being handled, as its dom_tree_to_* converter
+   reads it. */
+const gchar* sixtp_stream_to_text (sixtp_stream_reader* reader);
+gboolean sixtp_stream_to_guid (sixtp_stream_reader* reader, GncGUID* guid);
+gboolean sixtp_stream_to_gnc_numeric (sixtp_stream_reader* reader,
+                                      gnc_numeric* num);
+Timespec sixtp_stream_to_timespec (sixtp_stream_reader* reader);
+gnc_commodity* sixtp_stream_to_commodity_ref (sixtp_stream_reader* reader,
+                                              QofBook* book);
+/* The field's tag, for messages */
+const gchar* sixtp_stream_field_tag (sixtp_stream_reader* reader);
+
+#endif /* SIXTP_STREAM_PARSERS_H */
@@ -40,6 +40,7 @@ extern "C"
 
 #include "sixtp.h"
 #include "sixtp-parsers.h"
+#include "sixtp-pipeline.h"
 #include "sixtp-stack.h"
 
 #undef G_LOG_DOMAIN
@@ -145,6 +146,12 @@ sixtp_set_chars_fail (sixtp* parser, sixtp_result_handler handler)
     parser->chars_fail_handler = handler;
 }
 
+void
+sixtp_set_stream (sixtp* parser, const sixtp_stream_handlers* handlers)
+{
+    parser->stream = handlers;
+}
+
 sixtp*
 sixtp_new (void)
 {
@@ -398,6 +405,26 @@ sixtp_sax_start_handler (void* user_data,
     current_frame = (sixtp_stack_frame*) pdata->stack->data;
     current_parser = current_frame->parser;
 
+    if (pdata->pipeline && pdata->stream_depth == 0 &&
+        g_strcmp0 ((gchar*) name, SIXTP_PIPELINE_PLACEHOLDER) == 0)
+    {
+        /* Parse the shard in its place; the placeholder is empty, so
+           its end comes next. */
+        pdata->parsing_ok &= sixtp_pipeline_replay (pdata->pipeline, pdata);
+        pdata->in_placeholder = TRUE;
+        return;
+    }
+
+    if (pdata->stream_depth > 0)
+    {
+        pdata->stream_depth++;
+        if (current_parser->stream->start)
+            pdata->parsing_ok &=
+                current_parser->stream->start (current_frame->data_for_children,
+                                               (gchar*) name, (gchar**) attrs);
+        return;
+    }
+
     /* Use an extended lookup so we can get *our* copy of the key.
        Since we've strduped it, we know its lifetime... */
     lookup_success =
@@ -467,6 +494,9 @@ sixtp_sax_start_handler (void* user_data,
                                         (gchar*) name,
                                         (gchar**)attrs);
     }
+
+    if (next_parser->stream)
+        pdata->stream_depth = 1;
 }
 
 void
@@ -476,6 +506,15 @@ sixtp_sax_characters_handler (void* user_data, const xmlChar* text, int len)
     sixtp_stack_frame* frame;
 
     frame = (sixtp_stack_frame*) pdata->stack->data;
+    if (pdata->stream_depth > 0)
+    {
+        if (frame->parser->stream->characters)
+            pdata->parsing_ok &=
+                frame->parser->stream->characters (frame->data_for_children,
+                                                   (gchar*) text, len);
+        return;
+    }
+
     if (frame->parser->characters_handler)
     {
         gpointer result = NULL;
@@ -513,9 +552,26 @@ sixtp_sax_end_handler (void* user_data, const xmlChar* name)
     sixtp_child_result* child_result_data = NULL;
     gchar* end_tag = NULL;
 
+    if (pdata->in_placeholder)
+    {
+        pdata->in_placeholder = FALSE;
+        return;
+    }
+
     current_frame = (sixtp_stack_frame*) pdata->stack->data;
     parent_frame = (sixtp_stack_frame*) pdata->stack->next->data;
 
+    if (pdata->stream_depth > 1)
+    {
+        pdata->stream_depth--;
+        if (current_frame->parser->stream->end)
+            pdata->parsing_ok &=
+                current_frame->parser->stream->end (current_frame->data_for_children,
+                                                    (gchar*) name);
+        return;
+    }
+    pdata->stream_depth = 0;
+
     /* time to make sure we got the right closing tag.  Is this really
        necessary? */
     if (g_strcmp0 (current_frame->tag, (gchar*) name) != 0)
@@ -697,6 +753,7 @@ gnc_bad_xml_end_handler (gpointer data_for_children,
 static gboolean
 sixtp_parse_file_common (sixtp* sixtp,
                          xmlParserCtxtPtr xml_context,
+                         sixtp_pipeline* pipeline,
                          gpointer data_for_top_level,
                          gpointer global_data,
                          gpointer* parse_result)
@@ -713,6 +770,7 @@ sixtp_parse_file_common (sixtp* sixtp,
     ctxt->data.saxParserCtxt = xml_context;
     ctxt->data.saxParserCtxt->sax = &ctxt->handler;
     ctxt->data.saxParserCtxt->userData = &ctxt->data;
+    ctxt->data.pipeline = pipeline;
     ctxt->data.bad_xml_parser = sixtp_dom_parser_new (gnc_bad_xml_end_handler,
                                                       NULL, NULL);
     parse_ret = xmlParseDocument (ctxt->data.saxParserCtxt);
@@ -762,7 +820,7 @@ sixtp_parse_file (sixtp* sixtp,
 #else
     context = xmlCreateFileParserCtxt (filename);
 #endif
-    ret = sixtp_parse_file_common (sixtp, context, data_for_top_level,
+    ret = sixtp_parse_file_common (sixtp, context, NULL, data_for_top_level,
                                    global_data, parse_result);
     return ret;
 }
@@ -790,11 +848,34 @@ sixtp_parse_fd (sixtp* sixtp,
     xmlParserCtxtPtr context = xmlCreateIOParserCtxt (NULL, NULL,
                                                       sixtp_parser_read, NULL /*no close */, fd,
                                                       XML_CHAR_ENCODING_NONE);
-    ret = sixtp_parse_file_common (sixtp, context, data_for_top_level,
+    ret = sixtp_parse_file_common (sixtp, context, NULL, data_for_top_level,
                                    global_data, parse_result);
     return ret;
 }
 
+gboolean
+sixtp_parse_fd_parallel (sixtp* sixtp,
+                         FILE* fd,
+                         const char* shard_tag,
+                         const char* skip_tag,
+                         guint n_threads,
+                         gpointer data_for_top_level,
+                         gpointer global_data,
+                         gpointer* parse_result)
+{
+    gboolean ret;
+    sixtp_pipeline* pipeline = sixtp_pipeline_new (fd, shard_tag, skip_tag,
+                                                   n_threads);
+    xmlParserCtxtPtr context = xmlCreateIOParserCtxt (NULL, NULL,
+                                                      sixtp_pipeline_read, NULL /*no close */, pipeline,
+                                                      XML_CHAR_ENCODING_NONE);
+    ret = sixtp_parse_file_common (sixtp, context, pipeline,
+                                   data_for_top_level, global_data,
+                                   parse_result);
+    sixtp_pipeline_free (pipeline);
+    return ret;
+}
+
 gboolean
 sixtp_parse_buffer (sixtp* sixtp,
                     char* bufp,
@@ -805,7 +886,7 @@ sixtp_parse_buffer (sixtp* sixtp,
 {
     gboolean ret;
     xmlParserCtxtPtr context = xmlCreateMemoryParserCtxt (bufp, bufsz);
-    ret = sixtp_parse_file_common (sixtp, context, data_for_top_level,
+    ret = sixtp_parse_file_common (sixtp, context, NULL, data_for_top_level,
                                    global_data, parse_result);
     return ret;
 }
@@ -126,6 +126,28 @@ typedef void (*sixtp_fail_handler) (gpointer data_for_children,
 typedef void (*sixtp_push_handler) (xmlParserCtxtPtr xml_context,
                                     gpointer user_data);
 
+/* Handlers for the elements nested in one whose parser streams (see
+   sixtp_set_stream).  They get the data_for_children left by the
+   parser's start handler; no stack frame is pushed for these elements,
+   so they never reach any other handler. */
+typedef gboolean (*sixtp_stream_start_handler) (gpointer data_for_children,
+                                                const gchar* tag,
+                                                gchar** attrs);
+
+typedef gboolean (*sixtp_stream_characters_handler) (gpointer data_for_children,
+                                                     const char* text,
+                                                     int length);
+
+typedef gboolean (*sixtp_stream_end_handler) (gpointer data_for_children,
+                                              const gchar* tag);
+
+typedef struct
+{
+    sixtp_stream_start_handler start;
+    sixtp_stream_characters_handler characters;
+    sixtp_stream_end_handler end;
+} sixtp_stream_handlers;
+
 typedef struct sixtp
 {
     /* If you change this, don't forget to modify all the copy/etc. functions */
@@ -149,6 +171,10 @@ typedef struct sixtp
        children. */
 
     GHashTable* child_parsers;
+
+    const sixtp_stream_handlers* stream;
+    /* if set, receives everything between this node's start and end
+       tags instead of the child parsers. */
 } sixtp;
 
 typedef enum
@@ -190,6 +216,8 @@ struct _sixtp_child_result
     sixtp_result_handler fail_handler;
 };
 
+typedef struct sixtp_pipeline sixtp_pipeline;
+
 typedef struct sixtp_sax_data
 {
     gboolean parsing_ok;
@@ -197,6 +225,9 @@ typedef struct sixtp_sax_data
     gpointer global_data;
     xmlParserCtxtPtr saxParserCtxt;
     sixtp* bad_xml_parser;
+    int stream_depth; /* elements open in the streaming frame, if any */
+    sixtp_pipeline* pipeline; /* see sixtp-pipeline.h */
+    gboolean in_placeholder;
 } sixtp_sax_data;
 
 typedef struct
@@ -239,6 +270,14 @@ gboolean sixtp_parse_file (sixtp* sixtp, const char* filename,
 gboolean sixtp_parse_fd (sixtp* sixtp, FILE* fd,
                          gpointer data_for_top_level, gpointer global_data,
                          gpointer* parse_result);
+/* As sixtp_parse_fd, but the elements named shard_tag, unless inside
+   one named skip_tag, are tokenized on n_threads worker threads. */
+gboolean sixtp_parse_fd_parallel (sixtp* sixtp, FILE* fd,
+                                  const char* shard_tag, const char* skip_tag,
+                                  guint n_threads,
+                                  gpointer data_for_top_level,
+                                  gpointer global_data,
+                                  gpointer* parse_result);
 gboolean sixtp_parse_buffer (sixtp* sixtp, char* bufp, int bufsz,
                              gpointer data_for_top_level, gpointer global_data,
                              gpointer* parse_result);
@@ -257,6 +296,7 @@ void sixtp_set_cleanup_chars (sixtp* parser, sixtp_result_handler handler);
 void sixtp_set_fail (sixtp* parser, sixtp_fail_handler handler);
 void sixtp_set_result_fail (sixtp* parser, sixtp_result_handler handler);
 void sixtp_set_chars_fail (sixtp* parser, sixtp_result_handler handler);
+void sixtp_set_stream (sixtp* parser, const sixtp_stream_handlers* handlers);
 
 sixtp* sixtp_set_any (sixtp* tochange, gboolean cleanup, ...);
 sixtp* sixtp_add_some_sub_parsers (sixtp* tochange, gboolean cleanup, ...);
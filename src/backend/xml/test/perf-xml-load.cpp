@@ -0,0 +1,349 @@
+/***************************************************************************
+ *            perf-xml-load.cpp
+ *
+ *  Benchmark for writing and loading XML files with the threaded and
+ *  sequential writers and parsers.
+ *
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/* Writes a book of N transactions (100000 by default, or the first
+ * argument) of two splits each, with notes, memos and one price per
+ * ten transactions, to an uncompressed file, sequentially and with the
+ * transactions serialized on worker threads, checking that both files
+ * are the same.  Then times loading the file into a new book with the
+ * stream parsers, sequentially and with the transactions tokenized on
+ * worker threads, and with the DOM parsers, then writes the file's
+ * snapshot and times opening it, and checks that the books hold equal
+ * transactions.  Being a benchmark rather than a test, it is only
+ * built by "make perf-xml-load". */
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "qof.h"
+#include "qofbackend-p.h"
+#include "qofbook-p.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "TransLog.h"
+#include "gnc-commodity.h"
+#include "gnc-engine.h"
+#include "gnc-pricedb.h"
+#include "gnc-prefs.h"
+}
+
+#include "../gnc-backend-xml.h"
+#include "../io-gncxml-v2.h"
+#include "../io-gncsnapshot.h"
+#include "../sixtp-stream-parsers.h"
+
+static const int default_num_trans = 100000;
+static const time64 day = 24 * 3600;
+static const time64 start_date = 946684800; /* 2000-01-01 */
+
+static double
+seconds_since (gint64 start)
+{
+    return (g_get_monotonic_time () - start) / (double) G_USEC_PER_SEC;
+}
+
+static QofBook*
+book_with_backend (FileBackend* fbe)
+{
+    auto book = qof_book_new ();
+    memset (fbe, 0, sizeof (FileBackend));
+    qof_backend_init (&fbe->be);
+    qof_book_set_backend (book, &fbe->be);
+    return book;
+}
+
+static Account*
+add_account (QofBook* book, Account* root, gnc_commodity* comm,
+             const char* name, GNCAccountType type)
+{
+    auto acc = xaccMallocAccount (book);
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, comm);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static void
+add_transaction (QofBook* book, gnc_commodity* curr, Account* acc,
+                 Account* other, int i)
+{
+    auto trans = xaccMallocTransaction (book);
+    auto split = xaccMallocSplit (book);
+    auto other_split = xaccMallocSplit (book);
+    auto amount = gnc_numeric_create ((i * 31) % 100000 + 1, 100);
+    auto date = start_date + (i % 5000) * day;
+    char num[16];
+
+    g_snprintf (num, sizeof (num), "%d", i);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, curr);
+    xaccTransSetDatePostedSecsNormalized (trans, date);
+    xaccTransSetDateEnteredSecs (trans, date + 3600);
+    xaccTransSetNum (trans, num);
+    xaccTransSetDescription (trans, "benchmark transaction");
+    if (i % 3 == 0)
+        xaccTransSetNotes (trans, "a note & some <markup> to escape");
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetMemo (split, "benchmark memo");
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+    if (i % 2 == 0)
+    {
+        xaccSplitSetReconcile (split, YREC);
+        xaccSplitSetDateReconciledSecs (split, date + day);
+    }
+
+    xaccSplitSetParent (other_split, trans);
+    xaccSplitSetAccount (other_split, other);
+    xaccSplitSetAction (other_split, "Buy");
+    xaccSplitSetAmount (other_split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (other_split, gnc_numeric_neg (amount));
+    xaccTransCommitEdit (trans);
+}
+
+static void
+add_price (QofBook* book, gnc_commodity* comm, gnc_commodity* curr, int i)
+{
+    auto price = gnc_price_create (book);
+    Timespec ts = { start_date + (i % 5000) * day, 0 };
+
+    gnc_price_begin_edit (price);
+    gnc_price_set_commodity (price, comm);
+    gnc_price_set_currency (price, curr);
+    gnc_price_set_time (price, ts);
+    gnc_price_set_source_string (price, "user:price-editor");
+    gnc_price_set_typestr (price, "last");
+    gnc_price_set_value (price, gnc_numeric_create (i % 997 + 1, 100));
+    gnc_price_commit_edit (price);
+    gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+    gnc_price_unref (price);
+}
+
+static char*
+write_book (QofBook* book, gint threads)
+{
+    char* filename = g_strdup ("perf-xml-load-XXXXXX");
+    int fd = g_mkstemp (filename);
+    if (fd < 0)
+    {
+        g_free (filename);
+        return NULL;
+    }
+    close (fd);
+
+    gnc_prefs_set_file_save_threads (threads);
+
+    auto start = g_get_monotonic_time ();
+    if (!gnc_book_write_to_xml_file_v2 (book, filename, FALSE))
+    {
+        fprintf (stderr, "writing %s failed\n", filename);
+        g_unlink (filename);
+        g_free (filename);
+        return NULL;
+    }
+    printf ("wrote with %d threads in %.3f s\n", threads,
+            seconds_since (start));
+    return filename;
+}
+
+static gboolean
+files_match (const char* filename, const char* other_filename)
+{
+    gchar* contents, *other_contents;
+    gsize length, other_length;
+    gboolean match = FALSE;
+
+    if (g_file_get_contents (filename, &contents, &length, NULL))
+    {
+        if (g_file_get_contents (other_filename, &other_contents,
+                                 &other_length, NULL))
+        {
+            match = length == other_length &&
+                    memcmp (contents, other_contents, length) == 0;
+            g_free (other_contents);
+        }
+        g_free (contents);
+    }
+    if (!match)
+        fprintf (stderr, "%s and %s differ\n", filename, other_filename);
+    return match;
+}
+
+static QofBook*
+load_book (const char* filename, gboolean stream, gint threads,
+           FileBackend* fbe)
+{
+    auto book = book_with_backend (fbe);
+    auto how = g_strdup_printf ("the %s parsers and %d threads",
+                                stream ? "stream" : "DOM", threads);
+
+    sixtp_set_use_stream_parsers (stream);
+    gnc_prefs_set_file_load_threads (threads);
+    fbe->fullpath = g_strdup (filename);
+
+    auto start = g_get_monotonic_time ();
+    if (!qof_session_load_from_xml_file_v2 (fbe, book, GNC_BOOK_XML2_FILE))
+    {
+        fprintf (stderr, "loading with %s failed\n", how);
+        exit (1);
+    }
+    printf ("loaded with %s in %.3f s\n", how, seconds_since (start));
+    g_free (how);
+    return book;
+}
+
+static QofBook*
+load_snapshot (QofBook* book, const char* filename, FileBackend* fbe)
+{
+    auto start = g_get_monotonic_time ();
+    if (!gnc_snapshot_write (book, filename))
+    {
+        fprintf (stderr, "writing the snapshot failed\n");
+        exit (1);
+    }
+    printf ("wrote the snapshot in %.3f s\n", seconds_since (start));
+
+    auto snapshot_book = book_with_backend (fbe);
+    fbe->fullpath = g_strdup (filename);
+    sixtp_set_use_stream_parsers (TRUE);
+
+    start = g_get_monotonic_time ();
+    auto snapshot = gnc_snapshot_open (filename);
+    if (!snapshot || !gnc_snapshot_load (snapshot, fbe, snapshot_book))
+    {
+        fprintf (stderr, "loading the snapshot failed\n");
+        exit (1);
+    }
+    gnc_snapshot_close (snapshot);
+    printf ("loaded the snapshot in %.3f s\n", seconds_since (start));
+    gnc_snapshot_remove (filename);
+    return snapshot_book;
+}
+
+struct compare_data
+{
+    QofBook* other;
+    int differences;
+};
+
+static void
+compare_transaction (QofInstance* inst, gpointer data)
+{
+    auto cd = static_cast<compare_data*> (data);
+    auto trans = GNC_TRANSACTION (inst);
+    auto other = xaccTransLookup (xaccTransGetGUID (trans), cd->other);
+
+    if (!xaccTransEqual (trans, other, TRUE, TRUE, FALSE, FALSE))
+        cd->differences++;
+}
+
+static gboolean
+books_match (QofBook* book, QofBook* other, int num_trans)
+{
+    auto trans = qof_book_get_collection (book, GNC_ID_TRANS);
+    auto other_trans = qof_book_get_collection (other, GNC_ID_TRANS);
+    auto prices = gnc_pricedb_get_num_prices (gnc_pricedb_get_db (book));
+    auto other_prices = gnc_pricedb_get_num_prices (gnc_pricedb_get_db (other));
+    compare_data cd = { other, 0 };
+
+    qof_collection_foreach (trans, compare_transaction, &cd);
+    if (qof_collection_count (trans) != (guint) num_trans ||
+        qof_collection_count (other_trans) != (guint) num_trans ||
+        prices != other_prices || cd.differences)
+    {
+        fprintf (stderr, "the books differ: %u and %u transactions, "
+                 "%u and %u prices, %d different transactions\n",
+                 qof_collection_count (trans),
+                 qof_collection_count (other_trans), prices, other_prices,
+                 cd.differences);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+int
+main (int argc, char** argv)
+{
+    int num_trans = argc > 1 ? atoi (argv[1]) : default_num_trans;
+    FileBackend fbe, stream_fbe, parallel_fbe, dom_fbe, snapshot_fbe;
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+    xaccLogDisable ();
+
+    auto book = book_with_backend (&fbe);
+    auto table = gnc_commodity_table_get_table (book);
+    auto curr = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                            "USD");
+    auto stock = gnc_commodity_new (book, "Benchmark Inc", "NASDAQ", "BMK",
+                                    "", 1000);
+    gnc_commodity_table_insert (table, stock);
+    auto root = gnc_account_create_root (book);
+    auto acc = add_account (book, root, curr, "Bank", ACCT_TYPE_BANK);
+    auto other = add_account (book, root, curr, "Expenses", ACCT_TYPE_EXPENSE);
+
+    for (int i = 0; i < num_trans; ++i)
+    {
+        add_transaction (book, curr, acc, other, i);
+        if (i % 10 == 0)
+            add_price (book, stock, curr, i);
+    }
+
+    char* filename = write_book (book, 0);
+    char* parallel_filename = write_book (book, 3);
+    if (!filename || !parallel_filename || !files_match (filename,
+                                                         parallel_filename))
+        return 1;
+    g_unlink (parallel_filename);
+    g_free (parallel_filename);
+
+    auto stream_book = load_book (filename, TRUE, 0, &stream_fbe);
+    auto parallel_book = load_book (filename, TRUE, 3, &parallel_fbe);
+    auto dom_book = load_book (filename, FALSE, 0, &dom_fbe);
+    auto snapshot_book = load_snapshot (stream_book, filename, &snapshot_fbe);
+    g_unlink (filename);
+    g_free (filename);
+
+    int rv = 0;
+    if (!books_match (stream_book, parallel_book, num_trans) ||
+        !books_match (stream_book, dom_book, num_trans) ||
+        !books_match (stream_book, snapshot_book, num_trans))
+        rv = 1;
+
+    qof_close ();
+    return rv;
+}
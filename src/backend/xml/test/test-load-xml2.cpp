@@ -43,6 +43,8 @@ extern "C"
 #include <TransLog.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
+#include <Account.h>
+#include <Transaction.h>
 
 #include <test-stuff.h>
 #include <unittest-support.h>
@@ -78,6 +80,63 @@ remove_locks (const char* filename)
     remove_files_pattern (filename, ".LCK");
 }
 
+struct compare_data
+{
+    QofBook* other;
+    int differences;
+};
+
+static void
+compare_transaction (QofInstance* inst, gpointer data)
+{
+    auto cd = static_cast<compare_data*> (data);
+    auto trans = GNC_TRANSACTION (inst);
+    auto other = xaccTransLookup (xaccTransGetGUID (trans), cd->other);
+
+    if (!xaccTransEqual (trans, other, TRUE, TRUE, TRUE, FALSE))
+        cd->differences++;
+}
+
+/* Load the file again with its transactions tokenized on worker
+ * threads, and check that the book holds the same objects as the one
+ * read sequentially. */
+static void
+test_parallel_load_file (const char* filename, QofBook* book)
+{
+    QofSession* session = qof_session_new ();
+    QofCollection* trans = qof_book_get_collection (book, GNC_ID_TRANS);
+    QofBook* other;
+    compare_data cd;
+
+    gnc_prefs_set_file_load_threads (2);
+    qof_session_begin (session, filename, TRUE, FALSE, TRUE);
+    qof_session_load (session, NULL);
+    gnc_prefs_set_file_load_threads (0);
+    other = qof_session_get_book (session);
+
+    do_test_args (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+                  "parallel load xml2", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (session), filename);
+    do_test_args (xaccAccountEqual (gnc_book_get_root_account (book),
+                                    gnc_book_get_root_account (other), TRUE),
+                  "parallel load accounts", __FILE__, __LINE__,
+                  "accounts differ for file [%s]", filename);
+    cd.other = other;
+    cd.differences = 0;
+    qof_collection_foreach (trans, compare_transaction, &cd);
+    do_test_args (cd.differences == 0 &&
+                  qof_collection_count (trans) ==
+                  qof_collection_count (qof_book_get_collection (other,
+                                                                 GNC_ID_TRANS)),
+                  "parallel load transactions", __FILE__, __LINE__,
+                  "%d transactions differ for file [%s]", cd.differences,
+                  filename);
+
+    qof_session_end (session);
+    qof_session_destroy (session);
+}
+
 static void
 test_load_file (const char* filename)
 {
@@ -111,6 +170,7 @@ test_load_file (const char* filename)
                   "session load xml2", __FILE__, __LINE__,
                   "qof error=%d for file [%s]",
                   qof_session_get_error (session), filename);
+    test_parallel_load_file (filename, book);
     /* Uncomment the line below to generate corrected files */
     /*    qof_session_save( session, NULL ); */
     qof_session_end (session);
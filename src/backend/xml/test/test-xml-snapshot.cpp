@@ -0,0 +1,424 @@
+/***************************************************************************
+ *            test-xml-snapshot.cpp
+ *
+ *  Tests loading a book from its snapshot against loading it from the
+ *  XML file the snapshot was written with.
+ *
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <gnc-engine.h>
+#include <cashobjects.h>
+#include <TransLog.h>
+#include <qofbackend-p.h>
+#include <qofinstance-p.h>
+
+#include <test-stuff.h>
+
+#include <Account.h>
+#include <Split.h>
+#include <Transaction.h>
+#include <gnc-commodity.h>
+#include <gnc-lot.h>
+#include <gnc-pricedb.h>
+}
+
+#include <kvp_frame.hpp>
+
+#include "../gnc-backend-xml.h"
+#include "../io-gncxml-v2.h"
+#include "../io-gncsnapshot.h"
+#include "../sixtp-stream-parsers.h"
+
+static const int num_trans = 60;
+static const time64 day = 24 * 3600;
+static const time64 start_date = 946684800; /* 2000-01-01 */
+
+static QofBook*
+book_with_backend (FileBackend* fbe)
+{
+    QofBook* book = qof_book_new ();
+
+    memset (fbe, 0, sizeof (FileBackend));
+    qof_backend_init (&fbe->be);
+    qof_book_set_backend (book, &fbe->be);
+    return book;
+}
+
+static Account*
+add_account (QofBook* book, Account* root, gnc_commodity* comm,
+             const char* name, GNCAccountType type)
+{
+    Account* acc = xaccMallocAccount (book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, comm);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+/* Every reconcile state, slots of each kind, lots and a voided
+ * transaction, all of which the snapshot keeps in its own columns. */
+static void
+add_transaction (QofBook* book, gnc_commodity* curr, Account* acc,
+                 Account* other, GNCLot* lot, int i)
+{
+    static const char states[] = { NREC, CREC, YREC, FREC };
+    Transaction* trans = xaccMallocTransaction (book);
+    Split* split = xaccMallocSplit (book);
+    Split* other_split = xaccMallocSplit (book);
+    gnc_numeric amount = gnc_numeric_create (i * 37 % 1000 + 1, 100);
+    time64 date = start_date + i * day;
+    char num[16];
+
+    g_snprintf (num, sizeof (num), "%d", i);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, curr);
+    xaccTransSetDatePostedSecsNormalized (trans, date);
+    xaccTransSetDateEnteredSecs (trans, date + 3600);
+    xaccTransSetNum (trans, num);
+    xaccTransSetDescription (trans, i % 2 ? "snapshot" : "");
+    if (i % 3 == 0)
+        xaccTransSetNotes (trans, "a note & <markup>");
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetMemo (split, "memo");
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+    xaccSplitSetReconcile (split, states[i % 4]);
+    if (states[i % 4] == YREC)
+        xaccSplitSetDateReconciledSecs (split, date + day);
+    if (i % 5 == 0)
+        gnc_lot_add_split (lot, split);
+
+    xaccSplitSetParent (other_split, trans);
+    xaccSplitSetAccount (other_split, other);
+    if (i % 4)
+        xaccSplitSetAction (other_split, "Buy");
+    xaccSplitSetAmount (other_split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (other_split, gnc_numeric_neg (amount));
+    if (i % 7 == 0)
+    {
+        KvpFrame* frame = qof_instance_get_slots (QOF_INSTANCE (other_split));
+        GDate date_value;
+
+        g_date_set_dmy (&date_value, 1 + i % 28, G_DATE_JANUARY, 2000);
+        delete frame->set_path ({"snapshot", "count"}, new KvpValue {INT64_C (7)});
+        delete frame->set_path ({"snapshot", "ratio"}, new KvpValue {0.5});
+        delete frame->set_path ({"snapshot", "date"}, new KvpValue {date_value});
+        delete frame->set ("number", new KvpValue {amount});
+    }
+    xaccTransCommitEdit (trans);
+
+    if (i % 11 == 0)
+        xaccTransVoid (trans, "voided in the snapshot test");
+}
+
+static void
+add_price (QofBook* book, gnc_commodity* comm, gnc_commodity* curr, int i)
+{
+    GNCPrice* price = gnc_price_create (book);
+    Timespec ts = { start_date + i * day, 0 };
+
+    gnc_price_begin_edit (price);
+    gnc_price_set_commodity (price, comm);
+    gnc_price_set_currency (price, curr);
+    gnc_price_set_time (price, ts);
+    gnc_price_set_source_string (price, "user:price-editor");
+    gnc_price_set_typestr (price, i % 2 ? "last" : "nav");
+    gnc_price_set_value (price, gnc_numeric_create (i % 97 + 1, 100));
+    gnc_price_commit_edit (price);
+    gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+    gnc_price_unref (price);
+}
+
+static QofBook*
+make_book (FileBackend* fbe)
+{
+    QofBook* book = book_with_backend (fbe);
+    gnc_commodity_table* table = gnc_commodity_table_get_table (book);
+    gnc_commodity* curr = gnc_commodity_table_lookup (
+                              table, GNC_COMMODITY_NS_CURRENCY, "USD");
+    gnc_commodity* stock = gnc_commodity_new (book, "Snapshot Inc", "NASDAQ",
+                                              "SNAP", "", 1000);
+    Account* root, *bank, *expenses;
+    GNCLot* lot;
+
+    gnc_commodity_table_insert (table, stock);
+    root = gnc_account_create_root (book);
+    bank = add_account (book, root, curr, "Bank", ACCT_TYPE_BANK);
+    expenses = add_account (book, root, curr, "Expenses", ACCT_TYPE_EXPENSE);
+    lot = gnc_lot_new (book);
+    xaccAccountInsertLot (bank, lot);
+
+    delete qof_instance_get_slots (QOF_INSTANCE (book))->set_path (
+        {"options", "snapshot"}, new KvpValue {g_strdup ("book slot")});
+
+    for (int i = 0; i < num_trans; ++i)
+    {
+        add_transaction (book, curr, bank, expenses, lot, i);
+        if (i % 10 == 0)
+            add_price (book, stock, curr, i);
+    }
+    return book;
+}
+
+static QofBook*
+load_xml (const char* filename, FileBackend* fbe)
+{
+    QofBook* book = book_with_backend (fbe);
+
+    fbe->fullpath = g_strdup (filename);
+    do_test (qof_session_load_from_xml_file_v2 (fbe, book, GNC_BOOK_XML2_FILE),
+             "load the XML file");
+    return book;
+}
+
+static QofBook*
+load_snapshot (const char* filename, FileBackend* fbe)
+{
+    QofBook* book = book_with_backend (fbe);
+    gnc_snapshot* snapshot = gnc_snapshot_open (filename);
+
+    fbe->fullpath = g_strdup (filename);
+    do_test (snapshot != NULL, "accept the snapshot of a saved file");
+    if (snapshot)
+    {
+        do_test (gnc_snapshot_load (snapshot, fbe, book), "load the snapshot");
+        gnc_snapshot_close (snapshot);
+    }
+    return book;
+}
+
+struct compare_data
+{
+    QofBook* other;
+    int differences;
+};
+
+static void
+compare_account (Account* acc, gpointer data)
+{
+    compare_data* cd = static_cast<compare_data*> (data);
+    Account* other = xaccAccountLookup (qof_entity_get_guid (acc), cd->other);
+
+    if (!xaccAccountEqual (acc, other, TRUE))
+        cd->differences++;
+}
+
+static void
+compare_transaction (QofInstance* inst, gpointer data)
+{
+    compare_data* cd = static_cast<compare_data*> (data);
+    Transaction* trans = GNC_TRANSACTION (inst);
+    Transaction* other = xaccTransLookup (xaccTransGetGUID (trans), cd->other);
+
+    if (!xaccTransEqual (trans, other, TRUE, TRUE, TRUE, FALSE) ||
+        qof_instance_compare_kvp (QOF_INSTANCE (trans),
+                                  QOF_INSTANCE (other)) != 0)
+        cd->differences++;
+}
+
+static void
+compare_split (QofInstance* inst, gpointer data)
+{
+    compare_data* cd = static_cast<compare_data*> (data);
+    Split* split = GNC_SPLIT (inst);
+    Split* other = xaccSplitLookup (xaccSplitGetGUID (split), cd->other);
+    GNCLot* lot = xaccSplitGetLot (split);
+    GNCLot* other_lot = other ? xaccSplitGetLot (other) : NULL;
+
+    if (!xaccSplitEqual (split, other, TRUE, TRUE, FALSE) ||
+        xaccSplitGetReconcile (split) != xaccSplitGetReconcile (other) ||
+        qof_instance_compare_kvp (QOF_INSTANCE (split),
+                                  QOF_INSTANCE (other)) != 0 ||
+        (lot == NULL) != (other_lot == NULL) ||
+        (lot && !guid_equal (gnc_lot_get_guid (lot),
+                             gnc_lot_get_guid (other_lot))))
+        cd->differences++;
+}
+
+static int
+count_differences (QofBook* book, QofBook* other, QofIdTypeConst type,
+                   QofInstanceForeachCB cb)
+{
+    QofCollection* col = qof_book_get_collection (book, type);
+    QofCollection* other_col = qof_book_get_collection (other, type);
+    compare_data cd = { other, 0 };
+
+    qof_collection_foreach (col, cb, &cd);
+    return cd.differences + (qof_collection_count (col) !=
+                             qof_collection_count (other_col));
+}
+
+static void
+test_books_match (QofBook* book, QofBook* snapshot_book)
+{
+    Account* root = gnc_book_get_root_account (book);
+    compare_data cd = { snapshot_book, 0 };
+
+    gnc_account_foreach_descendant (root, compare_account, &cd);
+    do_test (cd.differences == 0 &&
+             gnc_account_n_descendants (root) ==
+             gnc_account_n_descendants (
+                 gnc_book_get_root_account (snapshot_book)),
+             "snapshot accounts");
+    do_test (count_differences (book, snapshot_book, GNC_ID_TRANS,
+                                compare_transaction) == 0,
+             "snapshot transactions");
+    do_test (count_differences (book, snapshot_book, GNC_ID_SPLIT,
+                                compare_split) == 0,
+             "snapshot splits");
+    do_test (gnc_pricedb_equal (gnc_pricedb_get_db (book),
+                                gnc_pricedb_get_db (snapshot_book)) &&
+             gnc_pricedb_get_num_prices (gnc_pricedb_get_db (book)) ==
+             gnc_pricedb_get_num_prices (gnc_pricedb_get_db (snapshot_book)),
+             "snapshot prices");
+    do_test (qof_instance_compare_kvp (QOF_INSTANCE (book),
+                                      QOF_INSTANCE (snapshot_book)) == 0,
+             "snapshot book slots");
+    do_test (!qof_book_session_not_saved (book) &&
+             !qof_book_session_not_saved (snapshot_book),
+             "snapshot book saved");
+}
+
+static void
+replace_contents (const char* filename, const gchar* contents, gsize length)
+{
+    if (!g_file_set_contents (filename, contents, length, NULL))
+        failure_args ("g_file_set_contents", __FILE__, __LINE__, "%s",
+                      filename);
+}
+
+/* A snapshot is only used with the file it was written with, and
+ * only when it is whole. */
+static void
+test_rejected_snapshots (QofBook* book, const char* filename)
+{
+    gchar* snapshot_filename = gnc_snapshot_filename (filename);
+    gchar* contents, *snapshot_contents;
+    gsize length, snapshot_length;
+    gnc_snapshot* snapshot;
+
+    if (!g_file_get_contents (filename, &contents, &length, NULL))
+    {
+        failure_args ("g_file_get_contents", __FILE__, __LINE__, "%s",
+                      filename);
+        g_free (snapshot_filename);
+        return;
+    }
+
+    /* the same size, another checksum */
+    contents[length / 2] = contents[length / 2] == ' ' ? '\t' : ' ';
+    replace_contents (filename, contents, length);
+    snapshot = gnc_snapshot_open (filename);
+    do_test (snapshot == NULL, "reject the snapshot of a changed file");
+    gnc_snapshot_close (snapshot);
+
+    replace_contents (filename, contents, length - 1);
+    snapshot = gnc_snapshot_open (filename);
+    do_test (snapshot == NULL, "reject the snapshot of a shorter file");
+    gnc_snapshot_close (snapshot);
+
+    do_test (gnc_book_write_to_xml_file_v2 (book, filename, FALSE) &&
+             gnc_snapshot_write (book, filename), "rewrite the snapshot");
+    snapshot = gnc_snapshot_open (filename);
+    do_test (snapshot != NULL, "accept the rewritten snapshot");
+    gnc_snapshot_close (snapshot);
+
+    if (g_file_get_contents (snapshot_filename, &snapshot_contents,
+                             &snapshot_length, NULL))
+    {
+        replace_contents (snapshot_filename, snapshot_contents,
+                          snapshot_length / 2);
+        snapshot = gnc_snapshot_open (filename);
+        do_test (snapshot == NULL, "reject a truncated snapshot");
+        gnc_snapshot_close (snapshot);
+
+        replace_contents (snapshot_filename, snapshot_contents, 16);
+        snapshot = gnc_snapshot_open (filename);
+        do_test (snapshot == NULL, "reject a truncated snapshot header");
+        gnc_snapshot_close (snapshot);
+        g_free (snapshot_contents);
+    }
+    else
+        failure_args ("g_file_get_contents", __FILE__, __LINE__, "%s",
+                      snapshot_filename);
+
+    gnc_snapshot_remove (filename);
+    g_free (contents);
+    g_free (snapshot_filename);
+}
+
+static void
+test_snapshot (void)
+{
+    FileBackend fbe, xml_fbe, snapshot_fbe;
+    gchar* filename = g_strdup ("test_file_XXXXXX");
+    int fd = g_mkstemp (filename);
+    QofBook* book = make_book (&fbe);
+    QofBook* xml_book, *snapshot_book;
+
+    close (fd);
+    sixtp_set_use_stream_parsers (TRUE);
+    if (!gnc_book_write_to_xml_file_v2 (book, filename, FALSE) ||
+        !gnc_snapshot_write (book, filename))
+    {
+        failure_args ("gnc_snapshot_write", __FILE__, __LINE__, "%s",
+                      filename);
+        g_unlink (filename);
+        g_free (filename);
+        return;
+    }
+
+    xml_book = load_xml (filename, &xml_fbe);
+    snapshot_book = load_snapshot (filename, &snapshot_fbe);
+    test_books_match (xml_book, snapshot_book);
+    test_rejected_snapshots (book, filename);
+
+    g_unlink (filename);
+    g_free (filename);
+}
+
+int
+main (int argc, char** argv)
+{
+    qof_init ();
+    cashobjects_register ();
+    xaccLogDisable ();
+
+    test_snapshot ();
+
+    print_test_results ();
+    qof_close ();
+    exit (get_rv ());
+}
@@ -29,6 +29,7 @@ extern "C"
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/types.h>
@@ -36,8 +37,10 @@ extern "C"
 #include <sys/stat.h>
 
 #include <gnc-engine.h>
+#include <gnc-prefs.h>
 #include <cashobjects.h>
 #include <TransLog.h>
+#include <qofbackend-p.h>
 
 #include <test-stuff.h>
 #include <test-engine-stuff.h>
@@ -52,7 +55,10 @@ extern "C"
 #include "../gnc-xml.h"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
+#include "../sixtp-stream-parsers.h"
 #include "../io-gncxml-gen.h"
+#include "../io-gncxml-v2.h"
+#include "../gnc-backend-xml.h"
 #include <test-file-stuff.h>
 
 static QofBook* book;
@@ -443,6 +449,21 @@ test_transaction (void)
             success_args ("transaction_xml", __FILE__, __LINE__, "%d", i);
         }
 
+        {
+            /* The writer's text must be what libxml2 writes for the tree. */
+            auto buf = xmlBufferCreate ();
+            auto text = g_string_new (NULL);
+            xmlNodeDump (buf, NULL, test_node, 0, 1);
+            xmlBufferCCat (buf, "\n");
+            gnc_transaction_to_xml_text (ran_trn, text);
+            do_test_args (g_strcmp0 ((const char*) xmlBufferContent (buf),
+                                     text->str) == 0,
+                          "transaction_xml_text", __FILE__, __LINE__,
+                          "%d", i);
+            g_string_free (text, TRUE);
+            xmlBufferFree (buf);
+        }
+
         filename1 = g_strdup_printf ("test_file_XXXXXX");
 
         fd = g_mkstemp (filename1);
@@ -492,7 +513,31 @@ test_transaction (void)
                               __FILE__, __LINE__, "%d", i);
             }
             else
-                really_get_rid_of_transaction (data.new_trn);
+            {
+                /* The DOM parser must read the same transaction as the
+                 * stream parser. */
+                Transaction* stream_trn = data.new_trn;
+
+                sixtp_set_use_stream_parsers (FALSE);
+                parser = gnc_transaction_sixtp_parser_create ();
+                sixtp_set_use_stream_parsers (TRUE);
+                if (!gnc_xml_parse_file (parser, filename1,
+                                         test_add_transaction,
+                                         (gpointer)&data, book))
+                {
+                    failure_args ("gnc_xml_parse_file returned FALSE",
+                                  __FILE__, __LINE__, "DOM parser %d", i);
+                }
+                else
+                {
+                    do_test_args (xaccTransEqual (stream_trn, data.new_trn,
+                                                  TRUE, TRUE, TRUE, FALSE),
+                                  "stream and DOM transaction parsers",
+                                  __FILE__, __LINE__, "%d", i);
+                    really_get_rid_of_transaction (data.new_trn);
+                }
+                really_get_rid_of_transaction (stream_trn);
+            }
         }
         /* no handling of circular data structures.  We'll do that later */
         /* sixtp_destroy(parser); */
@@ -505,6 +550,51 @@ test_transaction (void)
     }
 }
 
+static gchar*
+write_book_with_threads (QofBook* wbook, gint threads)
+{
+    gchar* filename = g_strdup ("test_file_XXXXXX");
+    gchar* contents = NULL;
+    int fd = g_mkstemp (filename);
+
+    close (fd);
+    gnc_prefs_set_file_save_threads (threads);
+    if (!gnc_book_write_to_xml_file_v2 (wbook, filename, FALSE) ||
+        !g_file_get_contents (filename, &contents, NULL, NULL))
+        failure_args ("gnc_book_write_to_xml_file_v2", __FILE__, __LINE__,
+                      "%d threads", threads);
+    gnc_prefs_set_file_save_threads (0);
+    g_unlink (filename);
+    g_free (filename);
+    return contents;
+}
+
+/* Transactions serialized on worker threads must come out as the same
+ * bytes as those the DOM writer gives, over several batches. */
+static void
+test_threaded_writer (void)
+{
+    FileBackend fbe;
+    QofBook* wbook = get_random_book ();
+    gchar* dom_text, *threaded_text;
+
+    memset (&fbe, 0, sizeof (FileBackend));
+    qof_backend_init (&fbe.be);
+    qof_book_set_backend (wbook, &fbe.be);
+    add_random_transactions_to_book (wbook, 600);
+
+    dom_text = write_book_with_threads (wbook, 0);
+    threaded_text = write_book_with_threads (wbook, 3);
+    do_test (dom_text && threaded_text &&
+             strcmp (dom_text, threaded_text) == 0,
+             "threaded transaction writer");
+
+    g_free (dom_text);
+    g_free (threaded_text);
+    qof_book_set_backend (wbook, NULL);
+    qof_book_destroy (wbook);
+}
+
 static gboolean
 test_real_transaction (const char* tag, gpointer global_data, gpointer data)
 {
@@ -538,6 +628,7 @@ main (int argc, char** argv)
     else
     {
         test_transaction ();
+        test_threaded_writer ();
     }
 
     print_test_results ();
@@ -34,6 +34,15 @@ static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
+static gint file_load_threads     = 0;    // This is also the default in the prefs backend
+static gint file_save_threads     = 0;    // This is also the default in the prefs backend
+static gboolean file_snapshot     = FALSE; // This is also the default in the prefs backend
+static gboolean sql_load_as_needed = FALSE; // This is also the default in the prefs backend
+static gint sql_cache_size        = 50000; // This is also the default in the prefs backend
+static gboolean sql_slot_blobs    = FALSE; // This is also the default in the prefs backend
+
+/* Fewer transactions than this would be dropped and loaded again all the time */
+#define SQL_CACHE_SIZE_MIN 1000
 
 PrefsBackend *prefsbackend = NULL;
 
@@ -116,6 +125,78 @@ gnc_prefs_set_file_retention_days(gint days)
     file_retention_days = days;
 }
 
+gint
+gnc_prefs_get_file_load_threads(void)
+{
+    return file_load_threads;
+}
+
+void
+gnc_prefs_set_file_load_threads(gint threads)
+{
+    file_load_threads = MAX(threads, 0);
+}
+
+gint
+gnc_prefs_get_file_save_threads(void)
+{
+    return file_save_threads;
+}
+
+void
+gnc_prefs_set_file_save_threads(gint threads)
+{
+    file_save_threads = MAX(threads, 0);
+}
+
+gboolean
+gnc_prefs_get_file_snapshot(void)
+{
+    return file_snapshot;
+}
+
+void
+gnc_prefs_set_file_snapshot(gboolean snapshot)
+{
+    file_snapshot = snapshot;
+}
+
+gboolean
+gnc_prefs_get_sql_load_as_needed(void)
+{
+    return sql_load_as_needed;
+}
+
+void
+gnc_prefs_set_sql_load_as_needed(gboolean as_needed)
+{
+    sql_load_as_needed = as_needed;
+}
+
+gint
+gnc_prefs_get_sql_cache_size(void)
+{
+    return sql_cache_size;
+}
+
+void
+gnc_prefs_set_sql_cache_size(gint size)
+{
+    sql_cache_size = MAX(size, SQL_CACHE_SIZE_MIN);
+}
+
+gboolean
+gnc_prefs_get_sql_slot_blobs(void)
+{
+    return sql_slot_blobs;
+}
+
+void
+gnc_prefs_set_sql_slot_blobs(gboolean slot_blobs)
+{
+    sql_slot_blobs = slot_blobs;
+}
+
 guint
 gnc_prefs_get_long_version()
 {
@@ -113,6 +113,37 @@ void gnc_prefs_set_file_retention_policy(gint policy);
 gint gnc_prefs_get_file_retention_days(void);
 void gnc_prefs_set_file_retention_days(gint days);
 
+/* The number of worker threads reading the transactions of an XML
+ * file, 0 to read it on the loading thread alone. */
+gint gnc_prefs_get_file_load_threads(void);
+void gnc_prefs_set_file_load_threads(gint threads);
+
+/* The number of worker threads writing the transactions of an XML
+ * file, 0 to write it on the saving thread alone. */
+gint gnc_prefs_get_file_save_threads(void);
+void gnc_prefs_set_file_save_threads(gint threads);
+
+/* Whether a snapshot is saved next to an XML file to open it faster. */
+gboolean gnc_prefs_get_file_snapshot(void);
+void gnc_prefs_set_file_snapshot(gboolean snapshot);
+
+/* Whether the transactions of an SQL database are loaded as queries
+ * need them rather than all at once when it is opened. */
+gboolean gnc_prefs_get_sql_load_as_needed(void);
+void gnc_prefs_set_sql_load_as_needed(gboolean as_needed);
+
+/* The number of transactions loaded as needed from an SQL database
+ * which are kept in memory once unused.  Sizes below 1000 are raised
+ * to it. */
+gint gnc_prefs_get_sql_cache_size(void);
+void gnc_prefs_set_sql_cache_size(gint size);
+
+/* Whether a book written into an SQL database, e.g. with Save As,
+ * stores each object's slots as one serialized frame rather than in
+ * rows.  Databases which are only opened keep the storage they have. */
+gboolean gnc_prefs_get_sql_slot_blobs(void);
+void gnc_prefs_set_sql_slot_blobs(gboolean slot_blobs);
+
 guint gnc_prefs_get_long_version( void );
 
 /** @} */
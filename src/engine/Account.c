@@ -119,6 +119,7 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void account_clear_splits (AccountPrivate *priv);
 
 
 /********************************************************************\
@@ -274,8 +275,14 @@ gnc_account_init(Account* acc)
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
 
+    priv->first_dirty = NULL;
+
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->sort_all = FALSE;
+    priv->sort_suspects = g_hash_table_new (g_direct_hash, g_direct_equal);
+    priv->split_seq = g_sequence_new (NULL);
+    priv->split_iters = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -287,6 +294,12 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    g_list_free (priv->splits);
+    g_sequence_free (priv->split_seq);
+    g_hash_table_destroy (priv->split_iters);
+    g_hash_table_destroy (priv->sort_suspects);
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -1282,6 +1295,8 @@ xaccFreeAccount (Account *acc)
 
     priv->balance_dirty = FALSE;
     priv->sort_dirty = FALSE;
+    priv->sort_all = FALSE;
+    account_clear_splits (priv);
 
     /* qof_instance_release (&acc->inst); */
     g_object_unref(acc);
@@ -1373,8 +1388,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            account_clear_splits (priv);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1712,25 +1726,185 @@ gnc_account_set_sort_dirty (Account *acc)
 
     priv = GET_PRIVATE(acc);
     priv->sort_dirty = TRUE;
+    priv->sort_all = TRUE;
 }
 
 void
-gnc_account_set_balance_dirty (Account *acc)
+gnc_account_set_sort_dirty_from_split (Account *acc, Split *split)
 {
     AccountPrivate *priv;
 
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(split));
 
     if (qof_instance_get_destroying(acc))
         return;
 
     priv = GET_PRIVATE(acc);
+    priv->sort_dirty = TRUE;
+    g_hash_table_insert (priv->sort_suspects, split, split);
+}
+
+/* Flag the split at node, and so every split after it, as having a
+ * stale running balance.  priv->first_dirty keeps the earliest split
+ * so flagged, which is where xaccAccountRecomputeBalance() starts.  A
+ * NULL node leaves the split balances alone and only dirties the
+ * account totals. */
+static void
+account_set_balance_dirty_from (AccountPrivate *priv, GList *node)
+{
+    Split *split;
+
     priv->balance_dirty = TRUE;
+    if (!node)
+        return;
+
+    split = node->data;
+    split->balance_dirty = TRUE;
+    if (priv->first_dirty && priv->first_dirty != split &&
+            g_sequence_iter_compare (
+                g_hash_table_lookup (priv->split_iters, priv->first_dirty),
+                g_hash_table_lookup (priv->split_iters, split)) < 0)
+        return;
+    priv->first_dirty = split;
+}
+
+void
+gnc_account_set_balance_dirty (Account *acc)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    account_set_balance_dirty_from (priv, priv->splits);
+}
+
+void
+gnc_account_set_balance_dirty_from_split (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+    GSequenceIter *iter;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(GNC_IS_SPLIT(split));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    iter = g_hash_table_lookup (priv->split_iters, split);
+    if (iter)
+        account_set_balance_dirty_from (priv, g_sequence_get (iter));
+    else
+        priv->balance_dirty = TRUE;
 }
 
 /********************************************************************\
 \********************************************************************/
 
+/* The splits of an account are kept in two structures that always
+ * hold the same sequence: priv->splits, the GList handed out by
+ * xaccAccountGetSplitList(), and priv->split_seq, a balanced tree
+ * (GSequence) whose items are the nodes of that GList.  The tree
+ * finds the place of a new split and the splits posted around a date
+ * in O(log n), while priv->split_iters maps each split to its tree
+ * item so that membership tests and removal don't have to walk the
+ * list.  The GList nodes are linked and unlinked by hand to follow
+ * the tree.  An edit that may move a split records it in
+ * priv->sort_suspects, so that xaccAccountSortSplits() only has to
+ * look at those splits. */
+
+static gint
+split_node_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    return xaccSplitOrder (((const GList *) a)->data,
+                           ((const GList *) b)->data);
+}
+
+static void
+split_list_link_before (AccountPrivate *priv, GList *node, GList *sibling)
+{
+    node->next = sibling;
+    node->prev = sibling->prev;
+    if (sibling->prev)
+        sibling->prev->next = node;
+    else
+        priv->splits = node;
+    sibling->prev = node;
+}
+
+static void
+split_list_link_after (GList *node, GList *sibling)
+{
+    node->prev = sibling;
+    node->next = sibling->next;
+    if (sibling->next)
+        sibling->next->prev = node;
+    sibling->next = node;
+}
+
+/* Insert the unlinked list node of a split in sort order, and return
+ * its tree item. */
+static GSequenceIter *
+account_insert_node_sorted (AccountPrivate *priv, GList *node)
+{
+    GSequenceIter *iter, *next;
+
+    iter = g_sequence_insert_sorted (priv->split_seq, node,
+                                     split_node_order, NULL);
+    g_hash_table_insert (priv->split_iters, node->data, iter);
+
+    next = g_sequence_iter_next (iter);
+    if (!g_sequence_iter_is_end (next))
+        split_list_link_before (priv, node, g_sequence_get (next));
+    else if (!g_sequence_iter_is_begin (iter))
+        split_list_link_after (node, g_sequence_get (g_sequence_iter_prev (iter)));
+    else
+        priv->splits = node;
+    return iter;
+}
+
+/* Insert the split in sort order, and return its list node. */
+static GList *
+account_insert_split_sorted (AccountPrivate *priv, Split *s)
+{
+    GList *node = g_list_alloc ();
+
+    node->data = s;
+    account_insert_node_sorted (priv, node);
+    return node;
+}
+
+/* Put the split at the head of the list without regard to its order,
+ * and return its list node. */
+static GList *
+account_prepend_split (AccountPrivate *priv, Split *s)
+{
+    GSequenceIter *iter;
+
+    priv->splits = g_list_prepend (priv->splits, s);
+    iter = g_sequence_prepend (priv->split_seq, priv->splits);
+    g_hash_table_insert (priv->split_iters, s, iter);
+    return priv->splits;
+}
+
+/* Drop all the splits at once; the splits themselves are left alone. */
+static void
+account_clear_splits (AccountPrivate *priv)
+{
+    g_sequence_remove_range (g_sequence_get_begin_iter (priv->split_seq),
+                             g_sequence_get_end_iter (priv->split_seq));
+    g_hash_table_remove_all (priv->split_iters);
+    g_hash_table_remove_all (priv->sort_suspects);
+    g_list_free (priv->splits);
+    priv->splits = NULL;
+    priv->first_dirty = NULL;
+}
+
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
@@ -1741,19 +1915,20 @@ gnc_account_insert_split (Account *acc, Split *s)
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (g_hash_table_lookup (priv->split_iters, s))
         return FALSE;
 
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        /* The tree can only place the split if it is in order itself. */
+        xaccAccountSortSplits (acc, FALSE);
+        node = account_insert_split_sorted (priv, s);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        node = account_prepend_split (priv, s);
         priv->sort_dirty = TRUE;
+        g_hash_table_insert (priv->sort_suspects, s, s);
     }
 
     //FIXME: find better event
@@ -1761,7 +1936,8 @@ gnc_account_insert_split (Account *acc, Split *s)
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
+    /* Only the new split and those after it get new balances. */
+    account_set_balance_dirty_from (priv, node);
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1771,27 +1947,141 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
+    GSequenceIter *iter;
     GList *node;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    iter = g_hash_table_lookup (priv->split_iters, s);
+    if (NULL == iter)
         return FALSE;
 
+    node = g_sequence_get (iter);
+    /* The splits following the removed one lose its amount. */
+    if (priv->first_dirty == s)
+        priv->first_dirty = NULL;
+    account_set_balance_dirty_from (priv, node->next);
+    g_sequence_remove (iter);
+    g_hash_table_remove (priv->split_iters, s);
+    g_hash_table_remove (priv->sort_suspects, s);
     priv->splits = g_list_delete_link(priv->splits, node);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
 
+static gboolean
+split_list_is_sorted (GList *splits)
+{
+    GList *lp;
+
+    for (lp = splits; lp && lp->next; lp = lp->next)
+        if (xaccSplitOrder (lp->data, lp->next->data) > 0)
+            return FALSE;
+    return TRUE;
+}
+
+/* Sort the whole account, for when any split may be out of place. */
+static void
+account_sort_all_splits (AccountPrivate *priv)
+{
+    GSequenceIter *iter;
+    GList *prev = NULL;
+
+    /* Most edits that dirty the sort don't change the order, in which
+     * case the running balances are still good. */
+    if (split_list_is_sorted (priv->splits))
+        return;
+
+    /* Sorting the tree keeps its items, so the split map stays valid;
+     * the list is then relinked to follow the tree. */
+    g_sequence_sort (priv->split_seq, split_node_order, NULL);
+    priv->splits = NULL;
+    for (iter = g_sequence_get_begin_iter (priv->split_seq);
+            !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter))
+    {
+        GList *node = g_sequence_get (iter);
+        node->prev = prev;
+        node->next = NULL;
+        if (prev)
+            prev->next = node;
+        else
+            priv->splits = node;
+        prev = node;
+    }
+    account_set_balance_dirty_from (priv, priv->splits);
+}
+
+static gboolean
+split_node_in_order (GList *node)
+{
+    return (!node->prev || xaccSplitOrder (node->prev->data, node->data) <= 0)
+           && (!node->next || xaccSplitOrder (node->data, node->next->data) <= 0);
+}
+
+/* Put back in order the splits in priv->sort_suspects, the only ones
+ * that can be out of place.  The list is in order if each of them is
+ * in order with its neighbours; otherwise they are all taken out,
+ * which leaves the others in order, and inserted again. */
+static void
+account_sort_suspect_splits (AccountPrivate *priv)
+{
+    GHashTableIter hiter;
+    gpointer split;
+    GList *nodes = NULL, *lp;
+    gint first = G_MAXINT;
+    gboolean sorted = TRUE;
+
+    g_hash_table_iter_init (&hiter, priv->sort_suspects);
+    while (sorted && g_hash_table_iter_next (&hiter, &split, NULL))
+    {
+        GSequenceIter *iter = g_hash_table_lookup (priv->split_iters, split);
+        if (iter)
+            sorted = split_node_in_order (g_sequence_get (iter));
+    }
+    if (sorted)
+        return;
+
+    /* The running balances are good up to the first split moved. */
+    if (priv->first_dirty)
+        first = g_sequence_iter_get_position (
+                    g_hash_table_lookup (priv->split_iters, priv->first_dirty));
+    priv->first_dirty = NULL;
+
+    g_hash_table_iter_init (&hiter, priv->sort_suspects);
+    while (g_hash_table_iter_next (&hiter, &split, NULL))
+    {
+        GSequenceIter *iter = g_hash_table_lookup (priv->split_iters, split);
+        GList *node;
+
+        if (!iter)
+            continue;
+        first = MIN (first, g_sequence_iter_get_position (iter));
+        node = g_sequence_get (iter);
+        g_sequence_remove (iter);
+        g_hash_table_remove (priv->split_iters, split);
+        priv->splits = g_list_remove_link (priv->splits, node);
+        nodes = g_list_prepend (nodes, node);
+    }
+
+    for (lp = nodes; lp; lp = lp->next)
+    {
+        GSequenceIter *iter = account_insert_node_sorted (priv, lp->data);
+        first = MIN (first, g_sequence_iter_get_position (iter));
+    }
+    g_list_free (nodes);
+
+    account_set_balance_dirty_from (
+        priv, g_sequence_get (g_sequence_get_iter_at_pos (priv->split_seq,
+                              first)));
+}
+
 void
 xaccAccountSortSplits (Account *acc, gboolean force)
 {
@@ -1802,11 +2092,203 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+
+    if (priv->sort_all)
+        account_sort_all_splits (priv);
+    else
+        account_sort_suspect_splits (priv);
+
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    priv->sort_all = FALSE;
+    g_hash_table_remove_all (priv->sort_suspects);
+}
+
+/* Compare a split list node from the tree with the date in user_data.
+ * The NULL search key stands for the date; splits posted before it
+ * order before the key and all others after it, so a search finds
+ * the first split posted at or after the date. */
+static gint
+split_node_date_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    time64 date = *(const time64 *) user_data;
+    const GList *node = a ? a : b;
+    gint before;
+
+    before = xaccTransGetDate (xaccSplitGetParent (node->data)) < date;
+    if (a)
+        return before ? -1 : 1;
+    return before ? 1 : -1;
+}
+
+/* Return the last split in the account posted before date, or NULL if
+ * there is none.  The splits are sorted and their running balances
+ * brought up to date first. */
+static Split *
+account_find_last_split_before (Account *acc, time64 date)
+{
+    AccountPrivate *priv;
+    GSequenceIter *iter;
+
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+    xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
+
+    priv = GET_PRIVATE(acc);
+    iter = g_sequence_search (priv->split_seq, NULL,
+                              split_node_date_order, &date);
+    if (g_sequence_iter_is_begin (iter))
+        return NULL;
+    return ((GList *) g_sequence_get (g_sequence_iter_prev (iter)))->data;
 }
 
+/********************************************************************\
+\********************************************************************/
+
+/* Split queries by account or by posting date are served by the
+ * accounts' split trees rather than by checking every split of the
+ * book.  The trees hold the splits as of their transactions' last
+ * commit, like xaccAccountGetSplitList(), so while any transaction has
+ * an edit open, in which xaccSplitSetAccount() or a new posting date
+ * may have moved a split, the queries check every split instead. */
+
+static gboolean
+guid_list_has_before (const GList *guids, const GList *node)
+{
+    for (; guids != node; guids = guids->next)
+        if (guid_equal (guids->data, node->data))
+            return TRUE;
+    return FALSE;
+}
+
+static gint64
+split_account_index_estimate (QofBook *book, const QofQueryIndexKey *key)
+{
+    const GList *node;
+    gint64 count = 0;
+
+    if (xaccTransAnyOpen ())
+        return -1;
+    for (node = key->guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+        if (acc && !guid_list_has_before (key->guids, node))
+            count += g_hash_table_size (GET_PRIVATE(acc)->split_iters);
+    }
+    return count;
+}
+
+static void
+split_account_index_lookup (QofBook *book, const QofQueryIndexKey *key,
+                            QofInstanceForeachCB cb, gpointer user_data)
+{
+    const GList *node, *lp;
+
+    for (node = key->guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+        if (!acc || guid_list_has_before (key->guids, node))
+            continue;
+        for (lp = GET_PRIVATE(acc)->splits; lp; lp = lp->next)
+            cb (lp->data, user_data);
+    }
+}
+
+static const QofQueryIndex split_account_index =
+{
+    "split account",
+    split_account_index_estimate,
+    split_account_index_lookup,
+};
+
+typedef struct
+{
+    const QofQueryIndexKey *key;
+    gint64 in_range;
+    gint64 in_accounts;
+    QofInstanceForeachCB cb;
+    gpointer user_data;
+} SplitDateIndexData;
+
+/* Find the splits of the account posted in the key's range, as the
+ * tree items [*first, *last). */
+static void
+account_date_range (Account *acc, const QofQueryIndexKey *key,
+                    GSequenceIter **first, GSequenceIter **last)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    time64 end;
+
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+    *first = g_sequence_search (priv->split_seq, NULL,
+                                split_node_date_order, (gpointer) &key->start);
+    if (key->end == G_MAXINT64)
+    {
+        *last = g_sequence_get_end_iter (priv->split_seq);
+        return;
+    }
+    end = key->end + 1;
+    *last = g_sequence_search (priv->split_seq, NULL,
+                               split_node_date_order, &end);
+}
+
+static void
+split_date_index_count (QofInstance *inst, gpointer user_data)
+{
+    SplitDateIndexData *data = user_data;
+    Account *acc = GNC_ACCOUNT(inst);
+    GSequenceIter *first, *last;
+
+    account_date_range (acc, data->key, &first, &last);
+    data->in_range += g_sequence_iter_get_position (last) -
+                      g_sequence_iter_get_position (first);
+    data->in_accounts += g_hash_table_size (GET_PRIVATE(acc)->split_iters);
+}
+
+static gint64
+split_date_index_estimate (QofBook *book, const QofQueryIndexKey *key)
+{
+    SplitDateIndexData data = { key, 0, 0, NULL, NULL };
+
+    if (xaccTransAnyOpen ())
+        return -1;
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            split_date_index_count, &data);
+
+    /* Splits not yet committed to an account can only be found by
+     * checking them all. */
+    if (data.in_accounts !=
+            qof_collection_count (qof_book_get_collection (book, GNC_ID_SPLIT)))
+        return -1;
+    return data.in_range;
+}
+
+static void
+split_date_index_visit (QofInstance *inst, gpointer user_data)
+{
+    SplitDateIndexData *data = user_data;
+    GSequenceIter *iter, *last;
+
+    account_date_range (GNC_ACCOUNT(inst), data->key, &iter, &last);
+    for (; iter != last; iter = g_sequence_iter_next (iter))
+        data->cb (((GList *) g_sequence_get (iter))->data, data->user_data);
+}
+
+static void
+split_date_index_lookup (QofBook *book, const QofQueryIndexKey *key,
+                         QofInstanceForeachCB cb, gpointer user_data)
+{
+    SplitDateIndexData data = { key, 0, 0, cb, user_data };
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_ACCOUNT),
+                            split_date_index_visit, &data);
+}
+
+static const QofQueryIndex split_date_index =
+{
+    "split date posted",
+    split_date_index_estimate,
+    split_date_index_lookup,
+};
+
 static void
 xaccAccountBringUpToDate(Account *acc)
 {
@@ -2065,6 +2547,10 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * in dollars.  Thus, two different mechanisms must be used to      *
  * compute balances, depending on account type.                     *
  *                                                                  *
+ * Only the splits from priv->first_dirty, the earliest one flagged *
+ * balance_dirty, onwards are recomputed; the running balance of    *
+ * the split before it is correct and is the starting point.        *
+ *                                                                  *
  * Args:   account -- the account for which to recompute balances   *
  * Return: void                                                     *
 \********************************************************************/
@@ -2076,7 +2562,7 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
+    GList *lp = NULL, *prev = NULL;
 
     if (NULL == acc) return;
 
@@ -2086,13 +2572,36 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Skip over the splits whose running balances are still good. */
+    if (priv->first_dirty)
+    {
+        lp = g_sequence_get (g_hash_table_lookup (priv->split_iters,
+                             priv->first_dirty));
+        prev = lp->prev;
+    }
+    else if (priv->splits)
+    {
+        prev = g_sequence_get (g_sequence_iter_prev (
+                                   g_sequence_get_end_iter (priv->split_seq)));
+    }
+
+    if (prev)
+    {
+        Split *split = (Split *) prev->data;
+        balance            = split->balance;
+        cleared_balance    = split->cleared_balance;
+        reconciled_balance = split->reconciled_balance;
+    }
+    else
+    {
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
 
     PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
            priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    for (; lp; lp = lp->next)
     {
         Split *split = (Split *) lp->data;
         gnc_numeric amt = xaccSplitGetAmount (split);
@@ -2114,13 +2623,14 @@ xaccAccountRecomputeBalance (Account * acc)
         split->balance = balance;
         split->cleared_balance = cleared_balance;
         split->reconciled_balance = reconciled_balance;
-
+        split->balance_dirty = FALSE;
     }
 
     priv->balance = balance;
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->first_dirty = NULL;
 }
 
 /********************************************************************\
@@ -2235,7 +2745,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    account_set_balance_dirty_from (priv, priv->splits); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2417,7 +2927,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, priv->splits);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3203,7 +3713,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, priv->splits);
 }
 
 void
@@ -3216,7 +3726,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, priv->splits);
 }
 
 void
@@ -3229,7 +3739,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_set_balance_dirty_from (priv, priv->splits);
 }
 
 gnc_numeric
@@ -3294,103 +3804,41 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
-    AccountPrivate *priv;
-    GList   *lp;
-    Timespec ts, trans_ts;
-    gboolean found = FALSE;
-    gnc_numeric balance;
+    Split *split;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
-    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
-    xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
-
-    priv = GET_PRIVATE(acc);
-    balance = priv->balance;
-
-    /* Since transaction post times are stored as a Timespec,
-     * convert date into a Timespec as well rather than converting
-     * each transaction's Timespec into a time64.
-     *
-     * FIXME: CAS: I think this comment is a bogus justification for
-     * using xaccTransGetDatePostedTS.  There's no benefit to using
-     * Timespec when the input argument is time64, and it's hard to
-     * imagine that casting long long to long and comparing two longs is
-     * worse than comparing two long longs every time.  IMO,
-     * xaccAccountGetPresentBalance gets this right, and its algorithm
-     * should be used here.
-     */
-    ts.tv_sec = date;
-    ts.tv_nsec = 0;
-
-    lp = priv->splits;
-    while ( lp && !found )
-    {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
-        if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
-            found = TRUE;
-        else
-            lp = lp->next;
-    }
-
-    if ( lp )
-    {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
-        }
-    }
-
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
+    /* The running balance of the last split before the date is the
+     * answer.  If there is none, the AsOf date must be before any
+     * entries, so return zero. */
+    split = account_find_last_split_before (acc, date);
+    if (!split)
+        return gnc_numeric_zero();
 
-    return( balance );
+    return xaccSplitGetBalance (split);
 }
 
 /*
  * Originally gsr_account_present_balance in gnc-split-reg.c
  *
- * How does this routine compare to xaccAccountGetBalanceAsOfDate just
- * above?  These two routines should eventually be collapsed into one.
- * Perhaps the startup logic from that one, and the logic from this
- * one that walks from the tail of the split list.
+ * This is the balance as of the end of today, i.e. the running
+ * balance of the last split posted no later than today.
  */
+/* XXX: violates the const'ness by forcing a sort before searching
+ * the splits. */
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
-    AccountPrivate *priv;
-    GList *node;
-    time64 today;
+    Split *split;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
-    priv = GET_PRIVATE(acc);
-    today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
-    {
-        Split *split = node->data;
-
-        if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
-            return xaccSplitGetBalance (split);
-    }
+    split = account_find_last_split_before ((Account*)acc,
+                                            gnc_time64_get_today_end() + 1);
+    if (!split)
+        return gnc_numeric_zero ();
 
-    return gnc_numeric_zero ();
+    return xaccSplitGetBalance (split);
 }
 
 
@@ -3709,6 +4157,16 @@ xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
 /********************************************************************\
 \********************************************************************/
 
+/* A backend which loads transactions as needed may not have loaded
+ * them all yet; everything here that walks the account's splits
+ * itself, rather than through a query, has it load them first. */
+static void
+account_load_splits (const Account *acc)
+{
+    QofBook *book = qof_instance_get_book (acc);
+    qof_backend_load_related (qof_book_get_backend (book), QOF_INSTANCE (acc));
+}
+
 /* THIS API NEEDS TO CHANGE.
  *
  * This code exposes the internal structure of the account object to
@@ -3724,6 +4182,7 @@ SplitList *
 xaccAccountGetSplitList (const Account *acc)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    account_load_splits (acc);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
     return GET_PRIVATE(acc)->splits;
 }
@@ -3736,7 +4195,8 @@ xaccAccountCountSplits (const Account *acc, gboolean include_children)
     nr = 0;
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
 
-    nr = g_list_length(xaccAccountGetSplitList(acc));
+    account_load_splits (acc);
+    nr = g_hash_table_size(GET_PRIVATE(acc)->split_iters);
     if (include_children && (gnc_account_n_children(acc) != 0))
     {
         for (i=0; i < gnc_account_n_children(acc); i++)
@@ -4714,6 +5174,7 @@ finder_help_function(const Account *acc, const char *description,
 
     /* Then see if we have any work to do */
     if (acc == NULL) return;
+    account_load_splits (acc);
 
     /* Why is this loop iterated backwards ?? Presumably because the split
      * list is in date order, and the most recent matches should be
@@ -4936,6 +5397,7 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
 
     if (!acc) return 0;
 
+    account_load_splits (acc);
     priv = GET_PRIVATE(acc);
     for (split_p = priv->splits; split_p; split_p = next)
     {
@@ -4985,6 +5447,7 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
+    account_load_splits (acc);
     for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
     {
         s = split_p->data;
@@ -5159,16 +5622,16 @@ struct token_accounts_info
  * \note Can always assume that keys are unique, reduces code in this function
  */
 static void
-buildTokenInfo(const char *key, const GValue *value, gpointer data)
+buildTokenInfo(const char *key, gint64 token_count, gpointer data)
 {
     struct token_accounts_info *tokenInfo = (struct token_accounts_info*)data;
     struct account_token_count* this_account;
 
     //  PINFO("buildTokenInfo: account '%s', token_count: '%" G_GINT64_FORMAT "'", (char*)key,
-    //                  g_value_get_int64(value));
+    //                  token_count);
 
     /* add the count to the total_count */
-    tokenInfo->total_count += g_value_get_int64(value);
+    tokenInfo->total_count += token_count;
 
     /* allocate a new structure for this account and it's token count */
     this_account = (struct account_token_count*)
@@ -5176,7 +5639,7 @@ buildTokenInfo(const char *key, const GValue *value, gpointer data)
 
     /* fill in the account guid and number of tokens found for this account guid */
     this_account->account_guid = (char*)key;
-    this_account->token_count = g_value_get_int64(value);
+    this_account->token_count = token_count;
 
     /* append onto the glist a pointer to the new account_token_count structure */
     tokenInfo->accounts = g_list_prepend(tokenInfo->accounts, this_account);
@@ -5281,9 +5744,13 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
     GHashTable *final_probabilities = g_hash_table_new(g_str_hash,
                                                        g_str_equal);
     struct account_info account_i;
+    static const QofKvpPath *bayes_path = NULL;
 
     ENTER(" ");
 
+    if (!bayes_path)
+        bayes_path = qof_kvp_path_intern (IMAP_FRAME_BAYES);
+
     /* check to see if the imap is NULL */
     if (!imap)
     {
@@ -5298,8 +5765,6 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
     for (current_token = tokens; current_token;
          current_token = current_token->next)
     {
-        char* path = g_strdup_printf (IMAP_FRAME_BAYES "/%s",
-                                            (char*)current_token->data);
         /* zero out the token_accounts_info structure */
         memset(&tokenInfo, 0, sizeof(struct token_accounts_info));
 
@@ -5309,9 +5774,9 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
          * doesn't already exist or adding to the existing accounts token
          * count if it does
          */
-        qof_instance_foreach_slot(QOF_INSTANCE (imap->acc), path,
-                                  buildTokenInfo, &tokenInfo);
-        g_free (path);
+        qof_instance_foreach_slot_int64(QOF_INSTANCE (imap->acc), bayes_path,
+                                        (char*)current_token->data,
+                                        buildTokenInfo, &tokenInfo);
         /* for each account we have just found, see if the account
          * already exists in the list of account probabilities, if not
          * add it
@@ -6091,6 +6556,15 @@ gboolean xaccAccountRegister (void)
 
     qof_class_register (GNC_ID_ACCOUNT, (QofSortFunc) qof_xaccAccountOrder, params);
 
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                          QOF_PARAM_GUID, NULL),
+                              QOF_TYPE_GUID, &split_account_index);
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DATE_POSTED, NULL),
+                              QOF_TYPE_DATE, &split_date_index);
+
     return qof_object_register (&account_object_def);
 }
 
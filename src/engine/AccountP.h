@@ -109,9 +109,20 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    Split *first_dirty;         /* earliest split with a stale balance */
 
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
+    gboolean sort_all;          /* ... anywhere, not just at sort_suspects */
+    GHashTable *sort_suspects;  /* splits that may be out of place */
+
+    /* The split list is backed by a balanced tree holding its nodes in
+     * the same order, giving O(log n) sorted insertion and lookups by
+     * date posted, and by a map from each split to its tree item for
+     * O(1) membership tests and removal.  See Account.c.
+     */
+    GSequence *split_seq;       /* tree of the GList nodes in 'splits' */
+    GHashTable *split_iters;    /* Split* -> GSequenceIter* in split_seq */
 
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
@@ -132,6 +143,19 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Mark the running balances of the split and of every split after it
+ * in the account as needing recomputation.  Unlike
+ * gnc_account_set_balance_dirty(), the balances of the splits before
+ * it are kept, so the next xaccAccountRecomputeBalance() only has to
+ * redo the tail of the account. */
+void gnc_account_set_balance_dirty_from_split (Account *acc, Split *split);
+
+/* Mark the split as possibly out of place in the account's sort
+ * order.  Unlike gnc_account_set_sort_dirty(), the next
+ * xaccAccountSortSplits() then only has to check and move this split
+ * and the others so marked, not the whole account. */
+void gnc_account_set_sort_dirty_from_split (Account *acc, Split *split);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
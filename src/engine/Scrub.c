@@ -64,6 +64,7 @@ xaccAccountTreeScrubOrphans (Account *acc)
 {
     if (!acc) return;
 
+    xaccScrubUtilityLoadAll (acc);
     xaccAccountScrubOrphans (acc);
     gnc_account_foreach_descendant(acc,
                                    (AccountCb)xaccAccountScrubOrphans, NULL);
@@ -110,6 +111,7 @@ xaccAccountScrubOrphans (Account *acc)
     str = xaccAccountGetName (acc);
     str = str ? str : "(null)";
     PINFO ("Looking for orphans in account %s \n", str);
+    xaccScrubUtilityLoadAll (acc);
 
     for (node = xaccAccountGetSplitList(acc); node; node = node->next)
     {
@@ -159,6 +161,7 @@ xaccAccountTreeScrubSplits (Account *account)
 {
     if (!account) return;
 
+    xaccScrubUtilityLoadAll (account);
     xaccAccountScrubSplits (account);
     gnc_account_foreach_descendant(account,
                                    (AccountCb)xaccAccountScrubSplits, NULL);
@@ -169,6 +172,7 @@ xaccAccountScrubSplits (Account *account)
 {
     GList *node;
 
+    xaccScrubUtilityLoadAll (account);
     for (node = xaccAccountGetSplitList (account); node; node = node->next)
         xaccSplitScrub (node->data);
 }
@@ -276,6 +280,7 @@ xaccSplitScrub (Split *split)
 void
 xaccAccountTreeScrubImbalance (Account *acc)
 {
+    xaccScrubUtilityLoadAll (acc);
     xaccAccountScrubImbalance (acc);
     gnc_account_foreach_descendant(acc,
                                    (AccountCb)xaccAccountScrubImbalance, NULL);
@@ -293,6 +298,7 @@ xaccAccountScrubImbalance (Account *acc)
     str = xaccAccountGetName(acc);
     str = str ? str : "(null)";
     PINFO ("Looking for imbalance in account %s \n", str);
+    xaccScrubUtilityLoadAll (acc);
 
     splits = xaccAccountGetSplitList(acc);
     split_count = g_list_length (splits);
@@ -1337,6 +1343,18 @@ xaccAccountScrubKvp (Account *account)
 
 /* ================================================================ */
 
+void
+xaccScrubUtilityLoadAll (const Account *acc)
+{
+    QofBook *book;
+
+    if (!acc) return;
+    book = gnc_account_get_book (acc);
+    qof_backend_load_related (qof_book_get_backend (book), QOF_INSTANCE (book));
+}
+
+/* ================================================================ */
+
 Account *
 xaccScrubUtilityGetOrMakeAccount (Account *root, gnc_commodity * currency,
                                   const char *accname, GNCAccountType acctype,
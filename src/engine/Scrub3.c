@@ -42,6 +42,7 @@
 #include "AccountP.h"
 #include "Scrub2.h"
 #include "Scrub3.h"
+#include "ScrubP.h"
 #include "Transaction.h"
 #include "TransactionP.h"
 
@@ -163,6 +164,7 @@ xaccAccountScrubLots (Account *acc)
     if (FALSE == xaccAccountHasTrades (acc)) return;
 
     ENTER ("(acc=%s)", xaccAccountGetName(acc));
+    xaccScrubUtilityLoadAll (acc);
     xaccAccountBeginEdit(acc);
     xaccAccountAssignLots (acc);
 
@@ -191,6 +193,7 @@ xaccAccountTreeScrubLots (Account *acc)
 {
     if (!acc) return;
 
+    xaccScrubUtilityLoadAll (acc);
     gnc_account_foreach_descendant(acc, lot_scrub_cb, NULL);
     xaccAccountScrubLots (acc);
 }
@@ -39,6 +39,7 @@
 #include "gncInvoice.h"
 #include "Scrub2.h"
 #include "ScrubBusiness.h"
+#include "ScrubP.h"
 #include "Transaction.h"
 
 #undef G_LOG_DOMAIN
@@ -524,6 +525,7 @@ gncScrubBusinessAccountLots (Account *acc)
 
     ENTER ("(acc=%s)", str);
     PINFO ("Cleaning up superfluous lot links in account %s \n", str);
+    xaccScrubUtilityLoadAll (acc);
     xaccAccountBeginEdit(acc);
 
     lots = xaccAccountGetLotList(acc);
@@ -565,6 +567,7 @@ gncScrubBusinessAccountSplits (Account *acc)
 
     ENTER ("(acc=%s)", str);
     PINFO ("Cleaning up superfluous lot links in account %s \n", str);
+    xaccScrubUtilityLoadAll (acc);
     xaccAccountBeginEdit(acc);
 
     splits = xaccAccountGetSplitList(acc);
@@ -613,6 +616,7 @@ gncScrubBusinessAccountTree (Account *acc)
 {
     if (!acc) return;
 
+    xaccScrubUtilityLoadAll (acc);
     gnc_account_foreach_descendant(acc, lot_scrub_cb, NULL);
     gncScrubBusinessAccount (acc);
 }
@@ -37,5 +37,10 @@ Account * xaccScrubUtilityGetOrMakeAccount (Account *root,
         gnc_commodity * currency, const char *accname,
         GNCAccountType acctype, gboolean placeholder);
 
+/* Scrubbing follows splits into other accounts and lots, so a backend
+ * which loads transactions as they are needed must load all of them
+ * first.  Not for public use. */
+void xaccScrubUtilityLoadAll (const Account *acc);
+
 
 #endif /* XACC_SCRUB_P_H */
@@ -60,11 +60,17 @@
 const char *void_former_amt_str = "void-former-amount";
 const char *void_former_val_str = "void-former-value";
 
+/* Interned path of the split type, read whenever a split is drawn; set up
+ * by the class init. */
+static const QofKvpPath *split_type_path = NULL;
+
 #define PRICE_SIGFIGS 6
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_ENGINE;
 
+static void split_sort_key_free (SplitSortKey *key);
+
 /* KVP key values used for SX info stored Split's slots. */
 #define GNC_SX_ID                    "sched-xaction"
 #define GNC_SX_ACCOUNT               "account"
@@ -123,9 +129,14 @@ gnc_split_init(Split* split)
     split->balance             = gnc_numeric_zero();
     split->cleared_balance     = gnc_numeric_zero();
     split->reconciled_balance  = gnc_numeric_zero();
+    split->balance_dirty       = FALSE;
+
+    split->sort_key     = NULL;
 
     split->gains = GAINS_STATUS_UNKNOWN;
     split->gains_split = NULL;
+
+    split->dirty_fields = SPLIT_DIRTY_ALL;
 }
 
 static void
@@ -321,6 +332,8 @@ gnc_split_class_init(SplitClass* klass)
     gobject_class->set_property = gnc_split_set_property;
     gobject_class->get_property = gnc_split_get_property;
 
+    split_type_path = qof_kvp_path_intern ("split-type");
+
     g_object_class_install_property
         (gobject_class,
          PROP_ACTION,
@@ -537,6 +550,8 @@ xaccSplitReinit(Split * split)
 
     split->gains = GAINS_STATUS_UNKNOWN;
     split->gains_split = NULL;
+
+    split->dirty_fields = SPLIT_DIRTY_ALL;
 }
 
 /********************************************************************\
@@ -715,6 +730,8 @@ xaccFreeSplit (Split *split)
     }
     CACHE_REMOVE(split->memo);
     CACHE_REMOVE(split->action);
+    split_sort_key_free (split->sort_key);
+    split->sort_key = NULL;
 
     /* Just in case someone looks up freed memory ... */
     split->memo        = (char *) 1;
@@ -740,7 +757,8 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_sort_dirty_from_split (s->acc, s);
+        gnc_account_set_balance_dirty_from_split (s->acc, s);
     }
 
     /* set dirty flag on lot too. */
@@ -944,6 +962,7 @@ xaccSplitSetAccount (Split *s, Account *acc)
         xaccTransBeginEdit(trans);
 
     s->acc = acc;
+    s->dirty_fields |= SPLIT_DIRTY_ACCOUNT;
     qof_instance_set_dirty(QOF_INSTANCE(s));
 
     if (trans)
@@ -1027,7 +1046,8 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_sort_dirty_from_split (acc, s);
+        gnc_account_set_balance_dirty_from_split (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1041,7 +1061,10 @@ xaccSplitRollbackEdit(Split *s)
        only because we don't emit events for changing accounts until
        the final commit. */
     if (s->acc != s->orig_acc)
+    {
         s->acc = s->orig_acc;
+        s->dirty_fields |= SPLIT_DIRTY_ACCOUNT;
+    }
 
     /* Undestroy if needed */
     if (qof_instance_get_destroying(s) && s->parent)
@@ -1167,6 +1190,7 @@ xaccSplitSetSharePriceAndAmount (Split *s, gnc_numeric price, gnc_numeric amt)
                                     GNC_HOW_RND_ROUND_HALF_UP);
     s->value  = gnc_numeric_mul(s->amount, price,
                                 get_currency_denom(s), GNC_HOW_RND_ROUND_HALF_UP);
+    s->dirty_fields |= SPLIT_DIRTY_AMOUNT | SPLIT_DIRTY_VALUE;
 
     SET_GAINS_A_VDIRTY(s);
     mark_split (s);
@@ -1182,6 +1206,7 @@ qofSplitSetSharePrice (Split *split, gnc_numeric price)
     split->value = gnc_numeric_mul(xaccSplitGetAmount(split),
                                    price, get_currency_denom(split),
                                    GNC_HOW_RND_ROUND_HALF_UP);
+    split->dirty_fields |= SPLIT_DIRTY_VALUE;
 }
 
 void
@@ -1194,6 +1219,7 @@ xaccSplitSetSharePrice (Split *s, gnc_numeric price)
     s->value = gnc_numeric_mul(xaccSplitGetAmount(s),
                                price, get_currency_denom(s),
                                GNC_HOW_RND_ROUND_HALF_UP);
+    s->dirty_fields |= SPLIT_DIRTY_VALUE;
 
     SET_GAINS_VDIRTY(s);
     mark_split (s);
@@ -1215,12 +1241,14 @@ qofSplitSetAmount (Split *split, gnc_numeric amt)
     {
         split->amount = amt;
     }
+    split->dirty_fields |= SPLIT_DIRTY_AMOUNT;
 }
 
 /* The amount of the split in the _account's_ commodity. */
 void
 xaccSplitSetAmount (Split *s, gnc_numeric amt)
 {
+    gnc_numeric old_amt;
     if (!s) return;
     g_return_if_fail(gnc_numeric_check(amt) == GNC_ERROR_OK);
     ENTER ("(split=%p) old amt=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT
@@ -1228,6 +1256,7 @@ xaccSplitSetAmount (Split *s, gnc_numeric amt)
            s->amount.num, s->amount.denom, amt.num, amt.denom);
 
     xaccTransBeginEdit (s->parent);
+    old_amt = s->amount;
     if (s->acc)
     {
         s->amount = gnc_numeric_convert(amt, get_commodity_denom(s),
@@ -1236,6 +1265,10 @@ xaccSplitSetAmount (Split *s, gnc_numeric amt)
     }
     else
         s->amount = amt;
+    /* Committing reconverts the amount of a split that was moved or
+     * loaded, usually to the same thing. */
+    if (!gnc_numeric_eq (s->amount, old_amt))
+        s->dirty_fields |= SPLIT_DIRTY_AMOUNT;
 
     SET_GAINS_ADIRTY(s);
     mark_split (s);
@@ -1250,6 +1283,7 @@ qofSplitSetValue (Split *split, gnc_numeric amt)
     g_return_if_fail(split);
     split->value = gnc_numeric_convert(amt,
                                        get_currency_denom(split), GNC_HOW_RND_ROUND_HALF_UP);
+    split->dirty_fields |= SPLIT_DIRTY_VALUE;
     g_assert(gnc_numeric_check (split->value) != GNC_ERROR_OK);
 }
 
@@ -1270,7 +1304,11 @@ xaccSplitSetValue (Split *s, gnc_numeric amt)
                                   GNC_HOW_RND_ROUND_HALF_UP);
     if (gnc_numeric_check(new_val) == GNC_ERROR_OK &&
         !(gnc_numeric_zero_p (new_val) && !gnc_numeric_zero_p (amt)))
+    {
+        if (!gnc_numeric_eq (s->value, new_val))
+            s->dirty_fields |= SPLIT_DIRTY_VALUE;
         s->value = new_val;
+    }
     else PERR("numeric error %s in converting the split value's denominator with amount %s and denom  %d", gnc_numeric_errorCode_to_string(gnc_numeric_check(new_val)), gnc_numeric_to_string(amt), get_currency_denom(s));
 
     SET_GAINS_VDIRTY(s);
@@ -1349,6 +1387,7 @@ xaccSplitSetBaseValue (Split *s, gnc_numeric value,
               gnc_commodity_get_printname(commodity));
         return;
     }
+    s->dirty_fields |= SPLIT_DIRTY_AMOUNT | SPLIT_DIRTY_VALUE;
 
     SET_GAINS_A_VDIRTY(s);
     mark_split (s);
@@ -1481,23 +1520,19 @@ xaccSplitDestroy (Split *split)
 /********************************************************************\
 \********************************************************************/
 
-gint
-xaccSplitOrder (const Split *sa, const Split *sb)
+/* The ordering of xaccSplitOrder() without the sort keys, for the
+ * splits that don't get one: those with a NULL action when the book
+ * uses the split action as the num. */
+static gint
+split_order_uncached (const Split *sa, const Split *sb,
+                      gboolean action_for_num)
 {
     int retval;
     int comp;
     char *da, *db;
-    gboolean action_for_num;
-
-    if (sa == sb) return 0;
-    /* nothing is always less than something */
-    if (!sa) return -1;
-    if (!sb) return +1;
 
     /* sort in transaction order, but use split action rather than trans num
      * according to book option */
-    action_for_num = qof_book_use_split_action_for_num_field
-        (xaccSplitGetBook (sa));
     if (action_for_num)
         retval = xaccTransOrder_num_action (sa->parent, sa->action,
                                             sb->parent, sb->action);
@@ -1542,6 +1577,204 @@ xaccSplitOrder (const Split *sa, const Split *sb)
     return 0;
 }
 
+guint
+xaccSplitGetDirtyFields (const Split *split)
+{
+    g_return_val_if_fail (split, SPLIT_DIRTY_ALL);
+    return split->dirty_fields;
+}
+
+void
+xaccSplitClearDirtyFields (Split *split)
+{
+    g_return_if_fail (split);
+    split->dirty_fields = 0;
+}
+
+/* The sort key of a split: a byte string that compares with memcmp()
+ * the way xaccSplitOrder() orders splits on their transaction's date,
+ * num and description, the transaction's guid and the split's memo,
+ * action and reconciled flag.  The key keeps copies of the fields it
+ * was built from and is rebuilt when they no longer match, so it
+ * doesn't matter how the fields were changed. */
+struct SplitSortKey
+{
+    gboolean action_for_num;
+    const Transaction *trans;
+    GncGUID trans_guid;
+    Timespec date_posted;
+    Timespec date_entered;
+    char *num;
+    char *description;
+    char *memo;
+    char *action;
+    char reconciled;
+    GByteArray *bytes;
+};
+
+static void
+split_sort_key_free (SplitSortKey *key)
+{
+    if (!key) return;
+    g_free (key->num);
+    g_free (key->description);
+    g_free (key->memo);
+    g_free (key->action);
+    g_byte_array_free (key->bytes, TRUE);
+    g_free (key);
+}
+
+/* Append a signed integer so that memcmp() orders it numerically:
+ * big-endian with the sign bit flipped. */
+static void
+sort_key_append_int64 (GByteArray *bytes, gint64 val)
+{
+    guint64 uval = (guint64) val ^ G_GUINT64_CONSTANT (0x8000000000000000);
+    guint8 buf[8];
+    int i;
+
+    for (i = 7; i >= 0; i--, uval >>= 8)
+        buf[i] = uval & 0xff;
+    g_byte_array_append (bytes, buf, sizeof (buf));
+}
+
+/* Append the collation key of str, including its terminating nul so
+ * that a shorter key sorts before any longer one it prefixes. */
+static void
+sort_key_append_collate_key (GByteArray *bytes, const char *str)
+{
+    gchar *ckey = g_utf8_collate_key (str ? str : "", -1);
+    g_byte_array_append (bytes, (guint8 *) ckey, strlen (ckey) + 1);
+    g_free (ckey);
+}
+
+static SplitSortKey *
+split_sort_key_new (const Split *split, gboolean action_for_num)
+{
+    const Transaction *trans = split->parent;
+    SplitSortKey *key = g_new0 (SplitSortKey, 1);
+    guint8 byte;
+
+    key->action_for_num = action_for_num;
+    key->trans = trans;
+    key->memo = g_strdup (split->memo);
+    key->action = g_strdup (split->action);
+    key->reconciled = split->reconciled;
+    key->bytes = g_byte_array_sized_new (96);
+
+    /* Splits with a transaction come before splits without one. */
+    byte = trans ? 0 : 1;
+    g_byte_array_append (key->bytes, &byte, 1);
+    if (trans)
+    {
+        const char *num = action_for_num ? split->action : trans->num;
+        if (!num) num = "";
+
+        key->trans_guid = *qof_instance_get_guid (trans);
+        key->date_posted = trans->date_posted;
+        key->date_entered = trans->date_entered;
+        key->num = g_strdup (trans->num);
+        key->description = g_strdup (trans->description);
+
+        sort_key_append_int64 (key->bytes, trans->date_posted.tv_sec);
+        sort_key_append_int64 (key->bytes, trans->date_posted.tv_nsec);
+        sort_key_append_int64 (key->bytes, atoi (num));
+        sort_key_append_int64 (key->bytes, trans->date_entered.tv_sec);
+        sort_key_append_int64 (key->bytes, trans->date_entered.tv_nsec);
+        sort_key_append_collate_key (key->bytes, trans->description);
+        g_byte_array_append (key->bytes, key->trans_guid.reserved,
+                             GUID_DATA_SIZE);
+    }
+    sort_key_append_collate_key (key->bytes, split->memo);
+    sort_key_append_collate_key (key->bytes, split->action);
+    byte = split->reconciled;
+    g_byte_array_append (key->bytes, &byte, 1);
+    return key;
+}
+
+/* Whether the key still matches the fields of the split and its
+ * transaction.  This is much cheaper than building the key, which
+ * collates the strings. */
+static gboolean
+split_sort_key_valid (const SplitSortKey *key, const Split *split,
+                      gboolean action_for_num)
+{
+    const Transaction *trans = split->parent;
+
+    if (key->action_for_num != action_for_num || key->trans != trans ||
+            key->reconciled != split->reconciled ||
+            g_strcmp0 (key->memo, split->memo) ||
+            g_strcmp0 (key->action, split->action))
+        return FALSE;
+    if (!trans)
+        return TRUE;
+    return timespec_equal (&key->date_posted, &trans->date_posted) &&
+           timespec_equal (&key->date_entered, &trans->date_entered) &&
+           guid_equal (&key->trans_guid, qof_instance_get_guid (trans)) &&
+           !g_strcmp0 (key->num, trans->num) &&
+           !g_strcmp0 (key->description, trans->description);
+}
+
+static const GByteArray *
+split_get_sort_key (Split *split, gboolean action_for_num)
+{
+    if (!split->sort_key ||
+            !split_sort_key_valid (split->sort_key, split, action_for_num))
+    {
+        split_sort_key_free (split->sort_key);
+        split->sort_key = split_sort_key_new (split, action_for_num);
+    }
+    return split->sort_key->bytes;
+}
+
+gint
+xaccSplitOrder (const Split *sa, const Split *sb)
+{
+    const GByteArray *ka, *kb;
+    int retval;
+    int comp;
+    gboolean action_for_num;
+
+    if (sa == sb) return 0;
+    /* nothing is always less than something */
+    if (!sa) return -1;
+    if (!sb) return +1;
+
+    action_for_num = qof_book_use_split_action_for_num_field
+        (xaccSplitGetBook (sa));
+    /* Splits with a NULL action under the split-action num option
+     * don't get a key, see split_order_uncached(). */
+    if (action_for_num && (!sa->action || !sb->action))
+        return split_order_uncached (sa, sb, action_for_num);
+
+    /* The keys cover everything up to and including the reconciled
+     * flag; a difference is always found before the shorter key ends. */
+    ka = split_get_sort_key ((Split *) sa, action_for_num);
+    kb = split_get_sort_key ((Split *) sb, action_for_num);
+    retval = memcmp (ka->data, kb->data, MIN (ka->len, kb->len));
+    if (retval) return retval < 0 ? -1 : +1;
+    if (ka->len != kb->len)
+        return ka->len < kb->len ? -1 : +1;
+
+    /* compare amounts */
+    comp = gnc_numeric_compare(xaccSplitGetAmount(sa), xaccSplitGetAmount (sb));
+    if (comp < 0) return -1;
+    if (comp > 0) return +1;
+
+    comp = gnc_numeric_compare(xaccSplitGetValue(sa), xaccSplitGetValue (sb));
+    if (comp < 0) return -1;
+    if (comp > 0) return +1;
+
+    /* if dates differ, return */
+    DATE_CMP(sa, sb, date_reconciled);
+
+    /* else, sort on guid - keeps sort stable. */
+    retval = qof_instance_guid_compare(sa, sb);
+    if (retval) return retval;
+
+    return 0;
+}
+
 gint
 xaccSplitOrderDateOnly (const Split *sa, const Split *sb)
 {
@@ -1710,6 +1943,7 @@ qofSplitSetMemo (Split *split, const char* memo)
 {
     g_return_if_fail(split);
     CACHE_REPLACE(split->memo, memo);
+    split->dirty_fields |= SPLIT_DIRTY_MEMO;
 }
 
 void
@@ -1719,6 +1953,7 @@ xaccSplitSetMemo (Split *split, const char *memo)
     xaccTransBeginEdit (split->parent);
 
     CACHE_REPLACE(split->memo, memo);
+    split->dirty_fields |= SPLIT_DIRTY_MEMO;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1729,6 +1964,7 @@ qofSplitSetAction (Split *split, const char *actn)
 {
     g_return_if_fail(split);
     CACHE_REPLACE(split->action, actn);
+    split->dirty_fields |= SPLIT_DIRTY_ACTION;
 }
 
 void
@@ -1738,6 +1974,7 @@ xaccSplitSetAction (Split *split, const char *actn)
     xaccTransBeginEdit (split->parent);
 
     CACHE_REPLACE(split->action, actn);
+    split->dirty_fields |= SPLIT_DIRTY_ACTION;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1755,6 +1992,7 @@ qofSplitSetReconcile (Split *split, char recn)
         case FREC:
         case VREC:
             split->reconciled = recn;
+            split->dirty_fields |= SPLIT_DIRTY_RECONCILE;
             mark_split (split);
             xaccAccountRecomputeBalance (split->acc);
             break;
@@ -1778,6 +2016,7 @@ xaccSplitSetReconcile (Split *split, char recn)
         case FREC:
         case VREC:
             split->reconciled = recn;
+            split->dirty_fields |= SPLIT_DIRTY_RECONCILE;
             mark_split (split);
             qof_instance_set_dirty(QOF_INSTANCE(split));
             xaccAccountRecomputeBalance (split->acc);
@@ -1798,6 +2037,7 @@ xaccSplitSetDateReconciledSecs (Split *split, time64 secs)
 
     split->date_reconciled.tv_sec = secs;
     split->date_reconciled.tv_nsec = 0;
+    split->dirty_fields |= SPLIT_DIRTY_DATE_RECONCILED;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1810,6 +2050,7 @@ xaccSplitSetDateReconciledTS (Split *split, Timespec *ts)
     xaccTransBeginEdit (split->parent);
 
     split->date_reconciled = *ts;
+    split->dirty_fields |= SPLIT_DIRTY_DATE_RECONCILED;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1871,6 +2112,7 @@ xaccSplitSetParent(Split *s, Transaction *t)
         qof_event_gen(&old_trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
     }
     s->parent = t;
+    s->dirty_fields |= SPLIT_DIRTY_PARENT;
 
     xaccTransCommitEdit(old_trans);
     qof_instance_set_dirty(QOF_INSTANCE(s));
@@ -1902,6 +2144,7 @@ xaccSplitSetLot(Split* split, GNCLot* lot)
 {
     xaccTransBeginEdit (split->parent);
     split->lot = lot;
+    split->dirty_fields |= SPLIT_DIRTY_LOT;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 }
@@ -1989,13 +2232,11 @@ xaccSplitGetBook (const Split *split)
 const char *
 xaccSplitGetType(const Split *s)
 {
-    GValue v = G_VALUE_INIT;
-    const char *split_type = NULL;
+    const char *split_type;
 
     if (!s) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (s), "split-type", &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-        split_type = g_value_get_string (&v);
+    split_type = qof_instance_get_kvp_string (QOF_INSTANCE (s),
+                                              split_type_path);
     return split_type ? split_type : "normal";
 }
 
@@ -2008,6 +2249,7 @@ xaccSplitMakeStockSplit(Split *s)
     xaccTransBeginEdit (s->parent);
 
     s->value = gnc_numeric_zero();
+    s->dirty_fields |= SPLIT_DIRTY_VALUE;
     g_value_init (&v, G_TYPE_STRING);
     g_value_set_string (&v, "stock-split");
     qof_instance_set_kvp (QOF_INSTANCE (s), "split-type", &v);
@@ -2266,6 +2508,31 @@ qofSplitSetAccount(Split *s, QofInstance *ent)
     xaccSplitSetAccount(s, acc);
 }
 
+/* The splits whose query parameters read the given object. */
+static void
+split_trans_dependents (QofInstance *inst, QofInstanceForeachCB cb,
+                        gpointer user_data)
+{
+    g_list_foreach (xaccTransGetSplitList (GNC_TRANSACTION (inst)),
+                    (GFunc) cb, user_data);
+}
+
+static void
+split_account_dependents (QofInstance *inst, QofInstanceForeachCB cb,
+                          gpointer user_data)
+{
+    g_list_foreach (xaccAccountGetSplitList (GNC_ACCOUNT (inst)),
+                    (GFunc) cb, user_data);
+}
+
+static void
+split_lot_dependents (QofInstance *inst, QofInstanceForeachCB cb,
+                      gpointer user_data)
+{
+    g_list_foreach (gnc_lot_get_split_list (GNC_LOT (inst)),
+                    (GFunc) cb, user_data);
+}
+
 gboolean xaccSplitRegister (void)
 {
     static const QofParam params[] =
@@ -2366,6 +2633,13 @@ gboolean xaccSplitRegister (void)
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, NULL);
 
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_TRANS,
+                                   split_trans_dependents);
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_ACCOUNT,
+                                   split_account_dependents);
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_LOT,
+                                   split_lot_dependents);
+
     return qof_object_register (&split_object_def);
 }
 
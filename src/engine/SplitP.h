@@ -68,6 +68,21 @@
 #define GAINS_STATUS_VDIRTY    (GAINS_STATUS_VALU_DIRTY)
 #define GAINS_STATUS_A_VDIRTY  (GAINS_STATUS_AMNT_DIRTY|GAINS_STATUS_VALU_DIRTY|GAINS_STATUS_LOT_DIRTY)
 
+/* Bits of split_s.dirty_fields, one for each field a backend stores
+ * apart from the slots, which the KvpFrame tracks itself. */
+#define SPLIT_DIRTY_PARENT           0x001
+#define SPLIT_DIRTY_ACCOUNT          0x002
+#define SPLIT_DIRTY_MEMO             0x004
+#define SPLIT_DIRTY_ACTION           0x008
+#define SPLIT_DIRTY_RECONCILE        0x010
+#define SPLIT_DIRTY_DATE_RECONCILED  0x020
+#define SPLIT_DIRTY_VALUE            0x040
+#define SPLIT_DIRTY_AMOUNT           0x080
+#define SPLIT_DIRTY_LOT              0x100
+#define SPLIT_DIRTY_ALL              0x1ff
+
+typedef struct SplitSortKey SplitSortKey;
+
 struct split_s
 {
     QofInstance inst;
@@ -125,6 +140,21 @@ struct split_s
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
+
+    /* Set when the balances above, and those of every split after this
+     * one in the account, need to be recomputed.  Splits before the
+     * first flagged split in an account hold correct balances, which
+     * lets xaccAccountRecomputeBalance() skip them. */
+    gboolean     balance_dirty;
+
+    /* Cached key for xaccSplitOrder(), built on demand and checked
+     * against the fields it covers before each use.  See Split.c. */
+    SplitSortKey *sort_key;
+
+    /* The SPLIT_DIRTY_* fields set since the backend last saved or
+     * loaded the split, so that it can write only those.  A new split
+     * has them all set. */
+    guint        dirty_fields;
 };
 
 struct _SplitClass
@@ -152,6 +182,12 @@ void xaccSplitCopyKvp (const Split *from, Split *to);
 Split *xaccDupeSplit (const Split *s);
 void mark_split (Split *s);
 
+/* The SPLIT_DIRTY_* bits of the fields set since the last call to
+ * xaccSplitClearDirtyFields(), which a backend makes once it has
+ * saved or loaded the split. */
+guint xaccSplitGetDirtyFields (const Split *split);
+void xaccSplitClearDirtyFields (Split *split);
+
 void xaccSplitVoid(Split *split);
 void xaccSplitUnvoid(Split *split);
 void xaccSplitCommitEdit(Split *s);
@@ -194,6 +194,18 @@ const char *assoc_uri_str = "assoc_uri";
 
 #define ISO_DATELENGTH 32 /* length of an iso 8601 date string. */
 
+/* Interned paths of the slots read whenever a transaction is drawn or
+ * committed; set up by the class init. */
+static const QofKvpPath *trans_notes_path = NULL;
+static const QofKvpPath *trans_is_closing_path = NULL;
+static const QofKvpPath *trans_txn_type_path = NULL;
+static const QofKvpPath *trans_read_only_path = NULL;
+static const QofKvpPath *void_reason_path = NULL;
+
+/* The number of transactions with an edit open, whose changes the
+ * accounts' split lists don't show yet. */
+static gint open_transactions = 0;
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_ENGINE;
 
@@ -285,6 +297,7 @@ gnc_transaction_init(Transaction* trans)
 
     trans->marker = 0;
     trans->orig = NULL;
+    trans->dirty_fields = TRANS_DIRTY_ALL;
     LEAVE (" ");
 }
 
@@ -413,6 +426,12 @@ gnc_transaction_class_init(TransactionClass* klass)
     gobject_class->set_property = gnc_transaction_set_property;
     gobject_class->get_property = gnc_transaction_get_property;
 
+    trans_notes_path = qof_kvp_path_intern (trans_notes_str);
+    trans_is_closing_path = qof_kvp_path_intern (trans_is_closing_str);
+    trans_txn_type_path = qof_kvp_path_intern (TRANS_TXN_TYPE_KVP);
+    trans_read_only_path = qof_kvp_path_intern (TRANS_READ_ONLY_REASON);
+    void_reason_path = qof_kvp_path_intern (void_reason_str);
+
     g_object_class_install_property
     (gobject_class,
      PROP_NUM,
@@ -593,6 +612,20 @@ xaccTransSortSplits (Transaction *trans)
     trans->splits = new_list;
 }
 
+guint
+xaccTransGetDirtyFields (const Transaction *trans)
+{
+    g_return_val_if_fail (trans, TRANS_DIRTY_ALL);
+    return trans->dirty_fields;
+}
+
+void
+xaccTransClearDirtyFields (Transaction *trans)
+{
+    g_return_if_fail (trans);
+    trans->dirty_fields = 0;
+}
+
 
 /********************************************************************\
 \********************************************************************/
@@ -787,6 +820,18 @@ xaccTransCopyFromClipBoard(const Transaction *from_trans, Transaction *to_trans,
 
 /*################## Added for Reg2 #################*/
 
+static void xaccFreeTransaction (Transaction *trans);
+
+/* Drop the copy kept for rolling back an open edit. */
+static void
+free_orig (Transaction *trans)
+{
+    if (!trans->orig) return;
+    xaccFreeTransaction (trans->orig);
+    trans->orig = NULL;
+    --open_transactions;
+}
+
 /********************************************************************\
  Free the transaction.
 \********************************************************************/
@@ -824,11 +869,7 @@ xaccFreeTransaction (Transaction *trans)
     trans->date_posted.tv_sec = 0;
     trans->date_posted.tv_nsec = 0;
 
-    if (trans->orig)
-    {
-        xaccFreeTransaction (trans->orig);
-        trans->orig = NULL;
-    }
+    free_orig (trans);
 
     /* qof_instance_release (&trans->inst); */
     g_object_unref(trans);
@@ -1418,6 +1459,7 @@ xaccTransSetCurrency (Transaction *trans, gnc_commodity *curr)
     xaccTransBeginEdit(trans);
 
     trans->common_currency = curr;
+    trans->dirty_fields |= TRANS_DIRTY_CURRENCY;
     if (old_curr != NULL && trans->splits != NULL)
     {
         gnc_numeric rate = find_new_rate(trans, curr);
@@ -1456,6 +1498,13 @@ xaccTransBeginEdit (Transaction *trans)
     /* Make a clone of the transaction; we will use this
      * in case we need to roll-back the edit. */
     trans->orig = dupe_trans (trans);
+    ++open_transactions;
+}
+
+gboolean
+xaccTransAnyOpen (void)
+{
+    return open_transactions > 0;
 }
 
 /********************************************************************\
@@ -1623,8 +1672,7 @@ static void trans_cleanup_commit(Transaction *trans)
     /* Get rid of the copy we made. We won't be rolling back,
      * so we don't need it any more.  */
     PINFO ("get rid of rollback trans=%p", trans->orig);
-    xaccFreeTransaction (trans->orig);
-    trans->orig = NULL;
+    free_orig (trans);
 
     /* Sort the splits. Why do we need to do this ?? */
     /* Good question.  Who knows?  */
@@ -1691,6 +1739,7 @@ xaccTransCommitEdit (Transaction *trans)
     if (0 == trans->date_entered.tv_sec)
     {
 	trans->date_entered.tv_sec = gnc_time(NULL);
+        trans->dirty_fields |= TRANS_DIRTY_DATE_ENTERED;
         qof_instance_set_dirty(QOF_INSTANCE(trans));
     }
 
@@ -1855,9 +1904,7 @@ xaccTransRollbackEdit (Transaction *trans)
     if (!qof_book_is_readonly(qof_instance_get_book(trans)))
         xaccTransWriteLog (trans, 'R');
 
-    xaccFreeTransaction (trans->orig);
-
-    trans->orig = NULL;
+    free_orig (trans);
     qof_instance_set_destroying(trans, FALSE);
 
     /* Put back to zero. */
@@ -1943,6 +1990,8 @@ xaccTransSetDateInternal(Transaction *trans, Timespec *dadate, Timespec val)
     }
 
     *dadate = val;
+    trans->dirty_fields |= (dadate == &trans->date_posted) ?
+                           TRANS_DIRTY_DATE_POSTED : TRANS_DIRTY_DATE_ENTERED;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);
     xaccTransCommitEdit(trans);
@@ -2126,6 +2175,7 @@ xaccTransSetNum (Transaction *trans, const char *xnum)
     xaccTransBeginEdit(trans);
 
     CACHE_REPLACE(trans->num, xnum);
+    trans->dirty_fields |= TRANS_DIRTY_NUM;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);  /* Dirty balance of every account in trans */
     xaccTransCommitEdit(trans);
@@ -2146,6 +2196,7 @@ xaccTransSetDescription (Transaction *trans, const char *desc)
     xaccTransBeginEdit(trans);
 
     CACHE_REPLACE(trans->description, desc);
+    trans->dirty_fields |= TRANS_DIRTY_DESCRIPTION;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2290,22 +2341,19 @@ xaccTransGetAssociation (const Transaction *trans)
 const char *
 xaccTransGetNotes (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     if (!trans) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), trans_notes_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (trans),
+                                        trans_notes_path);
 }
 
 gboolean
 xaccTransGetIsClosingTxn (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
+    gint64 is_closing;
     if (!trans) return FALSE;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), trans_is_closing_str, &v);
-    if (G_VALUE_HOLDS_INT64 (&v))
-         return g_value_get_int64 (&v);
+    if (qof_instance_get_kvp_int64 (QOF_INSTANCE (trans),
+                                    trans_is_closing_path, &is_closing))
+         return is_closing;
     return FALSE;
 }
 
@@ -2398,13 +2446,11 @@ xaccTransRetDateDueTS (const Transaction *trans)
 char
 xaccTransGetTxnType (const Transaction *trans)
 {
-    const char *s = NULL;
-    GValue v = G_VALUE_INIT;
+    const char *s;
 
     if (!trans) return TXN_TYPE_NONE;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), TRANS_TXN_TYPE_KVP, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (trans),
+                                     trans_txn_type_path);
     if (s && strlen (s) == 1)
 	return *s;
 
@@ -2417,12 +2463,10 @@ xaccTransGetReadOnly (const Transaction *trans)
     /* XXX This flag should be cached in the transaction structure
      * for performance reasons, since its checked every trans commit.
      */
-    GValue v = G_VALUE_INIT;
-    const char *s = NULL;
+    const char *s;
     if (trans == NULL) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE(trans), TRANS_READ_ONLY_REASON, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE(trans),
+                                     trans_read_only_path);
     if (s && strlen (s))
 	return s;
 
@@ -2643,26 +2687,20 @@ xaccTransVoid(Transaction *trans, const char *reason)
 gboolean
 xaccTransGetVoidStatus(const Transaction *trans)
 {
-    const char *s = NULL;
-    GValue v = G_VALUE_INIT;
+    const char *s;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), void_reason_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (trans), void_reason_path);
     return s && strlen(s);
 }
 
 const char *
 xaccTransGetVoidReason(const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), void_reason_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (trans),
+                                        void_reason_path);
 }
 
 Timespec
@@ -71,6 +71,15 @@
  * A "split" is more commonly referred to as an "entry" in a "transaction".
  */
 
+/* Bits of transaction_s.dirty_fields, one for each field a backend
+ * stores apart from the slots, which the KvpFrame tracks itself. */
+#define TRANS_DIRTY_CURRENCY      0x01
+#define TRANS_DIRTY_NUM           0x02
+#define TRANS_DIRTY_DATE_POSTED   0x04
+#define TRANS_DIRTY_DATE_ENTERED  0x08
+#define TRANS_DIRTY_DESCRIPTION   0x10
+#define TRANS_DIRTY_ALL           0x1f
+
 struct transaction_s
 {
     QofInstance inst;     /* glbally unique id */
@@ -110,6 +119,11 @@ struct transaction_s
      * any changes made if/when the edit is abandoned.
      */
     Transaction *orig;
+
+    /* The TRANS_DIRTY_* fields set since the backend last saved or
+     * loaded the transaction, so that it can write only those.  A new
+     * transaction has them all set. */
+    guint dirty_fields;
 };
 
 struct _TransactionClass
@@ -141,6 +155,12 @@ Transaction * xaccDupeTransaction (const Transaction *t);
 void xaccTransSetVersion (Transaction*, gint32);
 gint32 xaccTransGetVersion (const Transaction*);
 
+/* The TRANS_DIRTY_* bits of the fields set since the last call to
+ * xaccTransClearDirtyFields(), which a backend makes once it has saved
+ * or loaded the transaction. */
+guint xaccTransGetDirtyFields (const Transaction *trans);
+void xaccTransClearDirtyFields (Transaction *trans);
+
 /* Code to register Transaction type with the engine */
 gboolean xaccTransRegister (void);
 
@@ -167,6 +187,10 @@ void xaccDisableDataScrubbing(void);
 void xaccTransRemoveSplit (Transaction *trans, const Split *split);
 void check_open (const Transaction *trans);
 
+/* Whether any transaction has an edit open, so that the accounts'
+ * split lists may be missing a change to its splits. */
+gboolean xaccTransAnyOpen (void);
+
 /* Structure for accessing static functions for testing */
 typedef struct
 {
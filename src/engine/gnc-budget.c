@@ -631,12 +631,6 @@ gnc_budget_lookup (const GncGUID *guid, const QofBook *book)
     return GNC_BUDGET(qof_collection_lookup_entity (col, guid));
 }
 
-static void just_get_one(QofInstance *ent, gpointer data)
-{
-    GncBudget **bgt = (GncBudget**)data;
-    if (bgt && !*bgt) *bgt = GNC_BUDGET(ent);
-}
-
 GncBudget*
 gnc_budget_get_default (QofBook *book)
 {
@@ -660,11 +654,12 @@ gnc_budget_get_default (QofBook *book)
 
     if ( bgt == NULL )
     {
+        QofCollectionIter iter;
+
         col = qof_book_get_collection(book, GNC_ID_BUDGET);
-        if (qof_collection_count(col) > 0)
-        {
-            qof_collection_foreach(col, just_get_one, &bgt);
-        }
+        qof_collection_iter_init(&iter, col);
+        bgt = (GncBudget *) qof_collection_iter_next(&iter);
+        qof_collection_iter_end(&iter);
     }
 
     return bgt;
@@ -300,6 +300,7 @@ gnc_lot_free(GNCLot* lot)
     {
         Split *s = node->data;
         s->lot = NULL;
+        s->dirty_fields |= SPLIT_DIRTY_LOT;
     }
     g_list_free (priv->splits);
 
@@ -370,6 +371,16 @@ gnc_lot_get_book (GNCLot *lot)
 
 /* ============================================================= */
 
+/* A lot's splits can be in any transaction of the book, so a backend
+ * which loads transactions as they are needed must load all of them
+ * before the split list is used. */
+static void
+lot_load_splits (const GNCLot *lot)
+{
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (lot));
+    qof_backend_load_related (qof_book_get_backend (book), QOF_INSTANCE (book));
+}
+
 gboolean
 gnc_lot_is_closed (GNCLot *lot)
 {
@@ -416,6 +427,7 @@ gnc_lot_get_split_list (const GNCLot *lot)
 {
     LotPrivate* priv;
     if (!lot) return NULL;
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     return priv->splits;
 }
@@ -424,6 +436,7 @@ gint gnc_lot_count_splits (const GNCLot *lot)
 {
     LotPrivate* priv;
     if (!lot) return 0;
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     return g_list_length (priv->splits);
 }
@@ -490,6 +503,7 @@ gnc_lot_get_balance (GNCLot *lot)
     gnc_numeric baln = zero;
     if (!lot) return zero;
 
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     if (!priv->splits)
     {
@@ -537,6 +551,7 @@ gnc_lot_get_balance_before (const GNCLot *lot, const Split *split,
     *value = val;
     if (lot == NULL) return;
 
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     if (priv->splits)
     {
@@ -657,6 +672,7 @@ gnc_lot_get_earliest_split (GNCLot *lot)
 {
     LotPrivate* priv;
     if (!lot) return NULL;
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
     priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
@@ -671,6 +687,7 @@ gnc_lot_get_latest_split (GNCLot *lot)
     SplitList *node;
 
     if (!lot) return NULL;
+    lot_load_splits (lot);
     priv = GET_PRIVATE(lot);
     if (! priv->splits) return NULL;
     priv->splits = g_list_sort (priv->splits, (GCompareFunc) xaccSplitOrderDateOnly);
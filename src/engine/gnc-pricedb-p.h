@@ -56,6 +56,11 @@ struct gnc_price_db_s
 {
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
+    GHashTable *unsorted;		 /* price arrays appended to in bulk */
+    GHashTable *merged_prices;	 /* commodity -> prices in all currencies */
+    GHashTable *conversions;	 /* cached balance conversion routes */
+    GQueue conversions_lru;      /* their keys, least recently used first */
+    GHashTable *commodity_graph; /* commodity -> commodities priced with it */
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
 };
 
@@ -39,8 +39,12 @@ static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         Timespec t, gboolean sameday);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(GPtrArray *p, gpointer user_data),
                             gpointer user_data);
+static void pricedb_clear_conversions(GNCPriceDB *db);
+static void conversion_route_free(gpointer data);
+static guint conversion_key_hash(gconstpointer key);
+static gboolean conversion_key_equal(gconstpointer a, gconstpointer b);
 
 enum
 {
@@ -566,6 +570,8 @@ gnc_price_set_value(GNCPrice *p, gnc_numeric value)
         p->value = value;
         gnc_price_set_dirty(p);
         gnc_price_commit_edit (p);
+        /* A zero price is skipped by balance conversions. */
+        if (p->db) pricedb_clear_conversions (p->db);
     }
 }
 
@@ -823,12 +829,204 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to GPtrArrays of GNCPrices.  The top-level key
+   is the commodity you want the prices for, and the second level key
+   is the commodity that the value is expressed in terms of.
+
+   Each array holds a reference to each of its prices and is kept in
+   the order of a GNCPrice list (see gnc-pricedb.h): newest first, so
+   the time lookups can binary search it.  During a bulk update prices
+   are only appended, and the array is noted in db->unsorted to be
+   sorted once, when it is next looked at.
  */
 
+static gint
+compare_prices_by_date_indirect(gconstpointer a, gconstpointer b)
+{
+    return compare_prices_by_date(*(GNCPrice * const *) a,
+                                  *(GNCPrice * const *) b);
+}
+
+static void
+price_array_sort(GNCPriceDB *db, GPtrArray *prices)
+{
+    if (g_hash_table_remove(db->unsorted, prices))
+        g_ptr_array_sort(prices, compare_prices_by_date_indirect);
+}
+
+static void
+pricedb_sort_unsorted(GNCPriceDB *db)
+{
+    GHashTableIter iter;
+    gpointer prices;
+
+    g_hash_table_iter_init(&iter, db->unsorted);
+    while (g_hash_table_iter_next(&iter, &prices, NULL))
+        g_ptr_array_sort(prices, compare_prices_by_date_indirect);
+    g_hash_table_remove_all(db->unsorted);
+}
+
+/* Returns the sorted array of prices of commodity in terms of
+ * currency, or NULL if there are none. */
+static GPtrArray *
+pricedb_get_price_array(GNCPriceDB *db, const gnc_commodity *commodity,
+                        const gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+    GPtrArray *prices;
+
+    if (!db->commodity_hash) return NULL;
+    currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
+    if (!currency_hash) return NULL;
+    prices = g_hash_table_lookup(currency_hash, currency);
+    if (prices)
+        price_array_sort(db, prices);
+    return prices;
+}
+
+/* Returns the index of the first price in prices not newer than t, or
+ * if strict the first one older than t; prices->len if there is none. */
+static guint
+price_array_search_time(GPtrArray *prices, Timespec t, gboolean strict)
+{
+    guint lo = 0, hi = prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec price_t = gnc_price_get_time(g_ptr_array_index(prices, mid));
+        int cmp = timespec_cmp(&price_t, &t);
+
+        if (cmp > 0 || (strict && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Returns the index at which p sorts into prices. */
+static guint
+price_array_search_price(GPtrArray *prices, GNCPrice *p)
+{
+    guint lo = 0, hi = prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (compare_prices_by_date(g_ptr_array_index(prices, mid), p) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+price_array_insert(GPtrArray *prices, GNCPrice *p, guint index)
+{
+    /* g_ptr_array_insert() needs GLib 2.40. */
+    g_ptr_array_add(prices, p);
+    memmove(prices->pdata + index + 1, prices->pdata + index,
+            (prices->len - 1 - index) * sizeof(gpointer));
+    prices->pdata[index] = p;
+}
+
+/* Removes p from prices, dropping the array's reference; returns FALSE
+ * if it wasn't there. */
+static gboolean
+price_array_remove(GPtrArray *prices, GNCPrice *p)
+{
+    guint index = price_array_search_price(prices, p);
+
+    if (index >= prices->len || g_ptr_array_index(prices, index) != p)
+    {
+        /* Not where its time says; look everywhere. */
+        for (index = 0; index < prices->len; index++)
+            if (g_ptr_array_index(prices, index) == p)
+                break;
+        if (index == prices->len)
+            return FALSE;
+    }
+    g_ptr_array_remove_index(prices, index);
+    gnc_price_unref(p);
+    return TRUE;
+}
+
+/* Checks the prices on p's day, which lie on either side of index, for
+ * one that duplicates p. */
+static gboolean
+price_array_has_duplicate(GPtrArray *prices, GNCPrice *p, guint index)
+{
+    PriceListIsDuplStruct dupl = { p, FALSE };
+    Timespec day = timespecCanonicalDayTime(gnc_price_get_time(p));
+    guint i;
+
+    for (i = index; i > 0 && !dupl.isDupl; i--)
+    {
+        GNCPrice *other = g_ptr_array_index(prices, i - 1);
+        Timespec other_day = timespecCanonicalDayTime(gnc_price_get_time(other));
+        if (!timespec_equal(&day, &other_day)) break;
+        price_list_is_duplicate(other, &dupl);
+    }
+    for (i = index; i < prices->len && !dupl.isDupl; i++)
+    {
+        GNCPrice *other = g_ptr_array_index(prices, i);
+        Timespec other_day = timespecCanonicalDayTime(gnc_price_get_time(other));
+        if (!timespec_equal(&day, &other_day)) break;
+        price_list_is_duplicate(other, &dupl);
+    }
+    return dupl.isDupl;
+}
+
+/* Returns a PriceList of the prices, without adding references. */
+static PriceList *
+price_array_to_list(GPtrArray *prices)
+{
+    PriceList *result = NULL;
+    guint i;
+
+    for (i = prices->len; i > 0; i--)
+        result = g_list_prepend(result, g_ptr_array_index(prices, i - 1));
+    return result;
+}
+
+/* Finds, among the prices of c in terms of currency and those of
+ * currency in terms of c, the oldest price newer than t and the newest
+ * price not newer than t, as they would be placed in the merged list of
+ * both. */
+static void
+pricedb_prices_around(GNCPriceDB *db, const gnc_commodity *c,
+                      const gnc_commodity *currency, Timespec t,
+                      GNCPrice **newer, GNCPrice **not_newer)
+{
+    GPtrArray *arrays[2];
+    int i;
+
+    arrays[0] = pricedb_get_price_array(db, c, currency);
+    arrays[1] = pricedb_get_price_array(db, currency, c);
+    *newer = *not_newer = NULL;
+    for (i = 0; i < 2; i++)
+    {
+        guint index;
+
+        if (!arrays[i]) continue;
+        index = price_array_search_time(arrays[i], t, FALSE);
+        if (index > 0)
+        {
+            GNCPrice *p = g_ptr_array_index(arrays[i], index - 1);
+            if (!*newer || compare_prices_by_date(p, *newer) > 0)
+                *newer = p;
+        }
+        if (index < arrays[i]->len)
+        {
+            GNCPrice *p = g_ptr_array_index(arrays[i], index);
+            if (!*not_newer || compare_prices_by_date(p, *not_newer) < 0)
+                *not_newer = p;
+        }
+    }
+}
+
 /* GObject Initialization */
 QOF_GOBJECT_IMPL(gnc_pricedb, GNCPriceDB, QOF_TYPE_INSTANCE);
 
@@ -877,6 +1075,17 @@ gnc_pricedb_create(QofBook * book)
 
     result->commodity_hash = g_hash_table_new(NULL, NULL);
     g_return_val_if_fail (result->commodity_hash, NULL);
+    result->unsorted = g_hash_table_new(NULL, NULL);
+    result->merged_prices =
+        g_hash_table_new_full(NULL, NULL, NULL,
+                              (GDestroyNotify) g_ptr_array_unref);
+    result->conversions =
+        g_hash_table_new_full(conversion_key_hash, conversion_key_equal,
+                              g_free, conversion_route_free);
+    g_queue_init(&result->conversions_lru);
+    result->commodity_graph =
+        g_hash_table_new_full(NULL, NULL, NULL,
+                              (GDestroyNotify) g_list_free);
     return result;
 }
 
@@ -885,18 +1094,18 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
+    GPtrArray *prices = (GPtrArray *) data;
+    guint i;
 
-    for (node = price_list; node; node = node->next)
+    for (i = 0; i < prices->len; i++)
     {
-        p = node->data;
+        GNCPrice *p = g_ptr_array_index(prices, i);
 
         p->db = NULL;
+        gnc_price_unref(p);
     }
 
-    gnc_price_list_destroy(price_list);
+    g_ptr_array_free(prices, TRUE);
 }
 
 static void
@@ -924,6 +1133,11 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    g_hash_table_destroy (db->unsorted);
+    g_hash_table_destroy (db->merged_prices);
+    g_queue_clear (&db->conversions_lru);
+    g_hash_table_destroy (db->conversions);
+    g_hash_table_destroy (db->commodity_graph);
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -932,6 +1146,9 @@ void
 gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update)
 {
     db->bulk_update = bulk_update;
+    /* Sort everything loaded in bulk in one pass. */
+    if (!bulk_update)
+        pricedb_sort_unsorted(db);
 }
 
 /* ==================================================================== */
@@ -1006,7 +1223,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_array_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1016,6 +1233,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1049,6 +1267,7 @@ gnc_pricedb_equal (GNCPriceDB *db1, GNCPriceDB *db2)
     equal_data.equal = TRUE;
     equal_data.db2 = db2;
 
+    pricedb_sort_unsorted (db1);
     g_hash_table_foreach (db1->commodity_hash,
                           pricedb_equal_foreach_currencies_hash,
                           &equal_data);
@@ -1065,7 +1284,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    GPtrArray *prices;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1106,17 +1325,20 @@ add_price(GNCPriceDB *db, GNCPrice *p)
  * add this one. If this price is of equal or better precedence than the old
  * one, copy this one over the old one.
  */
-    old_price = gnc_pricedb_lookup_day (db, p->commodity, p->currency,
-                                        p->tmspec);
-    if (!db->bulk_update && old_price != NULL)
+    if (!db->bulk_update)
     {
-        if (p->source > old_price->source)
+        old_price = gnc_pricedb_lookup_day (db, p->commodity, p->currency,
+                                            p->tmspec);
+        if (old_price != NULL)
         {
-            gnc_price_unref(p);
-            LEAVE ("Better price already in DB.");
-            return FALSE;
+            if (p->source > old_price->source)
+            {
+                gnc_price_unref(p);
+                LEAVE ("Better price already in DB.");
+                return FALSE;
+            }
+            gnc_pricedb_remove_price(db, old_price);
         }
-        gnc_pricedb_remove_price(db, old_price);
     }
 
     currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
@@ -1126,20 +1348,35 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
+    prices = g_hash_table_lookup(currency_hash, currency);
+    if (!prices)
     {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
+        prices = g_ptr_array_new();
+        g_hash_table_insert(currency_hash, currency, prices);
     }
 
-    if (!price_list)
+    if (db->bulk_update)
     {
-        LEAVE (" no price list");
-        return FALSE;
+        /* Sorted when the bulk update ends, or the first time a lookup
+         * needs it. */
+        gnc_price_ref(p);
+        g_ptr_array_add(prices, p);
+        g_hash_table_insert(db->unsorted, prices, prices);
     }
+    else
+    {
+        guint index;
 
-    g_hash_table_insert(currency_hash, currency, price_list);
+        price_array_sort(db, prices);
+        index = price_array_search_price(prices, p);
+        if (!price_array_has_duplicate(prices, p, index))
+        {
+            gnc_price_ref(p);
+            price_array_insert(prices, p, index);
+        }
+    }
+    g_hash_table_remove(db->merged_prices, commodity);
+    pricedb_clear_conversions(db);
     p->db = db;
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
@@ -1190,7 +1427,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    GPtrArray *prices;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1226,24 +1463,28 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
+    prices = pricedb_get_price_array(db, commodity, currency);
+    if (!prices)
+    {
+        LEAVE ("db=%p, pr=%p not in db", db, p);
+        return FALSE;
+    }
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
+    if (!price_array_remove(prices, p))
     {
         gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
+        LEAVE (" cannot remove price");
         return FALSE;
     }
+    g_hash_table_remove(db->merged_prices, commodity);
+    pricedb_clear_conversions(db);
 
     /* if the price list is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (prices->len == 0)
     {
         g_hash_table_remove(currency_hash, currency);
+        g_ptr_array_free(prices, TRUE);
 
         if (cleanup)
         {
@@ -1338,18 +1579,16 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *prices = (GPtrArray *) val;
     remove_info *data = (remove_info *) user_data;
+    guint i;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* The most recent price is the first in the list */
-    if (!data->delete_last)
-        node = g_list_next(node);
-
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* The most recent price is the first in the array; now check
+     * each item after it */
+    for (i = data->delete_last ? 0 : 1; i < prices->len; i++)
+        check_one_price_date(g_ptr_array_index(prices, i), data);
 
     LEAVE(" ");
 }
@@ -1392,6 +1631,7 @@ gnc_pricedb_remove_old_prices(GNCPriceDB *db,
 
     /* Traverse the database once building up an external list of prices
      * to be deleted */
+    pricedb_sort_unsorted(db);
     g_hash_table_foreach(db->commodity_hash,
                          pricedb_remove_foreach_currencies_hash,
                          &data);
@@ -1419,30 +1659,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *prices = price_array_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, prices);
         g_list_free (*l);
+        g_list_free (prices);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = prices;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    GPtrArray *prices = NULL;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        prices = g_hash_table_lookup(hash, currency);
+        if (!prices)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_array_to_list (prices);
     }
     else
     {
@@ -1493,6 +1736,7 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     PriceList *forward_list = NULL, *reverse_list = NULL;
     g_return_val_if_fail (db != NULL, NULL);
     g_return_val_if_fail (commodity != NULL, NULL);
+    pricedb_sort_unsorted (db);
     forward_hash = g_hash_table_lookup(db->commodity_hash, commodity);
     if (currency && bidi)
         reverse_hash = g_hash_table_lookup(db->commodity_hash, currency);
@@ -1536,21 +1780,27 @@ gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
-    GNCPrice *result;
-    GHashTable *currency_hash;
+    GPtrArray *arrays[2];
+    GNCPrice *result = NULL;
+    int i;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
+    /* This works magically because prices are kept in date-sorted
      * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+     * first of either direction's prices.  */
+    arrays[0] = pricedb_get_price_array(db, commodity, currency);
+    arrays[1] = pricedb_get_price_array(db, currency, commodity);
+    for (i = 0; i < 2; i++)
+    {
+        GNCPrice *p;
+        if (!arrays[i]) continue;
+        p = g_ptr_array_index(arrays[i], 0);
+        if (!result || compare_prices_by_date(p, result) < 0)
+            result = p;
+    }
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE(" ");
     return result;
 }
@@ -1560,13 +1810,13 @@ static void
 lookup_latest(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
+    GPtrArray *prices = (GPtrArray *)val;
     GList **return_list = (GList **)user_data;
 
-    if (!price_list) return;
+    if (!prices || !prices->len) return;
 
-    /* the latest price is the first in list */
-    gnc_price_list_insert(return_list, price_list->data, FALSE);
+    /* the latest price is the first in the array */
+    gnc_price_list_insert(return_list, g_ptr_array_index(prices, 0), FALSE);
 }
 
 typedef struct
@@ -1587,53 +1837,50 @@ typedef struct
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(GPtrArray *prices, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *first;
     gnc_commodity *com;
     gnc_commodity *cur;
+    guint index;
 
-    if (!price_list)
+    if (!prices || !prices->len)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+    first = g_ptr_array_index(prices, 0);
+    com = gnc_price_get_commodity(first);
+    cur = gnc_price_get_currency(first);
 
     /* if this price list isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
+    /* The prices are sorted in decreasing order of time.  Find the first
+       price that is older than the requested time and add it and the
        previous price to the result list. */
-    while (node != NULL)
+    index = price_array_search_time(prices, helper->t, TRUE);
+    if (index < prices->len)
     {
-        GNCPrice *price = node->data;
-        Timespec price_t = gnc_price_get_time(price);
-        if (timespec_cmp(&price_t, &helper->t) < 0)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
+        GNCPrice *price = g_ptr_array_index(prices, index);
+        /* If there is a previous price add it to the results. */
+        if (index > 0)
         {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
+            GNCPrice *prev_price = g_ptr_array_index(prices, index - 1);
+            gnc_price_ref(prev_price);
+            *helper->list = g_list_prepend(*helper->list, prev_price);
         }
-        node = node->next;
+        /* Add the first price before the desired time */
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
+    }
+    else
+    {
+        /* The last price is later than given time, add it */
+        GNCPrice *price = g_ptr_array_index(prices, prices->len - 1);
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
     }
 
     return TRUE;
@@ -1839,7 +2086,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    GPtrArray *prices;
     GHashTable *currency_hash;
     gint size;
 
@@ -1854,8 +2101,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        prices = g_hash_table_lookup(currency_hash, currency);
+        if (prices)
         {
             LEAVE("yes");
             return TRUE;
@@ -1899,9 +2146,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
+    GPtrArray *prices = value;
 
-    *result += g_list_length(price_list);
+    *result += prices->len;
 }
 
 int
@@ -1924,6 +2171,35 @@ gnc_pricedb_num_prices(GNCPriceDB *db,
     return result;
 }
 
+/* Returns all the prices of commodity c, in any currency, in one
+ * array sorted newest first.  The array is cached until a price of c is
+ * added or removed, so that walking the prices with
+ * gnc_pricedb_nth_price() doesn't merge the currencies' prices again
+ * for every n. */
+static GPtrArray *
+pricedb_get_merged_prices(GNCPriceDB *db, GHashTable *currency_hash,
+                          const gnc_commodity *c)
+{
+    GPtrArray *merged = g_hash_table_lookup(db->merged_prices, c);
+    GHashTableIter iter;
+    gpointer value;
+
+    if (merged) return merged;
+
+    merged = g_ptr_array_new();
+    g_hash_table_iter_init(&iter, currency_hash);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        GPtrArray *prices = value;
+        guint i;
+        for (i = 0; i < prices->len; i++)
+            g_ptr_array_add(merged, g_ptr_array_index(prices, i));
+    }
+    g_ptr_array_sort(merged, compare_prices_by_date_indirect);
+    g_hash_table_insert(db->merged_prices, (gpointer) c, merged);
+    return merged;
+}
+
 /* Return the nth price for the given commodity
  */
 GNCPrice *
@@ -1941,6 +2217,7 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
     if (currency_hash)
     {
         int num_currencies = g_hash_table_size(currency_hash);
+        GPtrArray *prices = NULL;
         if (num_currencies == 1)
         {
             /* Optimize the case of prices in only one currency, it's common
@@ -1950,61 +2227,18 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
             g_hash_table_iter_init(&iter, currency_hash);
             if (g_hash_table_iter_next(&iter, &key, &value))
             {
-                PriceList *prices = value;
-                result = g_list_nth_data(prices, n);
+                prices = value;
+                price_array_sort(db, prices);
             }
         }
         else if (num_currencies > 1)
         {
             /* Prices for multiple currencies, must find the nth entry in the
                merged currency list. */
-            GList **price_array = (GList **)g_new(gpointer, num_currencies);
-            GList **next_list;
-            int i, j;
-            GHashTableIter iter;
-            gpointer key, value;
-
-            /* Build an array of all the currencies this commodity has prices for */
-            for (i = 0, g_hash_table_iter_init(&iter, currency_hash);
-                 g_hash_table_iter_next(&iter, &key, &value) && i < num_currencies;
-                 i++)
-            {
-                price_array[i] = value;
-            }
-
-            /* Iterate n times to get the nth price, each time finding the currency
-               with the latest price */
-            for (i = 0; i <= n; i++)
-            {
-                next_list = NULL;
-                for (j = 0; j < num_currencies; j++)
-                {
-                    /* Save this entry if it's the first one or later than
-                       the saved one. */
-                    if (price_array[j] != NULL &&
-                        (next_list == NULL || *next_list == NULL ||
-                        compare_prices_by_date((*next_list)->data, (price_array[j])->data) > 0))
-                    {
-                        next_list = &price_array[j];
-                    }
-                }
-                /* next_list points to the list with the latest price unless all
-                   the lists are empty */
-                if (next_list && *next_list)
-                {
-                    result = (*next_list)->data;
-                    *next_list = (*next_list)->next;
-                }
-                else
-                {
-                    /* all the lists are empty, "n" is greater than the number
-                       of prices for this commodity. */
-                    result = NULL;
-                    break;
-                }
-            }
-            g_free(price_array);
+            prices = pricedb_get_merged_prices(db, currency_hash, c);
         }
+        if (prices && (guint) n < prices->len)
+            result = g_ptr_array_index(prices, n);
     }
 
     LEAVE ("price=%p", result);
@@ -2026,27 +2260,22 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
                            const gnc_commodity *currency,
                            Timespec t)
 {
-    GList *price_list;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    GNCPrice *newer, *p;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    /* Prices at exactly t come first among those not newer than t. */
+    pricedb_prices_around (db, c, currency, t, &newer, &p);
+    if (p)
     {
-        GNCPrice *p = item->data;
         Timespec price_time = gnc_price_get_time(p);
         if (timespec_equal(&price_time, &t))
         {
             gnc_price_ref(p);
-            g_list_free (price_list);
+            LEAVE (" ");
             return p;
         }
-        item = item->next;
     }
-    g_list_free (price_list);
     LEAVE (" ");
     return NULL;
 }
@@ -2058,35 +2287,22 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        Timespec t,
                        gboolean sameday)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
 
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
+    /* find the first candidate past the one we want and the one just
+       before it.  Remember that prices are in most-recent-first order. */
+    pricedb_prices_around (db, c, currency, t, &current_price, &next_price);
+    if (!current_price)
+        current_price = next_price;
+    if (!current_price)
     {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
+        LEAVE (" no prices");
+        return NULL;
     }
 
     if (current_price)      /* How can this be null??? */
@@ -2159,7 +2375,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2179,62 +2394,42 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
                                   gnc_commodity *currency,
                                   Timespec t)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    GHashTable *currency_hash;
-    Timespec price_time;
+    GNCPrice *newer;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time (item->data);
-        if (timespec_cmp(&price_time, &t) <= 0)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (timespec_cmp(&price_time, &t) > 0 && item);
+    pricedb_prices_around (db, c, currency, t, &newer, &current_price);
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
 
-static gnc_numeric
-direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                           const gnc_commodity *from, const gnc_commodity *to,
-                           Timespec *t)
-{
-    GNCPrice *price;
-    gnc_numeric retval = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
-        return retval;
-    if (gnc_numeric_zero_p(bal))
-        return retval;
-    if (t != NULL)
-        price = gnc_pricedb_lookup_nearest_in_time(db, from, to, *t);
-    else
-        price = gnc_pricedb_lookup_latest(db, from, to);
-    if (price == NULL)
-        return retval;
-    if (gnc_price_get_commodity(price) == from)
-        retval = gnc_numeric_mul (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
-    else
-        retval = gnc_numeric_div (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
-    gnc_price_unref (price);
-    return retval;
+/* ==================================================================== */
+/* balance conversion
+
+   Converting a balance means finding a route of prices from one
+   commodity to the other: a price between the two, failing that a
+   pair of prices sharing a third commodity, and failing that the
+   shortest chain of commodity pairs with prices.  Reports convert many
+   balances with the same commodities and date, so the routes are
+   cached in db->conversions, keyed by the commodities and the time
+   looked up (or the latest prices).  Each report date adds entries, so
+   only the PRICEDB_MAX_CONVERSIONS most recently used are kept.  They
+   hold references to their prices, which keeps any later change of a
+   price's value visible; adding or removing a price clears the cache,
+   since it may change which prices a route should use.
+ */
 
-}
+#define PRICEDB_MAX_CONVERSIONS 1024
+
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    gboolean latest;
+    Timespec t;
+} ConversionKey;
 
 typedef struct
 {
@@ -2242,6 +2437,58 @@ typedef struct
     GNCPrice *to;
 } PriceTuple;
 
+typedef struct
+{
+    GNCPrice *direct;           /* a price between from and to, and */
+    gboolean indirect_searched; /* whether the other routes were sought: */
+    PriceTuple common;          /* prices of both with one commodity, or */
+    GList *chain;               /* prices linking from to to, in order */
+    GList *lru_link;            /* the key's link in db->conversions_lru */
+} ConversionRoute;
+
+static guint
+conversion_key_hash(gconstpointer key)
+{
+    const ConversionKey *k = key;
+    guint hash = g_direct_hash(k->from) * 31 + g_direct_hash(k->to);
+
+    if (!k->latest)
+        hash = hash * 31 + (guint) (k->t.tv_sec ^ (k->t.tv_sec >> 32));
+    return hash;
+}
+
+static gboolean
+conversion_key_equal(gconstpointer a, gconstpointer b)
+{
+    const ConversionKey *ka = a, *kb = b;
+
+    if (ka->from != kb->from || ka->to != kb->to || ka->latest != kb->latest)
+        return FALSE;
+    return ka->latest || timespec_equal(&ka->t, &kb->t);
+}
+
+static void
+conversion_route_free(gpointer data)
+{
+    ConversionRoute *route = data;
+
+    gnc_price_unref(route->direct);
+    gnc_price_unref(route->common.from);
+    gnc_price_unref(route->common.to);
+    gnc_price_list_destroy(route->chain);
+    g_free(route);
+}
+
+static void
+pricedb_clear_conversions(GNCPriceDB *db)
+{
+    g_queue_clear(&db->conversions_lru);
+    if (g_hash_table_size(db->conversions))
+        g_hash_table_remove_all(db->conversions);
+    if (g_hash_table_size(db->commodity_graph))
+        g_hash_table_remove_all(db->commodity_graph);
+}
+
 static PriceTuple
 extract_common_prices (PriceList *from_prices, PriceList *to_prices)
 {
@@ -2281,6 +2528,179 @@ extract_common_prices (PriceList *from_prices, PriceList *to_prices)
     return retval;
 }
 
+static GNCPrice *
+lookup_conversion_price (GNCPriceDB *db, const gnc_commodity *from,
+                         const gnc_commodity *to, Timespec *t)
+{
+    if (t != NULL)
+        return gnc_pricedb_lookup_nearest_in_time(db, from, to, *t);
+    return gnc_pricedb_lookup_latest(db, from, to);
+}
+
+static void
+commodity_graph_add_edge (GHashTable *graph, gnc_commodity *a,
+                          gnc_commodity *b)
+{
+    GList *neighbours = g_hash_table_lookup(graph, a);
+    if (g_list_find(neighbours, b)) return;
+    g_hash_table_steal(graph, a);
+    g_hash_table_insert(graph, a, g_list_prepend(neighbours, b));
+}
+
+/* Returns the commodities that have prices with c, building the graph
+ * of commodities linked by prices when it has been cleared. */
+static GList *
+pricedb_commodity_neighbours (GNCPriceDB *db, const gnc_commodity *c)
+{
+    if (!g_hash_table_size(db->commodity_graph))
+    {
+        GHashTableIter com_iter;
+        gpointer com, currency_hash;
+
+        g_hash_table_iter_init(&com_iter, db->commodity_hash);
+        while (g_hash_table_iter_next(&com_iter, &com, &currency_hash))
+        {
+            GHashTableIter cur_iter;
+            gpointer cur;
+
+            g_hash_table_iter_init(&cur_iter, currency_hash);
+            while (g_hash_table_iter_next(&cur_iter, &cur, NULL))
+            {
+                commodity_graph_add_edge(db->commodity_graph, com, cur);
+                commodity_graph_add_edge(db->commodity_graph, cur, com);
+            }
+        }
+    }
+    return g_hash_table_lookup(db->commodity_graph, c);
+}
+
+/* Finds the shortest chain of commodity pairs with prices from 'from'
+ * to 'to' by a breadth-first search, and returns the price used for
+ * each pair. */
+static GList *
+find_conversion_chain (GNCPriceDB *db, const gnc_commodity *from,
+                       const gnc_commodity *to, Timespec *t)
+{
+    GHashTable *came_from = g_hash_table_new(NULL, NULL);
+    GQueue queue = G_QUEUE_INIT;
+    GList *chain = NULL;
+    gboolean found = FALSE;
+
+    g_hash_table_insert(came_from, (gpointer) from, (gpointer) from);
+    g_queue_push_tail(&queue, (gpointer) from);
+    while (!found && !g_queue_is_empty(&queue))
+    {
+        gnc_commodity *c = g_queue_pop_head(&queue);
+        GList *node;
+
+        for (node = pricedb_commodity_neighbours(db, c); node;
+             node = node->next)
+        {
+            if (g_hash_table_lookup(came_from, node->data)) continue;
+            g_hash_table_insert(came_from, node->data, c);
+            if (node->data == to)
+            {
+                found = TRUE;
+                break;
+            }
+            g_queue_push_tail(&queue, node->data);
+        }
+    }
+    g_queue_clear(&queue);
+
+    if (found)
+    {
+        const gnc_commodity *c, *prev;
+        for (c = to; c != from; c = prev)
+        {
+            GNCPrice *price;
+            prev = g_hash_table_lookup(came_from, c);
+            price = lookup_conversion_price(db, prev, c, t);
+            if (!price)
+            {
+                gnc_price_list_destroy(chain);
+                chain = NULL;
+                break;
+            }
+            chain = g_list_prepend(chain, price);
+        }
+    }
+    g_hash_table_destroy(came_from);
+    return chain;
+}
+
+static ConversionRoute *
+find_conversion_route (GNCPriceDB *db, const gnc_commodity *from,
+                       const gnc_commodity *to, Timespec *t)
+{
+    ConversionRoute *route = g_new0(ConversionRoute, 1);
+
+    /* Look for a direct price. */
+    route->direct = lookup_conversion_price(db, from, to, t);
+    if (route->direct &&
+        gnc_numeric_zero_p(gnc_price_get_value(route->direct)))
+    {
+        gnc_price_unref(route->direct);
+        route->direct = NULL;
+    }
+    return route;
+}
+
+/* The routes through other commodities, which are also used when a
+ * balance converted by the direct price rounds to zero. */
+static void
+find_indirect_conversion_route (GNCPriceDB *db, const gnc_commodity *from,
+                                const gnc_commodity *to, Timespec *t,
+                                ConversionRoute *route)
+{
+    GList *from_prices = NULL, *to_prices = NULL;
+
+    route->indirect_searched = TRUE;
+
+    /*
+     * no usable direct price, try if we find a price in another currency
+     * and convert in two stages
+     */
+    if (t == NULL)
+    {
+        from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
+        /* "to" is often the book currency which may have lots of prices,
+            so avoid getting them if they aren't needed. */
+        if (from_prices)
+            to_prices = gnc_pricedb_lookup_latest_any_currency(db, to);
+    }
+    else
+    {
+        from_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
+                                                                      from, *t);
+        if (from_prices)
+            to_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
+                                                                    to, *t);
+    }
+    if (from_prices && to_prices)
+        route->common = extract_common_prices(from_prices, to_prices);
+    gnc_price_list_destroy(from_prices);
+    gnc_price_list_destroy(to_prices);
+    if (route->common.from)
+        return;
+
+    /* Neither: go through as many other commodities as it takes. */
+    route->chain = find_conversion_chain(db, from, to, t);
+}
+
+static gnc_numeric
+convert_balance_direct(gnc_numeric bal, const gnc_commodity *from,
+                       const gnc_commodity *to, GNCPrice *price)
+{
+    if (gnc_price_get_commodity(price) == from)
+        return gnc_numeric_mul (bal, gnc_price_get_value (price),
+                                gnc_commodity_get_fraction (to),
+                                GNC_HOW_RND_ROUND);
+    return gnc_numeric_div (bal, gnc_price_get_value (price),
+                            gnc_commodity_get_fraction (to),
+                            GNC_HOW_RND_ROUND);
+}
+
 static gnc_numeric
 convert_balance(gnc_numeric bal, const gnc_commodity *from,
                 const gnc_commodity *to, PriceTuple tuple)
@@ -2311,42 +2731,89 @@ convert_balance(gnc_numeric bal, const gnc_commodity *from,
                            fraction, GNC_HOW_RND_ROUND);
 
 }
+
 static gnc_numeric
-indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                             const gnc_commodity *from, const gnc_commodity *to,
-                             Timespec *t )
+convert_balance_chain(gnc_numeric bal, const gnc_commodity *from,
+                      const gnc_commodity *to, GList *chain)
 {
-    GList *from_prices = NULL, *to_prices = NULL;
-    PriceTuple tuple;
-    gnc_numeric zero = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
-        return zero;
-    if (gnc_numeric_zero_p(bal))
-        return zero;
-    if (t == NULL)
+    int no_round = GNC_HOW_DENOM_REDUCE | GNC_HOW_RND_NEVER;
+    gnc_numeric rate = gnc_numeric_create(1, 1);
+    const gnc_commodity *c = from;
+    GList *node;
+
+    /* Multiply out the exact rate, then round once. */
+    for (node = chain; node; node = node->next)
     {
-        from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
-        /* "to" is often the book currency which may have lots of prices,
-            so avoid getting them if they aren't needed. */
-        if (from_prices)
-            to_prices = gnc_pricedb_lookup_latest_any_currency(db, to);
+        GNCPrice *price = node->data;
+        gnc_numeric value = gnc_price_get_value(price);
+        if (gnc_price_get_commodity(price) == c)
+        {
+            rate = gnc_numeric_mul(rate, value, GNC_DENOM_AUTO, no_round);
+            c = gnc_price_get_currency(price);
+        }
+        else
+        {
+            rate = gnc_numeric_div(rate, value, GNC_DENOM_AUTO, no_round);
+            c = gnc_price_get_commodity(price);
+        }
+    }
+    if (gnc_numeric_check(rate))
+        return gnc_numeric_zero();
+    return gnc_numeric_mul(bal, rate, gnc_commodity_get_fraction(to),
+                           GNC_HOW_RND_ROUND);
+}
+
+static gnc_numeric
+pricedb_convert_balance (GNCPriceDB *db, gnc_numeric bal,
+                         const gnc_commodity *from, const gnc_commodity *to,
+                         Timespec *t)
+{
+    ConversionKey key;
+    ConversionRoute *route;
+
+    if (!db || from == NULL || to == NULL)
+        return gnc_numeric_zero();
+
+    key.from = from;
+    key.to = to;
+    key.latest = (t == NULL);
+    key.t = t ? *t : (Timespec) {0, 0};
+    route = g_hash_table_lookup(db->conversions, &key);
+    if (route)
+    {
+        g_queue_unlink(&db->conversions_lru, route->lru_link);
+        g_queue_push_tail_link(&db->conversions_lru, route->lru_link);
     }
     else
     {
-        from_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
-                                                                      from, *t);
-        if (from_prices)
-            to_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
-                                                                    to, *t);
+        ConversionKey *new_key = g_memdup(&key, sizeof(key));
+
+        if (g_hash_table_size(db->conversions) >= PRICEDB_MAX_CONVERSIONS)
+        {
+            GList *oldest = g_queue_pop_head_link(&db->conversions_lru);
+            g_hash_table_remove(db->conversions, oldest->data);
+            g_list_free_1(oldest);
+        }
+        route = find_conversion_route(db, from, to, t);
+        g_hash_table_insert(db->conversions, new_key, route);
+        g_queue_push_tail(&db->conversions_lru, new_key);
+        route->lru_link = db->conversions_lru.tail;
     }
-    if (from_prices == NULL || to_prices == NULL)
-        return zero;
-    tuple = extract_common_prices(from_prices, to_prices);
-    gnc_price_list_destroy(from_prices);
-    gnc_price_list_destroy(to_prices);
-    if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
-    return zero;
+
+    if (route->direct)
+    {
+        gnc_numeric result = convert_balance_direct(bal, from, to,
+                                                    route->direct);
+        if (!gnc_numeric_zero_p(result))
+            return result;
+    }
+    if (!route->indirect_searched)
+        find_indirect_conversion_route(db, from, to, t, route);
+    if (route->common.from)
+        return convert_balance(bal, from, to, route->common);
+    if (route->chain)
+        return convert_balance_chain(bal, from, to, route->chain);
+    return gnc_numeric_zero();
 }
 
 
@@ -2359,24 +2826,12 @@ gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
         const gnc_commodity *balance_currency,
         const gnc_commodity *new_currency)
 {
-    gnc_numeric new_value;
-
     if (gnc_numeric_zero_p (balance) ||
             gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
 
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, NULL);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
-
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, NULL);
+    return pricedb_convert_balance(pdb, balance, balance_currency,
+                                   new_currency, NULL);
 }
 
 gnc_numeric
@@ -2386,24 +2841,12 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
         const gnc_commodity *new_currency,
         Timespec t)
 {
-    gnc_numeric new_value;
-
     if (gnc_numeric_zero_p (balance) ||
         gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
 
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, &t);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
-
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, &t);
+    return pricedb_convert_balance(pdb, balance, balance_currency,
+                                   new_currency, &t);
 }
 
 
@@ -2411,34 +2854,56 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
 /* gnc_pricedb_foreach_price infrastructure
  */
 
-typedef struct
-{
-    gboolean ok;
-    gboolean (*func)(GNCPrice *p, gpointer user_data);
-    gpointer user_data;
-} GNCPriceDBForeachData;
+/* The traversals walk a snapshot of the prices, each holding a reference,
+ * so that the callbacks may remove prices from the database.  Prices
+ * removed before their turn are skipped. */
 
 static void
-pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
+pricedb_snapshot_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
-    GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
+    GPtrArray *prices = (GPtrArray *) val;
+    GPtrArray *snapshot = (GPtrArray *) user_data;
+    guint i;
 
-    /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    for (i = 0; i < prices->len; i++)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
-        foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index(prices, i);
+        gnc_price_ref(p);
+        g_ptr_array_add(snapshot, p);
     }
 }
 
 static void
-pricedb_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
+pricedb_snapshot_currencies_hash(gpointer key, gpointer val, gpointer user_data)
 {
     GHashTable *currencies_hash = (GHashTable *) val;
-    g_hash_table_foreach(currencies_hash, pricedb_foreach_pricelist, user_data);
+    g_hash_table_foreach(currencies_hash, pricedb_snapshot_pricelist, user_data);
+}
+
+static GPtrArray *
+pricedb_snapshot_new(void)
+{
+    return g_ptr_array_new_with_free_func((GDestroyNotify) gnc_price_unref);
+}
+
+static gboolean
+pricedb_snapshot_traversal(GNCPriceDB *db, GPtrArray *snapshot,
+                           gboolean (*f)(GNCPrice *p, gpointer user_data),
+                           gpointer user_data)
+{
+    gboolean ok = TRUE;
+    guint i;
+
+    /* stop traversal when f returns FALSE */
+    for (i = 0; ok && i < snapshot->len; i++)
+    {
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index(snapshot, i);
+        if (p->db != db)
+            continue;
+        ok = f(p, user_data);
+    }
+    g_ptr_array_free(snapshot, TRUE);
+    return ok;
 }
 
 static gboolean
@@ -2446,39 +2911,38 @@ unstable_price_traversal(GNCPriceDB *db,
                          gboolean (*f)(GNCPrice *p, gpointer user_data),
                          gpointer user_data)
 {
-    GNCPriceDBForeachData foreach_data;
+    GPtrArray *snapshot;
 
     if (!db || !f) return FALSE;
-    foreach_data.ok = TRUE;
-    foreach_data.func = f;
-    foreach_data.user_data = user_data;
     if (db->commodity_hash == NULL)
     {
         return FALSE;
     }
+    pricedb_sort_unsorted(db);
+    snapshot = pricedb_snapshot_new();
     g_hash_table_foreach(db->commodity_hash,
-                         pricedb_foreach_currencies_hash,
-                         &foreach_data);
+                         pricedb_snapshot_currencies_hash,
+                         snapshot);
 
-    return foreach_data.ok;
+    return pricedb_snapshot_traversal(db, snapshot, f, user_data);
 }
 
 /* foreach_pricelist */
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(GPtrArray *p, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GPtrArray *prices = (GPtrArray *) val;
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(prices, foreach_data->user_data);
     }
 }
 
@@ -2491,7 +2955,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(GPtrArray *p, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2504,6 +2968,7 @@ pricedb_pricelist_traversal(GNCPriceDB *db,
     {
         return FALSE;
     }
+    pricedb_sort_unsorted(db);
     g_hash_table_foreach(db->commodity_hash,
                          pricedb_pricelist_foreach_currencies_hash,
                          &foreach_data);
@@ -2543,14 +3008,16 @@ stable_price_traversal(GNCPriceDB *db,
                        gpointer user_data)
 {
     GSList *currency_hashes = NULL;
-    gboolean ok = TRUE;
+    GPtrArray *snapshot;
     GSList *i = NULL;
 
     if (!db || !f) return FALSE;
 
+    pricedb_sort_unsorted(db);
     currency_hashes = hash_table_to_list(db->commodity_hash);
     currency_hashes = g_slist_sort(currency_hashes,
                                    compare_hash_entries_by_commodity_key);
+    snapshot = pricedb_snapshot_new();
 
     for (i = currency_hashes; i; i = i->next)
     {
@@ -2563,17 +3030,8 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
-
-            for (node = (GList *) price_list; node; node = node->next)
-            {
-                GNCPrice *price = (GNCPrice *) node->data;
-
-                /* stop traversal when f returns FALSE */
-                if (FALSE == ok) break;
-                if (!f(price, user_data)) ok = FALSE;
-            }
+            pricedb_snapshot_pricelist(pricelist_entry->key,
+                                       pricelist_entry->value, snapshot);
         }
         if (price_lists)
         {
@@ -2588,7 +3046,7 @@ stable_price_traversal(GNCPriceDB *db,
         g_slist_foreach(currency_hashes, hash_entry_free_gfunc, NULL);
         g_slist_free(currency_hashes);
     }
-    return ok;
+    return pricedb_snapshot_traversal(db, snapshot, f, user_data);
 }
 
 gboolean
@@ -2778,49 +3236,28 @@ price_create (QofBook *book)
 /* ==================================================================== */
 /* a non-boolean foreach. Ugh */
 
-typedef struct
-{
-    void (*func)(GNCPrice *p, gpointer user_data);
-    gpointer user_data;
-}
-VoidGNCPriceDBForeachData;
-
-static void
-void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
-{
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
-    VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
-
-    while (node)
-    {
-        GNCPrice *p = (GNCPrice *) node->data;
-        foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
-    }
-}
-
-static void
-void_pricedb_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
-{
-    GHashTable *currencies_hash = (GHashTable *) val;
-    g_hash_table_foreach(currencies_hash, void_pricedb_foreach_pricelist, user_data);
-}
-
 static void
 void_unstable_price_traversal(GNCPriceDB *db,
                               void (*f)(GNCPrice *p, gpointer user_data),
                               gpointer user_data)
 {
-    VoidGNCPriceDBForeachData foreach_data;
+    GPtrArray *snapshot;
+    guint i;
 
     if (!db || !f) return;
-    foreach_data.func = f;
-    foreach_data.user_data = user_data;
 
+    pricedb_sort_unsorted(db);
+    snapshot = pricedb_snapshot_new();
     g_hash_table_foreach(db->commodity_hash,
-                         void_pricedb_foreach_currencies_hash,
-                         &foreach_data);
+                         pricedb_snapshot_currencies_hash,
+                         snapshot);
+    for (i = 0; i < snapshot->len; i++)
+    {
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index(snapshot, i);
+        if (p->db == db)
+            f(p, user_data);
+    }
+    g_ptr_array_free(snapshot, TRUE);
 }
 
 static void
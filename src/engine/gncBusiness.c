@@ -29,64 +29,199 @@
 /* The initialization of the business objects is done in
  * cashobjects_register() of <engine/cashobjects.h>. */
 
-struct _get_list_userdata
-{
-    GList *result;
-    QofAccessFunc is_active_accessor_func;
-};
-static void get_list_cb (QofInstance *inst, gpointer user_data)
+GList * gncBusinessGetList (QofBook *book, const char *type_name,
+                            gboolean all_including_inactive)
 {
-    struct _get_list_userdata* data = user_data;
-    if (!data->is_active_accessor_func || data->is_active_accessor_func(inst, NULL))
-        data->result = g_list_prepend(data->result, inst);
+    QofAccessFunc is_active_accessor_func = NULL;
+    QofCollectionIter iter;
+    QofInstance *inst;
+    GList *result = NULL;
+
+    if (!book || !type_name)
+        return NULL;
+
+    if (!all_including_inactive)
+    {
+        is_active_accessor_func =
+            qof_class_get_parameter_getter(type_name, QOF_PARAM_ACTIVE);
+    }
+
+    qof_collection_iter_init(&iter, qof_book_get_collection(book, type_name));
+    while ((inst = qof_collection_iter_next(&iter)))
+    {
+        if (!is_active_accessor_func || is_active_accessor_func(inst, NULL))
+            result = g_list_prepend(result, inst);
+    }
+
+    return result;
 }
 
 
-GList * gncBusinessGetList (QofBook *book, const char *type_name,
-                            gboolean all_including_inactive)
+GList * gncBusinessGetOwnerList (QofBook *book, const char *type_name,
+                                 gboolean all_including_inactive)
 {
-    struct _get_list_userdata data;
-    data.result = NULL;
-    data.is_active_accessor_func = NULL;
+    QofAccessFunc is_active_accessor_func = NULL;
+    QofCollectionIter iter;
+    QofInstance *inst;
+    GList *result = NULL;
+
+    if (!book || !type_name)
+        return NULL;
 
     if (!all_including_inactive)
     {
-        data.is_active_accessor_func =
+        is_active_accessor_func =
             qof_class_get_parameter_getter(type_name, QOF_PARAM_ACTIVE);
     }
 
-    qof_object_foreach(type_name, book, &get_list_cb, &data);
+    qof_collection_iter_init(&iter, qof_book_get_collection(book, type_name));
+    while ((inst = qof_collection_iter_next(&iter)))
+    {
+        if (!is_active_accessor_func || is_active_accessor_func(inst, NULL))
+        {
+            GncOwner *owner = gncOwnerNew();
+            qofOwnerSetEntity(owner, inst);
+            result = g_list_prepend(result, owner);
+        }
+    }
+
+    return result;
+}
+
+/* Queries for business objects by ID are served by an index of the
+ * objects by ID, one per book and object type, which the ID setters
+ * keep up to date. */
+
+#define ID_INDEX_BOOK_DATA "gnc-business-id-index"
+
+typedef struct
+{
+    GHashTable *by_id;          /* ID -> GList of instances */
+    GHashTable *ids;            /* instance -> its key in by_id */
+} IDIndex;
+
+static void
+id_index_free (gpointer data)
+{
+    IDIndex *index = data;
 
-    return data.result;
+    g_hash_table_destroy (index->ids);
+    g_hash_table_destroy (index->by_id);
+    g_free (index);
 }
 
-static void get_ownerlist_cb (QofInstance *inst, gpointer user_data)
+static void
+id_index_book_end (QofBook *book, gpointer key, gpointer data)
 {
-    struct _get_list_userdata* data = user_data;
-    if (!data->is_active_accessor_func || data->is_active_accessor_func(inst, NULL))
+    g_hash_table_destroy (data);
+    qof_book_set_data (book, key, NULL);
+}
+
+static IDIndex *
+id_index_get (QofBook *book, QofIdTypeConst type_name, gboolean create)
+{
+    GHashTable *indexes = qof_book_get_data (book, ID_INDEX_BOOK_DATA);
+    IDIndex *index;
+
+    if (!indexes)
     {
-        GncOwner *owner = gncOwnerNew();
-        qofOwnerSetEntity(owner, inst);
-        data->result = g_list_prepend(data->result, owner);
+        if (!create) return NULL;
+        indexes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, id_index_free);
+        qof_book_set_data_fin (book, ID_INDEX_BOOK_DATA, indexes,
+                               id_index_book_end);
     }
+    index = g_hash_table_lookup (indexes, type_name);
+    if (!index && create)
+    {
+        index = g_new0 (IDIndex, 1);
+        index->by_id = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify) g_list_free);
+        index->ids = g_hash_table_new (NULL, NULL);
+        g_hash_table_insert (indexes, (gpointer) type_name, index);
+    }
+    return index;
 }
 
-GList * gncBusinessGetOwnerList (QofBook *book, const char *type_name,
-                                 gboolean all_including_inactive)
+void gncBusinessSetIndexedID (QofInstance *inst, const char *id)
 {
-    struct _get_list_userdata data;
-    data.result = NULL;
-    data.is_active_accessor_func = NULL;
+    QofBook *book = qof_instance_get_book (inst);
+    IDIndex *index;
+    gchar *old_id;
 
-    if (!all_including_inactive)
+    if (!book || qof_book_shutting_down (book)) return;
+    index = id_index_get (book, inst->e_type, id != NULL);
+    if (!index) return;
+
+    old_id = g_hash_table_lookup (index->ids, inst);
+    if (old_id)
     {
-        data.is_active_accessor_func =
-            qof_class_get_parameter_getter(type_name, QOF_PARAM_ACTIVE);
+        GList *insts = g_hash_table_lookup (index->by_id, old_id);
+
+        if (!g_strcmp0 (old_id, id)) return;
+        g_hash_table_remove (index->ids, inst);
+        insts = g_list_remove (insts, inst);
+        g_hash_table_steal (index->by_id, old_id);
+        if (insts)
+            g_hash_table_insert (index->by_id, old_id, insts);
+        else
+            g_free (old_id);
+    }
+
+    if (id)
+    {
+        gchar *key;
+        GList *insts;
+
+        if (!g_hash_table_lookup_extended (index->by_id, id,
+                                           (gpointer *) &key,
+                                           (gpointer *) &insts))
+        {
+            key = g_strdup (id);
+            insts = NULL;
+        }
+        g_hash_table_steal (index->by_id, key);
+        g_hash_table_insert (index->by_id, key,
+                             g_list_prepend (insts, inst));
+        g_hash_table_insert (index->ids, inst, key);
     }
+}
+
+static gint64
+id_index_estimate (QofBook *book, const QofQueryIndexKey *key)
+{
+    IDIndex *index = id_index_get (book, key->search_for, FALSE);
+
+    if (!index) return 0;
+    return g_list_length (g_hash_table_lookup (index->by_id, key->string));
+}
 
-    qof_object_foreach(type_name, book, &get_ownerlist_cb, &data);
+static void
+id_index_lookup (QofBook *book, const QofQueryIndexKey *key,
+                 QofInstanceForeachCB cb, gpointer user_data)
+{
+    IDIndex *index = id_index_get (book, key->search_for, FALSE);
+    GList *node;
+
+    if (!index) return;
+    for (node = g_hash_table_lookup (index->by_id, key->string); node;
+         node = node->next)
+        cb (node->data, user_data);
+}
 
-    return data.result;
+static const QofQueryIndex id_index =
+{
+    "business ID",
+    id_index_estimate,
+    id_index_lookup,
+};
+
+void gncBusinessRegisterIDIndex (QofIdTypeConst type_name,
+                                 const char *id_param)
+{
+    qof_query_register_index (type_name,
+                              qof_query_build_param_list (id_param, NULL),
+                              QOF_TYPE_STRING, &id_index);
 }
 
 gboolean gncBusinessIsPaymentAcctType (GNCAccountType type)
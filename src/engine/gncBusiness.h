@@ -87,6 +87,16 @@ typedef GList OwnerList;
 OwnerList * gncBusinessGetOwnerList (QofBook *book, QofIdTypeConst type_name,
                                      gboolean all_including_inactive);
 
+/** Records the new ID of a business object in the index that serves
+ * queries for objects of its type by ID.  Call it whenever the ID is
+ * set, and with a NULL id when the object is freed. */
+void gncBusinessSetIndexedID (QofInstance *inst, const char *id);
+
+/** Registers the index of objects of type_name by ID for queries by
+ * the id_param parameter. */
+void gncBusinessRegisterIDIndex (QofIdTypeConst type_name,
+                                 const char *id_param);
+
 /** Returns whether the given account type is a valid type to use in
  * business payments. Currently payments are allowed to/from assets,
  * liabilities and equity accounts. */
@@ -319,6 +319,7 @@ GncCustomer *gncCustomerCreate (QofBook *book)
     qof_instance_init_data (&cust->inst, _GNC_MOD_NAME, book);
 
     cust->id = CACHE_INSERT ("");
+    gncBusinessSetIndexedID (&cust->inst, cust->id);
     cust->name = CACHE_INSERT ("");
     cust->notes = CACHE_INSERT ("");
     cust->addr = gncAddressCreate (book, &cust->inst);
@@ -354,6 +355,7 @@ static void gncCustomerFree (GncCustomer *cust)
 
     qof_event_gen (&cust->inst, QOF_EVENT_DESTROY, NULL);
 
+    gncBusinessSetIndexedID (&cust->inst, NULL);
     CACHE_REMOVE (cust->id);
     CACHE_REMOVE (cust->name);
     CACHE_REMOVE (cust->notes);
@@ -392,6 +394,7 @@ void gncCustomerSetID (GncCustomer *cust, const char *id)
     if (!cust) return;
     if (!id) return;
     SET_STR(cust, cust->id, id);
+    gncBusinessSetIndexedID (&cust->inst, cust->id);
     mark_customer (cust);
     gncCustomerCommitEdit (cust);
 }
@@ -949,6 +952,7 @@ gboolean gncCustomerRegister (void)
     {
         return FALSE;
     }
+    gncBusinessRegisterIDIndex (GNC_ID_CUSTOMER, CUSTOMER_ID);
     /* temp */
     _gncCustomerPrintable(NULL);
     return qof_object_register (&gncCustomerDesc);
@@ -36,6 +36,7 @@
 #include "Transaction.h"
 #include "Account.h"
 #include "gncBillTermP.h"
+#include "gncBusiness.h"
 #include "gncEntry.h"
 #include "gncEntryP.h"
 #include "gnc-features.h"
@@ -320,6 +321,7 @@ GncInvoice *gncInvoiceCreate (QofBook *book)
     qof_instance_init_data (&invoice->inst, _GNC_MOD_NAME, book);
 
     invoice->id = CACHE_INSERT ("");
+    gncBusinessSetIndexedID (&invoice->inst, invoice->id);
     invoice->notes = CACHE_INSERT ("");
     invoice->billing_id = CACHE_INSERT ("");
 
@@ -350,6 +352,7 @@ GncInvoice *gncInvoiceCopy (const GncInvoice *from)
     gncInvoiceBeginEdit(invoice);
 
     invoice->id = CACHE_INSERT (from->id);
+    gncBusinessSetIndexedID (&invoice->inst, invoice->id);
     invoice->notes = CACHE_INSERT (from->notes);
     invoice->billing_id = CACHE_INSERT (from->billing_id);
     invoice->active = from->active;
@@ -416,6 +419,7 @@ static void gncInvoiceFree (GncInvoice *invoice)
 
     qof_event_gen (&invoice->inst, QOF_EVENT_DESTROY, NULL);
 
+    gncBusinessSetIndexedID (&invoice->inst, NULL);
     CACHE_REMOVE (invoice->id);
     CACHE_REMOVE (invoice->notes);
     CACHE_REMOVE (invoice->billing_id);
@@ -438,6 +442,7 @@ void gncInvoiceSetID (GncInvoice *invoice, const char *id)
 {
     if (!invoice || !id) return;
     SET_STR (invoice, invoice->id, id);
+    gncBusinessSetIndexedID (&invoice->inst, invoice->id);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
 }
@@ -2151,6 +2156,7 @@ gboolean gncInvoiceRegister (void)
     {
         return FALSE;
     }
+    gncBusinessRegisterIDIndex (GNC_ID_INVOICE, INVOICE_ID);
     return qof_object_register (&gncInvoiceDesc);
 }
 
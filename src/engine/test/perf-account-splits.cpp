@@ -0,0 +1,151 @@
+/***************************************************************************
+ *            perf-account-splits.cpp
+ *
+ *  Benchmark for building and querying an account with many splits.
+ *
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/* Builds an account of N splits (500000 by default, or the first
+ * argument) through the public engine API, posting the transactions
+ * in shuffled date order so that most inserts land in the middle of
+ * the split list, then times as-of-date balance lookups on it.  It is
+ * not part of the tests; build it with "make perf-account-splits" and
+ * run it by hand. */
+extern "C"
+{
+#include "config.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "TransLog.h"
+#include "gnc-commodity.h"
+#include "gnc-engine.h"
+}
+
+static const int default_num_splits = 500000;
+static const time64 day = 24 * 3600;
+static const time64 start_date = 946684800; /* 2000-01-01 */
+
+static void
+add_transaction (QofBook *book, gnc_commodity *curr, Account *acc,
+                 Account *other, time64 date, gint64 cents)
+{
+    auto trans = xaccMallocTransaction (book);
+    auto split = xaccMallocSplit (book);
+    auto other_split = xaccMallocSplit (book);
+    auto amount = gnc_numeric_create (cents, 100);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, curr);
+    xaccTransSetDatePostedSecsNormalized (trans, date);
+    xaccTransSetDescription (trans, "benchmark");
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+
+    xaccSplitSetParent (other_split, trans);
+    xaccSplitSetAccount (other_split, other);
+    xaccSplitSetAmount (other_split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (other_split, gnc_numeric_neg (amount));
+    xaccTransCommitEdit (trans);
+}
+
+static double
+seconds_since (gint64 start)
+{
+    return (g_get_monotonic_time () - start) / (double) G_USEC_PER_SEC;
+}
+
+int
+main (int argc, char **argv)
+{
+    int num_splits = argc > 1 ? atoi (argv[1]) : default_num_splits;
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+    xaccLogDisable ();
+
+    auto session = qof_session_new ();
+    auto book = qof_session_get_book (session);
+    auto curr = gnc_commodity_new (book, "Benchmark Dollar", "CURRENCY",
+                                   "BMD", "", 100);
+    auto root = gnc_account_create_root (book);
+    auto acc = xaccMallocAccount (book);
+    auto other = xaccMallocAccount (book);
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, "Bank");
+    xaccAccountSetType (acc, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (acc, curr);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    xaccAccountBeginEdit (other);
+    xaccAccountSetName (other, "Expenses");
+    xaccAccountSetType (other, ACCT_TYPE_EXPENSE);
+    xaccAccountSetCommodity (other, curr);
+    gnc_account_append_child (root, other);
+    xaccAccountCommitEdit (other);
+
+    /* Post the days in a fixed pseudo-random order: a multiplier
+     * coprime with the count visits each day exactly once. */
+    auto start = g_get_monotonic_time ();
+    gint64 total = 0;
+    for (int i = 0; i < num_splits; ++i)
+    {
+        gint64 day_num = ((gint64) i * 7919) % num_splits;
+        if (num_splits % 7919 == 0)
+            day_num = i;
+        add_transaction (book, curr, acc, other,
+                         start_date + (day_num / 4) * day, day_num + 1);
+        total += day_num + 1;
+    }
+    printf ("built %d splits in %.3f s\n", num_splits, seconds_since (start));
+
+    start = g_get_monotonic_time ();
+    auto count = xaccAccountCountSplits (acc, FALSE);
+    auto balance = xaccAccountGetBalanceAsOfDate (acc, G_MAXINT64);
+    printf ("first balance lookup (sort and balances) in %.3f s\n",
+            seconds_since (start));
+    if (count != num_splits ||
+        !gnc_numeric_equal (balance, gnc_numeric_create (total, 100)))
+    {
+        fprintf (stderr, "account has %" G_GINT64_FORMAT
+                 " splits and an unexpected balance\n", count);
+        return 1;
+    }
+
+    const int lookups = 100000;
+    start = g_get_monotonic_time ();
+    for (int i = 0; i < lookups; ++i)
+        xaccAccountGetBalanceAsOfDate (acc, start_date + (i % (num_splits / 4 + 1)) * day);
+    printf ("%d as-of-date balance lookups in %.3f s\n", lookups,
+            seconds_since (start));
+
+    start = g_get_monotonic_time ();
+    qof_session_destroy (session);
+    printf ("destroyed the book in %.3f s\n", seconds_since (start));
+    qof_close ();
+    return 0;
+}
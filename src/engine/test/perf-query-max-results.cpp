@@ -0,0 +1,172 @@
+/***************************************************************************
+ *            perf-query-max-results.cpp
+ *
+ *  Benchmark for sorted split queries returning the last few results.
+ *
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/* Builds a book of N splits (1000000 by default, or the first
+ * argument) in transactions of two splits, then times a query for all
+ * of them sorted by date, number and value, once for all the results
+ * and once for the last 50 (or the second argument), and checks that
+ * the short list is the tail of the long one.  "make check" neither
+ * builds nor runs it; "make perf-query-max-results" builds it. */
+extern "C"
+{
+#include "config.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "TransLog.h"
+#include "gnc-commodity.h"
+#include "gnc-engine.h"
+}
+
+static const int default_num_splits = 1000000;
+static const int default_max_results = 50;
+static const time64 day = 24 * 3600;
+static const time64 start_date = 946684800; /* 2000-01-01 */
+
+static void
+add_transaction (QofBook *book, gnc_commodity *curr, Account *acc,
+                 Account *other, time64 date, const char *num, gint64 cents)
+{
+    auto trans = xaccMallocTransaction (book);
+    auto split = xaccMallocSplit (book);
+    auto other_split = xaccMallocSplit (book);
+    auto amount = gnc_numeric_create (cents, 100);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, curr);
+    xaccTransSetDatePostedSecsNormalized (trans, date);
+    xaccTransSetNum (trans, num);
+    xaccTransSetDescription (trans, "benchmark");
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, amount);
+
+    xaccSplitSetParent (other_split, trans);
+    xaccSplitSetAccount (other_split, other);
+    xaccSplitSetAmount (other_split, gnc_numeric_neg (amount));
+    xaccSplitSetValue (other_split, gnc_numeric_neg (amount));
+    xaccTransCommitEdit (trans);
+}
+
+static double
+seconds_since (gint64 start)
+{
+    return (g_get_monotonic_time () - start) / (double) G_USEC_PER_SEC;
+}
+
+static Account *
+add_account (QofBook *book, Account *root, gnc_commodity *curr,
+             const char *name, GNCAccountType type)
+{
+    auto acc = xaccMallocAccount (book);
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, curr);
+    gnc_account_append_child (root, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static QofQuery *
+sorted_split_query (QofBook *book, int max_results)
+{
+    auto q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    qof_query_set_sort_order (q,
+        qof_query_build_param_list (SPLIT_TRANS, TRANS_DATE_POSTED, NULL),
+        qof_query_build_param_list (SPLIT_TRANS, TRANS_NUM, NULL),
+        qof_query_build_param_list (SPLIT_VALUE, NULL));
+    qof_query_set_max_results (q, max_results);
+    return q;
+}
+
+int
+main (int argc, char **argv)
+{
+    int num_splits = argc > 1 ? atoi (argv[1]) : default_num_splits;
+    int max_results = argc > 2 ? atoi (argv[2]) : default_max_results;
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+    xaccLogDisable ();
+
+    auto session = qof_session_new ();
+    auto book = qof_session_get_book (session);
+    auto curr = gnc_commodity_new (book, "Benchmark Dollar", "CURRENCY",
+                                   "BMD", "", 100);
+    auto root = gnc_account_create_root (book);
+    auto acc = add_account (book, root, curr, "Bank", ACCT_TYPE_BANK);
+    auto other = add_account (book, root, curr, "Expenses",
+                              ACCT_TYPE_EXPENSE);
+
+    /* Many transactions share a date and number, so the secondary and
+     * tertiary sorts matter. */
+    auto start = g_get_monotonic_time ();
+    for (int i = 0; i < num_splits / 2; ++i)
+    {
+        char num[16];
+        g_snprintf (num, sizeof (num), "%d", i % 7);
+        add_transaction (book, curr, acc, other,
+                         start_date + ((i * 7919) % (num_splits / 8 + 1)) * day,
+                         num, (i * 31) % 1000 + 1);
+    }
+    printf ("built %d splits in %.3f s\n", num_splits, seconds_since (start));
+
+    auto all_q = sorted_split_query (book, -1);
+    start = g_get_monotonic_time ();
+    auto all = qof_query_run (all_q);
+    printf ("sorted query for all %u splits in %.3f s\n",
+            g_list_length (all), seconds_since (start));
+
+    auto top_q = sorted_split_query (book, max_results);
+    start = g_get_monotonic_time ();
+    auto top = qof_query_run (top_q);
+    printf ("sorted query for the last %d splits in %.3f s\n", max_results,
+            seconds_since (start));
+
+    int rv = 0;
+    auto node = g_list_nth (all, g_list_length (all) - g_list_length (top));
+    for (auto tp = top; tp || node; tp = tp->next, node = node->next)
+    {
+        if (!tp || !node || tp->data != node->data)
+        {
+            fprintf (stderr, "the last results differ from the full sort\n");
+            rv = 1;
+            break;
+        }
+    }
+
+    qof_query_destroy (top_q);
+    qof_query_destroy (all_q);
+    qof_session_destroy (session);
+    qof_close ();
+    return rv;
+}
@@ -68,6 +68,239 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+typedef struct
+{
+    time64 start;
+    guint count;
+} DateCount;
+
+static void
+count_splits_posted_from (QofInstance *inst, gpointer user_data)
+{
+    DateCount *data = static_cast<DateCount*>(user_data);
+    Transaction *trans = xaccSplitGetParent (GNC_SPLIT(inst));
+
+    if (trans && xaccTransGetDate (trans) >= data->start)
+        data->count++;
+}
+
+/* Split queries by account and by date are served by indexes; check
+ * that they find the same splits as looking at all of them. */
+static void
+test_split_query_indexes (QofBook *book, Account *root)
+{
+    GList *accounts = gnc_account_get_descendants (root);
+    GList *node, *splits, *lp;
+    QofQuery *q;
+
+    for (node = accounts; node; node = node->next)
+    {
+        Account *acc = GNC_ACCOUNT(node->data);
+        GList *acc_splits = xaccAccountGetSplitList (acc);
+        DateCount data;
+
+        q = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (q, book);
+        xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+        splits = qof_query_run (q);
+        if (g_list_length (splits) != g_list_length (acc_splits))
+        {
+            failure_args ("account query", __FILE__, __LINE__,
+                          "found %d splits, not %d", g_list_length (splits),
+                          g_list_length (acc_splits));
+            qof_query_destroy (q);
+            break;
+        }
+        for (lp = splits; lp; lp = lp->next)
+            if (xaccSplitGetAccount (GNC_SPLIT(lp->data)) != acc)
+                failure ("account query found a split of another account");
+        qof_query_destroy (q);
+
+        if (!acc_splits) continue;
+        lp = g_list_nth (acc_splits, g_list_length (acc_splits) / 2);
+        data.start = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(lp->data)));
+        data.count = 0;
+        qof_collection_foreach (qof_book_get_collection (book, GNC_ID_SPLIT),
+                                count_splits_posted_from, &data);
+
+        q = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (q, book);
+        xaccQueryAddDateMatchTT (q, TRUE, data.start, FALSE, 0, QOF_QUERY_AND);
+        splits = qof_query_run (q);
+        if (g_list_length (splits) != data.count)
+            failure_args ("date query", __FILE__, __LINE__,
+                          "found %d splits, not %d", g_list_length (splits),
+                          data.count);
+        qof_query_destroy (q);
+    }
+
+    /* A split moved in an open transaction is found in its new account. */
+    for (node = accounts; node && node->next; node = node->next)
+    {
+        Account *acc = GNC_ACCOUNT(node->next->data);
+        GList *acc_splits = xaccAccountGetSplitList (GNC_ACCOUNT(node->data));
+        Split *split;
+        Transaction *trans;
+
+        if (!acc_splits) continue;
+        split = GNC_SPLIT(acc_splits->data);
+        trans = xaccSplitGetParent (split);
+        xaccTransBeginEdit (trans);
+        xaccSplitSetAccount (split, acc);
+        q = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (q, book);
+        xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+        splits = qof_query_run (q);
+        if (!g_list_find (splits, split))
+            failure ("account query missed a split moved in an open edit");
+        qof_query_destroy (q);
+        xaccTransRollbackEdit (trans);
+        break;
+    }
+    g_list_free (accounts);
+    success ("split query indexes find the right splits");
+}
+
+static QofQuery *
+sorted_split_query (QofBook *book, int max_results)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+
+    qof_query_set_book (q, book);
+    qof_query_set_sort_order (q,
+        qof_query_build_param_list (SPLIT_TRANS, TRANS_DATE_POSTED, NULL),
+        qof_query_build_param_list (SPLIT_RECONCILE, NULL),
+        qof_query_build_param_list (SPLIT_VALUE, NULL));
+    qof_query_set_max_results (q, max_results);
+    return q;
+}
+
+/* The last few results of a sorted query are picked without sorting
+ * all of them; check that they are the tail of the full sort. */
+static void
+test_max_results (QofBook *book)
+{
+    QofQuery *all_q = sorted_split_query (book, -1);
+    QofQuery *top_q = sorted_split_query (book, 7);
+    GList *all = qof_query_run (all_q);
+    GList *top = qof_query_run (top_q);
+    guint top_len = MIN (g_list_length (all), 7);
+    GList *node = g_list_nth (all, g_list_length (all) - top_len);
+
+    if (g_list_length (top) != top_len)
+        failure_args ("max results", __FILE__, __LINE__,
+                      "found %d splits, not %d", g_list_length (top), top_len);
+    for (; top && node; top = top->next, node = node->next)
+        if (top->data != node->data)
+        {
+            failure ("the last results differ from the full sort");
+            break;
+        }
+    qof_query_destroy (top_q);
+    qof_query_destroy (all_q);
+    success ("max results keep the order of the full sort");
+}
+
+static QofQuery *
+posted_from_query (QofBook *book, time64 start)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, TRUE, start, FALSE, 0, QOF_QUERY_AND);
+    return q;
+}
+
+static void
+check_incremental_query (QofQuery *inc_q, QofBook *book, time64 start,
+                         const char *what)
+{
+    QofQuery *q = posted_from_query (book, start);
+    GList *expected = qof_query_run (q);
+    GList *found = qof_query_run (inc_q);
+
+    if (g_list_length (found) != g_list_length (expected))
+        failure_args (what, __FILE__, __LINE__, "found %d splits, not %d",
+                      g_list_length (found), g_list_length (expected));
+    for (; found && expected; found = found->next, expected = expected->next)
+        if (found->data != expected->data)
+        {
+            failure_args (what, __FILE__, __LINE__,
+                          "results differ from a full run");
+            break;
+        }
+    qof_query_destroy (q);
+}
+
+/* An incremental query only checks again the splits of the objects
+ * changed since its last run; check that it still finds what a full
+ * run does. */
+static void
+test_incremental_query (QofBook *book)
+{
+    const time64 week = 7 * 24 * 3600;
+    QofQuery *all_q = qof_query_create_for (GNC_ID_SPLIT);
+    QofQuery *inc_q;
+    QofBook *other_book;
+    GList *node, *trans_list = NULL;
+    Transaction *trans;
+    time64 start;
+    int i;
+
+    qof_query_set_book (all_q, book);
+    node = qof_query_run (all_q);
+    if (!node)
+    {
+        qof_query_destroy (all_q);
+        return;
+    }
+    node = g_list_nth (node, g_list_length (node) / 2);
+    start = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(node->data)));
+
+    inc_q = posted_from_query (book, start);
+    qof_query_set_incremental (inc_q, TRUE);
+    check_incremental_query (inc_q, book, start, "first incremental run");
+
+    /* Move some transactions out of the range and some into it. */
+    for (node = qof_query_last_run (all_q); node; node = node->next)
+    {
+        trans = xaccSplitGetParent (GNC_SPLIT(node->data));
+        if (!g_list_find (trans_list, trans))
+            trans_list = g_list_prepend (trans_list, trans);
+    }
+    for (node = trans_list, i = 0; node; node = node->next, i++)
+    {
+        trans = GNC_TRANSACTION(node->data);
+        if (i % 3 == 2) continue;
+        xaccTransBeginEdit (trans);
+        xaccTransSetDatePostedSecsNormalized (trans,
+                                              start + (i % 3 ? week : -week));
+        xaccTransCommitEdit (trans);
+    }
+    check_incremental_query (inc_q, book, start, "run after date changes");
+
+    node = trans_list->next ? trans_list->next : trans_list;
+    trans = GNC_TRANSACTION(node->data);
+    xaccTransBeginEdit (trans);
+    xaccTransDestroy (trans);
+    xaccTransCommitEdit (trans);
+    check_incremental_query (inc_q, book, start, "run after a destroy");
+
+    /* Changes in another book don't reach the results. */
+    other_book = qof_book_new ();
+    trans = get_random_transaction (other_book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedSecsNormalized (trans, start + week);
+    xaccTransCommitEdit (trans);
+    check_incremental_query (inc_q, book, start, "run after another book");
+    qof_book_destroy (other_book);
+
+    g_list_free (trans_list);
+    qof_query_destroy (inc_q);
+    qof_query_destroy (all_q);
+    success ("incremental queries find the right splits");
+}
+
 static void
 run_test (void)
 {
@@ -82,6 +315,9 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    test_split_query_indexes (book, root);
+    test_max_results (book);
+    test_incremental_query (book);
 
     qof_session_end (session);
 }
@@ -1146,6 +1146,8 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     /* Check that it works the first time */
     g_assert (gnc_account_insert_split (fixture->acct, split1));
     g_assert_cmpuint (g_list_length (priv->splits), == , 1);
+    g_assert_cmpint (g_sequence_get_length (priv->split_seq), == , 1);
+    g_assert (g_hash_table_lookup (priv->split_iters, split1) != NULL);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 1);
@@ -1180,6 +1182,8 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
     g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpint (g_sequence_get_length (priv->split_seq), == , 2);
+    g_assert (g_hash_table_lookup (priv->split_iters, split3) == NULL);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1329,6 +1333,7 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
                 clr_bal = gnc_numeric_zero ();
     SetupData *sdata = (SetupData*)pData;
     TxnParms* t_arr;
+    Split *first, *last;
     g_assert (sdata != NULL);
     t_arr = (TxnParms*)sdata->txns;
     for (unsigned int ind = 0; ind < sdata->num_txns; ind++)
@@ -1349,6 +1354,66 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
     g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
     g_assert (!priv->balance_dirty);
+    /* Dirtying a single split recomputes only from that split onward,
+     * so a stale balance ahead of it is left alone. */
+    first = static_cast<Split*>(priv->splits->data);
+    last = static_cast<Split*>(g_list_last (priv->splits)->data);
+    g_assert (first != last);
+    first->balance = gnc_numeric_zero ();
+    gnc_account_set_balance_dirty_from_split (fixture->acct, last);
+    g_assert (priv->balance_dirty);
+    g_assert (last->balance_dirty);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (!priv->balance_dirty);
+    g_assert (!last->balance_dirty);
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    g_assert (gnc_numeric_zero_p (first->balance));
+}
+
+/* Changing the date of a transaction marks only its splits as possibly
+ * out of place, and the sort moves just those. */
+static void
+test_xaccAccountSortSplits (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    Split *first = static_cast<Split*>(priv->splits->data);
+    Split *last = static_cast<Split*>(g_list_last (priv->splits)->data);
+    Transaction *txn = xaccSplitGetParent (first);
+    gnc_numeric bal = priv->starting_balance;
+    GList *splits, *node;
+
+    g_assert (first != last);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (priv->first_dirty == NULL);
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, xaccTransGetDate (xaccSplitGetParent (last))
+                                + 24 * 3600);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert (priv->sort_dirty);
+    g_assert (!priv->sort_all);
+    g_assert (g_hash_table_lookup (priv->sort_suspects, first) == first);
+
+    splits = xaccAccountGetSplitList (fixture->acct);
+    g_assert (!priv->sort_dirty);
+    g_assert_cmpuint (g_hash_table_size (priv->sort_suspects), == , 0);
+    g_assert (g_list_last (splits)->data == first);
+    g_assert_cmpint (g_sequence_get_length (priv->split_seq), == ,
+                     g_list_length (splits));
+    for (node = splits; node->next; node = node->next)
+        g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(node->data),
+                                         static_cast<Split*>(node->next->data)),
+                         <= , 0);
+
+    /* The moved split was first, so every running balance is redone. */
+    g_assert (priv->first_dirty == splits->data);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (priv->first_dirty == NULL);
+    for (node = splits; node; node = node->next)
+    {
+        Split *split = static_cast<Split*>(node->data);
+        bal = gnc_numeric_add_fixed (bal, xaccSplitGetAmount (split));
+        g_assert (gnc_numeric_eq (split->balance, bal));
+    }
 }
 
 /* xaccAccountOrder
@@ -2554,6 +2619,7 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountSortSplits", Fixture, &some_data, setup, test_xaccAccountSortSplits,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
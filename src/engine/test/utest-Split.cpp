@@ -402,10 +402,13 @@ test_xaccSplitEqualCheckBal (Fixture *fixture, gconstpointer pData)
 
     hdlr = g_log_set_handler ("gnc.engine", loglevel,
                               (GLogFunc)test_checked_handler, &check);
+    /* PINFO only logs at the levels qof_log is set to */
+    qof_log_set_level ("gnc.engine", QOF_LOG_INFO);
 
     g_assert_cmpint (fixture->func->xaccSplitEqualCheckBal ("test ", foo, foo), ==, TRUE);
     g_assert_cmpint (fixture->func->xaccSplitEqualCheckBal ("test ", foo, bar), ==, FALSE);
     g_assert_cmpint (check.hits, ==, 1);
+    qof_log_set_level ("gnc.engine", QOF_LOG_WARNING);
     g_log_remove_handler ("gnc.engine", hdlr);
 
 }
@@ -447,6 +450,8 @@ test_xaccSplitEqual (Fixture *fixture, gconstpointer pData)
 
     hdlr  = g_log_set_handler (logdomain, loglevel,
                                (GLogFunc)test_list_handler, &checkA);
+    /* PINFO only logs at the levels qof_log is set to */
+    qof_log_set_level (logdomain, QOF_LOG_INFO);
     /* Note that check_splits is just passed through to xaccTransEqual, so we don't vary it here. */
     /* Test that a NULL comparison fails */
     g_assert (xaccSplitEqual (fixture->split, NULL, TRUE, TRUE, TRUE) == FALSE);
@@ -529,6 +534,7 @@ test_xaccSplitEqual (Fixture *fixture, gconstpointer pData)
     g_object_unref (split1);
     g_object_unref (split2);
     test_clear_error_list ();
+    qof_log_set_level (logdomain, QOF_LOG_WARNING);
     g_log_remove_handler (logdomain, hdlr);
 
     g_free (msg03);
@@ -435,6 +435,8 @@ test_gnc_transaction_set_get_property (Fixture *fixture, gconstpointer pData)
                      (GLogFunc)test_checked_handler);
     fixture->hdlrs = test_log_set_handler (fixture->hdlrs, check2,
                                            (GLogFunc)test_checked_handler);
+    /* PINFO only logs at the levels qof_log is set to */
+    qof_log_set_level ("gnc.engine", QOF_LOG_INFO);
     g_assert_cmpstr (txn->num, ==, "");
     g_assert_cmpstr (txn->description, ==, "");
     g_assert (txn->common_currency == NULL);
@@ -479,6 +481,7 @@ test_gnc_transaction_set_get_property (Fixture *fixture, gconstpointer pData)
     g_assert (timespec_equal (t_posted, &now));
     g_assert_cmpint (check1->hits, ==, 2);
     g_assert_cmpint (check2->hits, ==, 2);
+    qof_log_set_level ("gnc.engine", QOF_LOG_WARNING);
     xaccTransRollbackEdit (txn);
     test_destroy (txn);
     test_destroy (curr);
@@ -817,6 +820,8 @@ test_xaccTransEqual (Fixture *fixture, gconstpointer pData)
 
     fixture->hdlrs = test_log_set_handler (fixture->hdlrs, check,
                                            (GLogFunc)test_list_handler);
+    /* PINFO only logs at the levels qof_log is set to */
+    qof_log_set_level (logdomain, QOF_LOG_INFO);
     /* Booleans are check_guids, check_splits, check_balances, assume_ordered */
     g_assert (xaccTransEqual (NULL, NULL, TRUE, TRUE, TRUE, TRUE));
     g_assert (!xaccTransEqual (txn0, NULL, TRUE, TRUE, TRUE, TRUE));
@@ -976,6 +981,7 @@ test_xaccTransEqual (Fixture *fixture, gconstpointer pData)
         split11->balance = split01->balance;
         g_assert (xaccTransEqual (txn1, txn0, TRUE, TRUE, TRUE, TRUE));
     }
+    qof_log_set_level (logdomain, QOF_LOG_WARNING);
     g_free (check3->msg);
     g_free (check2->msg);
 }
@@ -1359,6 +1365,8 @@ test_xaccTransBeginEdit ()
                                     (GLogFunc)test_list_handler, NULL);
     test_add_error (check1);
     test_add_error (check2);
+    /* PINFO only logs at the levels qof_log is set to */
+    qof_log_set_level (logdomain, QOF_LOG_INFO);
 
 
     g_assert_cmpint (0, ==, qof_instance_get_editlevel (QOF_INSTANCE (txn)));
@@ -1395,6 +1403,7 @@ test_xaccTransBeginEdit ()
     g_assert_cmpint (1, ==, check1->hits);
     g_assert_cmpint (2, ==, check2->hits);
 
+    qof_log_set_level (logdomain, QOF_LOG_WARNING);
     g_log_remove_handler (logdomain, hdlr);
     test_clear_error_list ();
     test_error_struct_free (check1);
@@ -985,11 +985,57 @@ test_gnc_pricedb_lookup_day (PriceDBFixture *fixture, gconstpointer pData)
     g_assert(price == NULL);
 }
 
-// Not Used
+/* gnc_pricedb_nth_price
+GNCPrice *
+gnc_pricedb_nth_price (GNCPriceDB *db,// Local: 0:0:0
+*/
+static void
+test_gnc_pricedb_nth_price (PriceDBFixture *fixture, gconstpointer pData)
+{
+    /* GBP has prices in USD and EUR on the same seven days. */
+    Timespec t = gnc_dmy2timespec(1, 8, 2013);
+    GNCPrice *price = gnc_pricedb_nth_price(fixture->pricedb,
+                                            fixture->com->gbp, 2);
+    Timespec price_time = gnc_price_get_time(price);
+    g_assert(timespec_equal(&price_time, &t));
+    price = gnc_pricedb_nth_price(fixture->pricedb, fixture->com->gbp, 13);
+    price_time = gnc_price_get_time(price);
+    t = gnc_dmy2timespec(11, 4, 2009);
+    g_assert(timespec_equal(&price_time, &t));
+    g_assert(gnc_pricedb_nth_price(fixture->pricedb,
+                                   fixture->com->gbp, 14) == NULL);
+    /* The merged prices follow an added price. */
+    gnc_pricedb_add_price(fixture->pricedb,
+                          construct_price(qof_instance_get_book(fixture->pricedb),
+                                          fixture->com->gbp, fixture->com->usd,
+                                          gnc_dmy2timespec(1, 1, 2015),
+                                          PRICE_SOURCE_FQ,
+                                          gnc_numeric_create(155000, 100000)));
+    price = gnc_pricedb_nth_price(fixture->pricedb, fixture->com->gbp, 0);
+    price_time = gnc_price_get_time(price);
+    t = gnc_dmy2timespec(1, 1, 2015);
+    g_assert(timespec_equal(&price_time, &t));
+    g_assert(gnc_pricedb_nth_price(fixture->pricedb,
+                                   fixture->com->gbp, 14) != NULL);
+}
 /* gnc_pricedb_lookup_at_time
 GNCPrice *
 gnc_pricedb_lookup_at_time(GNCPriceDB *db,// Local: 0:0:0
 */
+static void
+test_gnc_pricedb_lookup_at_time (PriceDBFixture *fixture, gconstpointer pData)
+{
+    Timespec t = gnc_dmy2timespec(20, 7, 2011);
+    GNCPrice *price = gnc_pricedb_lookup_at_time(fixture->pricedb,
+                                                 fixture->com->usd,
+                                                 fixture->com->aud, t);
+    g_assert_cmpstr(GET_COM_NAME(price), ==, "AUD");
+    gnc_price_unref(price);
+    t.tv_sec += 1;
+    price = gnc_pricedb_lookup_at_time(fixture->pricedb, fixture->com->usd,
+                                       fixture->com->aud, t);
+    g_assert(price == NULL);
+}
 /* lookup_nearest_in_time
 static GNCPrice *
 lookup_nearest_in_time(GNCPriceDB *db,// Local: 2:0:0
@@ -1017,11 +1063,28 @@ test_gnc_pricedb_lookup_nearest_in_time (PriceDBFixture *fixture, gconstpointer
     g_assert_cmpstr(GET_CUR_NAME(price), ==, "AUD");
     g_assert_cmpstr(GET_COM_NAME(price), ==, "USD");
 }
-// Not Used
 /* gnc_pricedb_lookup_latest_before
 GNCPrice *
 gnc_pricedb_lookup_latest_before (GNCPriceDB *db,// Local: 0:0:0
 */
+static void
+test_gnc_pricedb_lookup_latest_before (PriceDBFixture *fixture, gconstpointer pData)
+{
+    Timespec t = gnc_dmy2timespec(1, 12, 2012);
+    Timespec result_t = gnc_dmy2timespec(17, 11, 2012);
+    Timespec price_time;
+    GNCPrice *price =
+        gnc_pricedb_lookup_latest_before(fixture->pricedb, fixture->com->usd,
+                                         fixture->com->aud, t);
+    price_time = gnc_price_get_time(price);
+    g_assert_cmpstr(GET_COM_NAME(price), ==, "AUD");
+    g_assert(timespec_equal(&price_time, &result_t));
+    gnc_price_unref(price);
+    t = gnc_dmy2timespec(1, 1, 2009);
+    price = gnc_pricedb_lookup_latest_before(fixture->pricedb, fixture->com->usd,
+                                             fixture->com->aud, t);
+    g_assert(price == NULL);
+}
 /* direct_balance_conversion
 static gnc_numeric
 direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,// Local: 2:0:0
@@ -1088,6 +1151,12 @@ test_gnc_pricedb_convert_balance_latest_price (PriceDBFixture *fixture, gconstpo
                                                       fixture->com->aud);
     g_assert_cmpint(result.num, ==, 3575636);
     g_assert_cmpint(result.denom, ==, 100);
+    /* No price shares a commodity with both; go through USD and GBP. */
+    result = gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                      fixture->com->amzn,
+                                                      fixture->com->eur);
+    g_assert_cmpint(result.num, ==, 2506101);
+    g_assert_cmpint(result.denom, ==, 100);
 
 
 }
@@ -1099,6 +1168,8 @@ static void
 test_gnc_pricedb_convert_balance_nearest_price (PriceDBFixture *fixture, gconstpointer pData)
 {
     Timespec t = gnc_dmy2timespec(15, 8, 2011);
+    QofBook *book;
+    int i;
     gnc_numeric from = gnc_numeric_create(10000, 100);
     gnc_numeric result =
         gnc_pricedb_convert_balance_nearest_price(fixture->pricedb, from,
@@ -1126,7 +1197,43 @@ test_gnc_pricedb_convert_balance_nearest_price (PriceDBFixture *fixture, gconstp
                                                       fixture->com->aud, t);
     g_assert_cmpint(result.num, ==, 2089782);
     g_assert_cmpint(result.denom, ==, 100);
-
+    result = gnc_pricedb_convert_balance_nearest_price(fixture->pricedb, from,
+                                                      fixture->com->amzn,
+                                                      fixture->com->eur, t);
+    g_assert_cmpint(result.num, ==, 1559552);
+    g_assert_cmpint(result.denom, ==, 100);
+    /* A new price replaces the cached conversion. */
+    book = qof_instance_get_book(QOF_INSTANCE(fixture->pricedb));
+    gnc_pricedb_add_price(fixture->pricedb,
+                          construct_price(book, fixture->com->amzn,
+                                          fixture->com->eur, t,
+                                          PRICE_SOURCE_FQ,
+                                          gnc_numeric_create(200, 1)));
+    result = gnc_pricedb_convert_balance_nearest_price(fixture->pricedb, from,
+                                                      fixture->com->amzn,
+                                                      fixture->com->eur, t);
+    g_assert_cmpint(result.num, ==, 2000000);
+    g_assert_cmpint(result.denom, ==, 100);
+    /* Converting at many report dates keeps the cache bounded. */
+    for (i = 0; i < 2000; ++i)
+    {
+        Timespec day = {t.tv_sec + i * 86400, 0};
+        result = gnc_pricedb_convert_balance_nearest_price(fixture->pricedb,
+                                                          from,
+                                                          fixture->com->usd,
+                                                          fixture->com->aud,
+                                                          day);
+        g_assert(!gnc_numeric_zero_p(result));
+    }
+    g_assert_cmpuint(g_hash_table_size(fixture->pricedb->conversions), <=,
+                     1024);
+    g_assert_cmpuint(g_queue_get_length(&fixture->pricedb->conversions_lru),
+                     ==, g_hash_table_size(fixture->pricedb->conversions));
+    result = gnc_pricedb_convert_balance_nearest_price(fixture->pricedb, from,
+                                                      fixture->com->usd,
+                                                      fixture->com->aud, t);
+    g_assert_cmpint(result.num, ==, 9391);
+    g_assert_cmpint(result.denom, ==, 100);
 }
 /* pricedb_foreach_pricelist
 static void
@@ -1172,10 +1279,39 @@ test_stable_price_traversal (Fixture *fixture, gconstpointer pData)
 gboolean
 gnc_pricedb_foreach_price(GNCPriceDB *db,// C: 2 in 2  Local: 6:0:0
 */
-/* static void
-test_gnc_pricedb_foreach_price (Fixture *fixture, gconstpointer pData)
+typedef struct
 {
-}*/
+    GNCPriceDB *db;
+    int seen;
+} RemoveEveryOther;
+
+static gboolean
+remove_every_other (GNCPrice *p, gpointer user_data)
+{
+    RemoveEveryOther *data = user_data;
+    if (data->seen++ % 2 == 0)
+        gnc_pricedb_remove_price (data->db, p);
+    return TRUE;
+}
+
+static void
+test_gnc_pricedb_foreach_price (PriceDBFixture *fixture, gconstpointer pData)
+{
+    RemoveEveryOther data = {fixture->pricedb, 0};
+
+    /* Removing the price being visited must neither skip nor repeat the
+     * others. */
+    g_assert (gnc_pricedb_foreach_price (fixture->pricedb, remove_every_other,
+                                         &data, FALSE));
+    g_assert_cmpint (data.seen, ==, 32);
+    g_assert_cmpint (gnc_pricedb_get_num_prices (fixture->pricedb), ==, 16);
+
+    data.seen = 0;
+    g_assert (gnc_pricedb_foreach_price (fixture->pricedb, remove_every_other,
+                                         &data, TRUE));
+    g_assert_cmpint (data.seen, ==, 16);
+    g_assert_cmpint (gnc_pricedb_get_num_prices (fixture->pricedb), ==, 8);
+}
 /* add_price_to_list
 static gboolean
 add_price_to_list (GNCPrice *p, gpointer data)// Local: 0:1:0
@@ -1376,8 +1512,11 @@ test_suite_gnc_pricedb (void)
     GNC_TEST_ADD (suitename, "gnc pricedb has prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_has_prices, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_prices, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup day", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_day, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb nth price", PriceDBFixture, NULL, setup, test_gnc_pricedb_nth_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup at time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_at_time, teardown);
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup latest before", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_latest_before, teardown);
 // GNC_TEST_ADD (suitename, "direct balance conversion", Fixture, NULL, setup, test_direct_balance_conversion, teardown);
 // GNC_TEST_ADD (suitename, "extract common prices", Fixture, NULL, setup, test_extract_common_prices, teardown);
 // GNC_TEST_ADD (suitename, "convert balance", Fixture, NULL, setup, test_convert_balance, teardown);
@@ -1389,7 +1528,7 @@ test_suite_gnc_pricedb (void)
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);
 // GNC_TEST_ADD (suitename, "compare kvpairs by commodity key", Fixture, NULL, setup, test_compare_kvpairs_by_commodity_key, teardown);
 // GNC_TEST_ADD (suitename, "stable price traversal", Fixture, NULL, setup, test_stable_price_traversal, teardown);
-// GNC_TEST_ADD (suitename, "gnc pricedb foreach price", Fixture, NULL, setup, test_gnc_pricedb_foreach_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb foreach price", PriceDBFixture, NULL, setup, test_gnc_pricedb_foreach_price, teardown);
 // GNC_TEST_ADD (suitename, "add price to list", Fixture, NULL, setup, test_add_price_to_list, teardown);
 // GNC_TEST_ADD (suitename, "gnc price fixup legacy commods", Fixture, NULL, setup, test_gnc_price_fixup_legacy_commods, teardown);
 // GNC_TEST_ADD (suitename, "gnc price print", Fixture, NULL, setup, test_gnc_price_print, teardown);
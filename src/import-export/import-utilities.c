@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include "import-utilities.h"
 #include "qof.h"
+#include "qofinstance-p.h"
 #include "Account.h"
 #include "Transaction.h"
 
@@ -40,11 +41,22 @@
  * Account, Transaction and Split
 \********************************************************************/
 
+/* The getters are called for every split of every imported transaction,
+ * so they read the slot through an interned path instead of the property. */
+static const QofKvpPath *
+online_id_path (void)
+{
+    static const QofKvpPath *path = NULL;
+    if (!path)
+        path = qof_kvp_path_intern ("online_id");
+    return path;
+}
+
 const gchar * gnc_import_get_acc_online_id (Account * account)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (account), "online-id", &id, NULL);
-    return id;
+    g_return_val_if_fail (account != NULL, NULL);
+    return qof_instance_get_kvp_string (QOF_INSTANCE (account),
+                                        online_id_path ());
 }
 
 /* Used in the midst of editing a transaction; make it save the
@@ -59,9 +71,9 @@ void gnc_import_set_acc_online_id (Account *account, const gchar *id)
 
 const gchar * gnc_import_get_trans_online_id (Transaction * transaction)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (transaction), "online-id", &id, NULL);
-    return id;
+    g_return_val_if_fail (transaction != NULL, NULL);
+    return qof_instance_get_kvp_string (QOF_INSTANCE (transaction),
+                                        online_id_path ());
 }
 /* Not actually used */
 void gnc_import_set_trans_online_id (Transaction *transaction,
@@ -82,9 +94,9 @@ gboolean gnc_import_trans_has_online_id(Transaction * transaction)
 
 const gchar * gnc_import_get_split_online_id (Split * split)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (split), "online-id", &id, NULL);
-    return id;
+    g_return_val_if_fail (split != NULL, NULL);
+    return qof_instance_get_kvp_string (QOF_INSTANCE (split),
+                                        online_id_path ());
 }
 /* Used several places in a transaction edit where many other
  * parameters are also being set, so individual commits wouldn't be
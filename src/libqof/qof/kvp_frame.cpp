@@ -38,6 +38,8 @@ extern "C"
 #include <typeinfo>
 #include <sstream>
 #include <algorithm>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -45,26 +47,111 @@ static QofLogModule log_module = "qof.kvp";
 
 static const char delim = '/';
 
-KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
+KvpFrameImpl::slot_map::flat_type::const_iterator
+KvpFrameImpl::slot_map::flat_find(const char* key) const noexcept
 {
-    std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
-        [this](const map_type::value_type & a)
+    /* Keys taken from another frame, as when copying and comparing frames,
+     * are the same string cache entries, so try their pointers first. */
+    for (auto spot = m_flat.begin(); spot != m_flat.end(); ++spot)
+        if (spot->first == key)
+            return spot;
+    auto spot = std::lower_bound(m_flat.begin(), m_flat.end(), key,
+        [](const value_type& a, const char* b)
         {
-            auto key = static_cast<char *>(qof_string_cache_insert(a.first));
-            auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            return std::strcmp(a.first, b) < 0;
+        }
+    );
+    if (spot != m_flat.end() && std::strcmp(spot->first, key) == 0)
+        return spot;
+    return m_flat.end();
+}
+
+KvpValue*
+KvpFrameImpl::slot_map::find(const char* key) const noexcept
+{
+    if (m_tree)
+    {
+        auto spot = m_tree->find(key);
+        return spot == m_tree->end() ? nullptr : spot->second;
+    }
+    auto spot = flat_find(key);
+    return spot == m_flat.end() ? nullptr : spot->second;
+}
+
+void
+KvpFrameImpl::slot_map::insert(const char* key, KvpValue* value) noexcept
+{
+    if (m_tree)
+    {
+        m_tree->insert({key, value});
+        return;
+    }
+    auto spot = std::lower_bound(m_flat.begin(), m_flat.end(), key,
+        [](const value_type& a, const char* b)
+        {
+            return std::strcmp(a.first, b) < 0;
+        }
+    );
+    m_flat.insert(spot, {key, value});
+    if (m_flat.size() > max_flat)
+    {
+        m_tree.reset(new map_type(m_flat.begin(), m_flat.end()));
+        flat_type().swap(m_flat);
+    }
+}
+
+KvpFrameImpl::slot_map::value_type
+KvpFrameImpl::slot_map::erase(const char* key) noexcept
+{
+    value_type ret {nullptr, nullptr};
+    if (m_tree)
+    {
+        auto spot = m_tree->find(key);
+        if (spot == m_tree->end())
+            return ret;
+        ret = *spot;
+        m_tree->erase(spot);
+        if (m_tree->size() <= max_flat / 2)
+        {
+            m_flat.assign(m_tree->begin(), m_tree->end());
+            m_tree.reset();
+        }
+        return ret;
+    }
+    auto spot = flat_find(key);
+    if (spot == m_flat.end())
+        return ret;
+    ret = *spot;
+    m_flat.erase(m_flat.begin() + (spot - m_flat.cbegin()));
+    return ret;
+}
+
+KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept :
+    m_changed_keys(rhs.m_changed_keys),
+    m_changed_count(rhs.m_changed_count)
+{
+    for (uint8_t i = 0; i < m_changed_count && i < max_changed; ++i)
+        qof_string_cache_insert(m_changed_keys[i]);
+    rhs.m_valuemap.for_each(
+        [this](const char* key, KvpValue* value)
+        {
+            auto cachedkey =
+                static_cast<const char *>(qof_string_cache_insert(key));
+            this->m_valuemap.insert(cachedkey, new KvpValueImpl(*value));
         }
     );
 }
 
 KvpFrameImpl::~KvpFrameImpl() noexcept
 {
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-		 [](const map_type::value_type &a){
-		      qof_string_cache_remove(a.first);
-		      delete a.second;
-		  }
-	);
+    release_changed();
+    m_valuemap.for_each(
+        [](const char* key, KvpValue* value)
+        {
+            qof_string_cache_remove(key);
+            delete value;
+        }
+    );
     m_valuemap.clear();
 }
 
@@ -90,23 +177,20 @@ KvpFrameImpl::set(const char* key, KvpValue* value) noexcept
     if (!key) return nullptr;
     if (strchr(key, delim))
         return set(make_vector(key), value);
-    KvpValue* ret {nullptr};
-    auto spot = m_valuemap.find(key);
-    if (spot != m_valuemap.end())
-    {
-        qof_string_cache_remove(spot->first);
-        ret = spot->second;
-        m_valuemap.erase(spot);
-    }
+    mark_changed(key);
+    auto old = m_valuemap.erase(key);
 
     if (value)
     {
         auto cachedkey =
             static_cast<const char *>(qof_string_cache_insert(key));
-        m_valuemap.insert({cachedkey,value});
+        m_valuemap.insert(cachedkey, value);
     }
+    /* Only now, as key may be the cached string itself. */
+    if (old.first)
+        qof_string_cache_remove(old.first);
 
-    return ret;
+    return old.second;
 }
 
 static inline KvpFrameImpl*
@@ -185,15 +269,15 @@ KvpFrameImpl::to_string() const noexcept
     std::ostringstream ret;
     ret << "{\n";
 
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-        [this,&ret](const map_type::value_type &a)
+    m_valuemap.for_each(
+        [&ret](const char* key, KvpValue* value)
         {
             ret << "    ";
-            if (a.first)
-                ret << a.first;
+            if (key)
+                ret << key;
             ret << " => ";
-            if (a.second)
-                ret << a.second->to_string();
+            if (value)
+                ret << value->to_string();
             ret << ",\n";
         }
     );
@@ -206,10 +290,11 @@ std::vector<std::string>
 KvpFrameImpl::get_keys() const noexcept
 {
     std::vector<std::string> ret;
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-        [&ret](const KvpFrameImpl::map_type::value_type &a)
+    ret.reserve(m_valuemap.size());
+    m_valuemap.for_each(
+        [&ret](const char* key, KvpValue*)
         {
-            ret.push_back(a.first);
+            ret.push_back(key);
         }
     );
     return ret;
@@ -221,10 +306,113 @@ KvpFrameImpl::for_each_slot(void (*proc)(const char *key, KvpValue *value,
                             void *data) const noexcept
 {
     if (!proc) return;
-    std::for_each (m_valuemap.begin(), m_valuemap.end(),
-        [proc,data](const KvpFrameImpl::map_type::value_type & a)
+    m_valuemap.for_each(
+        [proc,data](const char* key, KvpValue* value)
+        {
+            proc (key, value, data);
+        }
+    );
+}
+
+void
+KvpFrameImpl::mark_changed(const char* path) noexcept
+{
+    if (!path) return;
+    while (*path == delim)
+        ++path;
+    auto len = strcspn(path, "/");
+    if (len == 0 || all_changed()) return;
+    for (uint8_t i = 0; i < m_changed_count; ++i)
+        if (strncmp(m_changed_keys[i], path, len) == 0 &&
+            m_changed_keys[i][len] == '\0')
+            return;
+    if (m_changed_count == max_changed)
+    {
+        ++m_changed_count;
+        return;
+    }
+    auto key = path[len] == '\0' ? qof_string_cache_insert(path) :
+        qof_string_cache_insert(std::string(path, len).c_str());
+    m_changed_keys[m_changed_count++] = static_cast<const char*>(key);
+}
+
+void
+KvpFrameImpl::release_changed() noexcept
+{
+    for (uint8_t i = 0; i < m_changed_count && i < max_changed; ++i)
+        qof_string_cache_remove(m_changed_keys[i]);
+    m_changed_count = 0;
+}
+
+static inline bool
+value_is_changed(const KvpValue* value) noexcept
+{
+    if (value->get_type() == KvpValue::Type::FRAME)
+        return value->get<KvpFrame*>()->is_changed();
+    if (value->get_type() == KvpValue::Type::GLIST)
+        for (auto node = value->get<GList*>(); node; node = node->next)
+            if (value_is_changed(static_cast<KvpValue*>(node->data)))
+                return true;
+    return false;
+}
+
+static inline void
+value_clear_changed(KvpValue* value) noexcept
+{
+    if (value->get_type() == KvpValue::Type::FRAME)
+        value->get<KvpFrame*>()->clear_changed();
+    else if (value->get_type() == KvpValue::Type::GLIST)
+        for (auto node = value->get<GList*>(); node; node = node->next)
+            value_clear_changed(static_cast<KvpValue*>(node->data));
+}
+
+bool
+KvpFrameImpl::is_changed() const noexcept
+{
+    if (m_changed_count)
+        return true;
+    return m_valuemap.any_of(
+        [](const char*, KvpValue* value)
+        {
+            return value_is_changed(value);
+        }
+    );
+}
+
+std::vector<std::string>
+KvpFrameImpl::get_changed_keys() const noexcept
+{
+    std::vector<std::string> ret;
+    if (all_changed())
+    {
+        m_valuemap.for_each(
+            [&ret](const char* key, KvpValue*)
+            {
+                ret.push_back(key);
+            }
+        );
+        return ret;
+    }
+    ret.assign(m_changed_keys.begin(), m_changed_keys.begin() + m_changed_count);
+    m_valuemap.for_each(
+        [&ret](const char* key, KvpValue* value)
         {
-            proc (a.first, a.second, data);
+            if (std::find(ret.begin(), ret.end(), key) == ret.end() &&
+                value_is_changed(value))
+                ret.push_back(key);
+        }
+    );
+    return ret;
+}
+
+void
+KvpFrameImpl::clear_changed() noexcept
+{
+    release_changed();
+    m_valuemap.for_each(
+        [](const char*, KvpValue* value)
+        {
+            value_clear_changed(value);
         }
     );
 }
@@ -235,10 +423,7 @@ KvpFrameImpl::get_slot(const char * key) const noexcept
     if (!key) return nullptr;
     if (strchr(key, delim))
         return get_slot(make_vector(key));
-    auto spot = m_valuemap.find(key);
-    if (spot == m_valuemap.end())
-        return nullptr;
-    return spot->second;
+    return m_valuemap.find(key);
 }
 
 KvpValueImpl *
@@ -255,6 +440,47 @@ KvpFrameImpl::get_slot(Path path) const noexcept
 
 }
 
+KvpValueImpl *
+KvpFrameImpl::get_slot(const KvpPathImpl& path) const noexcept
+{
+    auto cur_frame = this;
+    KvpValue* value {nullptr};
+    for (const auto& key : path.m_keys)
+    {
+        if (value != nullptr)
+        {
+            if (value->get_type() != KvpValue::Type::FRAME)
+                return nullptr;
+            cur_frame = value->get<KvpFrame*>();
+        }
+        value = cur_frame->m_valuemap.find(key.c_str());
+        if (value == nullptr)
+            return nullptr;
+    }
+    return value;
+}
+
+G_LOCK_DEFINE_STATIC(interned_paths);
+
+const KvpPathImpl*
+KvpPathImpl::intern(const char* path) noexcept
+{
+    static std::unordered_map<std::string,
+                              std::unique_ptr<KvpPathImpl>> paths;
+    std::string key {path ? path : ""};
+
+    G_LOCK(interned_paths);
+    auto& interned = paths[key];
+    if (!interned)
+    {
+        interned.reset(new KvpPathImpl);
+        interned->m_keys = make_vector(key);
+    }
+    auto ret = interned.get();
+    G_UNLOCK(interned_paths);
+    return ret;
+}
+
 int compare(const KvpFrameImpl * one, const KvpFrameImpl * two) noexcept
 {
     if (one && !two) return 1;
@@ -272,18 +498,20 @@ int compare(const KvpFrameImpl * one, const KvpFrameImpl * two) noexcept
  */
 int compare(const KvpFrameImpl & one, const KvpFrameImpl & two) noexcept
 {
-    for (const auto & a : one.m_valuemap)
-    {
-        auto otherspot = two.m_valuemap.find(a.first);
-        if (otherspot == two.m_valuemap.end())
+    int comparison = 0;
+    one.m_valuemap.any_of(
+        [&two, &comparison](const char* key, KvpValue* value)
         {
-            return 1;
+            auto othervalue = two.m_valuemap.find(key);
+            if (othervalue == nullptr)
+                comparison = 1;
+            else
+                comparison = compare(value, othervalue);
+            return comparison != 0;
         }
-        auto comparison = compare(a.second,otherspot->second);
-
-        if (comparison != 0)
-            return comparison;
-    }
+    );
+    if (comparison != 0)
+        return comparison;
 
     if (one.m_valuemap.size() < two.m_valuemap.size())
         return -1;
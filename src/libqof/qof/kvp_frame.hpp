@@ -89,12 +89,33 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
+#include <array>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <cstring>
 using Path = std::vector<std::string>;
 
+/** A '/'-delimited path split into its keys once, for slots which are
+ * looked up often enough that splitting and copying the path every time
+ * shows in profiles.  intern() returns the same KvpPathImpl for equal path
+ * strings, and it lasts as long as the program, so callers keep it in a
+ * static.
+ */
+struct KvpPathImpl
+{
+    /**
+     * Get the interned path for a '/'-delimited path string, creating it the
+     * first time. Safe to call from any thread.
+     * @param path: The path string.
+     * @return The interned path.
+     */
+    static const KvpPathImpl* intern(const char* path) noexcept;
+    Path m_keys;
+};
+
 /** Implements KvpFrame.
  *  It's a struct because QofInstance needs to use the typename to declare a
  *  KvpFrame* member, and QofInstance's API is C until its children are all
@@ -121,6 +142,72 @@ struct KvpFrameImpl
     };
     using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
 
+    /** Holds the slots of a frame, whose keys come from the string cache.
+     * Nearly all frames have only a few slots, so they are kept in a sorted
+     * array, which is a single allocation and is searched by key pointer
+     * before comparing strings.  A frame which grows past max_flat slots
+     * moves them to a map_type, and moves them back once it has shrunk to
+     * half that.
+     */
+    class slot_map
+    {
+    public:
+        using value_type = std::pair<const char*, KvpValue*>;
+        static constexpr size_t max_flat = 8;
+
+        /** Get the value for the key or nullptr if it doesn't exist. */
+        KvpValue* find(const char* key) const noexcept;
+        /** Add a slot. The key must come from the string cache and must not
+         * already be in the map. */
+        void insert(const char* key, KvpValue* value) noexcept;
+        /** Remove the slot for the key, returning its key and value, or a
+         * pair of nullptrs if there isn't one. */
+        value_type erase(const char* key) noexcept;
+        size_t size() const noexcept
+        {
+            return m_tree ? m_tree->size() : m_flat.size();
+        }
+        bool empty() const noexcept { return size() == 0; }
+        void clear() noexcept
+        {
+            m_flat.clear();
+            m_tree.reset();
+        }
+        /** Call func(key, value) for each slot in key order. */
+        template <typename Func> void for_each(Func func) const
+        {
+            if (m_tree)
+                for (const auto& a : *m_tree)
+                    func(a.first, a.second);
+            else
+                for (const auto& a : m_flat)
+                    func(a.first, a.second);
+        }
+        /** Test whether pred(key, value) is true for any slot. */
+        template <typename Pred> bool any_of(Pred pred) const
+        {
+            if (m_tree)
+            {
+                for (const auto& a : *m_tree)
+                    if (pred(a.first, a.second))
+                        return true;
+            }
+            else
+            {
+                for (const auto& a : m_flat)
+                    if (pred(a.first, a.second))
+                        return true;
+            }
+            return false;
+        }
+
+    private:
+        using flat_type = std::vector<value_type>;
+        flat_type::const_iterator flat_find(const char* key) const noexcept;
+        flat_type m_flat;
+        std::unique_ptr<map_type> m_tree;
+    };
+
     public:
     KvpFrameImpl() noexcept {};
 
@@ -204,6 +291,12 @@ struct KvpFrameImpl
      * @return The value at the key or nullptr.
      */
     KvpValue* get_slot(Path keys) const noexcept;
+    /** Get the value for the tail of an interned path or nullptr if it
+     * doesn't exist. Doesn't allocate.
+     * @param path: Interned path of keys leading to the desired value.
+     * @return The value at the key or nullptr.
+     */
+    KvpValue* get_slot(const KvpPathImpl& path) const noexcept;
     /** Convenience wrapper for std::for_each, which should be preferred.
      */
     void for_each_slot(void (*proc)(const char *key, KvpValue *value,
@@ -214,10 +307,49 @@ struct KvpFrameImpl
      * @return true if the frame contains nothing.
      */
     bool empty() const noexcept { return m_valuemap.empty(); }
+
+    /**
+     * Record that the value at the first key of path changed, for changes
+     * made to a value in place rather than with set().
+     * @param path: The '/'-delimited path of the changed value.
+     */
+    void mark_changed(const char* path) noexcept;
+    /** Test whether any value in the frame or its subframes was set or
+     * marked changed since the last clear_changed(). Copies of a frame
+     * start with the changes of the original.
+     * @return true if something changed.
+     */
+    bool is_changed() const noexcept;
+    /** Test whether more keys of the immediate frame changed since the last
+     * clear_changed() than the frame keeps track of. The keys of removed
+     * values are then unknown, so a caller storing the changes must replace
+     * all of the frame's slots.
+     * @return true if every key counts as changed.
+     */
+    bool all_changed() const noexcept { return m_changed_count > max_changed; }
+    /** Report the keys in the immediate frame whose values were set,
+     * removed or marked changed, or whose subframes changed, since the last
+     * clear_changed(). The keys of removed values are included although
+     * the frame no longer has them. If all_changed(), all of the frame's
+     * keys are reported.
+     * @return std::vector of keys as std::strings.
+     */
+    std::vector<std::string> get_changed_keys() const noexcept;
+    /** Forget the changes to the frame and its subframes, for instance once
+     * a backend has stored them.
+     */
+    void clear_changed() noexcept;
     friend int compare(const KvpFrameImpl&, const KvpFrameImpl&) noexcept;
 
     private:
-    map_type m_valuemap;
+    /* Edits between saves touch only a key or two of a frame, so the
+     * changed keys are kept in place, as references to the string cache,
+     * rather than allocated as they are written. */
+    static constexpr uint8_t max_changed = 4;
+    void release_changed() noexcept;
+    slot_map m_valuemap;
+    std::array<const char*, max_changed> m_changed_keys {};
+    uint8_t m_changed_count = 0;
 };
 
 int compare (const KvpFrameImpl &, const KvpFrameImpl &) noexcept;
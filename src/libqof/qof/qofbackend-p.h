@@ -140,6 +140,13 @@
  *    continue functioning even when disconnected from the server:
  *    this is because it will have its local cache of data from which to work.
  *
+ * The load_related() routine is for backends which load some of the
+ *    book only as queries need it.  It loads whatever of the book an
+ *    instance refers to, or is referred to by, that isn't in the engine
+ *    yet: for an account, the transactions with splits in it; for the
+ *    book, everything.  Backends which load the whole book at once
+ *    leave it NULL.
+ *
  * The sync() routine synchronizes the engine contents to the backend.
  *    This should done by using version numbers (hack alert -- the engine
  *    does not currently contain version numbers).
@@ -262,6 +269,7 @@ struct QofBackend_s
     gpointer (*compile_query) (QofBackend *, QofQuery *);
     void (*free_query) (QofBackend *, gpointer);
     void (*run_query) (QofBackend *, gpointer);
+    void (*load_related) (QofBackend *, QofInstance *);
 
     void (*sync) (QofBackend *, /*@ dependent @*/ QofBook *);
     void (*safe_sync) (QofBackend *, /*@ dependent @*/ QofBook *);
@@ -91,6 +91,14 @@ qof_backend_rollback_instance (QofBackend* be, QofInstance* inst)
     (be->rollback)(be, inst);
 }
 
+void
+qof_backend_load_related (QofBackend* be, QofInstance* inst)
+{
+    if (be == nullptr || be->load_related == nullptr || inst == nullptr)
+        return;
+    (be->load_related)(be, inst);
+}
+
 void
 qof_backend_set_message (QofBackend *be, const char *format, ...)
 {
@@ -154,6 +162,7 @@ qof_backend_init(QofBackend *be)
     be->compile_query = NULL;
     be->free_query = NULL;
     be->run_query = NULL;
+    be->load_related = NULL;
 
     be->sync = NULL;
     be->safe_sync = NULL;
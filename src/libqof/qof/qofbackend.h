@@ -104,6 +104,8 @@ typedef enum
                                     for internal use by GnuCash */
     ERR_FILEIO_FILE_UPGRADE,   /**< file will be upgraded and not be able to be
                                     read by prior versions - warn users*/
+    ERR_FILEIO_RELOAD,         /**< the backend gave up on a partly loaded
+                                    book; load again into a new book */
 
     /* network errors */
     ERR_NETIO_SHORT_READ = 2000,  /**< not enough bytes received */
@@ -147,6 +149,12 @@ typedef enum
     gboolean qof_backend_can_rollback (QofBackend*);
     void qof_backend_rollback_instance (QofBackend*, QofInstance*);
 
+/** Have a backend which loads the book as needed load what inst refers
+ * to or is referred to by: for an account, all of its splits; for the
+ * book, all of it.  Engine code which walks such lists itself, rather
+ * than through a query, calls this first. */
+    void qof_backend_load_related (QofBackend*, QofInstance*);
+
 /** \brief Load a QOF-compatible backend shared library.
 
     \param directory Can be NULL if filename is a complete path.
@@ -93,6 +93,19 @@ enum
     N_PROPERTIES		/* Just a counter */
 };
 
+/* Book data that isn't part of the public QofBook structure. */
+typedef struct QofBookPrivate
+{
+    /* The split-action-num-field option, cached because the split sort
+     * consults it on every comparison.  Only valid while
+     * num_field_source_isvalid is TRUE; see qof_book_options_changed(). */
+    gboolean num_field_source;
+    gboolean num_field_source_isvalid;
+} QofBookPrivate;
+
+#define GET_PRIVATE(o)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((o), QOF_TYPE_BOOK, QofBookPrivate))
+
 QOF_GOBJECT_GET_TYPE(QofBook, qof_book, QOF_TYPE_INSTANCE, {});
 QOF_GOBJECT_DISPOSE(qof_book);
 QOF_GOBJECT_FINALIZE(qof_book);
@@ -127,6 +140,7 @@ qof_book_init (QofBook *book)
     book->read_only = FALSE;
     book->session_dirty = FALSE;
     book->version = 0;
+    GET_PRIVATE(book)->num_field_source_isvalid = FALSE;
 }
 
 static void
@@ -261,6 +275,7 @@ qof_book_set_property (GObject      *object,
 			       OPTION_NAME_NUM_FIELD_SOURCE);
 	qof_instance_set_kvp (QOF_INSTANCE (book), key, value);
 	g_free (key);
+	qof_book_options_changed (book);
 	break;
     case PROP_OPT_DEFAULT_BUDGET:
 	key = g_strdup_printf ("%s/%s/%s", KVP_OPTION_PATH,
@@ -287,6 +302,7 @@ static void
 qof_book_class_init (QofBookClass *klass)
 {
     GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    g_type_class_add_private (klass, sizeof (QofBookPrivate));
     gobject_class->dispose = qof_book_dispose;
     gobject_class->finalize = qof_book_finalize;
     gobject_class->get_property = qof_book_get_property;
@@ -1042,14 +1058,27 @@ qof_book_use_trading_accounts (const QofBook *book)
 gboolean
 qof_book_use_split_action_for_num_field (const QofBook *book)
 {
-    const char *opt = NULL;
-    qof_instance_get (QOF_INSTANCE (book),
-		      "split-action-num-field", &opt,
-		      NULL);
+    g_return_val_if_fail (book, FALSE);
+    /* The cache isn't part of the book's logical state. */
+    auto priv = GET_PRIVATE(const_cast<QofBook*>(book));
+    if (!priv->num_field_source_isvalid)
+    {
+        const char *opt = NULL;
+        qof_instance_get (QOF_INSTANCE (book),
+                          "split-action-num-field", &opt,
+                          NULL);
 
-    if (opt && opt[0] == 't' && opt[1] == 0)
-        return TRUE;
-    return FALSE;
+        priv->num_field_source = (opt && opt[0] == 't' && opt[1] == 0);
+        priv->num_field_source_isvalid = TRUE;
+    }
+    return priv->num_field_source;
+}
+
+void
+qof_book_options_changed (QofBook *book)
+{
+    g_return_if_fail (book);
+    GET_PRIVATE(book)->num_field_source_isvalid = FALSE;
 }
 
 gboolean qof_book_uses_autoreadonly (const QofBook *book)
@@ -1176,6 +1205,7 @@ void
 qof_book_commit_edit(QofBook *book)
 {
     if (!qof_commit_edit (QOF_INSTANCE(book))) return;
+    qof_book_options_changed (book);
     qof_commit_edit_part2 (&book->inst, commit_err, noop, noop/*lot_free*/);
 }
 
@@ -1189,6 +1219,7 @@ qof_book_set_option (QofBook *book, KvpValue *value, GSList *path)
     qof_book_begin_edit (book);
     delete root->set_path(path_v, value);
     qof_instance_set_dirty (QOF_INSTANCE (book));
+    qof_book_options_changed (book);
     qof_book_commit_edit (book);
 }
 
@@ -1207,6 +1238,7 @@ qof_book_options_delete (QofBook *book)
 {
     KvpFrame *root = qof_instance_get_slots(QOF_INSTANCE (book));
     delete root->set_path(KVP_OPTION_PATH, nullptr);
+    qof_book_options_changed (book);
 }
 
 /* QofObject function implementation and registration */
@@ -293,6 +293,12 @@ GDate* qof_book_get_autoreadonly_gdate (const QofBook *book);
  *  if it uses transaction number field */
 gboolean qof_book_use_split_action_for_num_field (const QofBook *book);
 
+/** Discard the book's cached option values.  The option setters and
+ *  qof_book_commit_edit() do this themselves; code that fills in the
+ *  book's option frame directly, such as a backend loading the book
+ *  slots, must call it afterwards. */
+void qof_book_options_changed (QofBook *book);
+
 /** Is the book shutting down? */
 gboolean qof_book_shutting_down (const QofBook *book);
 
@@ -37,7 +37,27 @@ static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
+static guint   suspended_events  = 0;
 static GList   *handlers  =   NULL;
+static guint   batch_handlers    = 0;
+static guint   batch_level       = 0;
+
+/* The events collected for the batch handlers between the outermost
+ * qof_event_begin_batch and qof_event_end_batch.  The batch holds a weak
+ * reference to each entity, so that one freed without a QOF_EVENT_DESTROY
+ * reaching the batch, e.g. while events are suspended, drops out of it
+ * instead of being delivered, without its disposal and its removal from
+ * its collection waiting for the end of the batch. */
+typedef struct
+{
+    GArray *items;      /* QofEventBatchItems */
+    GHashTable *index;  /* entity -> its position in items plus one */
+} EventBatch;
+
+static EventBatch *pending_batch = NULL;
+/* Batches being delivered; more than one if a batch handler ends a
+ * nested batch of its own. */
+static GSList *delivering_batches = NULL;
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -73,10 +93,33 @@ find_next_handler_id(void)
     return handler_id;
 }
 
+static gint
+register_handler (QofEventHandler handler, QofEventBatchHandler batch_handler,
+                  gpointer user_data)
+{
+    HandlerInfo *hi;
+    gint handler_id;
+
+    /* look for a free handler id */
+    handler_id = find_next_handler_id();
+
+    /* Found one, add the handler */
+    hi = g_new0 (HandlerInfo, 1);
+
+    hi->handler = handler;
+    hi->batch_handler = batch_handler;
+    hi->user_data = user_data;
+    hi->handler_id = handler_id;
+
+    handlers = g_list_prepend (handlers, hi);
+    if (batch_handler)
+        batch_handlers++;
+    return handler_id;
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 {
-    HandlerInfo *hi;
     gint handler_id;
 
     ENTER ("(handler=%p, data=%p)", handler, user_data);
@@ -88,17 +131,27 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
         return 0;
     }
 
-    /* look for a free handler id */
-    handler_id = find_next_handler_id();
+    handler_id = register_handler (handler, NULL, user_data);
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
 
-    /* Found one, add the handler */
-    hi = g_new0 (HandlerInfo, 1);
+gint
+qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                  gpointer user_data)
+{
+    gint handler_id;
 
-    hi->handler = handler;
-    hi->user_data = user_data;
-    hi->handler_id = handler_id;
+    ENTER ("(handler=%p, data=%p)", handler, user_data);
 
-    handlers = g_list_prepend (handlers, hi);
+    /* sanity check */
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
+
+    handler_id = register_handler (NULL, handler, user_data);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
@@ -121,12 +174,14 @@ qof_event_unregister_handler (gint handler_id)
            of a generated event, such as QOF_EVENT_DESTROY.  In that case,
            we're in the middle of walking the GList and it is wrong to
            modify the list. So, instead, we just NULL the handler. */
-        if (hi->handler)
-            LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
-                   hi->handler, hi->user_data);
+        if (hi->handler || hi->batch_handler)
+            LEAVE ("(handler_id=%d) data=%p", handler_id, hi->user_data);
 
         /* safety -- clear the handler in case we're running events now */
+        if (hi->batch_handler)
+            batch_handlers--;
         hi->handler = NULL;
+        hi->batch_handler = NULL;
 
         if (handler_run_level == 0)
         {
@@ -168,6 +223,137 @@ qof_event_resume (void)
     suspend_counter--;
 }
 
+static EventBatch *
+event_batch_new (void)
+{
+    EventBatch *batch = g_new (EventBatch, 1);
+
+    batch->items = g_array_new (FALSE, FALSE, sizeof (QofEventBatchItem));
+    batch->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+    return batch;
+}
+
+static void
+event_batch_free (EventBatch *batch)
+{
+    g_array_free (batch->items, TRUE);
+    g_hash_table_destroy (batch->index);
+    g_free (batch);
+}
+
+static void
+event_batch_add (EventBatch *batch, QofInstance *entity, QofEventId event_id)
+{
+    QofEventBatchItem item;
+    guint pos;
+
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (batch->index, entity));
+    if (pos)
+    {
+        g_array_index (batch->items, QofEventBatchItem, pos - 1).event_mask |=
+            event_id;
+        return;
+    }
+
+    g_object_weak_ref (G_OBJECT (entity), event_batch_entity_freed, batch);
+    item.entity = entity;
+    item.event_mask = event_id;
+    g_array_append_val (batch->items, item);
+    g_hash_table_insert (batch->index, entity,
+                         GUINT_TO_POINTER (batch->items->len));
+}
+
+/* Take the entity out of the batch, leaving a NULL entity in its place,
+ * and return the events it had collected. */
+static QofEventId
+event_batch_take (EventBatch *batch, gconstpointer entity)
+{
+    QofEventBatchItem *item;
+    QofEventId event_mask;
+    guint pos;
+
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (batch->index, entity));
+    if (!pos)
+        return QOF_EVENT_NONE;
+
+    g_hash_table_remove (batch->index, entity);
+    item = &g_array_index (batch->items, QofEventBatchItem, pos - 1);
+    event_mask = item->event_mask;
+    item->entity = NULL;
+    item->event_mask = QOF_EVENT_NONE;
+    return event_mask;
+}
+
+/* Weak reference notification: the entity is being freed, and its weak
+ * reference is already gone. */
+static void
+event_batch_entity_freed (gpointer data, GObject *entity)
+{
+    event_batch_take (static_cast<EventBatch*>(data), entity);
+}
+
+/* Like event_batch_take, but for an entity which lives on. */
+static QofEventId
+event_batch_remove (EventBatch *batch, QofInstance *entity)
+{
+    QofEventId event_mask;
+
+    if (!batch)
+        return QOF_EVENT_NONE;
+    event_mask = event_batch_take (batch, entity);
+    if (event_mask != QOF_EVENT_NONE)
+        g_object_weak_unref (G_OBJECT (entity), event_batch_entity_freed,
+                             batch);
+    return event_mask;
+}
+
+static void
+run_batch_handlers (const QofEventBatchItem *items, guint n_items)
+{
+    GList *node;
+    GList *next_node = NULL;
+
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+
+        next_node = node->next;
+        if (hi->batch_handler)
+        {
+            PINFO("id=%d hi=%p han=%p items=%u", hi->handler_id, hi,
+                  hi->batch_handler, n_items);
+            hi->batch_handler (items, n_items, hi->user_data);
+        }
+    }
+}
+
+/* If we're the outermost event runner and we have pending deletes
+ * then go delete the handlers now.
+ */
+static void
+remove_pending_deletes (void)
+{
+    GList *node;
+    GList *next_node = NULL;
+
+    if (handler_run_level != 0 || !pending_deletes)
+        return;
+
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        next_node = node->next;
+        if (hi->handler == NULL && hi->batch_handler == NULL)
+        {
+            /* remove this node from the list, then free this node */
+            handlers = g_list_remove_link (handlers, node);
+            g_list_free_1 (node);
+            g_free (hi);
+        }
+    }
+    pending_deletes = 0;
+}
+
 static void
 qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                              gpointer event_data)
@@ -199,27 +385,42 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
             hi->handler (entity, event_id, hi->user_data, event_data);
         }
     }
-    handler_run_level--;
 
-    /* If we're the outermost event runner and we have pending deletes
-     * then go delete the handlers now.
-     */
-    if (handler_run_level == 0 && pending_deletes)
+    if (batch_handlers)
     {
-        for (node = handlers; node; node = next_node)
+        if (event_id & QOF_EVENT_DESTROY)
         {
-            HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
+            /* The entity is about to go away, so it can't wait for the
+             * end of the batch, nor be left in one being delivered. */
+            QofEventBatchItem item;
+            GSList *bnode;
+
+            item.entity = entity;
+            item.event_mask = event_id | event_batch_remove (pending_batch,
+                                                             entity);
+            for (bnode = delivering_batches; bnode; bnode = bnode->next)
+                event_batch_remove (static_cast<EventBatch*>(bnode->data),
+                                    entity);
+            run_batch_handlers (&item, 1);
+        }
+        else if (batch_level)
+        {
+            if (!pending_batch)
+                pending_batch = event_batch_new ();
+            event_batch_add (pending_batch, entity, event_id);
+        }
+        else
+        {
+            QofEventBatchItem item;
+
+            item.entity = entity;
+            item.event_mask = event_id;
+            run_batch_handlers (&item, 1);
         }
-        pending_deletes = 0;
     }
+    handler_run_level--;
+
+    remove_pending_deletes ();
 }
 
 void
@@ -238,9 +439,84 @@ qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
         return;
 
     if (suspend_counter)
+    {
+        suspended_events++;
         return;
+    }
 
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level overflow");
+    }
+}
+
+void
+qof_event_end_batch (void)
+{
+    EventBatch *batch;
+    guint i, n_items;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+
+    batch_level--;
+    if (batch_level || !pending_batch)
+        return;
+
+    /* Events generated by the batch handlers go to a batch of their own. */
+    batch = pending_batch;
+    pending_batch = NULL;
+
+    /* Squeeze out the entities destroyed during the batch. */
+    g_hash_table_remove_all (batch->index);
+    for (i = 0, n_items = 0; i < batch->items->len; i++)
+    {
+        QofEventBatchItem item = g_array_index (batch->items,
+                                                QofEventBatchItem, i);
+        if (!item.entity)
+            continue;
+        g_array_index (batch->items, QofEventBatchItem, n_items++) = item;
+        g_hash_table_insert (batch->index, item.entity,
+                             GUINT_TO_POINTER (n_items));
+    }
+    g_array_set_size (batch->items, n_items);
+
+    if (n_items)
+    {
+        delivering_batches = g_slist_prepend (delivering_batches, batch);
+        handler_run_level++;
+        run_batch_handlers (&g_array_index (batch->items, QofEventBatchItem, 0),
+                            n_items);
+        handler_run_level--;
+        delivering_batches = g_slist_remove (delivering_batches, batch);
+        remove_pending_deletes ();
+    }
+    for (i = 0; i < batch->items->len; i++)
+    {
+        QofInstance *entity = g_array_index (batch->items, QofEventBatchItem,
+                                             i).entity;
+        if (entity)
+            g_object_weak_unref (G_OBJECT (entity), event_batch_entity_freed,
+                                 batch);
+    }
+    event_batch_free (batch);
+}
+
+guint
+qof_event_get_suspended_count (void)
+{
+    return suspended_events;
+}
+
 /* =========================== END OF FILE ======================= */
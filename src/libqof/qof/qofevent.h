@@ -89,6 +89,29 @@ for future libqof1 or libqof2 usage.
 typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
                                  gpointer handler_data, gpointer event_data);
 
+/** \brief One entity's events in a batch.
+ *
+ * @param entity:     Entity which generated the events, or NULL if it was
+ *                    destroyed while the batch was being delivered.
+ * @param event_mask: All of the event ids the entity generated, or'ed
+ *                    together.
+ */
+typedef struct
+{
+    QofInstance *entity;
+    QofEventId event_mask;
+} QofEventBatchItem;
+
+/** \brief Handler invoked with a batch of events.
+ *
+ * @param items:        The entities and their events, in the order each
+ *                      entity first generated an event.
+ * @param n_items:      The number of items.
+ * @param handler_data: data supplied when handler was registered.
+ */
+typedef void (*QofEventBatchHandler) (const QofEventBatchItem *items,
+                                      guint n_items, gpointer handler_data);
+
 /** \brief Register a handler for events.
  *
  * @param handler:   handler to register
@@ -98,6 +121,26 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for batches of events.
+ *
+ * Outside of qof_event_begin_batch() and qof_event_end_batch() the handler
+ * is invoked for each event with a batch of one item. Inside, events are
+ * collected into one item per entity and delivered when the outermost
+ * batch ends, except for QOF_EVENT_DESTROY which is delivered at once,
+ * together with any events the entity generated earlier in the batch,
+ * while the entity is still valid. An entity freed without a
+ * QOF_EVENT_DESTROY, e.g. while events are suspended, is dropped from the
+ * batch. Batched events carry no event_data.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                       gpointer handler_data);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -139,6 +182,19 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start collecting events for batch handlers.
+ *
+ *    Event handlers registered with qof_event_register_handler() are
+ *    still invoked for each event. Batches nest; events are delivered
+ *    when qof_event_end_batch() has been called once for each call to
+ *    this function.
+ */
+void qof_event_begin_batch (void);
+
+/** Deliver the events collected since the outermost
+ *  qof_event_begin_batch() to the batch handlers. */
+void qof_event_end_batch (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,7 +41,10 @@ struct QofCollection_s
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    GHashTable * hash_of_entities;  /* guid -> position in entities plus one */
+    GPtrArray  * entities;   /* in insertion order, NULL where removed */
+    guint        n_removed;  /* NULLs in entities */
+    guint        iterating;  /* iterations which need entities to hold still */
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
@@ -54,6 +57,7 @@ qof_collection_new (QofIdType type)
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
     col->hash_of_entities = guid_hash_table_new();
+    col->entities = g_ptr_array_new();
     col->data = NULL;
     return col;
 }
@@ -63,8 +67,10 @@ qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
     g_hash_table_destroy(col->hash_of_entities);
+    g_ptr_array_free(col->entities, TRUE);
     col->e_type = NULL;
     col->hash_of_entities = NULL;
+    col->entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -80,6 +86,52 @@ qof_collection_get_type (const QofCollection *col)
 
 /* =============================================================== */
 
+/* Squeeze the removed entities out of the vector once they are most of
+ * it, unless somebody is walking it. */
+static void
+collection_compact (QofCollection *col)
+{
+    guint i, n_entities;
+
+    if (col->iterating || col->n_removed <= col->entities->len / 2)
+        return;
+
+    for (i = 0, n_entities = 0; i < col->entities->len; i++)
+    {
+        QofInstance *ent =
+            static_cast<QofInstance*>(g_ptr_array_index (col->entities, i));
+        if (!ent)
+            continue;
+        g_ptr_array_index (col->entities, n_entities++) = ent;
+        g_hash_table_insert (col->hash_of_entities,
+                             (gpointer)qof_instance_get_guid(ent),
+                             GUINT_TO_POINTER (n_entities));
+    }
+    g_ptr_array_set_size (col->entities, n_entities);
+    col->n_removed = 0;
+}
+
+static void
+collection_remove_guid (QofCollection *col, const GncGUID *guid)
+{
+    guint pos;
+
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (col->hash_of_entities, guid));
+    if (!pos) return;
+    g_hash_table_remove (col->hash_of_entities, guid);
+    g_ptr_array_index (col->entities, pos - 1) = NULL;
+    col->n_removed++;
+}
+
+static void
+collection_append (QofCollection *col, const GncGUID *guid, QofInstance *ent)
+{
+    collection_remove_guid (col, guid);
+    g_ptr_array_add (col->entities, ent);
+    g_hash_table_insert (col->hash_of_entities, (gpointer)guid,
+                         GUINT_TO_POINTER (col->entities->len));
+}
+
 void
 qof_collection_remove_entity (QofInstance *ent)
 {
@@ -90,7 +142,8 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_remove_guid (col, guid);
+    collection_compact (col);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -104,7 +157,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_append (col, guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -130,7 +183,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_append (coll, guid, ent);
     return TRUE;
 }
 
@@ -214,12 +267,13 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
+    guint pos;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (col->hash_of_entities, guid));
+    if (!pos) return NULL;
+    return static_cast<QofInstance*>(g_ptr_array_index (col->entities,
+                                                        pos - 1));
 }
 
 QofCollection *
@@ -303,39 +357,64 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
+void
+qof_collection_iter_init (QofCollectionIter *iter, const QofCollection *col)
 {
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
+    g_return_if_fail (iter);
 
-static void
-foreach_cb (gpointer item, gpointer arg)
+    /* The iteration only reads the collection, but keeps it from being
+     * compacted until the iteration ends. */
+    iter->col = const_cast<QofCollection*>(col);
+    iter->pos = 0;
+    iter->end = col ? col->entities->len : 0;
+    if (col)
+        iter->col->iterating++;
+}
+
+QofInstance *
+qof_collection_iter_next (QofCollectionIter *iter)
 {
-    struct _iterate *iter = static_cast<_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
+    g_return_val_if_fail (iter, NULL);
 
-    iter->fcn (ent, iter->data);
+    while (iter->pos < iter->end)
+    {
+        QofInstance *ent = static_cast<QofInstance*>(
+            g_ptr_array_index (iter->col->entities, iter->pos++));
+        if (ent)
+            return ent;
+    }
+    qof_collection_iter_end (iter);
+    return NULL;
+}
+
+void
+qof_collection_iter_end (QofCollectionIter *iter)
+{
+    g_return_if_fail (iter);
+
+    if (!iter->col)
+        return;
+    iter->col->iterating--;
+    collection_compact (iter->col);
+    iter->col = NULL;
+    iter->pos = iter->end = 0;
 }
 
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
+    QofCollectionIter iter;
+    QofInstance *ent;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
     PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    qof_collection_iter_init (&iter, col);
+    while ((ent = qof_collection_iter_next (&iter)))
+        cb_func (ent, user_data);
 
     PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
 }
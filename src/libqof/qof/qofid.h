@@ -141,6 +141,7 @@ print error message if its bad  */
 @param e_type QofIdType
 @param is_dirty gboolean
 @param hash_of_entities GHashTable
+@param entities GPtrArray, the entities in insertion order
 @param data gpointer, place where object class can hang arbitrary data
 
 */
@@ -167,10 +168,44 @@ QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID
 /** Callback type for qof_collection_foreach */
 typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 
-/** Call the callback for each entity in the collection. */
+/** Call the callback for each entity in the collection, in the order they
+ * were inserted. The callback may remove entities from the collection;
+ * those not yet visited are skipped. Entities inserted by the callback
+ * are not visited. */
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
+/** Iterator over the entities of a collection, to be kept on the stack:
+ *
+ * @code
+ * QofCollectionIter iter;
+ * QofInstance *inst;
+ * qof_collection_iter_init (&iter, col);
+ * while ((inst = qof_collection_iter_next (&iter)))
+ *     ...
+ * @endcode
+ *
+ * It visits the entities as qof_collection_foreach does. The members are
+ * private. */
+typedef struct
+{
+    QofCollection *col;
+    guint pos;
+    guint end;
+} QofCollectionIter;
+
+/** Start iterating over the collection. */
+void qof_collection_iter_init (QofCollectionIter *iter,
+                               const QofCollection *col);
+
+/** Return the next entity, or NULL once they have all been visited, at
+ * which point the iteration has ended. */
+QofInstance * qof_collection_iter_next (QofCollectionIter *iter);
+
+/** End an iteration before qof_collection_iter_next has returned NULL.
+ * Until then the collection holds its removed entities' places. */
+void qof_collection_iter_end (QofCollectionIter *iter);
+
 /** Store and retreive arbitrary object-defined data
  *
  * XXX We need to add a callback for when the collection is being
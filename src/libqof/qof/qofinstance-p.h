@@ -130,6 +130,55 @@ void qof_instance_set_kvp (QofInstance *inst, const gchar *key, const GValue *va
  */
 void qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue
 *value);
+/** A '/'-delimited KVP path split into its keys once, for slots read often
+ * enough that parsing the path and copying the value into a GValue on each
+ * read shows.  See KvpPathImpl. */
+typedef struct KvpPathImpl QofKvpPath;
+/** Get the interned path for a '/'-delimited path string.  The same string
+ * always gives the same path, which lasts as long as the program, so keep it
+ * in a static and intern it on first use.
+ * @param path: The '/'-delimited path.
+ * @return The interned path.
+ */
+const QofKvpPath* qof_kvp_path_intern (const char *path);
+/** Retrieves a string slot without copying it.
+ * @param inst: The QofInstance
+ * @param path: The interned path to the slot.
+ * @return The string, owned by the slot, or NULL if the slot doesn't exist
+ * or doesn't hold a string.
+ */
+const char* qof_instance_get_kvp_string (const QofInstance *inst,
+                                         const QofKvpPath *path);
+/** Retrieves an int64 slot.
+ * @param inst: The QofInstance
+ * @param path: The interned path to the slot.
+ * @param value: Set to the slot's value if it holds an int64.
+ * @return TRUE if the slot exists and holds an int64.
+ */
+gboolean qof_instance_get_kvp_int64 (const QofInstance *inst,
+                                     const QofKvpPath *path, gint64 *value);
+/** Retrieves a GUID slot without copying it.
+ * @param inst: The QofInstance
+ * @param path: The interned path to the slot.
+ * @return The GUID, owned by the slot, or NULL if the slot doesn't exist
+ * or doesn't hold a GUID.
+ */
+const GncGUID* qof_instance_get_kvp_guid (const QofInstance *inst,
+                                          const QofKvpPath *path);
+/** Calls proc with the key and value of each int64 slot in the frame at
+ * path, or in the frame at key below it if key isn't NULL.  Slots of other
+ * types are skipped.
+ * @param inst: The QofInstance
+ * @param path: The interned path to the frame.
+ * @param key: The key of or '/'-delimited path to a frame below path, or
+ * NULL.
+ * @param proc: The function to call; the key is owned by the frame.
+ * @param data: Passed to proc.
+ */
+void qof_instance_foreach_slot_int64 (const QofInstance *inst,
+                                      const QofKvpPath *path, const char *key,
+                                      void(*proc)(const char*, gint64, void*),
+                                      void* data);
 /** @} Close out the DOxygen ingroup */
 /* Functions to isolate the KVP mechanism inside QOF for cases where
 GValue * operations won't work.
@@ -578,6 +578,22 @@ qof_instance_get_slots (const QofInstance *inst)
     return inst->kvp_data;
 }
 
+static void
+mark_key_changed (const char *key, KvpValue *value, void *frame)
+{
+    static_cast<KvpFrame*>(frame)->mark_changed (key);
+}
+
+/* A frame replacing another in an instance differs from it in any key
+ * of either.  The keys are marked as the frames are walked, rather than
+ * copied out of them first. */
+static void
+mark_replaced_keys (KvpFrame *frame, const KvpFrame *old)
+{
+    old->for_each_slot (mark_key_changed, frame);
+    frame->for_each_slot (mark_key_changed, frame);
+}
+
 void
 qof_instance_set_slots (QofInstance *inst, KvpFrame *frm)
 {
@@ -588,6 +604,8 @@ qof_instance_set_slots (QofInstance *inst, KvpFrame *frm)
     priv = GET_PRIVATE(inst);
     if (inst->kvp_data && (inst->kvp_data != frm))
     {
+        if (frm)
+            mark_replaced_keys (frm, inst->kvp_data);
         delete inst->kvp_data;
     }
 
@@ -816,24 +834,16 @@ typedef struct
     GList* list;
 } GetReferringObjectHelperData;
 
-static void
-get_referring_object_instance_helper(QofInstance* inst, gpointer user_data)
-{
-    QofInstance** pInst = (QofInstance**)user_data;
-
-    if (*pInst == NULL)
-    {
-        *pInst = inst;
-    }
-}
-
 static void
 get_referring_object_helper(QofCollection* coll, gpointer user_data)
 {
-    QofInstance* first_instance = NULL;
+    QofCollectionIter iter;
+    QofInstance* first_instance;
     GetReferringObjectHelperData* data = (GetReferringObjectHelperData*)user_data;
 
-    qof_collection_foreach(coll, get_referring_object_instance_helper, &first_instance);
+    qof_collection_iter_init(&iter, coll);
+    first_instance = qof_collection_iter_next(&iter);
+    qof_collection_iter_end(&iter);
 
     if (first_instance != NULL)
     {
@@ -1080,17 +1090,56 @@ qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
     }
 }
 
+const QofKvpPath*
+qof_kvp_path_intern (const char *path)
+{
+    return KvpPathImpl::intern (path);
+}
+
+const char*
+qof_instance_get_kvp_string (const QofInstance *inst, const QofKvpPath *path)
+{
+    auto slot = inst->kvp_data->get_slot(*path);
+    if (slot == nullptr)
+        return nullptr;
+    return slot->get<const char*>();
+}
+
+gboolean
+qof_instance_get_kvp_int64 (const QofInstance *inst, const QofKvpPath *path,
+                            gint64 *value)
+{
+    auto slot = inst->kvp_data->get_slot(*path);
+    if (slot == nullptr || slot->get_type() != KvpValue::Type::INT64)
+        return FALSE;
+    *value = slot->get<int64_t>();
+    return TRUE;
+}
+
+const GncGUID*
+qof_instance_get_kvp_guid (const QofInstance *inst, const QofKvpPath *path)
+{
+    auto slot = inst->kvp_data->get_slot(*path);
+    if (slot == nullptr)
+        return nullptr;
+    return slot->get<GncGUID*>();
+}
+
 void
 qof_instance_copy_kvp (QofInstance *to, const QofInstance *from)
 {
+    auto frame = new KvpFrame(*from->kvp_data);
+    mark_replaced_keys (frame, to->kvp_data);
     delete to->kvp_data;
-    to->kvp_data = new KvpFrame(*from->kvp_data);
+    to->kvp_data = frame;
 }
 
 void
 qof_instance_swap_kvp (QofInstance *a, QofInstance *b)
 {
     std::swap(a->kvp_data, b->kvp_data);
+    mark_replaced_keys (a->kvp_data, b->kvp_data);
+    mark_replaced_keys (b->kvp_data, a->kvp_data);
 }
 
 int
@@ -1197,6 +1246,7 @@ qof_instance_kvp_remove_guid (const QofInstance *inst, const char *path,
             {
                 list = g_list_delete_link (list, node);
                 v->set(list);
+                inst->kvp_data->mark_changed(path);
                 delete val;
                 break;
             }
@@ -1226,7 +1276,10 @@ qof_instance_kvp_merge_guids (const QofInstance *target,
     {
     case KvpValue::Type::FRAME:
         if (target_val)
+        {
             target_val->add(v);
+            target->kvp_data->mark_changed(path);
+        }
         else
             target->kvp_data->set_path(path, v);
         donor->kvp_data->set(path, nullptr); //Contents moved, Don't delete!
@@ -1237,6 +1290,7 @@ qof_instance_kvp_merge_guids (const QofInstance *target,
             auto list = target_val->get<GList*>();
             list = g_list_concat(list, v->get<GList*>());
             target_val->set(list);
+            target->kvp_data->mark_changed(path);
         }
         else
             target->kvp_data->set(path, v);
@@ -1308,5 +1362,40 @@ qof_instance_foreach_slot (const QofInstance *inst, const char* path,
     frame->for_each_slot(wrap_gvalue_function, &new_data);
 }
 
+namespace {
+struct wrap_int64_param
+{
+    void (*proc)(const char*, gint64, void*);
+    void *user_data;
+};
+}
+static void
+wrap_int64_function (const char* key, KvpValue *val, gpointer data)
+{
+    auto param = static_cast<wrap_int64_param*>(data);
+    if (val->get_type() == KvpValue::Type::INT64)
+        param->proc(key, val->get<int64_t>(), param->user_data);
+}
+
+void
+qof_instance_foreach_slot_int64 (const QofInstance *inst,
+                                 const QofKvpPath *path, const char *key,
+                                 void (*proc)(const char*, gint64, void*),
+                                 void* data)
+{
+    auto slot = inst->kvp_data->get_slot(*path);
+    if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+        return;
+    if (key != nullptr)
+    {
+        slot = slot->get<KvpFrame*>()->get_slot(key);
+        if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+            return;
+    }
+    auto frame = slot->get<KvpFrame*>();
+    wrap_int64_param new_data {proc, data};
+    frame->for_each_slot(wrap_int64_function, &new_data);
+}
+
 /* ========================== END OF FILE ======================= */
 
@@ -67,6 +67,33 @@ static gint qof_log_num_spaces = 0;
 static GHashTable *log_table = NULL;
 static GLogFunc previous_handler = NULL;
 
+/* Every ENTER, LEAVE, PINFO and DEBUG goes through qof_log_check, so the
+ * most verbose threshold of all modules is kept where a check can read it
+ * without locking; most checks are for a level that no module logs at and
+ * stop there.  Past that, each module that was checked has its own entry
+ * holding the threshold it resolves to, which is updated in place whenever
+ * a level is set.
+ *
+ * The entries are found through level_cache, which is never changed once
+ * published: a module checked for the first time gets a new copy with its
+ * entry added, so checks read it without locking.  The copies it replaces,
+ * and the entries, are only freed by qof_log_shutdown.  log_table_lock
+ * guards log_table, module_levels and retired_caches. */
+typedef struct
+{
+    gchar *name;
+    gint thresh;        // Atomic
+} QofLogModuleLevel;
+
+G_LOCK_DEFINE_STATIC(log_table_lock);
+static GHashTable *level_cache = NULL;
+static GSList *module_levels = NULL;
+static GSList *retired_caches = NULL;
+static const QofLogLevel default_log_thresh = QOF_LOG_WARNING;
+static gint max_log_thresh = QOF_LOG_WARNING;
+
+static QofLogLevel log_table_lookup(const gchar *log_domain);
+
 void
 qof_log_indent(void)
 {
@@ -148,9 +175,11 @@ void
 qof_log_init_filename(const gchar* log_filename)
 {
     gboolean warn_about_missing_permission = FALSE;
+    G_LOCK(log_table_lock);
     if (log_table == NULL)
         log_table = g_hash_table_new_full(g_str_hash, g_str_equal,
                                           g_free, NULL);
+    G_UNLOCK(log_table_lock);
 
     if (log_filename)
     {
@@ -216,11 +245,29 @@ qof_log_shutdown (void)
         function_buffer = NULL;
     }
 
+    G_LOCK(log_table_lock);
     if (log_table != NULL)
     {
         g_hash_table_destroy(log_table);
         log_table = NULL;
     }
+    g_atomic_int_set(&max_log_thresh, default_log_thresh);
+    if (level_cache != NULL)
+    {
+        retired_caches = g_slist_prepend(retired_caches, level_cache);
+        g_atomic_pointer_set(&level_cache, NULL);
+    }
+    g_slist_free_full(retired_caches, (GDestroyNotify)g_hash_table_destroy);
+    retired_caches = NULL;
+    for (GSList *node = module_levels; node != NULL; node = node->next)
+    {
+        QofLogModuleLevel *entry = static_cast<QofLogModuleLevel*>(node->data);
+        g_free(entry->name);
+        g_free(entry);
+    }
+    g_slist_free(module_levels);
+    module_levels = NULL;
+    G_UNLOCK(log_table_lock);
 
     if (previous_handler != NULL)
     {
@@ -229,6 +276,34 @@ qof_log_shutdown (void)
     }
 }
 
+/* Resolves each module's cached threshold again and finds the most verbose
+ * one any module can resolve to.  The caller holds log_table_lock. */
+static void
+log_levels_changed(void)
+{
+    gint max_thresh = default_log_thresh;
+
+    if (log_table != NULL)
+    {
+        GHashTableIter iter;
+        gpointer level;
+
+        /* Modules which match no entry use the "" entry, if there is one,
+         * instead of the default. */
+        if (g_hash_table_lookup_extended(log_table, "", NULL, NULL))
+            max_thresh = 0;
+        g_hash_table_iter_init(&iter, log_table);
+        while (g_hash_table_iter_next(&iter, NULL, &level))
+            max_thresh = MAX(max_thresh, GPOINTER_TO_INT(level));
+    }
+    for (GSList *node = module_levels; node != NULL; node = node->next)
+    {
+        QofLogModuleLevel *entry = static_cast<QofLogModuleLevel*>(node->data);
+        g_atomic_int_set(&entry->thresh, (gint)log_table_lookup(entry->name));
+    }
+    g_atomic_int_set(&max_log_thresh, max_thresh);
+}
+
 void
 qof_log_set_level(QofLogModule log_module, QofLogLevel level)
 {
@@ -236,11 +311,15 @@ qof_log_set_level(QofLogModule log_module, QofLogLevel level)
     {
         return;
     }
+    G_LOCK(log_table_lock);
     if (!log_table)
     {
-        log_table = g_hash_table_new(g_str_hash, g_str_equal);
+        log_table = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          g_free, NULL);
     }
     g_hash_table_insert(log_table, g_strdup((gchar*)log_module), GINT_TO_POINTER((gint)level));
+    log_levels_changed();
+    G_UNLOCK(log_table_lock);
 }
 
 const char *
@@ -368,15 +447,17 @@ qof_log_parse_log_config(const char *filename)
     g_key_file_free(conf);
 }
 
-gboolean
-qof_log_check(QofLogModule log_domain, QofLogLevel log_level)
+/* Implements the "log.path.hierarchy" logic: the module uses the level of
+ * the longest of its dot-separated prefixes that has one.  The caller holds
+ * log_table_lock. */
+static QofLogLevel
+log_table_lookup(const gchar *log_domain)
 {
 //#define _QLC_DBG(x) x
 #define _QLC_DBG(x)
     GHashTable *log_levels = log_table;
-    gchar *domain_copy = g_strdup(log_domain == NULL ? "" : log_domain);
+    gchar *domain_copy = g_strdup(log_domain);
     gchar *dot_pointer = domain_copy;
-    static const QofLogLevel default_log_thresh = QOF_LOG_WARNING;
     QofLogLevel longest_match_level = default_log_thresh;
 
     {
@@ -414,7 +495,61 @@ _QLC_DBG( { printf("trying [%s] (%d):", log_domain, log_levels != NULL ? g_hash_
     _QLC_DBG( { printf(" found [%d]\n", longest_match_level); });
     g_free(domain_copy);
 
-    return log_level <= longest_match_level;
+    return longest_match_level;
+}
+
+/* Adds the entry of a module checked for the first time to a new copy of
+ * level_cache. */
+static QofLogModuleLevel*
+add_module_level(const gchar *log_domain)
+{
+    QofLogModuleLevel *entry;
+    GHashTable *cache;
+
+    G_LOCK(log_table_lock);
+    // Another thread may have added it first
+    entry = level_cache == NULL ? NULL : static_cast<QofLogModuleLevel*>
+            (g_hash_table_lookup(level_cache, log_domain));
+    if (entry == NULL)
+    {
+        entry = g_new(QofLogModuleLevel, 1);
+        entry->name = g_strdup(log_domain);
+        entry->thresh = (gint)log_table_lookup(log_domain);
+        module_levels = g_slist_prepend(module_levels, entry);
+
+        cache = g_hash_table_new(g_str_hash, g_str_equal);
+        for (GSList *node = module_levels; node != NULL; node = node->next)
+        {
+            QofLogModuleLevel *e = static_cast<QofLogModuleLevel*>(node->data);
+            g_hash_table_insert(cache, e->name, e);
+        }
+        if (level_cache != NULL)
+            retired_caches = g_slist_prepend(retired_caches, level_cache);
+        g_atomic_pointer_set(&level_cache, cache);
+    }
+    G_UNLOCK(log_table_lock);
+    return entry;
+}
+
+gboolean
+qof_log_check(QofLogModule log_domain, QofLogLevel log_level)
+{
+    GHashTable *cache;
+    QofLogModuleLevel *entry = NULL;
+
+    if (G_LIKELY((gint)log_level > g_atomic_int_get(&max_log_thresh)))
+        return FALSE;
+
+    if (log_domain == NULL)
+        log_domain = "";
+    cache = static_cast<GHashTable*>(g_atomic_pointer_get(&level_cache));
+    if (cache != NULL)
+        entry = static_cast<QofLogModuleLevel*>(g_hash_table_lookup(cache,
+                                                                    log_domain));
+    if (G_UNLIKELY(entry == NULL))
+        entry = add_module_level(log_domain);
+
+    return (gint)log_level <= g_atomic_int_get(&entry->thresh);
 }
 
 void
@@ -165,7 +165,9 @@ void qof_log_shutdown (void);
 const gchar * qof_log_prettify (const gchar *name);
 
 /** Check to see if the given @a log_module is configured to log at the given
- * @a log_level.  This implements the "log.path.hierarchy" logic. **/
+ * @a log_level.  This implements the "log.path.hierarchy" logic.  The level
+ * each module resolves to is cached until a level is next set, and a level
+ * which no module logs at is rejected without any lookup. **/
 gboolean qof_log_check(QofLogModule log_module, QofLogLevel log_level);
 
 /** Set the default level for QOF-related log paths. **/
@@ -197,14 +199,18 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print an informational note */
 #define PINFO(format, ...) do { \
-    g_log (log_module, G_LOG_LEVEL_INFO, \
-      "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_INFO)) { \
+      g_log (log_module, G_LOG_LEVEL_INFO, \
+        "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    } \
 } while (0)
 
 /** Print a debugging message */
 #define DEBUG(format, ...) do { \
-    g_log (log_module, G_LOG_LEVEL_DEBUG, \
-      "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+      g_log (log_module, G_LOG_LEVEL_DEBUG, \
+        "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    } \
 } while (0)
 
 /** Print a function entry debugging message */
@@ -249,14 +255,18 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print an informational note */
 #define PINFO(format, args...) do { \
-    g_log (log_module, G_LOG_LEVEL_INFO, \
-      "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_INFO)) { \
+      g_log (log_module, G_LOG_LEVEL_INFO, \
+        "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    } \
 } while (0)
 
 /** Print a debugging message */
 #define DEBUG(format, args...) do { \
-    g_log (log_module, G_LOG_LEVEL_DEBUG, \
-      "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+      g_log (log_module, G_LOG_LEVEL_DEBUG, \
+        "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    } \
 } while (0)
 
 /** Print a function entry debugging message */
@@ -37,6 +37,7 @@ extern "C"
 #include "qofbackend-p.h"
 #include "qofbook-p.h"
 #include "qofclass-p.h"
+#include "qofevent-p.h"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
 
@@ -105,11 +106,55 @@ struct _QofQuery
     gint              changed;
 
     GList *           results;
+
+    /* For incremental runs: the objects matching at the last run, the
+     * objects to check again, and for each object type that the terms
+     * read, how its events affect the objects searched for. */
+    gint              event_handler_id;
+    GHashTable *      matches;
+    GHashTable *      pending;
+    GHashTable *      dependencies;
+    gboolean          rescan;
+    guint             suspended_events;
 };
 
+/* How one of the query's or-clauses is run over a book: the order in
+ * which its terms are checked, and the index that lists the objects
+ * which can pass it, if any. */
+typedef struct _QofQueryClausePlan
+{
+    GPtrArray *          terms;
+    const QofQueryIndex *index;
+    QofQueryIndexKey     key;
+    gint64               estimate;
+} QofQueryClausePlan;
+
+/* An index registered for the terms on one parameter path. */
+typedef struct _QofQueryIndexReg
+{
+    QofIdTypeConst       obj_type;
+    QofQueryParamList *  param_list;
+    QofType              pred_type;
+    const QofQueryIndex *index;
+} QofQueryIndexReg;
+
+static GList *query_indexes = NULL;
+
+/* How events on one object type affect queries for another. */
+typedef struct _QofQueryDependentsReg
+{
+    QofIdTypeConst         obj_type;
+    QofIdTypeConst         dep_type;
+    QofQueryDependentsFunc fcn;
+} QofQueryDependentsReg;
+
+static GList *query_dependents = NULL;
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
+    GPtrArray *       plan;
+    GHashTable *      seen;
     GList *           list;
     gint              count;
 } QofQueryCB;
@@ -357,6 +402,77 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
     }
 }
 
+/* A matching object and its place in the list of matches, which breaks
+ * ties the way the stable g_list_sort_with_data() does. */
+typedef struct
+{
+    gpointer object;
+    guint    position;
+} QofQueryRankedObject;
+
+static gint
+ranked_object_cmp (gconstpointer a, gconstpointer b, gpointer q)
+{
+    const QofQueryRankedObject *ra = static_cast<const QofQueryRankedObject*>(a);
+    const QofQueryRankedObject *rb = static_cast<const QofQueryRankedObject*>(b);
+    int retval = sort_func (ra->object, rb->object, q);
+
+    if (retval) return retval;
+    return ra->position < rb->position ? -1 : ra->position > rb->position;
+}
+
+/* Return the last max_results of the objects in sort order, as sorting
+ * the whole list and cropping it would, but in O(n log max_results):
+ * a min-heap keeps the greatest objects seen so far, and only those are
+ * sorted at the end. */
+static GList *
+sort_top_objects (QofQuery *q, GList *objects, gint max_results)
+{
+    QofQueryRankedObject *heap = g_new (QofQueryRankedObject, max_results);
+    guint len = 0, size = max_results, position = 0, i, child;
+    GList *node, *result = NULL;
+
+    for (node = objects; node; node = node->next, position++)
+    {
+        QofQueryRankedObject item = { node->data, position };
+
+        if (len < size)
+        {
+            /* Sift the new object up from the bottom. */
+            for (i = len++; i > 0; i = (i - 1) / 2)
+            {
+                if (ranked_object_cmp (&heap[(i - 1) / 2], &item, q) <= 0)
+                    break;
+                heap[i] = heap[(i - 1) / 2];
+            }
+            heap[i] = item;
+            continue;
+        }
+
+        if (ranked_object_cmp (&item, &heap[0], q) <= 0)
+            continue;
+
+        /* Replace the least object and sift the new one down. */
+        for (i = 0; (child = 2 * i + 1) < len; i = child)
+        {
+            if (child + 1 < len &&
+                ranked_object_cmp (&heap[child + 1], &heap[child], q) < 0)
+                child++;
+            if (ranked_object_cmp (&item, &heap[child], q) <= 0)
+                break;
+            heap[i] = heap[child];
+        }
+        heap[i] = item;
+    }
+
+    g_qsort_with_data (heap, len, sizeof (QofQueryRankedObject),
+                       ranked_object_cmp, q);
+    for (i = len; i > 0; i--)
+        result = g_list_prepend (result, heap[i - 1].object);
+    g_free (heap);
+    return result;
+}
+
 /* ==================================================================== */
 /* This is the main workhorse for performing the query.  For each
  * object, it walks over all of the query terms to see if the
@@ -364,20 +480,21 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
  */
 
 static int
-check_object (const QofQuery *q, gpointer object)
+check_object (const GPtrArray *plan, gpointer object)
 {
-    const GList     * and_ptr;
-    const GList     * or_ptr;
-    const QofQueryTerm * qt;
+    guint     clause_num, term_num;
     int       and_terms_ok = 1;
 
-    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    for (clause_num = 0; clause_num < plan->len; clause_num++)
     {
+        const QofQueryClausePlan *clause =
+            static_cast<QofQueryClausePlan*>(g_ptr_array_index (plan, clause_num));
+
         and_terms_ok = 1;
-        for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
-	     and_ptr = static_cast<GList*>(and_ptr->next))
+        for (term_num = 0; term_num < clause->terms->len; term_num++)
         {
-            qt = (QofQueryTerm *)(and_ptr->data);
+            const QofQueryTerm * qt =
+                static_cast<QofQueryTerm*>(g_ptr_array_index (clause->terms, term_num));
             if (qt->param_fcns && qt->pred_fcn)
             {
                 const GSList *node;
@@ -417,7 +534,7 @@ check_object (const QofQuery *q, gpointer object)
      * may want to get all objects, but in a particular sorted
      * order.
      */
-    if (NULL == q->terms) return 1;
+    if (0 == plan->len) return 1;
     return 0;
 }
 
@@ -572,7 +689,7 @@ static void check_item_cb (gpointer object, gpointer user_data)
 
     if (!object || !ql) return;
 
-    if (check_object (ql->query, object))
+    if (check_object (ql->plan, object))
     {
         ql->list = g_list_prepend (ql->list, object);
         ql->count++;
@@ -580,6 +697,44 @@ static void check_item_cb (gpointer object, gpointer user_data)
     return;
 }
 
+/* Objects listed by the index of more than one clause are only
+ * checked once. */
+static void check_indexed_item_cb (QofInstance *object, gpointer user_data)
+{
+    QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
+
+    if (ql->seen)
+    {
+        if (g_hash_table_lookup (ql->seen, object)) return;
+        g_hash_table_insert (ql->seen, object, object);
+    }
+    check_item_cb (object, user_data);
+}
+
+/* Check every object of the searched-for type in the book.  Objects kept
+ * in their book's collection are walked in place; those with a foreach of
+ * their own, such as prices, which live in the price db, are visited
+ * through it. */
+static void scan_book (QofQueryCB* qcb, QofBook* book)
+{
+    QofQuery* q = qcb->query;
+    const QofObject* obj = qof_object_lookup (q->search_for);
+    QofCollectionIter iter;
+    QofInstance* object;
+
+    if (!obj || obj->foreach != qof_collection_foreach)
+    {
+        qof_object_foreach (q->search_for, book,
+                            (QofInstanceForeachCB) check_item_cb, qcb);
+        return;
+    }
+
+    qof_collection_iter_init (&iter,
+                              qof_book_get_collection (book, q->search_for));
+    while ((object = qof_collection_iter_next (&iter)))
+        check_item_cb (object, qcb);
+}
+
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
 {
     int ret;
@@ -637,6 +792,575 @@ static void query_clear_compiles (QofQuery *q)
     g_hash_table_foreach_remove (q->be_compiled, query_free_compiled, NULL);
 }
 
+/********************************************************************/
+/* The query planner */
+
+static GString *qof_query_printParamPath (QofQueryParamList * parmList);
+
+/* Times compared by day are rounded to the middle of their day, so an
+ * index range for them is widened by up to a day either way. */
+static const time64 date_match_day_slack = 2 * 24 * 3600;
+
+/* A rough guess at the fraction of objects that pass a term. */
+static double
+term_selectivity (const QofQueryTerm *qt)
+{
+    const QofQueryPredData *pd = qt->pdata;
+    double selectivity;
+
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_GUID))
+    {
+        switch (((const query_guid_def *) pd)->options)
+        {
+        case QOF_GUID_MATCH_ANY:
+        case QOF_GUID_MATCH_ALL:
+        case QOF_GUID_MATCH_LIST_ANY:
+            selectivity = 0.01;
+            break;
+        case QOF_GUID_MATCH_NULL:
+            selectivity = 0.1;
+            break;
+        default:
+            selectivity = 0.99;
+            break;
+        }
+    }
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_BOOLEAN))
+        selectivity = 0.5;
+    else
+    {
+        switch (pd->how)
+        {
+        case QOF_COMPARE_EQUAL:
+            selectivity = 0.05;
+            break;
+        case QOF_COMPARE_CONTAINS:
+            selectivity = 0.1;
+            break;
+        case QOF_COMPARE_NEQ:
+            selectivity = 0.95;
+            break;
+        case QOF_COMPARE_NCONTAINS:
+            selectivity = 0.9;
+            break;
+        default:
+            selectivity = 0.5;
+            break;
+        }
+    }
+    return qt->invert ? 1.0 - selectivity : selectivity;
+}
+
+/* A rough guess at the cost of checking a term: a call per parameter
+ * to walk, more for string compares and most for regular expressions. */
+static double
+term_cost (const QofQueryTerm *qt)
+{
+    double cost = g_slist_length (qt->param_fcns) + 1;
+
+    if (!g_strcmp0 (qt->pdata->type_name, QOF_TYPE_STRING))
+        cost *= ((const query_string_def *) qt->pdata)->is_regex ? 8 : 2;
+    return cost;
+}
+
+typedef struct
+{
+    QofQueryTerm * term;
+    double         rank;
+    guint          position;
+} QofQueryTermRank;
+
+static gint
+term_rank_cmp (gconstpointer a, gconstpointer b)
+{
+    const QofQueryTermRank *ra = static_cast<const QofQueryTermRank*>(a);
+    const QofQueryTermRank *rb = static_cast<const QofQueryTermRank*>(b);
+
+    if (ra->rank != rb->rank)
+        return ra->rank < rb->rank ? -1 : 1;
+    return ra->position < rb->position ? -1 : 1;
+}
+
+/* Order the terms of an and-clause so that the expected work to reject
+ * an object is least: a term that is cheap to check and rejects many
+ * objects goes first. */
+static GPtrArray *
+plan_term_order (GList *and_terms)
+{
+    GArray *ranks = g_array_new (FALSE, FALSE, sizeof (QofQueryTermRank));
+    GPtrArray *terms = g_ptr_array_new ();
+    GList *node;
+    guint i;
+
+    for (node = and_terms; node; node = node->next)
+    {
+        QofQueryTermRank rank;
+        double pass;
+
+        rank.term = static_cast<QofQueryTerm*>(node->data);
+        pass = MIN (term_selectivity (rank.term), 0.999);
+        rank.rank = term_cost (rank.term) / (1.0 - pass);
+        rank.position = ranks->len;
+        g_array_append_val (ranks, rank);
+    }
+    g_array_sort (ranks, term_rank_cmp);
+    for (i = 0; i < ranks->len; i++)
+        g_ptr_array_add (terms, g_array_index (ranks, QofQueryTermRank, i).term);
+    g_array_free (ranks, TRUE);
+    return terms;
+}
+
+/* Narrow the index key to the values the term can match.  Returns
+ * FALSE if the term can't be served by an index. */
+static gboolean
+term_index_key (const QofQueryTerm *qt, QofQueryIndexKey *key)
+{
+    const QofQueryPredData *pd = qt->pdata;
+
+    if (qt->invert) return FALSE;
+
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_GUID))
+    {
+        const query_guid_def *pdata = (const query_guid_def *) pd;
+
+        /* Several GUID terms: keep the first. */
+        if (pdata->options != QOF_GUID_MATCH_ANY || key->guids)
+            return FALSE;
+        key->guids = pdata->guids;
+        return TRUE;
+    }
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_STRING))
+    {
+        const query_string_def *pdata = (const query_string_def *) pd;
+
+        if (pd->how != QOF_COMPARE_EQUAL || pdata->is_regex ||
+            pdata->options != QOF_STRING_MATCH_NORMAL || key->string)
+            return FALSE;
+        key->string = pdata->matchstring;
+        return TRUE;
+    }
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_DATE))
+    {
+        const query_date_def *pdata = (const query_date_def *) pd;
+        time64 slack = 0, date = pdata->date.tv_sec;
+
+        if (pdata->options == QOF_DATE_MATCH_DAY)
+            slack = date_match_day_slack;
+        switch (pd->how)
+        {
+        case QOF_COMPARE_LT:
+        case QOF_COMPARE_LTE:
+            key->end = MIN (key->end, date + slack);
+            return TRUE;
+        case QOF_COMPARE_GT:
+        case QOF_COMPARE_GTE:
+            key->start = MAX (key->start, date - slack);
+            return TRUE;
+        case QOF_COMPARE_EQUAL:
+            key->start = MAX (key->start, date - slack);
+            key->end = MIN (key->end, date + slack);
+            return TRUE;
+        default:
+            return FALSE;
+        }
+    }
+    return FALSE;
+}
+
+/* Pick the registered index promising the fewest candidates for the
+ * clause in the book, if any. */
+static void
+plan_clause_index (QofQuery *q, GList *and_terms, QofBook *book,
+                   QofQueryClausePlan *clause)
+{
+    GList *reg_node, *node;
+
+    for (reg_node = query_indexes; reg_node; reg_node = reg_node->next)
+    {
+        QofQueryIndexReg *reg = static_cast<QofQueryIndexReg*>(reg_node->data);
+        QofQueryIndexKey key;
+        gboolean usable = FALSE;
+        gint64 estimate;
+
+        if (g_strcmp0 (reg->obj_type, q->search_for)) continue;
+
+        memset (&key, 0, sizeof (key));
+        key.search_for = q->search_for;
+        key.start = G_MININT64;
+        key.end = G_MAXINT64;
+        for (node = and_terms; node; node = node->next)
+        {
+            QofQueryTerm *qt = static_cast<QofQueryTerm*>(node->data);
+
+            if (g_strcmp0 (qt->pdata->type_name, reg->pred_type) ||
+                param_list_cmp (qt->param_list, reg->param_list))
+                continue;
+            if (term_index_key (qt, &key))
+                usable = TRUE;
+        }
+        if (!usable) continue;
+
+        estimate = reg->index->estimate (book, &key);
+        if (estimate < 0) continue;
+        if (!clause->index || estimate < clause->estimate)
+        {
+            clause->index = reg->index;
+            clause->key = key;
+            clause->estimate = estimate;
+        }
+    }
+}
+
+static void
+plan_free (GPtrArray *plan)
+{
+    guint i;
+
+    for (i = 0; i < plan->len; i++)
+    {
+        QofQueryClausePlan *clause =
+            static_cast<QofQueryClausePlan*>(g_ptr_array_index (plan, i));
+        g_ptr_array_free (clause->terms, TRUE);
+        g_free (clause);
+    }
+    g_ptr_array_free (plan, TRUE);
+}
+
+static void
+plan_log (QofQuery *q, GPtrArray *plan, gint64 total)
+{
+    guint i, j;
+
+    for (i = 0; i < plan->len; i++)
+    {
+        QofQueryClausePlan *clause =
+            static_cast<QofQueryClausePlan*>(g_ptr_array_index (plan, i));
+        GString *terms = g_string_new (NULL);
+
+        for (j = 0; j < clause->terms->len; j++)
+        {
+            QofQueryTerm *qt =
+                static_cast<QofQueryTerm*>(g_ptr_array_index (clause->terms, j));
+            GString *path = qof_query_printParamPath (qt->param_list);
+            g_string_append_printf (terms, "%s%s%s", j ? ", " : "",
+                                    qt->invert ? "!" : "", path->str);
+            g_string_free (path, TRUE);
+        }
+        if (clause->index)
+            DEBUG ("%s clause %u: index %s for %" G_GINT64_FORMAT " of %"
+                   G_GINT64_FORMAT " objects, terms %s", q->search_for, i,
+                   clause->index->name, clause->estimate, total, terms->str);
+        else
+            DEBUG ("%s clause %u: scan %" G_GINT64_FORMAT " objects, terms %s",
+                   q->search_for, i, total, terms->str);
+        g_string_free (terms, TRUE);
+    }
+}
+
+/* Plan the query's run over the book, or over a list of objects when
+ * book is NULL.  Returns TRUE if the objects are better found through
+ * the clause indexes than by visiting all of them. */
+static gboolean
+plan_query (QofQuery *q, QofBook *book, GPtrArray **plan_out)
+{
+    GPtrArray *plan = g_ptr_array_new ();
+    gboolean use_indexes = (book != NULL && q->terms != NULL);
+    gint64 total = 0, candidates = 0;
+    GList *or_ptr;
+
+    if (book)
+        total = qof_collection_count (qof_book_get_collection (book,
+                                      q->search_for));
+
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        GList *and_terms = static_cast<GList*>(or_ptr->data);
+        QofQueryClausePlan *clause = g_new0 (QofQueryClausePlan, 1);
+
+        clause->terms = plan_term_order (and_terms);
+        if (use_indexes)
+            plan_clause_index (q, and_terms, book, clause);
+        if (clause->index)
+            candidates += clause->estimate;
+        else
+            use_indexes = FALSE;
+        g_ptr_array_add (plan, clause);
+    }
+    if (candidates >= total)
+        use_indexes = FALSE;
+
+    if (qof_log_check (log_module, QOF_LOG_DEBUG))
+    {
+        if (book) plan_log (q, plan, total);
+        DEBUG ("%s", use_indexes ? "using the indexes" : "checking every object");
+    }
+
+    *plan_out = plan;
+    return use_indexes;
+}
+
+void
+qof_query_register_index (QofIdTypeConst obj_type,
+                          QofQueryParamList *param_list,
+                          QofType pred_type, const QofQueryIndex *index)
+{
+    QofQueryIndexReg *reg;
+    GList *node;
+
+    g_return_if_fail (obj_type && param_list && pred_type && index);
+    g_return_if_fail (index->estimate && index->lookup);
+
+    for (node = query_indexes; node; node = node->next)
+    {
+        reg = static_cast<QofQueryIndexReg*>(node->data);
+        if (!g_strcmp0 (reg->obj_type, obj_type) &&
+            !g_strcmp0 (reg->pred_type, pred_type) &&
+            !param_list_cmp (reg->param_list, param_list))
+        {
+            g_slist_free (reg->param_list);
+            reg->param_list = param_list;
+            reg->index = index;
+            return;
+        }
+    }
+
+    reg = g_new0 (QofQueryIndexReg, 1);
+    reg->obj_type = obj_type;
+    reg->param_list = param_list;
+    reg->pred_type = pred_type;
+    reg->index = index;
+    query_indexes = g_list_append (query_indexes, reg);
+}
+
+static void
+query_indexes_free (void)
+{
+    GList *node;
+
+    for (node = query_indexes; node; node = node->next)
+    {
+        QofQueryIndexReg *reg = static_cast<QofQueryIndexReg*>(node->data);
+        g_slist_free (reg->param_list);
+        g_free (reg);
+    }
+    g_list_free (query_indexes);
+    query_indexes = NULL;
+}
+
+/********************************************************************/
+/* Incremental queries */
+
+void
+qof_query_register_dependents (QofIdTypeConst obj_type,
+                               QofIdTypeConst dep_type,
+                               QofQueryDependentsFunc fcn)
+{
+    QofQueryDependentsReg *reg;
+    GList *node;
+
+    g_return_if_fail (obj_type && dep_type && fcn);
+
+    for (node = query_dependents; node; node = node->next)
+    {
+        reg = static_cast<QofQueryDependentsReg*>(node->data);
+        if (!g_strcmp0 (reg->obj_type, obj_type) &&
+            !g_strcmp0 (reg->dep_type, dep_type))
+        {
+            reg->fcn = fcn;
+            return;
+        }
+    }
+
+    reg = g_new0 (QofQueryDependentsReg, 1);
+    reg->obj_type = obj_type;
+    reg->dep_type = dep_type;
+    reg->fcn = fcn;
+    query_dependents = g_list_append (query_dependents, reg);
+}
+
+static const QofQueryDependentsReg *
+query_dependents_lookup (QofIdTypeConst obj_type, QofIdTypeConst dep_type)
+{
+    GList *node;
+
+    for (node = query_dependents; node; node = node->next)
+    {
+        QofQueryDependentsReg *reg =
+            static_cast<QofQueryDependentsReg*>(node->data);
+        if (!g_strcmp0 (reg->obj_type, obj_type) &&
+            !g_strcmp0 (reg->dep_type, dep_type))
+            return reg;
+    }
+    return NULL;
+}
+
+static void
+query_dependents_free (void)
+{
+    g_list_foreach (query_dependents, (GFunc) g_free, NULL);
+    g_list_free (query_dependents);
+    query_dependents = NULL;
+}
+
+/* Map each object type whose parameters the terms read, other than
+ * the type searched for, to its registered dependents, or to NULL if
+ * there are none.  A path ending in the guid of an object only reads
+ * a pointer of the object before it, and guids never change. */
+static void
+query_find_dependencies (QofQuery *q)
+{
+    GList *or_ptr, *and_ptr;
+    GSList *fcn_ptr;
+
+    g_hash_table_remove_all (q->dependencies);
+    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            QofQueryTerm *qt = static_cast<QofQueryTerm*>(and_ptr->data);
+
+            for (fcn_ptr = qt->param_fcns; fcn_ptr && fcn_ptr->next;
+                 fcn_ptr = fcn_ptr->next)
+            {
+                const QofParam *param =
+                    static_cast<const QofParam*>(fcn_ptr->data);
+                const QofParam *next =
+                    static_cast<const QofParam*>(fcn_ptr->next->data);
+
+                if (!fcn_ptr->next->next &&
+                    !g_strcmp0 (next->param_name, QOF_PARAM_GUID))
+                    continue;
+                if (g_hash_table_lookup_extended (q->dependencies,
+                                                  param->param_type,
+                                                  NULL, NULL))
+                    continue;
+                g_hash_table_insert (q->dependencies,
+                                     (gpointer) param->param_type,
+                                     (gpointer) query_dependents_lookup
+                                     (q->search_for, param->param_type));
+            }
+        }
+    }
+}
+
+static void
+query_pending_cb (QofInstance *inst, gpointer user_data)
+{
+    QofQuery *q = static_cast<QofQuery*>(user_data);
+    g_hash_table_insert (q->pending, inst, inst);
+}
+
+/* Remember the objects searched for that the event may have changed,
+ * and forget those destroyed. */
+static void
+query_event_handler (QofInstance *ent, QofEventId event_type,
+                     gpointer handler_data, gpointer event_data)
+{
+    QofQuery *q = static_cast<QofQuery*>(handler_data);
+    gpointer reg;
+
+    if (!ent || q->rescan) return;
+    /* Objects of other books can't be among the results. */
+    if (!g_list_find (q->books, qof_instance_get_book (ent))) return;
+
+    if (!g_strcmp0 (ent->e_type, q->search_for))
+    {
+        if (event_type & QOF_EVENT_DESTROY)
+        {
+            g_hash_table_remove (q->matches, ent);
+            g_hash_table_remove (q->pending, ent);
+        }
+        else
+            g_hash_table_insert (q->pending, ent, ent);
+    }
+
+    if (!g_hash_table_lookup_extended (q->dependencies, ent->e_type,
+                                       NULL, &reg))
+        return;
+    if (!reg)
+        q->rescan = TRUE;
+    else if (!(event_type & QOF_EVENT_DESTROY))
+        static_cast<QofQueryDependentsReg*>(reg)->fcn (ent, query_pending_cb, q);
+}
+
+static gboolean
+query_is_incremental (const QofQuery *q)
+{
+    return q->matches != NULL;
+}
+
+/* Check again the objects named in events since the last run, and
+ * return all the matches in qcb. */
+static void
+query_run_incremental (QofQueryCB *qcb)
+{
+    QofQuery *q = qcb->query;
+    GHashTableIter iter;
+    gpointer object;
+
+    plan_query (q, NULL, &qcb->plan);
+    g_hash_table_iter_init (&iter, q->pending);
+    while (g_hash_table_iter_next (&iter, &object, NULL))
+    {
+        if (check_object (qcb->plan, object))
+            g_hash_table_insert (q->matches, object, object);
+        else
+            g_hash_table_remove (q->matches, object);
+    }
+    g_hash_table_remove_all (q->pending);
+    plan_free (qcb->plan);
+    qcb->plan = NULL;
+
+    g_hash_table_iter_init (&iter, q->matches);
+    while (g_hash_table_iter_next (&iter, &object, NULL))
+    {
+        qcb->list = g_list_prepend (qcb->list, object);
+        qcb->count++;
+    }
+}
+
+/* Keep the matches of a full run for the next ones. */
+static void
+query_save_matches (QofQuery *q, GList *list)
+{
+    g_hash_table_remove_all (q->matches);
+    g_hash_table_remove_all (q->pending);
+    for (; list; list = list->next)
+        g_hash_table_insert (q->matches, list->data, list->data);
+    q->rescan = FALSE;
+    q->suspended_events = qof_event_get_suspended_count ();
+}
+
+void
+qof_query_set_incremental (QofQuery *q, gboolean incremental)
+{
+    if (!q) return;
+    if (incremental == query_is_incremental (q)) return;
+
+    if (incremental)
+    {
+        q->matches = g_hash_table_new (NULL, NULL);
+        q->pending = g_hash_table_new (NULL, NULL);
+        q->dependencies = g_hash_table_new (g_str_hash, g_str_equal);
+        q->event_handler_id = qof_event_register_handler (query_event_handler,
+                              q);
+        q->rescan = TRUE;
+        q->changed = 1;
+    }
+    else
+    {
+        qof_event_unregister_handler (q->event_handler_id);
+        g_hash_table_destroy (q->matches);
+        g_hash_table_destroy (q->pending);
+        g_hash_table_destroy (q->dependencies);
+        q->event_handler_id = 0;
+        q->matches = NULL;
+        q->pending = NULL;
+        q->dependencies = NULL;
+    }
+}
+
 /********************************************************************/
 /* PUBLISHED API FUNCTIONS */
 
@@ -734,13 +1458,16 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_return_val_if_fail (run_cb, NULL);
     ENTER (" q=%p", q);
 
-    /* XXX: Prioritize the query terms? */
-
     /* prepare the Query for processing */
     if (q->changed)
     {
         query_clear_compiles (q);
         compile_terms (q);
+        if (query_is_incremental (q))
+        {
+            query_find_dependencies (q);
+            q->rescan = TRUE;
+        }
     }
 
     /* Maybe log this sucker */
@@ -770,11 +1497,22 @@ static GList * qof_query_run_internal (QofQuery *q,
      */
     matching_objects = g_list_reverse(matching_objects);
 
-    /* Now sort the matching objects based on the search criteria */
+    /* Now sort the matching objects based on the search criteria.  If
+     * only some of them are wanted, there's no need to sort the rest. */
     if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
             (q->primary_sort.use_default && q->defaultSort))
     {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
+        if ((object_count > q->max_results) && (q->max_results > 0))
+        {
+            GList *top = sort_top_objects (q, matching_objects,
+                                           q->max_results);
+            g_list_free (matching_objects);
+            matching_objects = top;
+            object_count = q->max_results;
+        }
+        else
+            matching_objects = g_list_sort_with_data(matching_objects,
+                                                     sort_func, q);
     }
 
     /* Crop the list to limit the number of splits. */
@@ -815,20 +1553,22 @@ static GList * qof_query_run_internal (QofQuery *q,
 
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
+    QofQuery *q;
     GList *node;
 
     (void)cb_arg; /* unused */
     g_return_if_fail(qcb);
+    q = qcb->query;
 
-    for (node = qcb->query->books; node; node = node->next)
+    /* run the query in the backends */
+    for (node = q->books; node; node = node->next)
     {
         QofBook* book = static_cast<QofBook*>(node->data);
         QofBackend* be = book->backend;
 
-        /* run the query in the backend */
         if (be)
         {
-            gpointer compiled_query = g_hash_table_lookup (qcb->query->be_compiled,
+            gpointer compiled_query = g_hash_table_lookup (q->be_compiled,
                                       book);
 
             if (compiled_query && be->run_query)
@@ -836,11 +1576,47 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
                 (be->run_query) (be, compiled_query);
             }
         }
+    }
 
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+    /* Objects changed while events were suspended went unseen. */
+    if (query_is_incremental (q) && !q->rescan &&
+        q->suspended_events == qof_event_get_suspended_count ())
+    {
+        query_run_incremental (qcb);
+        return;
+    }
+
+    for (node = q->books; node; node = node->next)
+    {
+        QofBook* book = static_cast<QofBook*>(node->data);
+        guint i;
+
+        /* Iterate over the objects that may match */
+        if (!plan_query (q, book, &qcb->plan))
+        {
+            scan_book (qcb, book);
+        }
+        else
+        {
+            if (qcb->plan->len > 1)
+                qcb->seen = g_hash_table_new (NULL, NULL);
+            for (i = 0; i < qcb->plan->len; i++)
+            {
+                QofQueryClausePlan *clause =
+                    static_cast<QofQueryClausePlan*>(g_ptr_array_index (qcb->plan, i));
+                clause->index->lookup (book, &clause->key,
+                                       check_indexed_item_cb, qcb);
+            }
+            if (qcb->seen)
+                g_hash_table_destroy (qcb->seen);
+            qcb->seen = NULL;
+        }
+        plan_free (qcb->plan);
+        qcb->plan = NULL;
     }
+
+    if (query_is_incremental (q))
+        query_save_matches (q, qcb->list);
 }
 
 GList * qof_query_run (QofQuery *q)
@@ -854,7 +1630,10 @@ static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
     QofQuery* pq = static_cast<QofQuery*>(cb_arg);
 
     g_return_if_fail(pq);
+    plan_query (qcb->query, NULL, &qcb->plan);
     g_list_foreach(qof_query_last_run(pq), check_item_cb, qcb);
+    plan_free (qcb->plan);
+    qcb->plan = NULL;
 }
 
 GList *
@@ -990,6 +1769,7 @@ GSList * qof_query_get_term_type (QofQuery *q, QofQueryParamList *term_param)
 void qof_query_destroy (QofQuery *q)
 {
     if (!q) return;
+    qof_query_set_incremental (q, FALSE);
     free_members (q);
     query_clear_compiles (q);
     g_hash_table_destroy (q->be_compiled);
@@ -1019,6 +1799,13 @@ QofQuery * qof_query_copy (QofQuery *q)
 
     copy->changed = 1;
 
+    copy->event_handler_id = 0;
+    copy->matches = NULL;
+    copy->pending = NULL;
+    copy->dependencies = NULL;
+    if (query_is_incremental (q))
+        qof_query_set_incremental (copy, TRUE);
+
     return copy;
 }
 
@@ -1347,6 +2134,8 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    query_indexes_free ();
+    query_dependents_free ();
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
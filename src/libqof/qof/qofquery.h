@@ -383,6 +383,99 @@ QofIdType qof_query_get_search_for (const QofQuery *q);
 /** Return the list of books we're using */
 GList * qof_query_get_books (QofQuery *q);
 
+// @}
+
+/* --------------------------------------------------------- */
+/** \name Query Indexes
+ *
+ * Before running a query over a book, the query planner orders the
+ * terms of each and-clause so that the cheapest and most selective
+ * are checked first, and looks for an index that can list the
+ * candidates of every clause.  When it finds one for each clause and
+ * the indexes promise fewer objects than the book holds, only those
+ * objects are checked instead of every object of the searched type.
+ * The plan is logged when the query module logs at QOF_LOG_DEBUG.
+ *
+ * An index serves the terms with one parameter path of one object
+ * type.  The planner hands it the values the term can match:
+ *  - for QOF_TYPE_GUID terms matching any of a list of GUIDs, the list;
+ *  - for QOF_TYPE_DATE comparisons other than QOF_COMPARE_NEQ, a range
+ *    of times, with the and-clause's terms on the same path combined;
+ *  - for case-sensitive, non-regex QOF_COMPARE_EQUAL QOF_TYPE_STRING
+ *    terms, the string.
+ *
+ * An index may list more objects than match, because the planner
+ * still checks every term, but must not leave out any that match.
+ */
+// @{
+
+/** The values a term can match, as handed to an index. */
+typedef struct
+{
+    QofIdTypeConst search_for;  /**< The object type searched for. */
+    GList *        guids;       /**< QOF_TYPE_GUID: GncGUID pointers */
+    time64         start;       /**< QOF_TYPE_DATE: the earliest time */
+    time64         end;         /**< QOF_TYPE_DATE: the latest time */
+    const char *   string;      /**< QOF_TYPE_STRING: the value */
+} QofQueryIndexKey;
+
+typedef struct
+{
+    /** A name for the plans in the log. */
+    const char * name;
+    /** Return the number of objects lookup would visit for the key in
+     *  the book, or -1 if the index can't serve the book. */
+    gint64 (*estimate) (QofBook *book, const QofQueryIndexKey *key);
+    /** Call cb on each object whose indexed parameter may match the
+     *  key, at most once each. */
+    void (*lookup) (QofBook *book, const QofQueryIndexKey *key,
+                    QofInstanceForeachCB cb, gpointer user_data);
+} QofQueryIndex;
+
+/** Register an index for the terms of queries searching for obj_type
+ *  with the given parameter path and predicate type, replacing any
+ *  index registered for the same ones.  The query subsystem takes
+ *  ownership of param_list; the index must stay valid until
+ *  qof_query_shutdown().
+ */
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               QofQueryParamList *param_list,
+                               QofType pred_type,
+                               const QofQueryIndex *index);
+
+// @}
+
+/* --------------------------------------------------------- */
+/** \name Incremental Queries
+ *
+ * An incremental query keeps the set of objects matching it between
+ * runs, and listens to the events of the objects its terms read.  A
+ * run then only checks again the objects named in events since the
+ * previous one, and the objects that depend on those named.  Changing
+ * the terms or books, or events lost while suspended, make the next
+ * run check every object again.  The order of the matches before they
+ * are sorted is unspecified.
+ */
+// @{
+
+/** List the objects searched for that read a parameter of inst. */
+typedef void (*QofQueryDependentsFunc) (QofInstance *inst,
+                                        QofInstanceForeachCB cb,
+                                        gpointer user_data);
+
+/** Register how an event on an object of dep_type affects queries
+ *  searching for obj_type: the objects that fcn lists are checked
+ *  again.  Incremental queries whose terms read parameters of a type
+ *  with no registered function check every object after an event on
+ *  an object of that type.
+ */
+void qof_query_register_dependents (QofIdTypeConst obj_type,
+                                    QofIdTypeConst dep_type,
+                                    QofQueryDependentsFunc fcn);
+
+/** Make the query incremental, or not. */
+void qof_query_set_incremental (QofQuery *q, gboolean incremental);
+
 // @}
 /* @} */
 #ifdef __cplusplus
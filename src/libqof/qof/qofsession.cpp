@@ -232,7 +232,21 @@ QofSessionImpl::load (QofPercentageFunc percentage_func) noexcept
         if (be->load)
         {
             be->load (be, newbook, LOAD_TYPE_INITIAL_LOAD);
-            push_error (qof_backend_get_error(be), {});
+            auto err = qof_backend_get_error (be);
+            if (err == ERR_FILEIO_RELOAD)
+            {
+                /* The backend left the book half filled and will load
+                 * it another way; give it an empty book. */
+                PINFO ("reloading into a new book");
+                qof_book_set_backend (newbook, NULL);
+                qof_book_destroy (newbook);
+                newbook = qof_book_new ();
+                m_book = newbook;
+                qof_book_set_backend (newbook, be);
+                be->load (be, newbook, LOAD_TYPE_INITIAL_LOAD);
+                err = qof_backend_get_error (be);
+            }
+            push_error (err, {});
         }
     }
 
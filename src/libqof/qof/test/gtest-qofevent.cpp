@@ -0,0 +1,172 @@
+/********************************************************************
+ * gtest-qofevent.cpp -- unit tests for batched qof event delivery  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+#include <vector>
+#include <gtest/gtest.h>
+#include "../guid.hpp"
+extern "C"
+{
+#include "../qof.h"
+}
+
+using Batch = std::vector<QofEventBatchItem>;
+
+static void
+record_batch (const QofEventBatchItem *items, guint n_items, gpointer data)
+{
+    auto batches = static_cast<std::vector<Batch>*>(data);
+    batches->emplace_back (items, items + n_items);
+}
+
+static void
+count_event (QofInstance *ent, QofEventId event_type, gpointer data,
+             gpointer event_data)
+{
+    ++*static_cast<int*>(data);
+}
+
+class QofEventTest : public ::testing::Test
+{
+protected:
+    QofEventTest () :
+        m_one {static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE, NULL))},
+        m_two {static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE, NULL))}
+    {
+        m_batch_id = qof_event_register_batch_handler (record_batch,
+                                                       &m_batches);
+        m_count_id = qof_event_register_handler (count_event, &m_count);
+    }
+    ~QofEventTest ()
+    {
+        qof_event_unregister_handler (m_batch_id);
+        qof_event_unregister_handler (m_count_id);
+        g_object_unref (m_one);
+        g_object_unref (m_two);
+    }
+
+    QofInstance* m_one;
+    QofInstance* m_two;
+    std::vector<Batch> m_batches;
+    int m_count = 0;
+    gint m_batch_id;
+    gint m_count_id;
+};
+
+TEST_F(QofEventTest, unbatched_events_delivered_singly)
+{
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    ASSERT_EQ (2u, m_batches.size ());
+    EXPECT_EQ (1u, m_batches[0].size ());
+    EXPECT_EQ (m_one, m_batches[0][0].entity);
+    EXPECT_EQ (QOF_EVENT_MODIFY, m_batches[0][0].event_mask);
+    EXPECT_EQ (2, m_count);
+}
+
+TEST_F(QofEventTest, batch_coalesces_per_entity)
+{
+    qof_event_begin_batch ();
+    qof_event_gen (m_two, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_one, QOF_EVENT_ADD, nullptr);
+    qof_event_begin_batch ();
+    qof_event_gen (m_two, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    qof_event_end_batch ();
+    EXPECT_TRUE (m_batches.empty ());
+    qof_event_end_batch ();
+
+    EXPECT_EQ (4, m_count);
+    ASSERT_EQ (1u, m_batches.size ());
+    ASSERT_EQ (2u, m_batches[0].size ());
+    EXPECT_EQ (m_two, m_batches[0][0].entity);
+    EXPECT_EQ (QOF_EVENT_MODIFY, m_batches[0][0].event_mask);
+    EXPECT_EQ (m_one, m_batches[0][1].entity);
+    EXPECT_EQ (QOF_EVENT_ADD | QOF_EVENT_MODIFY, m_batches[0][1].event_mask);
+}
+
+TEST_F(QofEventTest, destroy_delivered_at_once)
+{
+    qof_event_begin_batch ();
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_two, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_one, QOF_EVENT_DESTROY, nullptr);
+    ASSERT_EQ (1u, m_batches.size ());
+    ASSERT_EQ (1u, m_batches[0].size ());
+    EXPECT_EQ (m_one, m_batches[0][0].entity);
+    EXPECT_EQ (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY,
+               m_batches[0][0].event_mask);
+    qof_event_end_batch ();
+
+    ASSERT_EQ (2u, m_batches.size ());
+    ASSERT_EQ (1u, m_batches[1].size ());
+    EXPECT_EQ (m_two, m_batches[1][0].entity);
+}
+
+TEST_F(QofEventTest, suspended_events_not_batched)
+{
+    qof_event_begin_batch ();
+    qof_event_suspend ();
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    qof_event_resume ();
+    qof_event_end_batch ();
+    EXPECT_TRUE (m_batches.empty ());
+    EXPECT_EQ (0, m_count);
+}
+
+TEST_F(QofEventTest, unregistered_during_batch)
+{
+    qof_event_begin_batch ();
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    qof_event_unregister_handler (m_batch_id);
+    qof_event_end_batch ();
+    EXPECT_TRUE (m_batches.empty ());
+    m_batch_id = qof_event_register_batch_handler (record_batch, &m_batches);
+}
+
+TEST_F(QofEventTest, batch_drops_entity_freed_before_delivery)
+{
+    auto book = qof_book_new ();
+    auto entity = static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE,
+                                                          NULL));
+    qof_instance_init_data (entity, "EventTest", book);
+    auto col = qof_book_get_collection (book, "EventTest");
+    auto guid = *qof_instance_get_guid (entity);
+    gpointer weak = entity;
+    g_object_add_weak_pointer (G_OBJECT (entity), &weak);
+
+    qof_event_begin_batch ();
+    qof_event_gen (entity, QOF_EVENT_MODIFY, nullptr);
+    qof_event_gen (m_one, QOF_EVENT_MODIFY, nullptr);
+    /* Dropped without a destroy event reaching the batch, it must still
+     * be freed and leave its collection at once. */
+    qof_event_suspend ();
+    g_object_unref (entity);
+    qof_event_resume ();
+    EXPECT_EQ (nullptr, weak);
+    EXPECT_EQ (nullptr, qof_collection_lookup_entity (col, &guid));
+    qof_event_end_batch ();
+
+    ASSERT_EQ (1u, m_batches.size ());
+    ASSERT_EQ (1u, m_batches[0].size ());
+    EXPECT_EQ (m_one, m_batches[0][0].entity);
+    qof_book_destroy (book);
+}
@@ -0,0 +1,154 @@
+/********************************************************************
+ * gtest-qofid.cpp -- unit tests for QofCollection iteration         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../guid.hpp"
+extern "C"
+{
+#include "../qof.h"
+}
+
+static const char* test_type = "test type";
+
+class QofCollectionTest : public ::testing::Test
+{
+public:
+    QofCollectionTest () : m_book {qof_book_new ()}
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            auto inst = static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE,
+                                                                NULL));
+            qof_instance_init_data (inst, test_type, m_book);
+            m_insts.push_back (inst);
+        }
+        m_col = qof_book_get_collection (m_book, test_type);
+    }
+    ~QofCollectionTest ()
+    {
+        for (auto inst : m_insts)
+            if (inst)
+                g_object_unref (inst);
+        qof_book_destroy (m_book);
+    }
+
+    void remove (int i)
+    {
+        g_object_unref (m_insts[i]);
+        m_insts[i] = nullptr;
+    }
+
+    std::vector<QofInstance*> visit ()
+    {
+        std::vector<QofInstance*> visited;
+        QofCollectionIter iter;
+        QofInstance* inst;
+        qof_collection_iter_init (&iter, m_col);
+        while ((inst = qof_collection_iter_next (&iter)))
+            visited.push_back (inst);
+        return visited;
+    }
+
+    std::vector<QofInstance*> live ()
+    {
+        std::vector<QofInstance*> insts;
+        for (auto inst : m_insts)
+            if (inst)
+                insts.push_back (inst);
+        return insts;
+    }
+
+    QofBook* m_book;
+    QofCollection* m_col;
+    std::vector<QofInstance*> m_insts;
+};
+
+TEST_F(QofCollectionTest, iterates_in_insertion_order)
+{
+    EXPECT_EQ (10u, qof_collection_count (m_col));
+    EXPECT_EQ (m_insts, visit ());
+}
+
+TEST_F(QofCollectionTest, lookup_after_removal)
+{
+    for (int i = 0; i < 8; ++i)
+        remove (i);
+    EXPECT_EQ (2u, qof_collection_count (m_col));
+    EXPECT_EQ (live (), visit ());
+    for (auto inst : live ())
+        EXPECT_EQ (inst, qof_collection_lookup_entity (m_col,
+                                                       qof_instance_get_guid (inst)));
+}
+
+struct RemoveData
+{
+    QofCollectionTest* test;
+    std::vector<QofInstance*> visited;
+};
+
+TEST_F(QofCollectionTest, remove_during_foreach)
+{
+    RemoveData data {this, {}};
+    /* Each visit removes the entity after next and itself. */
+    qof_collection_foreach (m_col, [](QofInstance* inst, gpointer user_data)
+        {
+            auto data = static_cast<RemoveData*>(user_data);
+            auto& insts = data->test->m_insts;
+            data->visited.push_back (inst);
+            auto pos = std::find (insts.begin (), insts.end (), inst) -
+                insts.begin ();
+            if (pos + 2 < static_cast<long>(insts.size ()) && insts[pos + 2])
+                data->test->remove (pos + 2);
+            data->test->remove (pos);
+        }, &data);
+    EXPECT_EQ (6u, data.visited.size ());
+    EXPECT_EQ (0u, qof_collection_count (m_col));
+    EXPECT_TRUE (visit ().empty ());
+}
+
+TEST_F(QofCollectionTest, removal_during_iteration_keeps_places)
+{
+    QofCollectionIter iter;
+    qof_collection_iter_init (&iter, m_col);
+    EXPECT_EQ (m_insts[0], qof_collection_iter_next (&iter));
+    for (int i = 1; i < 9; ++i)
+        remove (i);
+    EXPECT_EQ (m_insts[9], qof_collection_iter_next (&iter));
+    EXPECT_EQ (nullptr, qof_collection_iter_next (&iter));
+    EXPECT_EQ (live (), visit ());
+}
+
+TEST_F(QofCollectionTest, insert_after_early_end)
+{
+    QofCollectionIter iter;
+    qof_collection_iter_init (&iter, m_col);
+    EXPECT_EQ (m_insts[0], qof_collection_iter_next (&iter));
+    qof_collection_iter_end (&iter);
+    for (int i = 0; i < 9; ++i)
+        remove (i);
+    auto inst = static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE, NULL));
+    qof_instance_init_data (inst, test_type, m_book);
+    m_insts.push_back (inst);
+    EXPECT_EQ (live (), visit ());
+}
@@ -0,0 +1,153 @@
+/********************************************************************
+ * gtest-qoflog.cpp -- unit tests for the qoflog level checks       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+#include <gtest/gtest.h>
+#include "../guid.hpp"
+extern "C"
+{
+#include "../qof.h"
+}
+
+class QofLogTest : public ::testing::Test
+{
+protected:
+    void TearDown () override { qof_log_shutdown (); }
+};
+
+TEST_F(QofLogTest, default_threshold)
+{
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_ERROR));
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_WARNING));
+    EXPECT_FALSE (qof_log_check ("gnc.engine", QOF_LOG_INFO));
+    EXPECT_FALSE (qof_log_check ("gnc.engine", QOF_LOG_DEBUG));
+    EXPECT_FALSE (qof_log_check (nullptr, QOF_LOG_DEBUG));
+}
+
+TEST_F(QofLogTest, longest_prefix_wins)
+{
+    qof_log_set_level ("gnc", QOF_LOG_INFO);
+    qof_log_set_level ("gnc.engine.sx", QOF_LOG_DEBUG);
+    qof_log_set_level ("gnc.gui", QOF_LOG_ERROR);
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_INFO));
+    EXPECT_FALSE (qof_log_check ("gnc.engine", QOF_LOG_DEBUG));
+    EXPECT_TRUE (qof_log_check ("gnc.engine.sx", QOF_LOG_DEBUG));
+    EXPECT_TRUE (qof_log_check ("gnc.engine.sx.loop", QOF_LOG_DEBUG));
+    EXPECT_FALSE (qof_log_check ("gnc.gui", QOF_LOG_WARNING));
+    EXPECT_FALSE (qof_log_check ("gnc.engines", QOF_LOG_DEBUG));
+    EXPECT_FALSE (qof_log_check ("qof.engine", QOF_LOG_INFO));
+}
+
+TEST_F(QofLogTest, root_level)
+{
+    qof_log_set_level ("", QOF_LOG_ERROR);
+    EXPECT_FALSE (qof_log_check ("gnc.engine", QOF_LOG_WARNING));
+    qof_log_set_level ("", QOF_LOG_DEBUG);
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_DEBUG));
+    EXPECT_TRUE (qof_log_check (nullptr, QOF_LOG_DEBUG));
+}
+
+TEST_F(QofLogTest, set_level_replaces_cached_threshold)
+{
+    qof_log_set_level ("gnc.engine", QOF_LOG_DEBUG);
+    EXPECT_TRUE (qof_log_check ("gnc.engine.lots", QOF_LOG_DEBUG));
+    qof_log_set_level ("gnc.engine", QOF_LOG_INFO);
+    EXPECT_FALSE (qof_log_check ("gnc.engine.lots", QOF_LOG_DEBUG));
+    EXPECT_TRUE (qof_log_check ("gnc.engine.lots", QOF_LOG_INFO));
+    qof_log_set_level ("gnc.engine.lots", QOF_LOG_DEBUG);
+    EXPECT_TRUE (qof_log_check ("gnc.engine.lots", QOF_LOG_DEBUG));
+}
+
+TEST_F(QofLogTest, shutdown_restores_default)
+{
+    qof_log_set_level ("gnc", QOF_LOG_DEBUG);
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_DEBUG));
+    qof_log_shutdown ();
+    EXPECT_FALSE (qof_log_check ("gnc.engine", QOF_LOG_DEBUG));
+    EXPECT_TRUE (qof_log_check ("gnc.engine", QOF_LOG_WARNING));
+}
+
+TEST_F(QofLogTest, checked_module_follows_new_levels)
+{
+    EXPECT_FALSE (qof_log_check ("gnc.register", QOF_LOG_DEBUG));
+    qof_log_set_level ("gnc", QOF_LOG_DEBUG);
+    EXPECT_TRUE (qof_log_check ("gnc.register", QOF_LOG_DEBUG));
+    qof_log_set_level ("gnc", QOF_LOG_WARNING);
+    EXPECT_FALSE (qof_log_check ("gnc.register", QOF_LOG_INFO));
+    EXPECT_TRUE (qof_log_check ("gnc.register", QOF_LOG_WARNING));
+}
+
+static void
+count_message (const gchar*, GLogLevelFlags, const gchar*, gpointer data)
+{
+    ++*static_cast<int*>(data);
+}
+
+TEST_F(QofLogTest, pinfo_and_debug_follow_threshold)
+{
+    static QofLogModule log_module = "gnc.test.qoflog";
+    int count = 0;
+    auto levels = static_cast<GLogLevelFlags>(G_LOG_LEVEL_INFO |
+                                              G_LOG_LEVEL_DEBUG);
+    auto handler = g_log_set_handler (log_module, levels, count_message,
+                                      &count);
+    PINFO ("not logged");
+    DEBUG ("not logged");
+    EXPECT_EQ (0, count);
+    qof_log_set_level (log_module, QOF_LOG_INFO);
+    PINFO ("logged");
+    DEBUG ("not logged");
+    EXPECT_EQ (1, count);
+    qof_log_set_level (log_module, QOF_LOG_DEBUG);
+    DEBUG ("logged");
+    EXPECT_EQ (2, count);
+    g_log_remove_handler (log_module, handler);
+}
+
+static const char*
+count_call (int* calls)
+{
+    ++*calls;
+    return "argument";
+}
+
+TEST_F(QofLogTest, disabled_log_skips_arguments)
+{
+    static QofLogModule log_module = "gnc.test.qoflog";
+    int count = 0, calls = 0;
+    auto levels = static_cast<GLogLevelFlags>(G_LOG_LEVEL_INFO |
+                                              G_LOG_LEVEL_DEBUG);
+    auto handler = g_log_set_handler (log_module, levels, count_message,
+                                      &count);
+    qof_log_set_level ("gnc.gui", QOF_LOG_DEBUG);
+    PINFO ("%s", count_call (&calls));
+    DEBUG ("%s", count_call (&calls));
+    EXPECT_EQ (0, calls);
+    qof_log_set_level (log_module, QOF_LOG_INFO);
+    PINFO ("%s", count_call (&calls));
+    DEBUG ("%s", count_call (&calls));
+    EXPECT_EQ (1, calls);
+    qof_log_set_level (log_module, QOF_LOG_DEBUG);
+    DEBUG ("%s", count_call (&calls));
+    EXPECT_EQ (2, calls);
+    EXPECT_EQ (2, count);
+    g_log_remove_handler (log_module, handler);
+}
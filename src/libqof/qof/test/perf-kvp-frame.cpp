@@ -0,0 +1,269 @@
+/********************************************************************
+ * perf-kvp-frame.cpp: memory and lookup timings for KvpFrame      *
+ * over the slots of a typical book.                                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include <guid.hpp>
+#include "../kvp-value.hpp"
+#include "../kvp_frame.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+/* This only reports sizes and timings, so it is not one of the tests;
+ * "make perf-kvp-frame" builds it.  It returns nonzero if a copy or a
+ * lookup gives the wrong answer. */
+
+/* Count what operator new hands out, which covers the frames, their slot
+ * storage and the values, but not the keys in the string cache, which all
+ * frames share. */
+static size_t bytes_allocated = 0;
+
+void*
+operator new (size_t size)
+{
+    bytes_allocated += size;
+    if (auto ptr = std::malloc (size ? size : 1))
+        return ptr;
+    throw std::bad_alloc {};
+}
+
+void
+operator delete (void* ptr) noexcept
+{
+    std::free (ptr);
+}
+
+/* Slots as the engine sets them, in the proportions found in a personal
+ * book with a few years of online banking imports: most splits have no
+ * slots, transactions have a posted date and sometimes notes and an online
+ * id, and a few accounts carry a large bayesian import map. */
+class KvpFrameBench
+{
+public:
+    static constexpr int n_accounts = 150;
+    static constexpr int n_transactions = 20000;
+    static constexpr int n_splits = 2 * n_transactions + 5000;
+    static constexpr int n_bayes_accounts = 5;
+    static constexpr int n_tokens = 2000;
+
+    KvpFrameBench ()
+    {
+        auto start = bytes_allocated;
+        for (int i = 0; i < n_transactions; ++i)
+            m_transactions.push_back (make_transaction (i));
+        m_transaction_bytes = bytes_allocated - start;
+
+        start = bytes_allocated;
+        for (int i = 0; i < n_splits; ++i)
+            m_splits.push_back (make_split (i));
+        m_split_bytes = bytes_allocated - start;
+
+        start = bytes_allocated;
+        for (int i = 0; i < n_accounts; ++i)
+            m_accounts.push_back (make_account (i));
+        m_account_bytes = bytes_allocated - start;
+    }
+
+    ~KvpFrameBench ()
+    {
+        for (auto frame : m_transactions) delete frame;
+        for (auto frame : m_splits) delete frame;
+        for (auto frame : m_accounts) delete frame;
+    }
+
+    static std::string key (const char* prefix, int i)
+    {
+        return prefix + std::to_string (i);
+    }
+
+    static KvpFrame* make_transaction (int i)
+    {
+        auto frame = new KvpFrame;
+        GDate date;
+        g_date_set_dmy (&date, 1 + i % 28, static_cast<GDateMonth>(1 + i % 12),
+                        2010 + i % 7);
+        frame->set ("date-posted", new KvpValue {date});
+        if (i % 5 == 0)
+            frame->set ("notes", new KvpValue {g_strdup ("Paid in cash")});
+        if (i % 3 == 0)
+            frame->set ("online_id",
+                        new KvpValue {g_strdup (key ("FITID", i).c_str ())});
+        return frame;
+    }
+
+    static KvpFrame* make_split (int i)
+    {
+        auto frame = new KvpFrame;
+        if (i % 7 == 0)
+            frame->set ("online_id",
+                        new KvpValue {g_strdup (key ("FITID", i).c_str ())});
+        if (i % 50 == 0)
+            frame->set ("split-type", new KvpValue {g_strdup ("stock-split")});
+        return frame;
+    }
+
+    static KvpFrame* make_account (int i)
+    {
+        auto frame = new KvpFrame;
+        frame->set ("color", new KvpValue {g_strdup ("#1469EB")});
+        if (i % 10 == 0)
+            frame->set ("placeholder", new KvpValue {g_strdup ("true")});
+        if (i % 4 == 0)
+        {
+            frame->set_path ("reconcile-info/last-date",
+                             new KvpValue {INT64_C(1420070400) + i});
+            frame->set_path ("reconcile-info/last-interval/days",
+                             new KvpValue {INT64_C(0)});
+            frame->set_path ("reconcile-info/last-interval/months",
+                             new KvpValue {INT64_C(1)});
+        }
+        if (i < n_bayes_accounts)
+        {
+            for (int token = 0; token < n_tokens; ++token)
+                for (int acct = 0; acct <= token % 3; ++acct)
+                {
+                    auto path = "import-map-bayes/" + key ("token", token) +
+                        "/" + key ("account", acct);
+                    frame->set_path (path.c_str (),
+                                     new KvpValue {INT64_C(1) + token % 5});
+                }
+        }
+        return frame;
+    }
+
+    static void report (const char* what, size_t bytes, int count)
+    {
+        std::cout << what << ": " << bytes << " bytes, "
+                  << static_cast<double> (bytes) / count << " per frame"
+                  << std::endl;
+    }
+
+    /* func looks up count slots and returns how many it found, which must
+     * be expected. */
+    template <typename Func> void
+    time_lookups (const char* what, size_t count, int expected, Func func)
+    {
+        const int repeats = 20;
+        int hits = 0;
+        auto start = std::chrono::steady_clock::now ();
+        for (int r = 0; r < repeats; ++r)
+            hits += func ();
+        auto elapsed = std::chrono::steady_clock::now () - start;
+        if (hits != expected * repeats)
+        {
+            std::cerr << what << ": found " << hits << " slots, expected "
+                      << expected * repeats << std::endl;
+            ++m_failures;
+        }
+        std::cout << what << ": "
+                  << std::chrono::duration<double, std::nano> (elapsed).count ()
+                     / (repeats * count)
+                  << " ns per lookup" << std::endl;
+    }
+
+    std::vector<KvpFrame*> m_transactions;
+    std::vector<KvpFrame*> m_splits;
+    std::vector<KvpFrame*> m_accounts;
+    size_t m_transaction_bytes;
+    size_t m_split_bytes;
+    size_t m_account_bytes;
+    int m_failures = 0;
+
+    void memory ();
+    void lookup ();
+};
+
+void
+KvpFrameBench::memory ()
+{
+    std::cout << "sizeof (KvpFrame): " << sizeof (KvpFrame) << std::endl;
+    report ("transactions", m_transaction_bytes, n_transactions);
+    report ("splits", m_split_bytes, n_splits);
+    report ("accounts", m_account_bytes, n_accounts);
+
+    auto start = bytes_allocated;
+    std::vector<KvpFrame*> copies;
+    for (auto frame : m_transactions)
+        copies.push_back (new KvpFrame (*frame));
+    report ("transaction copies", bytes_allocated - start, n_transactions);
+    for (size_t i = 0; i < copies.size (); ++i)
+    {
+        if (compare (copies[i], m_transactions[i]) != 0)
+            ++m_failures;
+        delete copies[i];
+    }
+}
+
+void
+KvpFrameBench::lookup ()
+{
+    // Every fifth transaction has notes, every seventh split an online_id
+    // and every fourth account a reconcile date; all the tokens are there.
+    time_lookups ("transaction notes", n_transactions,
+                  (n_transactions + 4) / 5, [this]()
+    {
+        int hits = 0;
+        for (auto frame : m_transactions)
+            hits += frame->get_slot ("notes") != nullptr;
+        return hits;
+    });
+    time_lookups ("split online_id", n_splits, (n_splits + 6) / 7, [this]()
+    {
+        int hits = 0;
+        for (auto frame : m_splits)
+            hits += frame->get_slot ("online_id") != nullptr;
+        return hits;
+    });
+    auto last_date = KvpPathImpl::intern ("reconcile-info/last-date");
+    time_lookups ("account reconcile date, interned", n_accounts,
+                  (n_accounts + 3) / 4, [this, last_date]()
+    {
+        int hits = 0;
+        for (auto frame : m_accounts)
+            hits += frame->get_slot (*last_date) != nullptr;
+        return hits;
+    });
+    std::vector<std::string> tokens;
+    for (int token = 0; token < n_tokens; token += 7)
+        tokens.push_back ("import-map-bayes/" + key ("token", token));
+    time_lookups ("bayes tokens", n_bayes_accounts * tokens.size (),
+                  n_bayes_accounts * static_cast<int> (tokens.size ()),
+                  [this, &tokens]()
+    {
+        int hits = 0;
+        for (int i = 0; i < n_bayes_accounts; ++i)
+            for (const auto& token : tokens)
+                hits += m_accounts[i]->get_slot (token.c_str ()) != nullptr;
+        return hits;
+    });
+}
+
+int
+main ()
+{
+    KvpFrameBench bench;
+    bench.memory ();
+    bench.lookup ();
+    return bench.m_failures ? 1 : 0;
+}
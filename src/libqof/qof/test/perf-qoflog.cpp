@@ -0,0 +1,74 @@
+/********************************************************************
+ * perf-qoflog.cpp -- timings for the qoflog level check            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+/* Reports what qof_log_check costs when the level is off everywhere, and
+ * when another module logs at it, which is what every ENTER and LEAVE in
+ * an inner loop pays.  It only prints timings, so it is not one of the
+ * tests; "make perf-qoflog" builds it. */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+extern "C"
+{
+#include "qof.h"
+}
+
+static const int default_iterations = 10000000;
+
+static double
+ns_per_check (QofLogModule module, QofLogLevel level, int iterations,
+              int* hits)
+{
+    auto start = std::chrono::steady_clock::now ();
+    for (int i = 0; i < iterations; ++i)
+        if (qof_log_check (module, level))
+            ++*hits;
+    auto elapsed = std::chrono::steady_clock::now () - start;
+    return std::chrono::duration<double, std::nano> (elapsed).count () /
+        iterations;
+}
+
+int
+main (int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi (argv[1]) : default_iterations;
+    int hits = 0;
+
+    if (iterations <= 0)
+        iterations = default_iterations;
+
+    printf ("qof_log_check, nothing at debug: %.2f ns\n",
+            ns_per_check ("gnc.engine.pricedb", QOF_LOG_DEBUG, iterations,
+                          &hits));
+    qof_log_set_level ("gnc.gui", QOF_LOG_DEBUG);
+    printf ("qof_log_check, another module at debug: %.2f ns\n",
+            ns_per_check ("gnc.engine.pricedb", QOF_LOG_DEBUG, iterations,
+                          &hits));
+    qof_log_shutdown ();
+
+    if (hits)
+    {
+        fprintf (stderr, "the check passed %d times\n", hits);
+        return 1;
+    }
+    return 0;
+}
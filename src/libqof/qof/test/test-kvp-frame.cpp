@@ -195,6 +195,21 @@ TEST_F (KvpFrameTest, GetSlotPath)
     EXPECT_EQ (v1, t_root.get_slot(path3a));
 }
 
+TEST_F (KvpFrameTest, GetSlotInternedPath)
+{
+    auto path1 = KvpPathImpl::intern ("top/first");
+    auto path2 = KvpPathImpl::intern ("/top/third/");
+    auto path3 = KvpPathImpl::intern ("top/first/fourth");
+    auto path4 = KvpPathImpl::intern ("top/fifth");
+
+    EXPECT_EQ (path1, KvpPathImpl::intern ("top/first"));
+    EXPECT_EQ (t_int_val, t_root.get_slot(*path1));
+    EXPECT_EQ (t_str_val, t_root.get_slot(*path2));
+    EXPECT_EQ (nullptr, t_root.get_slot(*path3));
+    EXPECT_EQ (nullptr, t_root.get_slot(*path4));
+    EXPECT_EQ (nullptr, t_root.get_slot(*KvpPathImpl::intern ("")));
+}
+
 TEST_F (KvpFrameTest, Empty)
 {
     KvpFrameImpl f1, f2;
@@ -202,3 +217,126 @@ TEST_F (KvpFrameTest, Empty)
     EXPECT_TRUE(f1.empty());
     EXPECT_FALSE(f2.empty());
 }
+
+TEST_F (KvpFrameTest, Changed)
+{
+    KvpFrameImpl f1;
+    EXPECT_FALSE(f1.is_changed());
+    EXPECT_TRUE(t_root.is_changed());
+    t_root.clear_changed();
+    EXPECT_FALSE(t_root.is_changed());
+    EXPECT_TRUE(t_root.get_changed_keys().empty());
+
+    t_root.set_path("top/second/twenty-first", new KvpValue {2.2});
+    EXPECT_TRUE(t_root.is_changed());
+    auto keys = t_root.get_changed_keys();
+    EXPECT_EQ(keys.size(), 1);
+    assert_contains(keys, "top");
+
+    t_root.clear_changed();
+    t_root.set("new", new KvpValue {INT64_C(3)});
+    delete t_root.set("new", nullptr);
+    t_root.mark_changed("/other/path");
+    keys = t_root.get_changed_keys();
+    EXPECT_EQ(keys.size(), 2);
+    assert_contains(keys, "new");
+    assert_contains(keys, "other");
+
+    KvpFrameImpl f2 {t_root};
+    EXPECT_EQ(f2.get_changed_keys(), keys);
+
+    /* Past the keys a frame keeps track of, all of them count as changed */
+    t_root.clear_changed();
+    for (auto key : {"a", "b", "c", "d"})
+        t_root.set(key, new KvpValue {INT64_C(1)});
+    EXPECT_FALSE(t_root.all_changed());
+    EXPECT_EQ(t_root.get_changed_keys().size(), 4);
+    delete t_root.set("a", nullptr);
+    EXPECT_FALSE(t_root.all_changed());
+    t_root.mark_changed("top");
+    EXPECT_TRUE(t_root.all_changed());
+    EXPECT_TRUE(t_root.is_changed());
+    keys = t_root.get_changed_keys();
+    EXPECT_EQ(keys.size(), 4);
+    assert_contains(keys, "top");
+    assert_contains(keys, "d");
+    t_root.clear_changed();
+    EXPECT_FALSE(t_root.all_changed());
+    EXPECT_FALSE(t_root.is_changed());
+}
+
+TEST_F (KvpFrameTest, GrowAndShrink)
+{
+    /* Enough slots to move the frame out of its flat storage and back. */
+    std::vector<std::string> names;
+    for (int i = 0; i < 20; ++i)
+        names.push_back ("key" + std::to_string (i));
+    KvpFrameImpl frame;
+    for (auto it = names.rbegin (); it != names.rend (); ++it)
+        EXPECT_EQ (nullptr, frame.set (it->c_str (),
+                                       new KvpValue {INT64_C(1)}));
+    std::sort (names.begin (), names.end ());
+    EXPECT_EQ (names, frame.get_keys ());
+    for (const auto& name : names)
+        EXPECT_NE (nullptr, frame.get_slot (name.c_str ()));
+
+    KvpFrameImpl copy {frame};
+    EXPECT_EQ (0, compare (frame, copy));
+
+    while (names.size () > 2)
+    {
+        delete frame.set (names.back ().c_str (), nullptr);
+        names.pop_back ();
+        EXPECT_EQ (names, frame.get_keys ());
+        EXPECT_EQ (nullptr, frame.get_slot ("key9"));
+    }
+    EXPECT_NE (nullptr, frame.get_slot ("key0"));
+    EXPECT_NE (0, compare (frame, copy));
+}
+
+TEST_F (KvpFrameTest, FlatToTreeThreshold)
+{
+    /* Look up, replace and delete at every size on either side of the
+     * switch to the map and of the switch back. */
+    const int max_flat = KvpFrameImpl::slot_map::max_flat;
+    std::vector<std::string> names;
+    for (int i = 0; i < max_flat + 2; ++i)
+        names.push_back ("key" + std::to_string (i));
+
+    for (int size = 1; size <= max_flat + 2; ++size)
+    {
+        KvpFrameImpl frame;
+        std::vector<KvpValue*> values;
+        for (int i = 0; i < size; ++i)
+        {
+            values.push_back (new KvpValue {INT64_C(1) + i});
+            EXPECT_EQ (nullptr, frame.set (names[i].c_str (), values[i]));
+        }
+        EXPECT_EQ (static_cast<size_t>(size), frame.get_keys ().size ());
+        for (int i = 0; i < size; ++i)
+            EXPECT_EQ (values[i], frame.get_slot (names[i].c_str ()));
+        EXPECT_EQ (nullptr, frame.get_slot ("missing"));
+
+        /* Replacing a slot hands back the old value and keeps the size. */
+        auto last = names[size - 1].c_str ();
+        auto replacement = new KvpValue {INT64_C(100)};
+        EXPECT_EQ (values[size - 1], frame.set (last, replacement));
+        delete values[size - 1];
+        values[size - 1] = replacement;
+        EXPECT_EQ (replacement, frame.get_slot (last));
+        EXPECT_EQ (static_cast<size_t>(size), frame.get_keys ().size ());
+
+        /* Deleting from the front goes through every smaller size, and
+         * past the switch back for the frames that reached the map. */
+        for (int i = 0; i < size; ++i)
+        {
+            EXPECT_EQ (values[i], frame.set (names[i].c_str (), nullptr));
+            delete values[i];
+            EXPECT_EQ (nullptr, frame.get_slot (names[i].c_str ()));
+            EXPECT_EQ (nullptr, frame.set (names[i].c_str (), nullptr));
+            for (int j = i + 1; j < size; ++j)
+                EXPECT_EQ (values[j], frame.get_slot (names[j].c_str ()));
+        }
+        EXPECT_TRUE (frame.empty ());
+    }
+}
@@ -220,6 +220,8 @@ static struct
     QofBackend *be;
     QofBook *oldbook;
     gboolean error;
+    gboolean reload;
+    int loads;
     gboolean load_called;
 } load_session_struct;
 
@@ -233,6 +235,13 @@ mock_load (QofBackend *be, QofBook *book, QofBackendLoadType type)
     g_assert (qof_book_get_backend (book) == be);
     if (load_session_struct.error)
         qof_backend_set_error (be, ERR_BACKEND_DATA_CORRUPT); /* just any valid error */
+    load_session_struct.loads++;
+    if (load_session_struct.reload)
+    {
+        load_session_struct.reload = FALSE;
+        qof_backend_set_error (be, ERR_FILEIO_RELOAD);
+        return;
+    }
     load_session_struct.load_called = TRUE;
 }
 
@@ -277,6 +286,21 @@ test_qof_session_load (Fixture *fixture, gconstpointer pData)
     g_assert (load_session_struct.oldbook == newbook);
     g_assert (qof_session_get_book (fixture->session));
     g_assert (load_session_struct.load_called);
+
+    g_test_message ("Test when the backend asks for a new book");
+    load_session_struct.oldbook = qof_session_get_book (fixture->session);
+    load_session_struct.error = FALSE;
+    load_session_struct.reload = TRUE;
+    load_session_struct.loads = 0;
+    load_session_struct.load_called = FALSE;
+    qof_session_load (fixture->session, percentage_fn);
+    newbook = qof_session_get_book (fixture->session);
+    g_assert_cmpint (load_session_struct.loads, ==, 2);
+    g_assert (newbook != load_session_struct.oldbook);
+    g_assert (qof_book_get_backend (newbook) == be);
+    g_assert (load_session_struct.load_called);
+    g_assert_cmpint (qof_session_get_error (fixture->session), ==,
+                     ERR_BACKEND_NO_ERR);
 }
 
 static struct